@@ -0,0 +1,254 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "bench-signals.h"
+#include "dab-params.h"
+#include "fft-handler.h"
+#include "phasetable.h"
+#include "reed-solomon.h"
+#include "firecode-checker.h"
+#include <cmath>
+#include <cstring>
+
+#define RDS_BITCLK		1187.5
+#define	FM_DEVIATION		75000
+#define	FM_TONE			1000
+#define	FM_PILOT		19000
+
+//	The DAB ones
+
+void dabFrames(std::vector<std::complex<float>> &out, int frames,
+	       float snr, benchRandom &random) {
+    dabParams params(1);
+    phaseTable table(1);
+    fftHandler fft(1);
+    std::complex<float> *v = fft.getVector();
+    int16_t T_u = params.get_T_u();
+    int16_t T_g = params.get_T_g();
+    int16_t carriers = params.get_carriers();
+    std::vector<std::complex<float>> symbols(carriers);
+    float scale = 1.0 / sqrt(carriers);
+    float noise = pow(10, -snr / 20) * M_SQRT1_2;
+    int64_t p = 0;
+
+    out.resize(frames * params.get_T_F());
+    for (int f = 0; f < frames; f++) {
+	for (int i = 0; i < params.get_T_null(); i++)
+	    out[p++] = std::complex<float>(random.gaussian(),
+					   random.gaussian()) * noise;
+	for (int l = 0; l < params.get_L(); l++) {
+	    memset((void *) v, 0, T_u * sizeof(std::complex<float>));
+	    for (int i = 0; i < carriers; i++) {
+		int k = i < carriers / 2? i - carriers / 2: i - carriers / 2 + 1;
+
+		// block 0 is the phase reference, the others move each
+		// carrier on by an odd multiple of pi/4
+		if (l == 0)
+		    symbols[i] = std::polar(1.0f, table.get_Phi(k));
+		else
+		    symbols[i] *= std::polar(1.0f,
+				   float(M_PI / 4 * (2 * (random.next() >> 30) + 1)));
+		v[(T_u + k) % T_u] = symbols[i] * scale;
+	    }
+	    fft.do_IFFT();
+	    for (int i = 0; i < T_g; i++)
+		out[p++] = v[T_u - T_g + i] + std::complex<float>(random.gaussian(),
+						   random.gaussian()) * noise;
+	    for (int i = 0; i < T_u; i++)
+		out[p++] = v[i] + std::complex<float>(random.gaussian(),
+						      random.gaussian()) * noise;
+	}
+    }
+}
+
+static
+int parity(int x) {
+    x ^= x >> 16;
+    x ^= x >> 8;
+    x ^= x >> 4;
+    x ^= x >> 2;
+    x ^= x >> 1;
+    return x & 1;
+}
+
+void encode(const uint8_t *bits, int32_t length, uint8_t *out) {
+    static const int polys[4] = { 0155, 0117, 0123, 0155 };
+    int sr = 0;
+
+    // 6 tail bits flush the encoder
+    for (int32_t i = 0; i < length + 6; i++) {
+	sr = (sr << 1) | (i < length? bits[i] & 1: 0);
+	for (int k = 0; k < 4; k++)
+	    out[i * 4 + k] = parity(sr & polys[k]);
+    }
+}
+
+void convolve(const std::vector<uint8_t> &bits, std::vector<int16_t> &soft,
+	      float snr, benchRandom &random) {
+    std::vector<uint8_t> coded((bits.size() + 6) * 4);
+    float noise = 64 * pow(10, -snr / 20);
+
+    encode(bits.data(), bits.size(), coded.data());
+    soft.resize(coded.size());
+    for (size_t i = 0; i < coded.size(); i++) {
+	float s = (coded[i]? 64: -64) + random.gaussian() * noise;
+
+	soft[i] = s > 127? 127: s < -127? -127: int16_t(s);
+    }
+}
+
+void dabPlusSuperframe(int16_t bitRate, int errors,
+		       std::vector<uint8_t> frames[5], benchRandom &random) {
+    reedSolomon rs(8, 0435, 0, 1, 10);
+    firecode_checker fc;
+    int16_t RSDims = bitRate / 8;
+    int32_t size = 110 * RSDims;
+    int32_t frameBits = 24 * bitRate;
+    std::vector<uint8_t> out(size);
+    std::vector<uint8_t> bytes(120 * RSDims);
+    uint8_t rsIn[120] = { 0 };
+    uint8_t rsOut[120];
+    int32_t au[4];
+
+    for (int32_t i = 0; i < size; i++)
+	out[i] = random.byte();
+
+    // 48kHz, SBR, stereo: three AUs of equal size
+    au[0] = 6;
+    au[1] = au[0] + (size - au[0]) / 3;
+    au[2] = au[1] + (size - au[0]) / 3;
+    au[3] = size;
+    out[2] = 0x70;
+    out[3] = au[1] >> 4;
+    out[4] = ((au[1] & 0xf) << 4) | (au[2] >> 8);
+    out[5] = au[2] & 0xff;
+    for (int a = 0; a < 3; a++) {
+	uint8_t *p = &out[au[a]];
+	int32_t length = au[a + 1] - au[a] - 2;
+	uint16_t crc;
+
+	// keep clear of the PAD marker
+	if (((p[0] >> 5) & 07) == 4)
+	    p[0] ^= 0x20;
+	crc = ~crc16(p, length);
+	p[length] = crc >> 8;
+	p[length + 1] = crc & 0xff;
+    }
+
+    // the firecode covers bytes 2 .. 10, and is held in 0 and 1
+    for (int32_t f = 0; f < 0x10000; f++) {
+	out[0] = f >> 8;
+	out[1] = f & 0xff;
+	if (fc.check(out.data()))
+	    break;
+    }
+
+    // RS over the columns, then corrupt bytes anywhere past the first
+    // row, which holds the firecode
+    for (int16_t j = 0; j < RSDims; j++) {
+	for (int16_t k = 0; k < 110; k++)
+	    rsIn[k] = out[j + k * RSDims];
+	rs.enc(rsIn, rsOut, 135);
+	for (int e = 0; e < errors; e++)
+	    rsOut[1 + random.next() % 119] ^= random.byte() | 1;
+	for (int16_t k = 0; k < 120; k++)
+	    bytes[j + k * RSDims] = rsOut[k];
+    }
+
+    for (int f = 0; f < 5; f++) {
+	frames[f].resize(frameBits);
+	for (int32_t i = 0; i < frameBits; i++)
+	    frames[f][i] = (bytes[f * frameBits / 8 + i / 8] >> (7 - (i & 7))) & 1;
+    }
+}
+
+//	The FM ones
+
+static
+uint16_t rdsCheck(uint16_t info) {
+    uint32_t reg = (uint32_t) info << 10;
+
+    for (int i = 25; i >= 10; i--)
+	if (reg & (1u << i))
+	    reg ^= 0x5B9u << (i - 10);
+    return reg & 0x3ff;
+}
+
+void rdsBits(uint16_t pi, const char *ps, int32_t count,
+	     std::vector<uint8_t> &bits) {
+    static const uint16_t offsets[4] = { 0x0FC, 0x198, 0x168, 0x1B4 };
+    uint8_t previous = 0;
+    int segment = 0;
+
+    bits.resize(count);
+    for (int32_t i = 0; i < count; segment = (segment + 1) % 4) {
+	uint16_t blocks[4];
+
+	blocks[0] = pi;
+	blocks[1] = (1 << 10) | (10 << 5) | (1 << 3) | segment;
+	blocks[2] = 0xE0CD;
+	blocks[3] = (ps[2 * segment] << 8) | ps[2 * segment + 1];
+	for (int b = 0; b < 4 && i < count; b++) {
+	    uint32_t word = ((uint32_t) blocks[b] << 10) |
+			    (rdsCheck(blocks[b]) ^ offsets[b]);
+
+	    for (int j = 25; j >= 0 && i < count; j--) {
+		previous ^= (word >> j) & 1;
+		bits[i++] = previous;
+	    }
+	}
+    }
+}
+
+static
+float biphase(const std::vector<uint8_t> &bits, double t) {
+    double clock = t * RDS_BITCLK;
+    int64_t n = int64_t(clock);
+
+    return (bits[n % bits.size()]? 1: -1) * sin(2 * M_PI * (clock - n));
+}
+
+void rdsSignal(const std::vector<uint8_t> &bits, int32_t rate, int32_t length,
+	       float noise, std::vector<float> &out, benchRandom &random) {
+    out.resize(length);
+    for (int32_t i = 0; i < length; i++)
+	out[i] = biphase(bits, double(i) / rate) + random.gaussian() * noise;
+}
+
+void fmSignal(const std::vector<uint8_t> &rds, int32_t rate, int32_t length,
+	      float snr, std::vector<std::complex<float>> &out, benchRandom &random) {
+    float noise = pow(10, -snr / 20) * M_SQRT1_2;
+    double phase = 0;
+
+    // the RDS subcarrier is locked to the third harmonic of the pilot
+    out.resize(length);
+    for (int32_t i = 0; i < length; i++) {
+	double t = double(i) / rate;
+	double pilot = 2 * M_PI * FM_PILOT * t;
+	double mpx = 0.8 * sin(2 * M_PI * FM_TONE * t) +
+		     0.1 * sin(pilot) +
+		     0.05 * biphase(rds, t) * sin(3 * pilot);
+
+	phase = fmod(phase + 2 * M_PI * FM_DEVIATION * mpx / rate, 2 * M_PI);
+	out[i] = std::polar(1.0f, float(phase)) +
+		 std::complex<float>(random.gaussian(), random.gaussian()) * noise;
+    }
+}
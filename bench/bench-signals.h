@@ -0,0 +1,86 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef BENCH_SIGNALS_H
+#define BENCH_SIGNALS_H
+
+//	Deterministic stage inputs for the benchmark.
+//	Everything is derived from a seeded generator, so that the same
+//	build produces the same vectors, and hence the same digests
+#include <complex>
+#include <cstdint>
+#include <vector>
+#include "crc16.h"
+
+//	64 bit LCG, not for anything but reproducible noise
+class benchRandom {
+public:
+    benchRandom(uint64_t seed) { state = seed; }
+    uint32_t next(void) {
+	state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+	return (uint32_t) (state >> 32);
+    }
+    uint8_t byte(void) { return next() >> 24; }
+
+    // uniform in [-1, 1)
+    float uniform(void) { return (int32_t) next() / 2147483648.0f; }
+
+    // roughly gaussian, unit variance
+    float gaussian(void) {
+	return uniform() + uniform() + uniform();
+    }
+
+private:
+    uint64_t state;
+};
+
+//	Mode I frames: null symbol, phase reference and random
+//	pi/4 DQPSK data blocks, scaled to unit power, noise at snr dB
+void dabFrames(std::vector<std::complex<float>> &, int frames,
+	       float snr, benchRandom &);
+
+//	the DAB mother code, 4 bits out per bit in, 6 tail bits included
+void encode(const uint8_t *bits, int32_t length, uint8_t *out);
+
+//	the soft bits the FIC viterbi expects for the bits given, mother
+//	code and tail included, +-127 for a clean channel
+void convolve(const std::vector<uint8_t> &bits, std::vector<int16_t> &soft,
+	      float snr, benchRandom &);
+
+//	one DAB+ superframe at bitRate, 3 AUs at 48kHz with SBR, firecode,
+//	AU CRCs and RS parity in place, errors corrupted bytes per RS
+//	column, returned as the 5 logical frames, one bit per byte
+void dabPlusSuperframe(int16_t bitRate, int errors,
+		       std::vector<uint8_t> frames[5], benchRandom &);
+
+//	RDS groups 0A carrying the PS name, differentially encoded
+void rdsBits(uint16_t pi, const char *ps, int32_t count,
+	     std::vector<uint8_t> &);
+
+//	the RDS baseband as the decoder sees it after mixing down, bits
+//	shaped as biphase doublets at 1187.5 bps
+void rdsSignal(const std::vector<uint8_t> &, int32_t rate, int32_t length,
+	       float noise, std::vector<float> &, benchRandom &);
+
+//	a mono station: tone, pilot and RDS, 75kHz deviation, as IQ
+void fmSignal(const std::vector<uint8_t> &rds, int32_t rate, int32_t length,
+	      float snr, std::vector<std::complex<float>> &, benchRandom &);
+#endif // BENCH_SIGNALS_H
@@ -0,0 +1,1001 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+//	The DSP benchmark: feeds synthetic or recorded vectors through the
+//	individual stages of the receiver, and reports timings, allocations
+//	and a digest of the output, to be checked against golden digests
+//	and against a second run of the same stage.
+//	Inputs are deterministic, so that a given build, on a given
+//	architecture, always produces the same digests
+#include <QCoreApplication>
+#include <QFile>
+#include <QDir>
+#include <QTextStream>
+#include <QStringList>
+#include <QMap>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <unistd.h>
+#include "constants.h"
+#include "logger.h"
+#include "logging.h"
+#include "radio.h"
+#include "bench-signals.h"
+#include "dab-params.h"
+#include "process-params.h"
+#include "phasereference.h"
+#include "ofdm-decoder.h"
+#include "viterbi-spiral.h"
+#include "reed-solomon.h"
+#include "mp4processor.h"
+#include "fm-processor.h"
+#include "fm-demodulator.h"
+#include "rds-decoder.h"
+#include "trigtabs.h"
+#include "file-handler.h"
+#include "settings.h"
+
+#define	BENCH_SEED		0x67756775ULL
+#define	BENCH_PASSES		10
+#define	BENCH_FRAMES		20
+#define	BENCH_SNR		20
+#define	BENCH_BITRATE		96
+#define	BENCH_RS_ERRORS		3
+#define	BENCH_FM_RATE		256000
+#define	BENCH_RDS_RATE		(BENCH_FM_RATE / 4)
+#define	BENCH_AUDIO_RATE	48000
+
+//	every allocation in the process is counted, the stages are run
+//	one at a time, so whatever happens in between belongs to the stage
+static std::atomic<int64_t> allocations(0);
+
+void *operator new(size_t size) {
+    void *p;
+
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    p = malloc(size == 0? 1: size);
+    if (p == nullptr)
+	throw std::bad_alloc();
+    return p;
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    free(p);
+}
+
+//	The counterparts
+
+RadioInterface::RadioInterface(QObject *parent):
+	QObject(parent) {
+    eventCount = 0;
+    audioBuffer = nullptr;
+    soundOut = nullptr;
+}
+
+RadioInterface::~RadioInterface() {
+}
+
+void RadioInterface::addToEnsemble(const QString &s, uint SId) {
+    events.add(s);
+    events.add(SId);
+    eventCount++;
+}
+
+void RadioInterface::nameOfEnsemble(int id, const QString &s) {
+    events.add(id);
+    events.add(s);
+    eventCount++;
+}
+
+void RadioInterface::ensembleLoaded(int count) {
+    events.add(count);
+    eventCount++;
+}
+
+// nothing is started from the ensemble cache here, and it stays out
+// of the digest so that the golden values still hold
+void RadioInterface::timeSynced() {
+}
+
+void RadioInterface::showQuality(bool b) {
+    events.add(b);
+    eventCount++;
+}
+
+void RadioInterface::showStrength(float s) {
+    events.add(s);
+    eventCount++;
+}
+
+void RadioInterface::showLabel(QString s) {
+    log(LOG_EVENT, LOG_MIN, "label %s", qPrintable(s));
+    events.add(s);
+    eventCount++;
+}
+
+void RadioInterface::showPiCode(int pi, int frequency) {
+    events.add(pi);
+    events.add(frequency);
+    eventCount++;
+}
+
+void RadioInterface::showText(QString s) {
+    log(LOG_EVENT, LOG_MIN, "text %s", qPrintable(s));
+    events.add(s);
+    eventCount++;
+}
+
+void RadioInterface::showSoundMode(bool stereo) {
+    events.add(stereo);
+    eventCount++;
+}
+
+void RadioInterface::handleMotObject(QByteArray result, QString name,
+				     int contentType, bool dirElement) {
+    events.add(result.constData(), result.size());
+    events.add(name);
+    events.add(contentType);
+    events.add(dirElement);
+    eventCount++;
+}
+
+void RadioInterface::changeInConfiguration() {
+    eventCount++;
+}
+
+// the decoders call us in their own thread, so there is no need to
+// leave anything behind for the next call
+void RadioInterface::newAudio(int amount, int rate) {
+    _VLA(int16_t, vec, amount);
+
+    if (audioBuffer == nullptr || soundOut == nullptr)
+	return;
+    while (audioBuffer->GetRingBufferReadAvailable() >= amount) {
+	audioBuffer->getDataFromBuffer(vec, amount);
+	soundOut->audioOut(vec, amount, rate);
+    }
+}
+
+void RadioInterface::scanDone() {
+    eventCount++;
+}
+
+void RadioInterface::scanFound() {
+    eventCount++;
+}
+
+benchDevice::benchDevice(const std::vector<std::complex<float>> &v):
+	samples(v) {
+    position.store(0);
+    drained.store(false);
+}
+
+benchDevice::~benchDevice(void) {
+}
+
+bool benchDevice::restartReader(int32_t frequency) {
+    (void) frequency;
+    position.store(0);
+    drained.store(false);
+    return true;
+}
+
+void benchDevice::stopReader(void) {
+}
+
+int32_t benchDevice::getSamples(std::complex<float> *v, int32_t amount,
+				agcStats *stats) {
+    int64_t p = position.load();
+    int32_t n = std::min(int64_t(amount), int64_t(samples.size()) - p);
+
+    stats->min = stats->max = stats->overflows = 0;
+    if (n <= 0)
+	return 0;
+    memcpy(v, &samples[p], n * sizeof(std::complex<float>));
+    position.store(p + n);
+    return n;
+}
+
+int32_t benchDevice::Samples(void) {
+    int64_t left = samples.size() - position.load();
+
+    if (left == 0)
+	drained.store(true);
+    return std::min(left, int64_t(INT32_MAX));
+}
+
+bool benchDevice::finished(void) {
+    return drained.load();
+}
+
+benchAudio::benchAudio(void) {
+    samples = 0;
+}
+
+benchAudio::~benchAudio(void) {
+}
+
+void benchAudio::audioOutput(float *v, int32_t amount) {
+    digest.add(v, 2 * amount * sizeof(float));
+    samples += amount;
+}
+
+//	The stages
+
+struct benchResult {
+    benchResult(): samples(0), frames(0), nanos(0), allocations(0), digest(0) {}
+    int64_t samples;		// stage input units processed
+    int64_t frames;
+    int64_t nanos;
+    int64_t allocations;
+    uint64_t digest;
+    QString note;
+};
+
+struct benchContext {
+    int passes;
+    int frames;			// input length, in 96ms DAB frames
+    QString vectorDir;
+    bool writeVectors;
+
+    // recordings, via the file device
+    std::vector<std::complex<float>> dabRecording;
+    std::vector<std::complex<float>> fmRecording;
+};
+
+//	times a section of a stage, and charges it with the allocations
+//	made in the meantime
+class benchTimer {
+public:
+    benchTimer(benchResult &r): result(r) {}
+    void start(void) {
+	startAllocations = allocations.load();
+	startTime = std::chrono::steady_clock::now();
+    }
+    void stop(void) {
+	result.nanos += std::chrono::duration_cast<std::chrono::nanoseconds>
+			(std::chrono::steady_clock::now() - startTime).count();
+	result.allocations += allocations.load() - startAllocations;
+    }
+
+private:
+    benchResult &result;
+    std::chrono::steady_clock::time_point startTime;
+    int64_t startAllocations;
+};
+
+//	vector files are raw arrays of the stage input type, named after
+//	the input, so that the synthetic ones can be replaced by captures
+template <class T>
+static bool readVector(benchContext &c, const char *name, std::vector<T> &v) {
+    if (c.vectorDir == "" || c.writeVectors)
+	return false;
+
+    QFile file(c.vectorDir + "/" + name + ".vec");
+
+    if (!file.open(QIODevice::ReadOnly))
+	return false;
+    v.resize(file.size() / sizeof(T));
+    file.read((char *) v.data(), v.size() * sizeof(T));
+    log(LOG_DEV, LOG_MIN, "read %zu items from %s", v.size(), qPrintable(file.fileName()));
+    return v.size() > 0;
+}
+
+template <class T>
+static void writeVector(benchContext &c, const char *name, const std::vector<T> &v) {
+    if (c.vectorDir == "" || !c.writeVectors)
+	return;
+
+    QFile file(c.vectorDir + "/" + name + ".vec");
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+	fprintf(stderr, "could not write %s\n", qPrintable(file.fileName()));
+	return;
+    }
+    file.write((const char *) v.data(), v.size() * sizeof(T));
+}
+
+//	a recording may start anywhere: the frame starts at the null symbol,
+//	that is, at the minimum energy over T_null within the first frame
+static
+int64_t frameStart(const std::vector<std::complex<float>> &v,
+		   dabParams &params) {
+    int32_t T_null = params.get_T_null();
+    int32_t T_F = params.get_T_F();
+    int64_t best = 0;
+    float minimum = 0;
+    float energy = 0;
+
+    if ((int64_t) v.size() < T_F + T_null)
+	return 0;
+    for (int32_t i = 0; i < T_null; i++)
+	energy += std::norm(v[i]);
+    minimum = energy;
+    for (int32_t i = T_null; i < T_F + T_null; i++) {
+	energy += std::norm(v[i]) - std::norm(v[i - T_null]);
+	if (energy < minimum) {
+	    minimum = energy;
+	    best = i - T_null + 1;
+	}
+    }
+    return best;
+}
+
+static
+const std::vector<std::complex<float>> &dabInput(benchContext &c,
+						 int64_t *start) {
+    static std::vector<std::complex<float>> v;
+    static int64_t first = -1;
+
+    if (first < 0) {
+	dabParams params(1);
+
+	if (c.dabRecording.size() > 0) {
+	    v.swap(c.dabRecording);
+	    first = frameStart(v, params);
+	} else {
+	    if (!readVector(c, "dab", v)) {
+		benchRandom random(BENCH_SEED);
+
+		dabFrames(v, c.frames, BENCH_SNR, random);
+	    }
+	    first = 0;
+	}
+	writeVector(c, "dab", v);
+    }
+    *start = first;
+    return v;
+}
+
+//	the phase reference correlation, on a window which, like in the
+//	receiver, starts some way into the cyclic prefix of block 0
+static
+void benchSync(benchContext &c, benchResult &r) {
+    dabParams params(1);
+    processParams p;
+    int64_t start;
+    const std::vector<std::complex<float>> &iq = dabInput(c, &start);
+    int32_t T_u = params.get_T_u();
+    int32_t T_F = params.get_T_F();
+    int32_t frames = (int64_t(iq.size()) - start) / T_F;
+    std::vector<std::complex<float>> buffer(T_u);
+    benchDigest digest;
+    benchTimer timer(r);
+    int found = 0;
+
+    memset(&p, 0, sizeof(p));
+    p.dabMode = 1;
+    p.threshold = DAB_DEF_THRESHOLD;
+    p.diff_length = DIFF_LENGTH;
+    p.echo_depth = DAB_DEF_ECHO_DEPTH;
+    phaseReference reference(&p, &params);
+    for (int pass = 0; pass < c.passes; pass++)
+	for (int32_t f = 0; f < frames; f++) {
+	    const std::complex<float> *b = &iq[start + f * T_F +
+					       params.get_T_null() + 32];
+
+	    timer.start();
+	    memcpy(buffer.data(), b, T_u * sizeof(std::complex<float>));
+	    int32_t index = reference.findIndex(&buffer, DAB_DEF_THRESHOLD);
+	    timer.stop();
+	    if (pass == 0) {
+		digest.add(index);
+		if (index >= 0)
+		    found++;
+	    }
+	}
+    r.samples = int64_t(c.passes) * frames * T_u;
+    r.frames = int64_t(c.passes) * frames;
+    r.digest = digest.value();
+    r.note = QString("synced %1/%2").arg(found).arg(frames);
+}
+
+//	block 0 and the data blocks of each frame, as the receiver hands
+//	them over once synchronized
+static
+void benchOfdm(benchContext &c, benchResult &r) {
+    dabParams params(1);
+    int64_t start;
+    const std::vector<std::complex<float>> &iq = dabInput(c, &start);
+    int32_t T_u = params.get_T_u();
+    int32_t T_s = params.get_T_s();
+    int32_t T_g = params.get_T_g();
+    int32_t T_F = params.get_T_F();
+    int32_t L = params.get_L();
+    int16_t carriers = params.get_carriers();
+    int32_t frames = (int64_t(iq.size()) - start) / T_F;
+    RingBuffer<std::complex<float>> iqBuffer(2 * 1536);
+    std::vector<std::complex<float>> buffer(2 * T_s);
+    std::vector<int16_t> ibits(2 * carriers);
+    RadioInterface radioInterface;
+    ofdmDecoder decoder(&radioInterface, &params, 1, &iqBuffer);
+    benchDigest digest;
+    benchTimer timer(r);
+
+    for (int pass = 0; pass < c.passes; pass++)
+	for (int32_t f = 0; f < frames; f++) {
+	    const std::complex<float> *b = &iq[start + f * T_F + params.get_T_null()];
+
+	    timer.start();
+	    memcpy(buffer.data(), b + T_g, T_u * sizeof(std::complex<float>));
+	    decoder.processBlock_0(buffer);
+	    for (int32_t l = 1; l < L; l++) {
+		memcpy(buffer.data(), b + l * T_s, T_s * sizeof(std::complex<float>));
+		decoder.decode(&buffer, l, ibits.data());
+		if (pass == 0)
+		    digest.add(ibits.data(), ibits.size() * sizeof(int16_t));
+	    }
+	    timer.stop();
+	    iqBuffer.FlushRingBuffer();
+	}
+    r.samples = int64_t(c.passes) * frames * (T_u + (L - 1) * T_s);
+    r.frames = int64_t(c.passes) * frames;
+    r.digest = digest.value();
+}
+
+//	the FIC blocks: 4 per frame, 768 bits each
+static
+void benchViterbi(benchContext &c, benchResult &r) {
+    const int frameBits = 768;
+    const int softBits = (frameBits + 6) * 4;
+    std::vector<int16_t> soft;
+    std::vector<uint8_t> bits;
+    std::vector<uint8_t> out(frameBits);
+    viterbiSpiral viterbi(frameBits, true);
+    benchDigest digest;
+    benchTimer timer(r);
+    int64_t errors = 0;
+    int32_t blocks;
+
+    if (!readVector(c, "viterbi", soft)) {
+	benchRandom random(BENCH_SEED);
+	std::vector<uint8_t> block(frameBits);
+	std::vector<int16_t> encoded;
+
+	blocks = 4 * c.frames;
+	for (int32_t b = 0; b < blocks; b++) {
+	    for (int i = 0; i < frameBits; i++)
+		block[i] = random.next() >> 31;
+	    convolve(block, encoded, 3, random);
+	    bits.insert(bits.end(), block.begin(), block.end());
+	    soft.insert(soft.end(), encoded.begin(), encoded.end());
+	}
+    }
+    writeVector(c, "viterbi", soft);
+    blocks = soft.size() / softBits;
+    for (int pass = 0; pass < c.passes; pass++)
+	for (int32_t b = 0; b < blocks; b++) {
+	    timer.start();
+	    viterbi.deconvolve(&soft[b * softBits], out.data());
+	    timer.stop();
+	    if (pass > 0)
+		continue;
+	    digest.add(out.data(), frameBits);
+	    if (bits.size() > 0)
+		for (int i = 0; i < frameBits; i++)
+		    errors += out[i] != bits[b * frameBits + i];
+	}
+    r.samples = int64_t(c.passes) * blocks * softBits;
+    r.frames = int64_t(c.passes) * blocks;
+    r.digest = digest.value();
+    if (bits.size() > 0)
+	r.note = QString("bit errors %1").arg(errors);
+}
+
+//	the DAB+ outer code, a superframe of RSDims codewords at a time
+static
+void benchRs(benchContext &c, benchResult &r) {
+    const int16_t RSDims = BENCH_BITRATE / 8;
+    std::vector<uint8_t> in;
+    uint8_t out[110];
+    reedSolomon rs(8, 0435, 0, 1, 10);
+    benchDigest digest;
+    benchTimer timer(r);
+    int64_t corrections = 0;
+    int64_t failures = 0;
+    int32_t codewords;
+
+    if (!readVector(c, "rs", in)) {
+	benchRandom random(BENCH_SEED);
+	uint8_t data[120] = { 0 };
+	uint8_t codeword[120];
+
+	codewords = RSDims * std::max(1, c.frames / 5);
+	for (int32_t w = 0; w < codewords; w++) {
+	    for (int i = 0; i < 110; i++)
+		data[i] = random.byte();
+	    rs.enc(data, codeword, 135);
+	    for (int e = (w % 6) - 1; e >= 0; e--)
+		codeword[random.next() % 120] ^= random.byte() | 1;
+	    in.insert(in.end(), codeword, codeword + 120);
+	}
+    }
+    writeVector(c, "rs", in);
+    codewords = in.size() / 120;
+    for (int pass = 0; pass < c.passes; pass++)
+	for (int32_t w = 0; w < codewords; w++) {
+	    timer.start();
+	    int16_t ler = rs.dec(&in[w * 120], out, 135);
+	    timer.stop();
+	    if (pass > 0)
+		continue;
+	    digest.add(ler);
+	    digest.add(out, sizeof(out));
+	    if (ler < 0)
+		failures++;
+	    else
+		corrections += ler;
+	}
+    r.samples = int64_t(c.passes) * codewords * 120;
+    r.frames = int64_t(c.passes) * codewords / RSDims;
+    r.digest = digest.value();
+    r.note = QString("corrected %1 failed %2").arg(corrections).arg(failures);
+}
+
+//	the packet CRC, on the largest packets there are
+#define CRC_PACKET	96
+
+static
+void benchCrc(benchContext &c, benchResult &r) {
+    std::vector<uint8_t> in;
+    benchDigest digest;
+    benchTimer timer(r);
+    int64_t good = 0;
+    int32_t packets;
+
+    if (!readVector(c, "crc", in)) {
+	benchRandom random(BENCH_SEED);
+	uint8_t packet[CRC_PACKET];
+
+	packets = 256 * std::max(1, c.frames);
+	for (int32_t p = 0; p < packets; p++) {
+	    for (int i = 0; i < CRC_PACKET - 2; i++)
+		packet[i] = random.byte();
+	    uint16_t crc = ~crc16(packet, CRC_PACKET - 2);
+	    packet[CRC_PACKET - 2] = crc >> 8;
+	    packet[CRC_PACKET - 1] = crc & 0xFF;
+	    if (p % 4 == 3)
+		packet[random.next() % CRC_PACKET] ^= random.byte() | 1;
+	    in.insert(in.end(), packet, packet + CRC_PACKET);
+	}
+    }
+    writeVector(c, "crc", in);
+    packets = in.size() / CRC_PACKET;
+    for (int pass = 0; pass < c.passes; pass++)
+	for (int32_t p = 0; p < packets; p++) {
+	    timer.start();
+	    bool ok = check_crc16(&in[p * CRC_PACKET], CRC_PACKET - 2);
+	    timer.stop();
+	    if (pass > 0)
+		continue;
+	    digest.add(ok);
+	    good += ok;
+	}
+    r.samples = int64_t(c.passes) * packets * CRC_PACKET;
+    r.frames = int64_t(c.passes) * packets;
+    r.digest = digest.value();
+    r.note = QString("good %1 of %2").arg(good).arg(packets);
+}
+
+//	whole superframes through the mp4 processor: firecode, RS, AU CRCs
+//	and the AAC decoder. The synthetic AUs are not valid AAC, so for
+//	these it is the decoder's error path that is measured
+static
+void benchMp4(benchContext &c, benchResult &r) {
+    const int32_t frameBits = 24 * BENCH_BITRATE;
+    std::vector<uint8_t> in;
+    std::vector<uint8_t> frame(frameBits);
+    RingBuffer<int16_t> audioBuffer(8 * 32768);
+    benchDigest digest;
+    benchTimer timer(r);
+    int64_t audio = 0;
+    int32_t frames;
+
+    if (!readVector(c, "mp4", in)) {
+	benchRandom random(BENCH_SEED);
+	std::vector<uint8_t> superframe[5];
+
+	for (int s = 0; s < std::max(1, c.frames / 5); s++) {
+	    dabPlusSuperframe(BENCH_BITRATE, BENCH_RS_ERRORS, superframe, random);
+	    for (int f = 0; f < 5; f++)
+		in.insert(in.end(), superframe[f].begin(), superframe[f].end());
+	}
+    }
+    writeVector(c, "mp4", in);
+    frames = in.size() / frameBits;
+    for (int pass = 0; pass < c.passes; pass++) {
+	RadioInterface radioInterface;
+	benchAudio sink;
+	mp4Processor processor(&radioInterface, BENCH_BITRATE, &audioBuffer,
+			       nullptr, __ONLY_SOUND);
+
+	radioInterface.audioBuffer = &audioBuffer;
+	radioInterface.soundOut = &sink;
+	audioBuffer.FlushRingBuffer();
+	for (int32_t f = 0; f < frames; f++) {
+	    frame.assign(in.begin() + f * frameBits, in.begin() + (f + 1) * frameBits);
+	    timer.start();
+	    processor.addtoFrame(frame);
+	    timer.stop();
+	}
+	if (pass == 0) {
+	    digest.add(sink.digest.value());
+	    digest.add(radioInterface.events.value());
+	    audio = sink.samples;
+	}
+    }
+    r.samples = int64_t(c.passes) * frames * frameBits;
+    r.frames = int64_t(c.passes) * frames / 5;
+    r.digest = digest.value();
+    r.note = QString("audio %1").arg(audio);
+}
+
+//	like the DAB input, made once, so that a stage run again sees
+//	the very same samples
+static
+const std::vector<std::complex<float>> &fmInput(benchContext &c) {
+    static std::vector<std::complex<float>> iq;
+    static bool made = false;
+
+    if (!made) {
+	if (c.fmRecording.size() > 0)
+	    iq.swap(c.fmRecording);
+	else if (!readVector(c, "fm", iq)) {
+	    benchRandom random(BENCH_SEED);
+	    std::vector<uint8_t> rds;
+
+	    rdsBits(0x5A5A, "GUGLIELM", 4096, rds);
+	    fmSignal(rds, INPUT_RATE, c.frames * dabParams(1).get_T_F(), 30, iq, random);
+	}
+	writeVector(c, "fm", iq);
+
+	// the processor only takes whole buffers
+	iq.resize(iq.size() - iq.size() % 16384);
+	made = true;
+    }
+    return iq;
+}
+
+//	the whole of the FM chain, from IQ at INPUT_RATE to audio and RDS,
+//	with the processor's own thread consuming the vector as fast as
+//	it can
+static
+void benchFm(benchContext &c, benchResult &r) {
+    const std::vector<std::complex<float>> &iq = fmInput(c);
+    benchDigest digest;
+    benchTimer timer(r);
+    int64_t audio = 0;
+    int events = 0;
+
+    for (int pass = 0; pass < c.passes; pass++) {
+	RadioInterface radioInterface;
+	benchAudio sink;
+	benchDevice device(iq);
+	fmProcessor processor(&device, &radioInterface, INPUT_RATE, BENCH_FM_RATE,
+			      BENCH_AUDIO_RATE, BENCH_AUDIO_RATE,
+			      QString(FM_DEF_THRESHOLD).toInt());
+
+	processor.setSink(&sink);
+	processor.setFMRDSSelector(rdsDecoder::RDS1, false);
+	processor.setFMRDSDemod(fmProcessor::FM_RDS_AUTO);
+	processor.setFMMode(true);
+	processor.setBandwidth(KHz(QString(FM_DEF_FILTER).toInt()));
+	processor.setFMDecoder(fmDemodulator::fm_demod(QString(FM_DEF_DECODER).toInt()));
+	processor.setDeemphasis(QString(FM_DEF_DEEMPHASIS).toInt());
+	processor.setAudioBandwidth(QString(FM_DEF_LOW_PASS_FILTER).toInt());
+	processor.setAudioGain(QString(FM_DEF_AUDIO_GAIN).toInt());
+	device.restartReader(0);
+	timer.start();
+	processor.start();
+	while (!device.finished())
+	    usleep(100);
+	timer.stop();
+	processor.stop();
+
+	// the processor's signals are queued
+	QCoreApplication::processEvents();
+	if (pass == 0) {
+	    digest.add(sink.digest.value());
+	    digest.add(radioInterface.events.value());
+	    audio = sink.samples;
+	    events = radioInterface.eventCount;
+	}
+    }
+    r.samples = int64_t(c.passes) * iq.size();
+    r.frames = int64_t(c.passes) * iq.size() / 16384;
+    r.digest = digest.value();
+    r.note = QString("audio %1 events %2").arg(audio).arg(events);
+}
+
+//	the RDS bit and group decoders, on the mixed down subcarrier
+static
+void benchRds(benchContext &c, benchResult &r) {
+    std::vector<float> in;
+    trigTabs tables(BENCH_FM_RATE);
+    benchDigest digest;
+    benchTimer timer(r);
+    int events = 0;
+
+    if (!readVector(c, "rds", in)) {
+	benchRandom random(BENCH_SEED);
+	std::vector<uint8_t> rds;
+
+	rdsBits(0x5A5A, "GUGLIELM", 4096, rds);
+	rdsSignal(rds, BENCH_RDS_RATE, c.frames * BENCH_RDS_RATE * 96 / 1000,
+		  0.3, in, random);
+    }
+    writeVector(c, "rds", in);
+    for (int pass = 0; pass < c.passes; pass++)
+	for (int mode = rdsDecoder::RDS1; mode <= rdsDecoder::RDS2; mode++) {
+	    RadioInterface radioInterface;
+	    rdsDecoder decoder(&radioInterface, false, BENCH_RDS_RATE, &tables);
+
+	    timer.start();
+	    for (float v: in)
+		decoder.doDecode(v, rdsDecoder::RdsMode(mode));
+	    timer.stop();
+	    if (pass == 0) {
+		digest.add(radioInterface.events.value());
+		events += radioInterface.eventCount;
+	    }
+	}
+
+    // one frame per group's worth of samples
+    r.samples = int64_t(c.passes) * 2 * in.size();
+    r.frames = r.samples * 1187.5 / 104 / BENCH_RDS_RATE;
+    r.digest = digest.value();
+    r.note = QString("events %1").arg(events);
+}
+
+static const struct {
+    const char *name;
+    void (*run)(benchContext &, benchResult &);
+} stages[] = {
+    { "sync",		benchSync },
+    { "ofdm",		benchOfdm },
+    { "viterbi",	benchViterbi },
+    { "rs",		benchRs },
+    { "crc",		benchCrc },
+    { "mp4",		benchMp4 },
+    { "fm",		benchFm },
+    { "rds",		benchRds },
+};
+
+//	recordings go through the same file device as the receiver's
+static
+bool loadRecording(const QString &name, fileHandler::fileFormat format,
+		   int bits, int frames, std::vector<std::complex<float>> &v) {
+    int64_t wanted = int64_t(frames + 1) * dabParams(1).get_T_F();
+    agcStats stats;
+    int idle = 0;
+    fileHandler *device;
+
+    try {
+	device = new fileHandler(name, format, bits, false, false);
+    } catch (int e) {
+	fprintf(stderr, "could not open %s\n", qPrintable(name));
+	return false;
+    }
+    device->restartReader(0);
+    v.resize(wanted);
+    int64_t size = 0;
+    while (size < wanted && idle < 100) {
+	int32_t amount = std::min(int64_t(device->Samples()), wanted - size);
+
+	if (amount == 0) {
+	    idle++;
+	    usleep(10000);
+	    continue;
+	}
+	idle = 0;
+	size += device->getSamples(&v[size], amount, &stats);
+    }
+    device->stopReader();
+    delete device;
+    v.resize(size);
+    return size > 0;
+}
+
+static
+QMap<QString, QString> readGolden(const QString &name) {
+    QMap<QString, QString> golden;
+    QFile file(name);
+
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+	QTextStream in(&file);
+
+	while (!in.atEnd()) {
+	    QStringList f = in.readLine().simplified().split(' ');
+
+	    if (f.size() == 2 && !f[0].startsWith("#"))
+		golden[f[0]] = f[1];
+	}
+    }
+    return golden;
+}
+
+static
+void usage(const char *name) {
+    fprintf(stderr, "usage: %s [-s <stage>[,<stage>...]][-n <passes>][-N <frames>]"
+		    "[-f <DAB IQ file>][-m <FM IQ file>][-F wav|cu8|cs16|cf32][-b <bits>]"
+		    "[-r <vector directory> [-w]][-g <golden file> [-G]][-d <debug level>][-v]"
+		    "|-l|-h]\n", name);
+}
+
+int main(int argc, char **argv) {
+    benchContext context;
+    QStringList selected;
+    QString dabFile;
+    QString fmFile;
+    fileHandler::fileFormat iqFormat = fileHandler::FILE_AUTO;
+    int iqBits = 16;
+    QString goldenFile;
+    bool writeGolden = false;
+    QMap<QString, QString> golden;
+    int mismatches = 0;
+    int unstable = 0;
+    int opt;
+
+    context.passes = BENCH_PASSES;
+    context.frames = BENCH_FRAMES;
+    context.writeVectors = false;
+    while ((opt = getopt(argc, argv, "b:d:f:F:g:Ghlm:n:N:r:s:vw")) != -1)
+	switch (opt) {
+	case 'b':
+	    iqBits = atoi(optarg);
+	    break;
+	case 'd':
+	    setLogMask(QString(optarg).toLongLong(NULL, 0));
+	    break;
+	case 'f':
+	    dabFile = optarg;
+	    break;
+	case 'F':
+	    iqFormat = fileHandler::formatFor(optarg);
+	    if (iqFormat == fileHandler::FILE_AUTO) {
+		fprintf(stderr, "unknown IQ format %s\n", optarg);
+		exit(1);
+	    }
+	    break;
+	case 'g':
+	    goldenFile = optarg;
+	    break;
+	case 'G':
+	    writeGolden = true;
+	    break;
+	case 'l':
+	    for (auto &s: stages)
+		printf("%s\n", s.name);
+	    exit(0);
+	case 'm':
+	    fmFile = optarg;
+	    break;
+	case 'n':
+	    context.passes = std::max(1, atoi(optarg));
+	    break;
+	case 'N':
+	    context.frames = std::max(5, atoi(optarg));
+	    break;
+	case 'r':
+	    context.vectorDir = optarg;
+	    break;
+	case 's':
+	    selected = QString(optarg).split(',');
+	    break;
+	case 'v':
+	    incLogVerbosity();
+	    break;
+	case 'w':
+	    context.writeVectors = true;
+	    break;
+	case 'h':
+	    usage(argv[0]);
+	    exit(0);
+	default:
+	    usage(argv[0]);
+	    exit(1);
+	}
+
+    QCoreApplication a(argc, argv);
+    if (context.writeVectors && context.vectorDir != "" && !QDir().mkpath(context.vectorDir)) {
+	fprintf(stderr, "could not create %s\n", qPrintable(context.vectorDir));
+	exit(1);
+    }
+    if (dabFile != "" &&
+	!loadRecording(dabFile, iqFormat, iqBits, context.frames, context.dabRecording))
+	exit(1);
+    if (fmFile != "" &&
+	!loadRecording(fmFile, iqFormat, iqBits, context.frames, context.fmRecording))
+	exit(1);
+    if (goldenFile != "" && !writeGolden)
+	golden = readGolden(goldenFile);
+
+    printf("%-8s %12s %12s %12s  %-16s %s\n", "stage", "ns/sample", "frames/s",
+	   "allocs/frame", "digest", "");
+    QStringList lines;
+    for (auto &s: stages) {
+	benchResult r;
+	QString digest;
+	QString status;
+
+	if (selected.size() > 0 && !selected.contains(s.name))
+	    continue;
+	s.run(context, r);
+	digest = QString("%1").arg(r.digest, 16, 16, QChar('0'));
+
+	// no golden digests are shipped, so at the very least a second,
+	// untimed, run from fresh state has to come up with the same one
+	benchResult check;
+	int passes = context.passes;
+	context.passes = 1;
+	s.run(context, check);
+	context.passes = passes;
+	if (check.digest != r.digest) {
+	    status = "UNSTABLE";
+	    unstable++;
+	} else {
+	    lines << QString("%1 %2").arg(s.name).arg(digest);
+	    if (golden.contains(s.name)) {
+		if (golden[s.name] == digest)
+		    status = "ok";
+		else {
+		    status = "MISMATCH";
+		    mismatches++;
+		}
+	    }
+	}
+	printf("%-8s %12.3f %12.1f %12.2f  %s %s %s\n", s.name,
+	       r.samples > 0? double(r.nanos) / r.samples: 0,
+	       r.nanos > 0? r.frames * 1e9 / r.nanos: 0,
+	       r.frames > 0? double(r.allocations) / r.frames: 0,
+	       qPrintable(digest), qPrintable(status), qPrintable(r.note));
+	fflush(stdout);
+    }
+
+    if (goldenFile != "" && writeGolden) {
+	QFile file(goldenFile);
+
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+	    fprintf(stderr, "could not write %s\n", qPrintable(goldenFile));
+	    exit(1);
+	}
+	QTextStream out(&file);
+	out << "# " << TARGET << " " << CURRENT_VERSION << " bench digests\n";
+	for (auto &l: lines)
+	    out << l << "\n";
+    }
+    if (unstable > 0)
+	fprintf(stderr, "%i stage(s) do not repeat their own digest\n", unstable);
+    if (mismatches > 0)
+	fprintf(stderr, "%i stage(s) do not match %s\n", mismatches, qPrintable(goldenFile));
+    return unstable > 0 || mismatches > 0? 1: 0;
+}
@@ -0,0 +1,117 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+//	The benchmark's counterparts of the receiver.
+//	The processors only know the RadioInterface by name: with
+//	BENCHMARK, radio.h pulls in this one, which records what the
+//	processors report into a digest rather than showing it.
+//	The device replays a vector from memory, as fast as it is asked.
+#include "radio.h"
+#include "audio-base.h"
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <vector>
+
+//	64 bit FNV-1a, for bit exact comparisons against golden digests
+class benchDigest {
+public:
+    benchDigest() { reset(); }
+    void reset() { hash = 14695981039346656037ULL; }
+    void add(const void *data, size_t size) {
+	const uint8_t *p = (const uint8_t *) data;
+
+	for (size_t i = 0; i < size; i++)
+	    hash = (hash ^ p[i]) * 1099511628211ULL;
+    }
+    template <class T> void add(const T &v) { add(&v, sizeof(T)); }
+    void add(const QString &s) { QByteArray b = s.toUtf8(); add(b.constData(), b.size()); }
+    uint64_t value() const { return hash; }
+
+private:
+    uint64_t hash;
+};
+
+class RadioInterface: public QObject {
+Q_OBJECT
+public:
+    RadioInterface(QObject *parent = nullptr);
+    ~RadioInterface();
+
+    benchDigest events;
+    int eventCount;
+
+    // where the audio decoders leave their output, and where it goes
+    RingBuffer<int16_t> *audioBuffer;
+    audioBase *soundOut;
+
+public slots:
+    void addToEnsemble(const QString &, uint);
+    void nameOfEnsemble(int, const QString &);
+    void ensembleLoaded(int);
+    void timeSynced();
+    void showQuality(bool);
+    void showStrength(float);
+    void showLabel(QString);
+    void showPiCode(int, int);
+    void showText(QString);
+    void showSoundMode(bool);
+    void handleMotObject(QByteArray, QString, int, bool);
+    void changeInConfiguration();
+    void newAudio(int, int);
+    void scanDone();
+    void scanFound();
+};
+
+//	serves the vector in BUFFER sized chunks, and flags when the
+//	consumer came back for more after the last one
+class benchDevice: public deviceHandler {
+public:
+    benchDevice(const std::vector<std::complex<float>> &);
+    ~benchDevice(void);
+    bool restartReader(int32_t);
+    void stopReader(void);
+    int32_t getSamples(std::complex<float> *, int32_t, agcStats *);
+    int32_t Samples(void);
+    bool finished(void);
+
+private:
+    const std::vector<std::complex<float>> &samples;
+    std::atomic<int64_t> position;
+    std::atomic<bool> drained;
+};
+
+//	collects the output audio into a digest
+class benchAudio: public audioBase {
+public:
+    benchAudio(void);
+    ~benchAudio(void);
+
+    benchDigest digest;
+    int64_t samples;
+
+protected:
+    void audioOutput(float *, int32_t);
+};
+#endif // BENCH_H
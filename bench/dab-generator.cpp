@@ -0,0 +1,377 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "dab-generator.h"
+#include "eep-protection.h"
+#include "uep-protection.h"
+#include "protTables.h"
+#include "fib-table.h"
+#include "logging.h"
+#include <cmath>
+#include <cstring>
+
+//	the receiver's time deinterleaver, see Backend::processSegment
+static const int16_t interleaveMap[] = { 0, 8, 4, 12, 2, 10, 6, 14,
+					 1, 9, 5, 13, 3, 11, 7, 15 };
+
+//	the 9 bit energy dispersal register, started with all ones
+static
+void prbs(std::vector<uint8_t> &out, int32_t length) {
+    uint8_t shiftRegister[9];
+
+    memset(shiftRegister, 1, 9);
+    out.resize(length);
+    for (int32_t i = 0; i < length; i++) {
+	uint8_t b = shiftRegister[8] ^ shiftRegister[4];
+	for (int j = 8; j > 0; j--)
+	    shiftRegister[j] = shiftRegister[j - 1];
+	shiftRegister[0] = b;
+	out[i] = b;
+    }
+}
+
+dabGenerator::dabGenerator(uint16_t EId, const std::string &label,
+			   float snr, uint64_t seed)
+    : params(1), table(1), fft(1), mapper(&params), random(seed) {
+    this->EId = EId;
+    this->label = label;
+    noise = pow(10, -snr / 20) * M_SQRT1_2;
+    nextCU = 0;
+    CIFcount = 0;
+    nextFig = 0;
+
+    prbs(ficPRBS, 768);
+
+    // the FIC puncturing, as in the ficHandler: 21 blocks with PI 16,
+    // 3 with PI 15 and the 24 tail bits with PI_X
+    ficPuncturing.resize(3072 + 24);
+    for (int i = 0; i < 3072 + 24; i++) {
+	if (i < 21 * 128)
+	    ficPuncturing[i] = get_PCodes(16 - 1)[i % 32] != 0;
+	else if (i < 24 * 128)
+	    ficPuncturing[i] = get_PCodes(15 - 1)[i % 32] != 0;
+	else
+	    ficPuncturing[i] = get_PCodes(8 - 1)[i - 3072] != 0;
+    }
+
+    bits.resize(768);
+    coded.resize((768 + 6) * 4);
+    frameBits.resize((params.get_L() - 1) * 2 * params.get_carriers());
+    carriers.resize(params.get_T_u());
+    buildFigs();
+}
+
+dabGenerator::~dabGenerator() {
+    for (auto sc: subChannels) {
+	delete sc->puncturer;
+	delete sc;
+    }
+}
+
+bool dabGenerator::addService(const std::string &label, int16_t bitRate,
+			      int16_t protLevel, bool shortForm) {
+    static const int table_1[] = { 12, 8, 6, 4 };
+    static const int table_2[] = { 27, 21, 18, 15 };
+    int16_t length = 0;
+    int16_t tableIndex = -1;
+
+    if (subChannels.size() >= 64 || bitRate <= 0 || bitRate % 8 != 0)
+	return false;
+    if (shortForm) {
+	for (int i = 0; i < 64; i++)
+	    if (ProtLevel[i][2] == bitRate && ProtLevel[i][1] == protLevel) {
+		tableIndex = i;
+		length = ProtLevel[i][0];
+		break;
+	    }
+	if (tableIndex < 0)
+	    return false;
+    } else if (protLevel >= 0 && protLevel < 4)
+	length = bitRate * table_1[protLevel] / 8;
+    else if (protLevel >= 4 && protLevel < 8 && bitRate % 32 == 0)
+	length = bitRate / 32 * table_2[protLevel & 03];
+    else
+	return false;
+    if (nextCU + length > CIF_CUS)
+	return false;
+
+    subChannel *sc = new subChannel;
+    sc->label = label;
+    sc->SId = (EId & 0xf000) | (subChannels.size() + 1);
+    sc->subChId = subChannels.size();
+    sc->startAddr = nextCU;
+    sc->length = length;
+    sc->bitRate = bitRate;
+    sc->protLevel = protLevel;
+    sc->shortForm = shortForm;
+    sc->tableIndex = tableIndex;
+    if (shortForm)
+	sc->puncturer = new uep_protection(bitRate, protLevel);
+    else
+	sc->puncturer = new eep_protection(bitRate, protLevel);
+
+    // some uep profiles leave a few padding bits at the end, but
+    // the table does not cover every subchannel size
+    int32_t kept = 0;
+    for (auto b: sc->puncturer->puncturing())
+	kept += b;
+    if (kept > length * CU_BITS) {
+	log(LOG_DAB, LOG_MIN, "no puncturing for %i kbit/s, level %i",
+	    bitRate, protLevel);
+	delete sc->puncturer;
+	delete sc;
+	return false;
+    }
+
+    sc->nextFrame = 5;
+    for (int i = 0; i < 16; i++)
+	sc->history[i].assign(length * CU_BITS, 0);
+    sc->historyIndex = 0;
+    subChannels.push_back(sc);
+    nextCU += length;
+
+    if ((int32_t) mscPRBS.size() < 24 * bitRate)
+	prbs(mscPRBS, 24 * bitRate);
+    if (bits.size() < mscPRBS.size()) {
+	bits.resize(mscPRBS.size());
+	coded.resize((mscPRBS.size() + 6) * 4);
+    }
+    buildFigs();
+    return true;
+}
+
+//	FIG 1/0 and 1/1: charset, EId or SId, 16 characters and the
+//	short label flags
+static
+std::vector<uint8_t> labelFig(uint8_t extension, uint16_t id,
+			      const std::string &label) {
+    std::vector<uint8_t> fig(22, ' ');
+
+    fig[0] = (1 << 5) | 21;
+    fig[1] = extension;
+    fig[2] = id >> 8;
+    fig[3] = id & 0xff;
+    memcpy(&fig[4], label.data(), label.size() < 16? label.size(): 16);
+    fig[20] = 0xff;
+    fig[21] = 0x00;
+    return fig;
+}
+
+//	the carousel of FIGs that the FIBs cycle through: FIG 0/0 goes
+//	at the start of each FIC block instead, as it carries the CIF count
+void dabGenerator::buildFigs() {
+    std::vector<uint8_t> fig;
+
+    figs.clear();
+    nextFig = 0;
+
+    // subchannel organization, FIG 0/1, leaving room for FIG 0/0
+    for (auto sc: subChannels) {
+	int size = sc->shortForm? 3: 4;
+
+	if (fig.size() + size > 24) {
+	    figs.push_back(fig);
+	    fig.clear();
+	}
+	if (fig.empty()) {
+	    fig.push_back(0);
+	    fig.push_back(1);
+	}
+	fig.push_back((sc->subChId << 2) | (sc->startAddr >> 8));
+	fig.push_back(sc->startAddr & 0xff);
+	if (sc->shortForm)
+	    fig.push_back(sc->tableIndex);
+	else {
+	    fig.push_back(0x80 | ((sc->protLevel >> 2) << 4) |
+			  ((sc->protLevel & 03) << 2) | (sc->length >> 8));
+	    fig.push_back(sc->length & 0xff);
+	}
+	fig[0] = fig.size() - 1;
+    }
+    if (!fig.empty())
+	figs.push_back(fig);
+    fig.clear();
+
+    // basic service organization, FIG 0/2, one DAB+ component each
+    for (auto sc: subChannels) {
+	if (fig.size() + 5 > 24) {
+	    figs.push_back(fig);
+	    fig.clear();
+	}
+	if (fig.empty()) {
+	    fig.push_back(0);
+	    fig.push_back(2);
+	}
+	fig.push_back(sc->SId >> 8);
+	fig.push_back(sc->SId & 0xff);
+	fig.push_back(1);
+	fig.push_back(63);
+	fig.push_back((sc->subChId << 2) | 0x02);
+	fig[0] = fig.size() - 1;
+    }
+    if (!fig.empty())
+	figs.push_back(fig);
+
+    figs.push_back(labelFig(0, EId, label));
+    for (auto sc: subChannels)
+	figs.push_back(labelFig(1, sc->SId, sc->label));
+}
+
+//	one FIB: FIG 0/0 first if asked for, as many FIGs as fit, the end
+//	marker and the inverted CRC
+void dabGenerator::fib(uint8_t *out, bool ensembleInfo) {
+    int16_t used = 0;
+
+    memset(out, 0, 32);
+    if (ensembleInfo) {
+	out[used++] = 5;
+	out[used++] = 0;
+	out[used++] = EId >> 8;
+	out[used++] = EId & 0xff;
+	out[used++] = (CIFcount / 250) % 20;
+	out[used++] = CIFcount % 250;
+    }
+    for (size_t n = 0; n < figs.size(); n++) {
+	const std::vector<uint8_t> &fig = figs[nextFig];
+
+	if (used + (int16_t) fig.size() > 30)
+	    break;
+	memcpy(&out[used], fig.data(), fig.size());
+	used += fig.size();
+	nextFig = (nextFig + 1) % figs.size();
+    }
+    if (used < 30)
+	out[used] = 0xff;
+
+    uint16_t crc = ~crc16(out, 30);
+    out[30] = crc >> 8;
+    out[31] = crc & 0xff;
+}
+
+//	one FIC block, 3 FIBs, dispersed, convolved and punctured to 2304 bits
+void dabGenerator::fic(uint8_t *out) {
+    uint8_t fibs[3 * 32];
+
+    for (int i = 0; i < 3; i++)
+	fib(&fibs[i * 32], i == 0);
+    for (int i = 0; i < 768; i++)
+	bits[i] = ((fibs[i / 8] >> (7 - (i & 7))) & 1) ^ ficPRBS[i];
+    encode(bits.data(), 768, coded.data());
+    puncture(ficPuncturing, 3072 + 24, out);
+}
+
+//	one logical frame of a subchannel into its place in the CIF
+void dabGenerator::msc(subChannel *sc, uint8_t *out) {
+    int32_t frameBits = 24 * sc->bitRate;
+    int32_t fragmentSize = sc->length * CU_BITS;
+
+    if (sc->nextFrame == 5) {
+	dabPlusSuperframe(sc->bitRate, 0, sc->frames, random);
+	sc->nextFrame = 0;
+    }
+    const std::vector<uint8_t> &frame = sc->frames[sc->nextFrame++];
+    for (int32_t i = 0; i < frameBits; i++)
+	bits[i] = frame[i] ^ mscPRBS[i];
+    encode(bits.data(), frameBits, coded.data());
+    puncture(sc->puncturer->puncturing(), frameBits * 4 + 24,
+	     sc->history[sc->historyIndex].data());
+
+    // bit i goes out interleaveMap [i & 15] CIFs late, so that after
+    // the receiver's deinterleaver all of them are 16 CIFs late
+    for (int32_t i = 0; i < fragmentSize; i++)
+	out[i] = sc->history[(sc->historyIndex -
+			      interleaveMap[i & 017]) & 017][i];
+    sc->historyIndex = (sc->historyIndex + 1) & 017;
+}
+
+void dabGenerator::puncture(const std::vector<uint8_t> &table,
+			    int32_t length, uint8_t *out) {
+    for (int32_t i = 0; i < length; i++)
+	if (table[i])
+	    *out++ = coded[i];
+}
+
+//	a block out of the bits for its carriers, differentially against
+//	the previous one, through the frequency interleaver
+void dabGenerator::symbol(std::complex<float> *out, const uint8_t *b) {
+    int16_t T_u = params.get_T_u();
+    int16_t T_g = params.get_T_g();
+    int16_t K = params.get_carriers();
+    std::complex<float> *v = fft.getVector();
+    float scale = 1.0 / sqrt(K);
+
+    if (b == nullptr)
+	for (int16_t k = -K / 2; k <= K / 2; k++) {
+	    if (k != 0)
+		carriers[(T_u + k) % T_u] = std::polar(1.0f, table.get_Phi(k));
+	}
+    else
+	for (int16_t i = 0; i < K; i++) {
+	    int16_t index = mapper.mapIn(i);
+
+	    if (index < 0)
+		index += T_u;
+	    carriers[index] *= std::complex<float>(b[i]? -M_SQRT1_2: M_SQRT1_2,
+						   b[K + i]? -M_SQRT1_2: M_SQRT1_2);
+	}
+    for (int16_t i = 0; i < T_u; i++)
+	v[i] = carriers[i] * scale;
+    fft.do_IFFT();
+    memcpy(out, &v[T_u - T_g], T_g * sizeof(std::complex<float>));
+    memcpy(&out[T_g], v, T_u * sizeof(std::complex<float>));
+}
+
+void dabGenerator::addNoise(std::complex<float> *out, int32_t length) {
+    for (int32_t i = 0; i < length; i++)
+	out[i] += std::complex<float>(random.gaussian(),
+				      random.gaussian()) * noise;
+}
+
+void dabGenerator::nextFrame(std::complex<float> *out) {
+    int32_t blockBits = 2 * params.get_carriers();
+    int32_t ficBits = 3 * blockBits;
+    int32_t cifBits = CIF_CUS * CU_BITS;
+    int32_t T_s = params.get_T_s();
+    int32_t T_null = params.get_T_null();
+
+    // unused capacity carries whatever
+    for (size_t i = 0; i < frameBits.size(); i += 32) {
+	uint32_t r = random.next();
+
+	for (size_t j = i; j < i + 32 && j < frameBits.size(); j++, r >>= 1)
+	    frameBits[j] = r & 1;
+    }
+
+    // Mode I: 4 CIFs per frame, the FIC blocks in the first 3 symbols
+    for (int c = 0; c < 4; c++) {
+	fic(&frameBits[c * ficBits / 4]);
+	for (auto sc: subChannels)
+	    msc(sc, &frameBits[ficBits + c * cifBits +
+			       sc->startAddr * CU_BITS]);
+	CIFcount = (CIFcount + 1) % 5000;
+    }
+
+    memset((void *) out, 0, T_null * sizeof(std::complex<float>));
+    symbol(&out[T_null], nullptr);
+    for (int l = 1; l < params.get_L(); l++)
+	symbol(&out[T_null + l * T_s], &frameBits[(l - 1) * blockBits]);
+    addNoise(out, params.get_T_F());
+}
@@ -0,0 +1,111 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DAB_GENERATOR_H
+#define DAB_GENERATOR_H
+
+//	A local DAB ensemble, Mode I, for load testing the receiver.
+//	The receiver's building blocks run backwards: FIGs into CRC'd FIBs,
+//	DAB+ superframes through energy dispersal, the mother code and the
+//	eep/uep puncturing, time interleaving, the frequency interleaver
+//	and the differential modulation against the phase reference
+#include <complex>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "bench-signals.h"
+#include "dab-params.h"
+#include "fft-handler.h"
+#include "phasetable.h"
+#include "freq-interleaver.h"
+
+class protection;
+
+class dabGenerator {
+public:
+    dabGenerator(uint16_t EId, const std::string &label, float snr,
+		 uint64_t seed);
+    ~dabGenerator();
+
+    //	protLevel is as in the subchannel descriptors: 0 .. 3 for EEP 1A
+    //	to 4A, 4 .. 7 for 1B to 4B and, with shortForm, 1 .. 5 for UEP.
+    //	Fails if the profile does not exist or the CIF is full
+    bool	addService(const std::string &label, int16_t bitRate,
+		   int16_t protLevel, bool shortForm);
+    int16_t	services() { return subChannels.size(); }
+    int16_t	freeCUs() { return CIF_CUS - nextCU; }
+
+    //	one transmission frame, T_F samples of unit power signal plus noise
+    int32_t	frameSize() { return params.get_T_F(); }
+    void	nextFrame(std::complex<float> *);
+
+private:
+    static const int16_t CIF_CUS = 864;
+    static const int16_t CU_BITS = 64;
+
+    struct subChannel {
+	std::string	label;
+	uint16_t	SId;
+	int16_t		subChId;
+	int16_t		startAddr;
+	int16_t		length;
+	int16_t		bitRate;
+	int16_t		protLevel;
+	bool		shortForm;
+	int16_t		tableIndex;
+	protection	*puncturer;
+	std::vector<uint8_t>	frames[5];
+	int16_t		nextFrame;
+	std::vector<uint8_t>	history[16];
+	int16_t		historyIndex;
+    };
+
+    dabParams	params;
+    phaseTable	table;
+    fftHandler	fft;
+    interLeaver	mapper;
+    benchRandom	random;
+    uint16_t	EId;
+    std::string	label;
+    float	noise;
+    int16_t	nextCU;
+    uint16_t	CIFcount;
+    std::vector<subChannel *> subChannels;
+
+    std::vector<std::vector<uint8_t>> figs;
+    size_t	nextFig;
+    std::vector<uint8_t> ficPRBS;
+    std::vector<uint8_t> mscPRBS;
+    std::vector<uint8_t> ficPuncturing;
+    std::vector<uint8_t> bits;
+    std::vector<uint8_t> coded;
+    std::vector<uint8_t> frameBits;
+    std::vector<std::complex<float>> carriers;
+
+    void	buildFigs();
+    void	fib(uint8_t *, bool);
+    void	fic(uint8_t *);
+    void	msc(subChannel *, uint8_t *);
+    void	puncture(const std::vector<uint8_t> &, int32_t, uint8_t *);
+    void	symbol(std::complex<float> *, const uint8_t *);
+    void	addNoise(std::complex<float> *, int32_t);
+};
+#endif // DAB_GENERATOR_H
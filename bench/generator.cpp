@@ -0,0 +1,243 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+//	guglielmo-generator: writes a synthetic DAB ensemble, in any of the
+//	raw formats taken by the file input, for load testing the receiver
+#include <QString>
+#include <QStringList>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include "constants.h"
+#include "logger.h"
+#include "logging.h"
+#include "dab-generator.h"
+
+#define	GENERATOR_SEED		0x67756775
+#define	GENERATOR_FRAMES	100
+#define	GENERATOR_SNR		20
+
+enum iqFormat { IQ_CU8, IQ_CS16, IQ_CF32, IQ_UNKNOWN };
+
+//	as in fileHandler::formatFor, but for the raw formats only
+static
+iqFormat formatFor(const QString &s) {
+    QString f = s.toLower();
+
+    if (f == "cu8" || f == "u8" || f == "raw")
+	return IQ_CU8;
+    if (f == "cs16" || f == "s16")
+	return IQ_CS16;
+    if (f == "cf32" || f == "fc32" || f == "cfile")
+	return IQ_CF32;
+    return IQ_UNKNOWN;
+}
+
+//	<rate>A, <rate>B or U<level>, e.g. 3A, 1B, U3
+static
+bool parseProfile(const QString &s, int16_t &protLevel, bool &shortForm) {
+    QString p = s.toUpper();
+
+    if (p.size() != 2)
+	return false;
+    shortForm = p[0] == 'U';
+    if (shortForm) {
+	protLevel = p[1].digitValue();
+	return protLevel >= 1 && protLevel <= 5;
+    }
+    protLevel = p[0].digitValue() - 1;
+    if (protLevel < 0 || protLevel > 3)
+	return false;
+    if (p[1] == 'B')
+	protLevel += 1 << 2;
+    else if (p[1] != 'A')
+	return false;
+    return true;
+}
+
+//	unit power IQ scaled to a quarter of full scale for the integer
+//	formats, to leave headroom for the peaks
+static
+void writeFrame(FILE *f, iqFormat format, const std::vector<std::complex<float>> &v,
+		std::vector<uint8_t> &out) {
+    size_t n = v.size();
+
+    switch (format) {
+    case IQ_CU8:
+	out.resize(n * 2);
+	for (size_t i = 0; i < n; i++) {
+	    float re = 128 + 32 * real(v[i]);
+	    float im = 128 + 32 * imag(v[i]);
+
+	    out[2 * i] = re < 0? 0: re > UCHAR_MAX? UCHAR_MAX: uint8_t(re);
+	    out[2 * i + 1] = im < 0? 0: im > UCHAR_MAX? UCHAR_MAX: uint8_t(im);
+	}
+	break;
+    case IQ_CS16: {
+	out.resize(n * 2 * sizeof(int16_t));
+	int16_t *s = (int16_t *) out.data();
+
+	for (size_t i = 0; i < 2 * n; i++) {
+	    float x = 8192 * ((const float *) v.data())[i];
+
+	    s[i] = x < SHRT_MIN? SHRT_MIN: x > SHRT_MAX? SHRT_MAX: int16_t(x);
+	}
+	break;
+    }
+    default:
+	out.resize(n * sizeof(std::complex<float>));
+	memcpy(out.data(), v.data(), out.size());
+	break;
+    }
+    fwrite(out.data(), 1, out.size(), f);
+}
+
+static
+void usage(const char *name) {
+    fprintf(stderr, "usage: %s [-n <services>][-b <kbit/s>[,<kbit/s>...]]"
+		    "[-p <profile>[,<profile>...]][-S <snr dB>][-N <frames>]"
+		    "[-F cu8|cs16|cf32][-e <EId>][-l <ensemble label>][-r <seed>]"
+		    "[-d <debug level>][-v] <output file>|-\n"
+		    "profiles are 1A .. 4A, 1B .. 4B for EEP, U1 .. U5 for UEP\n", name);
+}
+
+int main(int argc, char **argv) {
+    int services = 1;
+    QStringList bitRates = { "64" };
+    QStringList profiles = { "3A" };
+    float snr = GENERATOR_SNR;
+    int frames = GENERATOR_FRAMES;
+    iqFormat format = IQ_UNKNOWN;
+    uint16_t EId = 0xe000;
+    QString label = "guglielmo";
+    uint64_t seed = GENERATOR_SEED;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:d:e:F:hl:n:N:p:r:S:v")) != -1)
+	switch (opt) {
+	case 'b':
+	    bitRates = QString(optarg).split(',');
+	    break;
+	case 'd':
+	    setLogMask(QString(optarg).toLongLong(NULL, 0));
+	    break;
+	case 'e':
+	    EId = QString(optarg).toUInt(NULL, 16);
+	    break;
+	case 'F':
+	    format = formatFor(optarg);
+	    if (format == IQ_UNKNOWN) {
+		fprintf(stderr, "unknown IQ format %s\n", optarg);
+		exit(1);
+	    }
+	    break;
+	case 'l':
+	    label = optarg;
+	    break;
+	case 'n':
+	    services = std::max(0, atoi(optarg));
+	    break;
+	case 'N':
+	    frames = std::max(1, atoi(optarg));
+	    break;
+	case 'p':
+	    profiles = QString(optarg).split(',');
+	    break;
+	case 'r':
+	    seed = QString(optarg).toULongLong(NULL, 0);
+	    break;
+	case 'S':
+	    snr = atof(optarg);
+	    break;
+	case 'v':
+	    incLogVerbosity();
+	    break;
+	case 'h':
+	    usage(argv[0]);
+	    exit(0);
+	default:
+	    usage(argv[0]);
+	    exit(1);
+	}
+    if (optind != argc - 1) {
+	usage(argv[0]);
+	exit(1);
+    }
+
+    QString name = argv[optind];
+    bool isPipe = name == "-";
+    if (format == IQ_UNKNOWN)
+	format = isPipe? IQ_CU8: formatFor(name.section('.', -1));
+    if (format == IQ_UNKNOWN) {
+	fprintf(stderr, "unknown format for %s, use -F\n", qPrintable(name));
+	exit(1);
+    }
+
+    dabGenerator generator(EId, label.toStdString(), snr, seed);
+
+    // bit rates and profiles are used in turn
+    for (int i = 0; i < services; i++) {
+	QString serviceLabel = QString("Service %1").arg(i + 1);
+	int16_t bitRate = bitRates[i % bitRates.size()].toShort();
+	int16_t protLevel;
+	bool shortForm;
+
+	if (!parseProfile(profiles[i % profiles.size()], protLevel, shortForm)) {
+	    fprintf(stderr, "invalid profile %s\n",
+		    qPrintable(profiles[i % profiles.size()]));
+	    exit(1);
+	}
+	if (!generator.addService(serviceLabel.toStdString(), bitRate,
+				  protLevel, shortForm)) {
+	    fprintf(stderr, "can't add service %i, %i kbit/s %s, %i CUs free\n",
+		    i + 1, bitRate, qPrintable(profiles[i % profiles.size()]),
+		    generator.freeCUs());
+	    exit(1);
+	}
+    }
+
+    FILE *f = isPipe? stdout: fopen(qPrintable(name), "wb");
+    if (f == nullptr) {
+	fprintf(stderr, "could not create %s\n", qPrintable(name));
+	exit(1);
+    }
+
+    std::vector<std::complex<float>> v(generator.frameSize());
+    std::vector<uint8_t> out;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++) {
+	generator.nextFrame(v.data());
+	writeFrame(f, format, v, out);
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() -
+						   start).count();
+    if (!isPipe)
+	fclose(f);
+
+    // 96ms per frame in Mode I
+    fprintf(stderr, "%i services, %i CUs free, %i frames, %.1fs of signal in %.1fs\n",
+	    generator.services(), generator.freeCUs(), frames, frames * 0.096, elapsed);
+    return 0;
+}
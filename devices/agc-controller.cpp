@@ -0,0 +1,201 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "agc-controller.h"
+#include "device-handler.h"
+#include "logging.h"
+
+agcController::agcController(deviceHandler *device) {
+    this->device = device;
+    enabled.store(false);
+    running.store(false);
+    synced.store(false);
+    waiting.store(false);
+    frameLength.store(0);
+    nullLength.store(0);
+    range.store(1);
+    for (auto &b: histogram)
+	b.store(0);
+    overflows.store(0);
+    samples.store(0);
+    gain = 0;
+    minGain = 0;
+    maxGain = 0;
+    minSignal = 0;
+    maxSignal = 0;
+    settle = 0;
+    raises = 0;
+}
+
+agcController::~agcController(void) {
+    stop();
+}
+
+void agcController::configure(bool enabled, int gain, int minGain, int maxGain) {
+    stop();
+    this->gain = gain;
+    this->minGain = minGain;
+    this->maxGain = maxGain;
+    device->getSwAGCRange(&minSignal, &maxSignal);
+    minSignal = (int64_t) minSignal * AGC_SPAN_SCALE / 100;
+    maxSignal = (int64_t) maxSignal * AGC_SPAN_SCALE / 100;
+    range.store(1 << device->bitDepth());
+    for (auto &b: histogram)
+	b.store(0);
+    overflows.store(0);
+    samples.store(0);
+    settle = AGC_SETTLE;
+    raises = 0;
+    synced.store(false);
+    if (!enabled)
+	return;
+    running.store(true);
+    this->enabled.store(true);
+    start();
+}
+
+void agcController::stop(void) {
+    enabled.store(false);
+    if (!running.load())
+	return;
+    running.store(false);
+    wakeUp.release();
+    boundary.release();
+    wait();
+    wakeUp.acquire(wakeUp.available());
+    boundary.acquire(boundary.available());
+}
+
+//	a block's worth of statistics, which is all the DSP threads pay for
+void agcController::update(const agcStats *stats, int32_t amount) {
+    if (!enabled.load(std::memory_order_relaxed) || amount <= 0 ||
+	stats->max < stats->min)
+	return;
+    int32_t r = range.load(std::memory_order_relaxed);
+    int64_t bucket = (int64_t) (stats->max - stats->min) * AGC_BUCKETS / (r + 1);
+
+    if (bucket >= AGC_BUCKETS)
+	bucket = AGC_BUCKETS - 1;
+    histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+    overflows.fetch_add(stats->overflows, std::memory_order_relaxed);
+    samples.fetch_add(amount, std::memory_order_relaxed);
+}
+
+void agcController::setSynced(bool s) {
+    synced.store(s, std::memory_order_relaxed);
+}
+
+//	called once the null symbol has been read
+void agcController::frameEnd(int32_t frameLength, int32_t nullLength) {
+    if (!waiting.load(std::memory_order_relaxed))
+	return;
+    this->frameLength.store(frameLength, std::memory_order_relaxed);
+    this->nullLength.store(nullLength, std::memory_order_relaxed);
+    boundary.release();
+}
+
+void agcController::run(void) {
+    while (running.load()) {
+	if (wakeUp.tryAcquire(1, AGC_PERIOD))
+	    continue;
+	decide();
+    }
+}
+
+//	the span of the blocks is taken at a high percentile rather than
+//	over the whole period, so that the odd spike does not drag the
+//	gain down
+void agcController::decide(void) {
+    uint32_t counts[AGC_BUCKETS];
+    uint32_t total = 0;
+    int32_t r = range.load();
+    int32_t o = overflows.exchange(0);
+    int64_t n = samples.exchange(0);
+    int newGain = gain;
+
+    for (int i = 0; i < AGC_BUCKETS; i++) {
+	counts[i] = histogram[i].exchange(0);
+	total += counts[i];
+    }
+
+    // the samples already buffered predate the last change
+    if (settle > 0) {
+	settle--;
+	return;
+    }
+    if (total == 0)
+	return;
+
+    uint32_t wanted = (uint64_t) total * AGC_PERCENTILE / 100;
+    uint32_t count = 0;
+    int b = 0;
+    for (; b < AGC_BUCKETS - 1; b++) {
+	count += counts[b];
+	if (count >= wanted)
+	    break;
+    }
+    int32_t span = (int64_t) (b + 1) * (r + 1) / AGC_BUCKETS;
+    log(LOG_AGC, LOG_VERBOSE, "blocks %u samples %lli span %i overflows %i%s",
+	total, (long long) n, span, o, synced.load()? " synced": "");
+
+    if ((o > 0 || span > maxSignal) && gain > minGain) {
+	newGain = gain - 1;
+	raises = 0;
+    } else if (span < minSignal && gain < maxGain) {
+	if (!synced.load() || ++raises >= AGC_SYNC_HOLD) {
+	    newGain = gain + 1;
+	    raises = 0;
+	}
+    } else
+	raises = 0;
+    if (newGain != gain)
+	apply(newGain);
+}
+
+void agcController::apply(int newGain) {
+
+    // while synced, wait for the DAB processor to be done with a frame
+    if (synced.load()) {
+	boundary.acquire(boundary.available());
+	waiting.store(true);
+	bool atEnd = boundary.tryAcquire(1, AGC_FRAME_WAIT);
+	waiting.store(false);
+	if (!running.load())
+	    return;
+	if (!atEnd && synced.load()) {
+	    log(LOG_AGC, LOG_VERBOSE, "no frame end, gain change deferred");
+	    return;
+	}
+
+	// the DSP is at the end of a null symbol, the tuner is ahead by
+	// what is buffered: wait for it to get to the next one
+	int32_t T_F = frameLength.load();
+	if (atEnd && T_F > 0) {
+	    int64_t ahead = nullLength.load() + device->Samples();
+	    int64_t wait = (T_F - ahead % T_F) % T_F;
+	    QThread::usleep(wait * 1000000 / INPUT_RATE);
+	}
+    }
+    log(LOG_AGC, LOG_MIN, "switching gain to %i", newGain);
+    device->setIfGain(newGain);
+    gain = newGain;
+    settle = AGC_SETTLE;
+}
@@ -0,0 +1,96 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AGC_CONTROLLER_H
+#define AGC_CONTROLLER_H
+
+//	The software AGC, owned by the device.
+//	The DSP threads hand over the conversion statistics of each block,
+//	which only costs a couple of atomic adds: the spans are gathered in
+//	a histogram, and a control thread of its own looks at it at a fixed
+//	cadence and moves the IF gain, so that the device is never called
+//	from the DSP threads.
+//	While a DAB receiver is synced, raises have to be asked for a few
+//	times in a row, and any change is aimed at the next null symbol as
+//	the tuner sees it, i.e. past the samples already buffered. The
+//	tuner's own control latency is unknown, so a change can still land
+//	a little late.
+#include <QThread>
+#include <QSemaphore>
+#include <atomic>
+#include <cstdint>
+
+#define AGC_BUCKETS	128
+#define AGC_PERIOD	100	// ms between decisions
+#define AGC_SETTLE	3	// periods skipped after a change
+#define AGC_SYNC_HOLD	3	// periods a raise is asked for while synced
+#define AGC_PERCENTILE	99
+#define AGC_FRAME_WAIT	250	// ms, for the end of a frame
+
+//	The thresholds are meant for the span over a whole period, about a
+//	million samples, the 99th percentile of the 2048 sample block spans
+//	comes out at 85% of that for a noise like signal such as OFDM
+#define AGC_SPAN_SCALE	85	// percent
+
+struct agcStats;
+class deviceHandler;
+
+class agcController: public QThread {
+public:
+    agcController(deviceHandler *);
+    ~agcController(void);
+
+    //	from the UI, restarts the controller from the given gain
+    void configure(bool enabled, int gain, int minGain, int maxGain);
+    void stop(void);
+
+    //	from the DSP threads
+    void update(const agcStats *, int32_t amount);
+    void setSynced(bool);
+    void frameEnd(int32_t frameLength, int32_t nullLength);
+
+private:
+    void run(void);
+    void decide(void);
+    void apply(int);
+
+    deviceHandler *device;
+    std::atomic<bool> enabled;
+    std::atomic<bool> running;
+    std::atomic<bool> synced;
+    std::atomic<bool> waiting;
+    std::atomic<int32_t> frameLength;
+    std::atomic<int32_t> nullLength;
+    std::atomic<int32_t> range;
+    std::atomic<uint32_t> histogram[AGC_BUCKETS];
+    std::atomic<int32_t> overflows;
+    std::atomic<int64_t> samples;
+    QSemaphore wakeUp;
+    QSemaphore boundary;
+    int gain;
+    int minGain;
+    int maxGain;
+    int32_t minSignal;
+    int32_t maxSignal;
+    int settle;
+    int raises;
+};
+#endif
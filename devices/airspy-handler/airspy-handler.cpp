@@ -38,6 +38,7 @@
 #include "airspy-handler.h"
 #include "logging.h"
 #include "math-helper.h"
+#include "sample-convert.h"
 #include <inttypes.h>
 
 #define DEV_AIRSPY LOG_DEV
@@ -103,7 +104,7 @@ airspyHandler::airspyHandler() {
         throw(22);
     }
 
-    theBuffer = new RingBuffer<std::complex<int32_t>>(4 * 1024 * 1024);
+    theBuffer = new RingBuffer<std::complex<int32_t>>(4 * 1024 * 1024, true);
     running.store(false);
     log(DEV_AIRSPY, LOG_MIN, "airspy loaded");
 }
@@ -303,30 +304,9 @@ void airspyHandler::getIfRange(int *min, int *max) {
 }
 
 int32_t airspyHandler::getSamples(std::complex<float>* v, int32_t size, agcStats* stats) {
-    _VLA(std::complex<int32_t>,  temp, size);
-    int32_t overflow = 0, minVal = INT_MAX, maxVal = INT_MIN;
-    int i;
-
-    int amount = theBuffer->getDataFromBuffer(temp, size);
-    for (i = 0; i < amount; i++) {
-        int r = real(temp[i]), im = imag(temp[i]);
-
-        if (r <= -SIGNAL_MAX || r >= SIGNAL_MAX-1 || im <= -SIGNAL_MAX || im >= SIGNAL_MAX-1)
-            overflow++;
-        if (r < minVal)
-            minVal = r;
-        if (r > maxVal)
-            maxVal = r;
-        if (im < minVal)
-            minVal = im;
-        if (im > maxVal)
-            maxVal = im;
-        v[i] = std::complex<float>(r / AMPLITUDE, im / AMPLITUDE);
-    }
-    stats->overflows = overflow;
-    stats->min = minVal;
-    stats->max = maxVal;
-    return amount;
+    resetAgcStats(stats);
+    return getIQFromBuffer<int32_t>(*theBuffer, v, size, 0, 1 / AMPLITUDE,
+                                    -SIGNAL_MAX, SIGNAL_MAX - 1, stats);
 }
 
 int32_t airspyHandler::Samples(void) {
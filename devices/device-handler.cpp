@@ -25,8 +25,14 @@
  */
 #include "constants.h"
 #include "device-handler.h"
+#include "agc-controller.h"
 
 deviceHandler::deviceHandler(void) {
+    agc = new agcController(this);
+}
+
+deviceHandler::~deviceHandler(void) {
+    delete agc;
 }
 
 void deviceHandler::getSwAGCRange(int32_t *min, int32_t *max) {
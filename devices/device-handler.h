@@ -45,6 +45,8 @@ struct agcStats {
     int overflows;
 };
 
+class agcController;
+
 #define DEV_SHORT 64
 #define DEV_LONG 128
 #define MAX_DEVICES 6
@@ -58,7 +60,7 @@ struct deviceStrings {
 class deviceHandler: public QThread {
     public:
     deviceHandler(void);
-    virtual ~deviceHandler(void) {}
+    virtual ~deviceHandler(void);
 
     virtual int	devices(deviceStrings *devs, int max) { (void) devs; (void) max; return 0; }
 
@@ -84,6 +86,12 @@ class deviceHandler: public QThread {
     virtual void setLnaGain(int) {}
     virtual void setAgcControl(int) {}
 
+    // the software agc, to be stopped before the device goes
+    agcController *agcControl(void) { return agc; }
+
     protected:
+
+    private:
+    agcController *agc;
 };
 #endif
@@ -0,0 +1,197 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "device-probe.h"
+#include "logging.h"
+#ifdef	HAVE_RTLSDR
+#include "rtlsdr-handler.h"
+#endif
+#ifdef	HAVE_SDRPLAY
+#include "sdrplay-handler.h"
+#endif
+#ifdef	HAVE_SDRPLAY_V3
+#include "sdrplay-handler-v3.h"
+#endif
+#ifdef	HAVE_AIRSPY
+#include "airspy-handler.h"
+#endif
+#ifdef	HAVE_HACKRF
+#include "hackrf-handler.h"
+#endif
+#ifdef	HAVE_LIME
+#include "lime-handler.h"
+#endif
+#ifdef	HAVE_PLUTO
+#include "pluto-handler.h"
+#endif
+
+void probeDevices(std::vector<deviceDescriptor> &deviceList, deviceHandler *fileDevice) {
+    deviceDescriptor discoveredDevice;
+
+    // a recording given on the command line takes precedence
+    if (fileDevice != nullptr) {
+	discoveredDevice.device = fileDevice;
+	discoveredDevice.deviceType = "File";
+	discoveredDevice.controls = 0;
+	deviceList.push_back(discoveredDevice);
+    }
+
+#ifdef HAVE_SDRPLAY_V3
+    bool foundV3 = false;
+    try {
+	    discoveredDevice.device = new sdrplayHandler_v3();
+	    discoveredDevice.deviceType = "Sdrplay V3";
+	    discoveredDevice.controls = HW_AGC|IF_GAIN|LNA_GAIN;
+	    deviceList.push_back(discoveredDevice);
+	    foundV3 = true;
+    } catch (int e) {}
+#endif
+#ifdef HAVE_SDRPLAY
+#ifdef HAVE_SDRPLAY_V3
+
+    // rdsplay v2 is a fallback
+    if (!foundV3)
+#endif
+	try {
+		discoveredDevice.device = new sdrplayHandler();
+		discoveredDevice.deviceType = "Sdrplay";
+		discoveredDevice.controls = HW_AGC|IF_GAIN|LNA_GAIN;
+		deviceList.push_back(discoveredDevice);
+	} catch (int e) {}
+#endif
+#ifdef HAVE_RTLSDR
+// no LNA
+    try {
+	    discoveredDevice.device = new rtlsdrHandler();
+	    discoveredDevice.deviceType = "RtlSdr";
+	    discoveredDevice.controls = SW_AGC|HW_AGC|COMBO_AGC|IF_GAIN;
+	    deviceList.push_back(discoveredDevice);
+    } catch (int e) {}
+#endif
+#ifdef HAVE_AIRSPY
+// no LNA
+    try {
+	    discoveredDevice.device = new airspyHandler();
+	    discoveredDevice.deviceType = "AirSpy";
+	    discoveredDevice.controls = SW_AGC|HW_AGC|IF_GAIN;
+	    deviceList.push_back(discoveredDevice);
+    } catch (int e) {}
+#endif
+#ifdef HAVE_LIME
+// no LNA
+    try {
+	    discoveredDevice.device = new limeHandler();
+	    discoveredDevice.deviceType = "Lime";
+	    discoveredDevice.controls = HW_AGC|IF_GAIN;
+	    deviceList.push_back(discoveredDevice);
+    } catch (int e) {}
+#endif
+#ifdef HAVE_PLUTO
+// no LNA
+    try {
+	    discoveredDevice.device = new plutoHandler();
+	    discoveredDevice.deviceType = "Pluto";
+	    discoveredDevice.controls = HW_AGC|IF_GAIN;
+	    deviceList.push_back(discoveredDevice);
+    } catch (int e) {}
+#endif
+#ifdef HAVE_HACKRF
+// no AGC
+    try {
+	    discoveredDevice.device = new hackrfHandler();
+	    discoveredDevice.deviceType = "HackRF";
+	    discoveredDevice.controls = IF_GAIN|LNA_GAIN;
+	    deviceList.push_back(discoveredDevice);
+    } catch (int e) {}
+#endif
+}
+
+// another instance of a known kind, which takes the first
+// free device of that kind, if any
+static deviceHandler *newDevice(const QString &deviceType) {
+    try {
+#ifdef HAVE_SDRPLAY_V3
+	if (deviceType == "Sdrplay V3")
+	    return new sdrplayHandler_v3();
+#endif
+#ifdef HAVE_SDRPLAY
+	if (deviceType == "Sdrplay")
+	    return new sdrplayHandler();
+#endif
+#ifdef HAVE_RTLSDR
+	if (deviceType == "RtlSdr")
+	    return new rtlsdrHandler();
+#endif
+#ifdef HAVE_AIRSPY
+	if (deviceType == "AirSpy")
+	    return new airspyHandler();
+#endif
+#ifdef HAVE_LIME
+	if (deviceType == "Lime")
+	    return new limeHandler();
+#endif
+#ifdef HAVE_PLUTO
+	if (deviceType == "Pluto")
+	    return new plutoHandler();
+#endif
+#ifdef HAVE_HACKRF
+	if (deviceType == "HackRF")
+	    return new hackrfHandler();
+#endif
+    } catch (int e) {}
+    return nullptr;
+}
+
+void probeScanDevices(std::vector<deviceDescriptor> &deviceList, deviceHandler *inUse,
+		      std::vector<deviceHandler *> &tuners,
+		      std::vector<deviceHandler *> &opened) {
+    if (inUse != nullptr)
+	tuners.push_back(inUse);
+    for (auto &d: deviceList) {
+	deviceStrings devNames[MAX_DEVICES];
+
+	// a recording can't be tuned
+	if (d.deviceType == "File")
+	    continue;
+	if (d.device != inUse)
+	    tuners.push_back(d.device);
+
+	// the probed handler already holds one
+	int dc = d.device->devices((deviceStrings *) &devNames, MAX_DEVICES);
+	for (int i = 1; i < dc; i++) {
+	    deviceHandler *extra = newDevice(d.deviceType);
+
+	    if (extra == nullptr)
+		break;
+	    if (d.controls & HW_AGC)
+		extra->setAgcControl(true);
+	    else if (d.controls & IF_GAIN) {
+		int32_t min, max;
+
+		extra->getIfRange(&min, &max);
+		extra->setIfGain((min + max) / 2);
+	    }
+	    tuners.push_back(extra);
+	    opened.push_back(extra);
+	}
+    }
+    log(LOG_DEV, LOG_MIN, "%i tuners available for scanning", (int) tuners.size());
+}
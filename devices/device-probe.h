@@ -0,0 +1,54 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DEVICE_PROBE_H
+#define DEVICE_PROBE_H
+
+//	Device discovery, shared by the GUI and the daemon
+#include "device-handler.h"
+#include <QString>
+#include <vector>
+
+enum deviceControls {
+    HW_AGC =	0x01,
+    IF_GAIN =	0x02,
+    LNA_GAIN =	0x04,
+    SW_AGC =	0x08,
+    COMBO_AGC =	0x10
+};
+
+class deviceDescriptor {
+public:
+    QString deviceType;
+    deviceHandler *device;
+    int controls;
+};
+
+// a recording given on the command line comes first
+void probeDevices(std::vector<deviceDescriptor> &, deviceHandler *fileDevice);
+
+// every tuner the band scan can use, the one in use first.
+// Further tuners of an already probed kind are opened as well, and
+// handed back in the last list, for the caller to delete
+void probeScanDevices(std::vector<deviceDescriptor> &, deviceHandler *inUse,
+		      std::vector<deviceHandler *> &tuners,
+		      std::vector<deviceHandler *> &opened);
+#endif
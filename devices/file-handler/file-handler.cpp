@@ -0,0 +1,322 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	<QFileInfo>
+#include	<QtEndian>
+#include	<climits>
+#include	<string.h>
+#if IS_WINDOWS
+#include	<fcntl.h>
+#include	<io.h>
+#endif
+#include	"file-handler.h"
+#include	"logging.h"
+#include	"sample-convert.h"
+
+#define DEV_FILE LOG_DEV
+
+#define	READLEN_DEFAULT	8192
+
+fileHandler::fileHandler(const QString &name, fileFormat format, int bits,
+			 bool realTime, bool loop): pipeBuffer(4 * 1024 * 1024, true) {
+    fileName = name;
+    this->format = format;
+    this->bits = (bits > 0 && bits <= 16)? bits: 16;
+    this->realTime = realTime;
+    this->loop = loop;
+    isPipe = (name == "-");
+    samples = nullptr;
+    sampleCount = 0;
+    position = 0;
+    delivered = 0;
+    running.store(false);
+    closing.store(false);
+
+    if (this->format == FILE_AUTO)
+	this->format = isPipe? FILE_CU8: formatFor(QFileInfo(name).suffix());
+    if (this->format == FILE_AUTO) {
+	log(DEV_FILE, LOG_MIN, "unknown format for %s", qPrintable(name));
+	throw(30);
+    }
+
+    int64_t bytes = 0;
+    if (isPipe) {
+	if (this->format == FILE_WAV) {
+	    log(DEV_FILE, LOG_MIN, "wav recordings can not be read from a pipe");
+	    throw(31);
+	}
+#if IS_WINDOWS
+	_setmode(_fileno(stdin), _O_BINARY);
+#endif
+    } else {
+	file.setFileName(name);
+	if (!file.open(QIODevice::ReadOnly)) {
+	    log(DEV_FILE, LOG_MIN, "failed to open %s", qPrintable(name));
+	    throw(32);
+	}
+	bytes = file.size();
+	samples = file.map(0, bytes);
+	if (samples == nullptr) {
+	    log(DEV_FILE, LOG_MIN, "failed to map %s", qPrintable(name));
+	    throw(33);
+	}
+	if (this->format == FILE_WAV &&
+	    (samples = parseWav(samples, &bytes)) == nullptr) {
+	    log(DEV_FILE, LOG_MIN, "%s is not a stereo IQ wav file", qPrintable(name));
+	    throw(34);
+	}
+    }
+
+    switch (this->format) {
+    default:
+    case FILE_CU8:
+	sampleSize = 2 * sizeof(uint8_t);
+	scale = 1.0 / 128;
+	this->bits = 8;
+	break;
+    case FILE_CS16:
+	sampleSize = 2 * sizeof(int16_t);
+	scale = 1.0 / (1 << (this->bits - 1));
+	break;
+    case FILE_CF32:
+	sampleSize = 2 * sizeof(float);
+	scale = 1.0;
+	break;
+    }
+    sampleCount = bytes / sampleSize;
+    if (!isPipe && sampleCount == 0) {
+	log(DEV_FILE, LOG_MIN, "%s contains no samples", qPrintable(name));
+	throw(35);
+    }
+    log(DEV_FILE, LOG_CHATTY, "opened %s, format %i, %lli samples, %s",
+	qPrintable(name), this->format, (long long) sampleCount,
+	realTime? "real time": "as fast as possible");
+}
+
+fileHandler::~fileHandler(void) {
+    running.store(false);
+    closing.store(true);
+
+    // the pipe reader might be stuck in fread
+    if (isRunning() && !wait(1000)) {
+	terminate();
+	wait();
+    }
+}
+
+fileHandler::fileFormat fileHandler::formatFor(const QString &s) {
+    QString f = s.toLower();
+
+    if (f == "wav")
+	return FILE_WAV;
+    if (f == "cu8" || f == "u8" || f == "raw")
+	return FILE_CU8;
+    if (f == "cs16" || f == "s16")
+	return FILE_CS16;
+    if (f == "cf32" || f == "fc32" || f == "cfile")
+	return FILE_CF32;
+    return FILE_AUTO;
+}
+
+//	find the data chunk of a RIFF WAVE file, and pick the sample
+//	format from the fmt chunk
+const uint8_t *fileHandler::parseWav(const uint8_t *base, int64_t *size) {
+    int64_t offset = 12;
+    int wavFormat = 0, channels = 0, wavBits = 0;
+
+    if (*size < 12 || memcmp(base, "RIFF", 4) != 0 ||
+	memcmp(base + 8, "WAVE", 4) != 0)
+	return nullptr;
+    while (offset + 8 <= *size) {
+	const uint8_t *chunk = base + offset;
+	int64_t chunkSize = qFromLittleEndian<quint32>(chunk + 4);
+
+	if (memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16) {
+	    wavFormat = qFromLittleEndian<quint16>(chunk + 8);
+	    channels = qFromLittleEndian<quint16>(chunk + 10);
+	    wavBits = qFromLittleEndian<quint16>(chunk + 22);
+
+	    // WAVE_FORMAT_EXTENSIBLE, the format is in the sub format guid
+	    if (wavFormat == 0xFFFE && chunkSize >= 40)
+		wavFormat = qFromLittleEndian<quint16>(chunk + 32);
+	} else if (memcmp(chunk, "data", 4) == 0) {
+	    if (channels != 2)
+		return nullptr;
+	    if (wavFormat == 1 && wavBits == 8)
+		format = FILE_CU8;
+	    else if (wavFormat == 1 && wavBits == 16)
+		format = FILE_CS16;
+	    else if (wavFormat == 3 && wavBits == 32)
+		format = FILE_CF32;
+	    else
+		return nullptr;
+
+	    // unfinished recordings have a bogus data size
+	    if (chunkSize > *size - offset - 8)
+		chunkSize = *size - offset - 8;
+	    *size = chunkSize;
+	    return chunk + 8;
+	}
+	offset += 8 + chunkSize + (chunkSize & 1);
+    }
+    return nullptr;
+}
+
+int32_t fileHandler::devices(deviceStrings *devs, int max) {
+    if (max < 1)
+	return 0;
+    QByteArray name = QFileInfo(fileName).fileName().toUtf8();
+    QByteArray path = fileName.toUtf8();
+
+    snprintf((char *) &devs[0].name, DEV_SHORT, "%s", isPipe? "stdin": name.data());
+    snprintf((char *) &devs[0].id, DEV_SHORT, "file-0");
+    snprintf((char *) &devs[0].description, DEV_LONG, "%s", path.data());
+    return 1;
+}
+
+bool fileHandler::restartReader(int32_t frequency) {
+    if (running.load())
+	return true;
+
+    log(DEV_FILE, LOG_MIN, "restarting replay, ignoring frequency %i", frequency);
+    delivered = 0;
+    clock.start();
+    running.store(true);
+
+    // the pipe reader runs until the end of input
+    if (isPipe && !isRunning())
+	start();
+    return true;
+}
+
+void fileHandler::stopReader(void) {
+    running.store(false);
+}
+
+//	reads stdin into the ring buffer, waiting for the consumer
+//	when the buffer is full
+void fileHandler::run(void) {
+    uint8_t buffer[READLEN_DEFAULT];
+
+    while (!closing.load()) {
+	if (pipeBuffer.GetRingBufferWriteAvailable() < READLEN_DEFAULT) {
+	    usleep(1000);
+	    continue;
+	}
+	size_t n = fread(buffer, 1, READLEN_DEFAULT, stdin);
+	if (n == 0) {
+	    log(DEV_FILE, LOG_MIN, "end of input on stdin");
+	    break;
+	}
+	pipeBuffer.putDataIntoBuffer(buffer, n);
+    }
+}
+
+//	in real time mode, limit the samples to those due since the
+//	reader was started; a consumer falling more than a second behind
+//	loses the backlog, as it would with a real device
+int32_t fileHandler::paced(int32_t n) {
+    if (!realTime)
+	return n;
+
+    int64_t due = (int64_t) (clock.nsecsElapsed() * (INPUT_RATE / 1e9));
+    if (due - delivered > INPUT_RATE)
+	delivered = due - INPUT_RATE;
+    return (int32_t) std::min((int64_t) n, due - delivered);
+}
+
+int32_t	fileHandler::Samples(void) {
+    int64_t available;
+
+    if (!running.load())
+	return 0;
+    if (isPipe)
+	available = pipeBuffer.GetRingBufferReadAvailable() / sampleSize;
+    else if (loop)
+	available = INPUT_RATE;
+    else
+	available = sampleCount - position;
+    return paced((int32_t) std::min(available, (int64_t) INPUT_RATE));
+}
+
+void fileHandler::convert(const uint8_t *in, std::complex<float> *V, int32_t n) {
+    switch (format) {
+    default:
+    case FILE_CU8:
+	convertIQ(in, V, n, 128, scale, 0, UCHAR_MAX, nullptr);
+	break;
+    case FILE_CS16:
+	convertIQ((const int16_t *) in, V, n, 0, scale, SHRT_MIN, SHRT_MAX, nullptr);
+	break;
+    case FILE_CF32:
+	memcpy((void *) V, in, n * sampleSize);
+	break;
+    }
+}
+
+//	recordings have no gain control, the stats stay empty
+int32_t	fileHandler::getSamples(std::complex<float> *V, int32_t size, agcStats *stats) {
+    int32_t n = std::min(size, Samples());
+    int32_t done = 0;
+
+    stats->overflows = 0;
+    stats->min = 0;
+    stats->max = 0;
+    if (n <= 0)
+	return 0;
+    if (isPipe)
+	switch (format) {
+	default:
+	case FILE_CU8:
+	    done = getIQFromBuffer<uint8_t>(pipeBuffer, V, n, 128, scale,
+					    0, UCHAR_MAX, nullptr);
+	    break;
+	case FILE_CS16:
+	    done = getIQFromBuffer<int16_t>(pipeBuffer, V, n, 0, scale,
+					    SHRT_MIN, SHRT_MAX, nullptr);
+	    break;
+	case FILE_CF32:
+	    done = pipeBuffer.getDataFromBuffer(V, n * sampleSize) / sampleSize;
+	    break;
+	}
+    else
+	while (done < n) {
+	    int32_t chunk = (int32_t) std::min((int64_t) (n - done),
+					       sampleCount - position);
+
+	    if (chunk == 0) {
+		if (!loop)
+		    break;
+		log(DEV_FILE, LOG_CHATTY, "looping %s", qPrintable(fileName));
+		position = 0;
+		continue;
+	    }
+	    convert(samples + position * sampleSize, V + done, chunk);
+	    position += chunk;
+	    done += chunk;
+	}
+    delivered += done;
+    return done;
+}
+
+int16_t fileHandler::bitDepth(void) {
+    return bits;
+}
@@ -0,0 +1,94 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FILE_HANDLER_H
+#define	FILE_HANDLER_H
+
+#include <stdio.h>
+#include <atomic>
+#include <QFile>
+#include <QElapsedTimer>
+#include "constants.h"
+#include "device-handler.h"
+#include "ringbuffer.h"
+
+//	replays recorded IQ samples at INPUT_RATE, either from a memory
+//	mapped file or from a pipe on stdin
+//	the recording is expected to be at INPUT_RATE, the frequency
+//	requested by the tuner is ignored
+class fileHandler: public deviceHandler {
+Q_OBJECT
+public:
+    enum fileFormat {
+	FILE_AUTO,
+	FILE_WAV,	// the sampleReader dump format, 16 bit stereo
+	FILE_CU8,	// rtl_sdr style unsigned bytes
+	FILE_CS16,
+	FILE_CF32
+    };
+
+    //	name "-" reads from stdin, bits is the significant bits in
+    //	16 bit recordings, realTime paces the samples at INPUT_RATE
+    fileHandler(const QString &name, fileFormat format, int bits,
+		bool realTime, bool loop);
+    ~fileHandler(void);
+
+    static fileFormat formatFor(const QString &);
+
+    int32_t devices(deviceStrings *, int);
+    bool restartReader(int32_t frequency);
+    void stopReader(void);
+    int32_t getSamples(std::complex<float> *,
+		       int32_t, agcStats *stats);
+    int32_t Samples(void);
+    int16_t bitDepth(void);
+
+private:
+    void run(void);
+    const uint8_t *parseWav(const uint8_t *, int64_t *);
+    int32_t paced(int32_t);
+    void convert(const uint8_t *, std::complex<float> *, int32_t);
+
+    QString fileName;
+    fileFormat format;
+    QFile file;
+    bool isPipe;
+    bool realTime;
+    bool loop;
+    int16_t bits;
+    int32_t sampleSize;
+    float scale;
+
+    //	memory mapped recordings
+    const uint8_t *samples;
+    int64_t sampleCount;
+    int64_t position;
+
+    //	pipes
+    RingBuffer<uint8_t> pipeBuffer;
+    std::atomic<bool> running;
+    std::atomic<bool> closing;
+
+    //	real time pacing
+    QElapsedTimer clock;
+    int64_t delivered;
+};
+#endif
@@ -26,6 +26,7 @@
 
 #include "lime-handler.h"
 #include "logging.h"
+#include "sample-convert.h"
 #define DEV_LIME LOG_DEV
 
 #define FIFO_SIZE 32768
@@ -34,7 +35,7 @@ static int16_t localBuffer[4 * FIFO_SIZE];
 lms_info_str_t limedevices[10];
 
 limeHandler::limeHandler()
-    : _I_Buffer(4 * 1024 * 1024) {
+    : _I_Buffer(4 * 1024 * 1024, true) {
 
 #if IS_WINDOWS
     const char* libraryString = "LimeSuite.dll";
@@ -196,15 +197,9 @@ void limeHandler::stopReader() {
 }
 
 int limeHandler::getSamples(std::complex<float>* V, int32_t size, agcStats* stats) {
-    std::complex<int16_t> temp[size];
-    int i;
-    int amount = _I_Buffer.getDataFromBuffer(temp, size);
     (void) stats;
-
-    for (i = 0; i < amount; i++)
-        V[i] = std::complex<float>(real(temp[i]) / 2048.0,
-            imag(temp[i]) / 2048.0);
-    return amount;
+    return getIQFromBuffer<int16_t>(_I_Buffer, V, size, 0, 1 / 2048.0,
+                                    SHRT_MIN, SHRT_MAX, nullptr);
 }
 
 int limeHandler::Samples() {
@@ -28,6 +28,7 @@
 #include	"rtlsdr-handler.h"
 #include	"rtl-sdr.h"
 #include	"logging.h"
+#include	"sample-convert.h"
 
 #define STRBUFLEN 256
 #define DEV_RTLSDR LOG_DEV
@@ -74,9 +75,7 @@ private:
     }
 };
 
-rtlsdrHandler::rtlsdrHandler(): _I_Buffer (4 * 1024 * 1024) {
-    int	i;
-
+rtlsdrHandler::rtlsdrHandler(): _I_Buffer (4 * 1024 * 1024, true) {
     currentId[0] = '\0';
     agcControl = false;
     ifGain = 50;
@@ -107,19 +106,19 @@ rtlsdrHandler::rtlsdrHandler(): _I_Buffer (4 * 1024 * 1024) {
 	CLOSE_LIBRARY(Handle);
 	throw(21);
     }
-    if (this->rtlsdr_get_device_count() == 0) {
+    int count = this->rtlsdr_get_device_count();
+    if (count == 0) {
 	CLOSE_LIBRARY(Handle);
 	throw(22);
     }
 
-    // rather than doing floating point divisions at all times
-    // we just have a table of possible float values
-    float median = float(1 + UCHAR_MAX / 2);
-    for (i = 0; i <= UCHAR_MAX; i++) {
-	convTable[i] = (i-median)/median;
-    }
-
-    if (!deviceOpen(0)) {
+    // the first one that is not taken, so that several dongles can be
+    // used at the same time
+    int devNo;
+    for (devNo = 0; devNo < count; devNo++)
+	if (deviceOpen(devNo))
+	    break;
+    if (devNo >= count) {
 	log(DEV_RTLSDR, LOG_MIN, "opening device failed");
 	CLOSE_LIBRARY(Handle);
 	throw(23);
@@ -165,7 +164,7 @@ bool rtlsdrHandler::deviceOpen(int devNo) {
     for (i = 0; i < gainsCount; i++)
         log(DEV_RTLSDR, LOG_CHATTY, "found gain %i", gains[i]);
     devName = this->rtlsdr_get_device_name(devNo);
-    sprintf((char *) currentId, "%s-%i", devName, 0);
+    sprintf((char *) currentId, "%s-%i", devName, devNo);
 
     rtlsdr_set_agc_mode(device, agcControl != 0);
     rtlsdr_set_tuner_gain_mode(device, 1);
@@ -285,31 +284,12 @@ void rtlsdrHandler::setAgcControl(int v) {
     rtlsdr_set_tuner_gain(device, gains[ifGain*gainsCount/GAIN_SCALE]);
 }
 
+// converted straight out of the ring buffer, a component at either
+// end of the range counts as an overflow
 int32_t	rtlsdrHandler::getSamples(std::complex<float> *V, int32_t size, agcStats *stats) {
-    int32_t amount, in, out;
-    int32_t overflow = 0, minVal = UCHAR_MAX, maxVal = 0;
-    _VLA(uint8_t, tempBuffer, 2*size*sizeof(uint8_t));
-
-    amount = _I_Buffer.getDataFromBuffer(tempBuffer, 2*size);
-    for (in = 0, out = 0; in < amount; out++) {
-	int r = tempBuffer[in++], im = tempBuffer[in++];
-
-	if (r == 0 || r == UCHAR_MAX || im == 0 || im == UCHAR_MAX)
-	    overflow++;
-	if (r < minVal)
-	    minVal = r;
-	if (r > maxVal)
-	    maxVal = r;
-	if (im < minVal)
-	    minVal = im;
-	if (im > maxVal)
-	    maxVal = im;
-	V[out] = std::complex<float>(convTable[r], convTable[im]);
-    }
-    stats->overflows = overflow;
-    stats->min = minVal;
-    stats->max = maxVal;
-    return amount/2;
+    resetAgcStats(stats);
+    return getIQFromBuffer<uint8_t>(_I_Buffer, V, size, 1 + UCHAR_MAX / 2,
+				    1.0f / (1 + UCHAR_MAX / 2), 0, UCHAR_MAX, stats);
 }
 
 int32_t	rtlsdrHandler::Samples(void) {
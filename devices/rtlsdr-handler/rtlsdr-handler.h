@@ -94,7 +94,6 @@ private:
     bool open;
     int *gains;
     int16_t gainsCount;
-    float convTable[UCHAR_MAX+1];
     char currentId[DEV_SHORT];
 
     pfnrtlsdr_open rtlsdr_open;
@@ -26,6 +26,7 @@
 #include "sdrplay-handler-v3.h"
 #include "constants.h"
 #include "logging.h"
+#include "sample-convert.h"
 
 #define DEV_PLAYV3 LOG_DEV
 
@@ -88,7 +89,7 @@ void EventCallback(sdrplay_api_EventT eventId,
     }
 }
 
-sdrplayHandler_v3::sdrplayHandler_v3(): _I_Buffer(4 * 1024 * 1024) {
+sdrplayHandler_v3::sdrplayHandler_v3(): _I_Buffer(4 * 1024 * 1024, true) {
     sdrplay_api_ErrT err;
     sdrplay_api_DeviceT devs[MAX_DEVICES];
     uint32_t devCount;
@@ -381,30 +382,9 @@ void sdrplayHandler_v3::stopReader() {
 }
 
 int32_t	sdrplayHandler_v3::getSamples(std::complex<float> *V, int32_t size, agcStats *stats) { 
-    _VLA(std::complex<int16_t>, temp, size);
-    int32_t overflow = 0, minVal = SHRT_MAX, maxVal = SHRT_MIN;
-    int i;
-
-    int amount = _I_Buffer.getDataFromBuffer(temp, size);
-    for (i = 0; i < amount; i++) {
-	int r = real(temp[i]), im = imag(temp[i]);
-
-	if (r <= signalMin || r >= signalMax || im <= signalMin || im >= signalMax)
-	    overflow++;
-	if (r < minVal)
-	    minVal = r;
-	if (r > maxVal) 
-	    maxVal = r;
-	if (im < minVal)
-	    minVal = im;
-	if (im > maxVal)
-	    maxVal = im;
-	V[i] = std::complex<float>(r / signalAmplitude, im / signalAmplitude);
-    }
-    stats->overflows = overflow;
-    stats->min = minVal;
-    stats->max = maxVal;
-    return amount;
+    resetAgcStats(stats);
+    return getIQFromBuffer<int16_t>(_I_Buffer, V, size, 0, 1 / signalAmplitude,
+				    signalMin, signalMax, stats);
 }
 
 int32_t sdrplayHandler_v3::Samples() {
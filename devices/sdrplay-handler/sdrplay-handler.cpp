@@ -26,13 +26,14 @@
 
 #include "sdrplay-handler.h"
 #include "logging.h"
+#include "sample-convert.h"
 
 #define DEV_PLAY LOG_DEV
 
 #define MIN_GAIN 20
 #define MAX_GAIN 59
 
-sdrplayHandler::sdrplayHandler(): _I_Buffer (4 * 1024 * 1024) {
+sdrplayHandler::sdrplayHandler(): _I_Buffer (4 * 1024 * 1024, true) {
     float ver;
     uint32_t devCount;
     mir_sdr_DeviceT devDesc[MAX_DEVICES];
@@ -408,30 +409,9 @@ void sdrplayHandler::stopReader(void) {
 }
 
 int32_t	sdrplayHandler::getSamples(std::complex<float> *V, int32_t size, agcStats *stats) { 
-    _VLA(std::complex<int16_t>, temp, size);
-    int32_t overflow = 0, minVal = SHRT_MAX, maxVal = SHRT_MIN;
-    int i;
-
-    int amount = _I_Buffer.getDataFromBuffer(temp, size);
-    for (i = 0; i < amount; i++) {
-	int r = real(temp[i]), im = imag(temp[i]);
-
-	if (r <= signalMin || r >= signalMax || im <= signalMin || im >= signalMax)
-	    overflow++;
-	if (r < minVal)
-	    minVal = r;
-	if (r > maxVal)
-	    maxVal = r;
-	if (im < minVal)
-	    minVal = im;
-	if (im > maxVal)
-	    maxVal = im;
-	V[i] = std::complex<float>(r / signalAmplitude, im / signalAmplitude);
-    }
-    stats->overflows = overflow;
-    stats->min = minVal;
-    stats->max = maxVal;
-    return amount;
+    resetAgcStats(stats);
+    return getIQFromBuffer<int16_t>(_I_Buffer, V, size, 0, 1 / signalAmplitude,
+				    signalMin, signalMax, stats);
 }
 
 int32_t	sdrplayHandler::Samples(void) {
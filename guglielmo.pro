@@ -6,7 +6,7 @@ orgName		= SQSL
 orgDomain	= sqsl.org
 TARGET		= $$objectName
 DEFINES		+= TARGET=\\\"$$objectName\\\" CURRENT_VERSION=\\\"$$objectVersion\\\" ORGNAME=\\\"$$orgName\\\" ORGDOMAIN=\\\"$$orgDomain\\\"
-QT		+= widgets multimedia
+QT		+= widgets multimedia network
 QMAKE_CXXFLAGS_RELEASE	-= -O2
 QMAKE_CFLAGS_RELEASE	-= -O2
 QMAKE_CXXFLAGS	+= -std=c++11 -O3 -isystem $$[QT_INSTALL_HEADERS]
@@ -55,6 +55,7 @@ linux {
 	} else {
 		contains(variant, x86_64) {
 			CONFIG += SSE
+#			CONFIG += AVX2
 		} else {
 			CONFIG += NO_SSE
 		}
@@ -190,7 +191,8 @@ DEPENDPATH += . \
 	      ./include/backend/data/journaline \
 	      ./include/output \
 	      ./include/support \
-	      ./devices 
+	      ./devices \
+	      ./devices/file-handler
 
 INCLUDEPATH += . \
 	      ./src \
@@ -208,7 +210,8 @@ INCLUDEPATH += . \
 	      ./include/output \
 	      ./include/support \
 	      ./include/support/viterbi-spiral \
-	      ./devices 
+	      ./devices \
+	      ./devices/file-handler
 
 # Input
 HEADERS += ./include/radio.h \
@@ -220,6 +223,7 @@ HEADERS += ./include/radio.h \
 	   ./include/listwidget.h \
 	   ./include/knob.h \
 	   ./include/dab/dab-processor.h \
+	   ./include/dab/dab-scanner.h \
 	   ./include/dab/dab-tables.h \
 	   ./include/fm/fm-demodulator.h \
 	   ./include/fm/fm-processor.h \
@@ -236,6 +240,7 @@ HEADERS += ./include/radio.h \
 	   ./include/ofdm/phasetable.h \
 	   ./include/ofdm/freq-interleaver.h \
 	   ./include/ofdm/tii_detector.h \
+	   ./include/ofdm/occupancy-detector.h \
 	   ./include/ofdm/fic-handler.h \
 	   ./include/ofdm/fib-decoder.h  \
 	   ./include/ofdm/fib-table.h \
@@ -275,6 +280,7 @@ HEADERS += ./include/radio.h \
 	   ./include/backend/data/journaline/newsobject.h \
 	   ./include/backend/data/journaline/NML.h \
 	   ./include/output/audio-base.h \
+	   ./include/output/sndfile-writer.h \
 	   ./include/output/newconverter.h \
 	   ./include/output/audiosink.h \
 	   ./include/output/Qt-audio.h \
@@ -282,6 +288,11 @@ HEADERS += ./include/radio.h \
 	   ./include/support/process-params.h \
 	   ./include/support/viterbi-spiral/viterbi-spiral.h \
 	   ./include/support/fir-filters.h \
+	   ./include/support/fir-engine.h \
+	   ./include/support/sample-convert.h \
+	   ./include/support/telemetry.h \
+	   ./include/support/crc16.h \
+	   ./include/support/simd-helper.h \
 	   ./include/support/fft.h \
 	   ./include/support/fft-filters.h \
 	   ./include/support/iir-filters.h \
@@ -290,11 +301,16 @@ HEADERS += ./include/radio.h \
            ./include/support/fft-handler.h \
 	   ./include/support/ringbuffer.h \
 	   ./include/support/dir-cache.h \
+	   ./include/support/slide-pipeline.h \
+	   ./include/support/ensemble-cache.h \
 	   ./include/support/dab-params.h \
 	   ./include/support/band-handler.h \
 	   ./include/support/bits-helper.h \
 	   ./include/support/math-helper.h \
-	   ./devices/device-handler.h
+	   ./devices/device-handler.h \
+	   ./devices/agc-controller.h \
+	   ./devices/device-probe.h \
+	   ./devices/file-handler/file-handler.h
 
 FORMS	+= ./guglielmo.ui \
 	   ./about.ui \
@@ -304,6 +320,7 @@ SOURCES += ./src/main.cpp \
 	   ./src/radio.cpp \
 	   ./src/dialogs.cpp \
 	   ./src/dab/dab-processor.cpp \
+	   ./src/dab/dab-scanner.cpp \
 	   ./src/dab/dab-tables.cpp \
 	   ./src/fm/fm-demodulator.cpp \
 	   ./src/fm/fm-processor.cpp \
@@ -318,6 +335,7 @@ SOURCES += ./src/main.cpp \
 	   ./src/ofdm/phasetable.cpp \
 	   ./src/ofdm/freq-interleaver.cpp \
 	   ./src/ofdm/tii_detector.cpp \
+	   ./src/ofdm/occupancy-detector.cpp \
 	   ./src/ofdm/fic-handler.cpp \
 	   ./src/ofdm/fib-decoder.cpp \
 	   ./src/protection/protTables.cpp \
@@ -351,11 +369,16 @@ SOURCES += ./src/main.cpp \
 	   ./src/backend/data/journaline/newsobject.cpp \
 	   ./src/backend/data/journaline/NML.cpp \
 	   ./src/output/audio-base.cpp \
+	   ./src/output/sndfile-writer.cpp \
 	   ./src/output/newconverter.cpp \
 	   ./src/output/audiosink.cpp \
            ./src/output/Qt-audio.cpp \
            ./src/output/Qt-audiodevice.cpp \
 	   ./src/support/fir-filters.cpp \
+	   ./src/support/fir-engine.cpp \
+	   ./src/support/sample-convert.cpp \
+	   ./src/support/telemetry.cpp \
+	   ./src/support/crc16.cpp \
 	   ./src/support/fft.cpp \
 	   ./src/support/fft-filters.cpp \
 	   ./src/support/iir-filters.cpp \
@@ -366,7 +389,12 @@ SOURCES += ./src/main.cpp \
 	   ./src/support/dab-params.cpp \
 	   ./src/support/band-handler.cpp \
 	   ./src/support/dir-cache.cpp \
-	   ./devices/device-handler.cpp
+	   ./src/support/slide-pipeline.cpp \
+	   ./src/support/ensemble-cache.cpp \
+	   ./devices/device-handler.cpp \
+	   ./devices/agc-controller.cpp \
+	   ./devices/device-probe.cpp \
+	   ./devices/file-handler/file-handler.cpp
 
 faad	{
 	DEFINES		+= __WITH_FAAD__
@@ -426,6 +454,10 @@ NEON	{
 	SOURCES		+= ./src/support/viterbi-spiral/spiral-neon.c
 }
 
+AVX2	{
+	QMAKE_CXXFLAGS	+= -mavx2 -mfma
+}
+
 NO_SSE	{
 	HEADERS		+= ./src/support/viterbi-spiral/spiral-no-sse.h
 	SOURCES		+= ./src/support/viterbi-spiral/spiral-no-sse.c
@@ -495,3 +527,82 @@ pluto   {
         SOURCES         += ./devices/pluto-handler/pluto-handler.cpp
 	LIBS            += -liio  -lad9361
 }
+
+#	qmake CONFIG+=daemon builds the headless daemon instead of the GUI
+daemon	{
+	TARGET		= $${objectName}-daemon
+	DEFINES		+= HEADLESS
+	CONFIG		-= mpris qwt
+	DEFINES		-= HAVE_MPRIS
+	QT		-= widgets
+	PKGCONFIG	-= mpris-qt5
+	LIBS		-= -lqwt
+	FORMS		=
+	HEADERS		-= ./include/radio.h \
+			   ./include/dab/dab-scanner.h \
+			   ./include/support/dir-cache.h \
+			   ./include/support/slide-pipeline.h
+	HEADERS		+= ./include/daemon.h
+	SOURCES		-= ./src/radio.cpp \
+			   ./src/dialogs.cpp \
+			   ./src/dab/dab-scanner.cpp \
+			   ./src/support/dir-cache.cpp \
+			   ./src/support/slide-pipeline.cpp
+	SOURCES		+= ./src/daemon.cpp
+}
+
+#	qmake CONFIG+=bench builds the DSP benchmark instead of the GUI
+bench	{
+	TARGET		= $${objectName}-bench
+	DEFINES		+= BENCHMARK
+	CONFIG		-= mpris qwt
+	DEFINES		-= HAVE_MPRIS
+	QT		-= widgets
+	PKGCONFIG	-= mpris-qt5
+	LIBS		-= -lqwt
+	FORMS		=
+	INCLUDEPATH	+= ./bench
+	DEPENDPATH	+= ./bench
+	HEADERS		-= ./include/radio.h \
+			   ./include/dab/dab-scanner.h \
+			   ./include/support/dir-cache.h \
+			   ./include/support/slide-pipeline.h
+	HEADERS		+= ./bench/bench.h \
+			   ./bench/bench-signals.h
+	SOURCES		-= ./src/main.cpp \
+			   ./src/radio.cpp \
+			   ./src/dialogs.cpp \
+			   ./src/dab/dab-scanner.cpp \
+			   ./src/support/dir-cache.cpp \
+			   ./src/support/slide-pipeline.cpp
+	SOURCES		+= ./bench/bench.cpp \
+			   ./bench/bench-signals.cpp
+}
+
+#	qmake CONFIG+=generator builds the synthetic ensemble generator,
+#	which only needs the building blocks it runs backwards
+generator {
+	TARGET		= $${objectName}-generator
+	CONFIG		-= mpris qwt
+	QT		= core
+	LIBS		-= -lqwt
+	FORMS		=
+	RESOURCES	=
+	INCLUDEPATH	+= ./bench
+	DEPENDPATH	+= ./bench
+	HEADERS		= ./bench/dab-generator.h \
+			  ./bench/bench-signals.h
+	SOURCES		= ./bench/generator.cpp \
+			  ./bench/dab-generator.cpp \
+			  ./bench/bench-signals.cpp \
+			  ./src/support/dab-params.cpp \
+			  ./src/support/fft-handler.cpp \
+			  ./src/support/crc16.cpp \
+			  ./src/ofdm/phasetable.cpp \
+			  ./src/ofdm/freq-interleaver.cpp \
+			  ./src/backend/reed-solomon.cpp \
+			  ./src/backend/galois.cpp \
+			  ./src/backend/firecode-checker.cpp \
+			  $$find(SOURCES, viterbi-spiral) \
+			  $$find(SOURCES, /protection/)
+}
@@ -39,6 +39,7 @@ class backendDriver {
                   RingBuffer<uint8_t> *, RingBuffer<uint8_t> *);
     ~backendDriver();
     void addtoFrame(std::vector<uint8_t> outData);
+    bool addService(serviceDescriptor *);
 
   private:
     frameProcessor *theProcessor;
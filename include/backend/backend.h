@@ -52,6 +52,7 @@ class Backend {
     ~Backend();
     int32_t process(int16_t *, int16_t);
     void stopRunning();
+    bool addService(serviceDescriptor *);
 
     //	we need sometimes to access the key parameters for decoding
     int serviceId;
@@ -28,46 +28,51 @@
 #define DATA_PROCESSOR_H
 
 #include "frame-processor.h"
-#include "ringbuffer.h"
+#include <QMutex>
 #include <QObject>
 #include <cstdio>
 #include <cstring>
+#include <map>
 #include <vector>
 
 class RadioInterface;
-class uep_deconvolve;
-class eep_deconvolve;
 class virtual_dataHandler;
 class packetdata;
 
+//	A packet subchannel may carry several services, each on its own
+//	packet address, and each with its own data groups being put
+//	together at any one time.
 class dataProcessor : public QObject, public frameProcessor {
     Q_OBJECT
   public:
-    dataProcessor(RadioInterface *mr, packetdata *pd,
-                  RingBuffer<uint8_t> *dataBuffer);
+    dataProcessor(RadioInterface *mr, packetdata *pd);
     ~dataProcessor();
     void addtoFrame(std::vector<uint8_t>);
+    bool addService(serviceDescriptor *);
 
   private:
+    class packetStream {
+      public:
+        int16_t DSCTy;
+        int16_t appType;
+        uint8_t DGflag;
+        int16_t expectedIndex;
+        uint8_t packetState;
+        std::vector<uint8_t> series; // packed
+        virtual_dataHandler *handler;
+    };
+
     RadioInterface *myRadioInterface;
     int16_t bitRate;
-    uint8_t DSCTy;
-    int16_t appType;
-    int16_t packetAddress;
-    uint8_t DGflag;
-    int16_t FEC_scheme;
-    RingBuffer<uint8_t> *dataBuffer;
-    int16_t expectedIndex;
-    std::vector<uint8_t> series;
-    uint8_t packetState;
-    int32_t streamAddress; // int since we init with -1
-                           //
-                           //	result handlers
-    void handleTDCAsyncstream(uint8_t *, int32_t);
+    QMutex locker;
+    std::map<int16_t, packetStream> streams; // by packet address
+    std::vector<uint8_t> frame;
+
+    virtual_dataHandler *newHandler(packetdata *);
     void handlePackets(uint8_t *, int32_t);
-    void handlePacket(uint8_t *);
-    virtual_dataHandler *my_dataHandler;
-    //
+    void handlePacket(uint8_t *, int32_t);
+    void addToSeries(packetStream *, uint8_t *, int32_t);
+
   signals:
     void show_mscErrors(int);
 };
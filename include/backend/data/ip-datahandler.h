@@ -27,16 +27,17 @@
 #ifndef IP_DATAHANDLER_H
 #define IP_DATAHANDLER_H
 #include "constants.h"
-#include "ringbuffer.h"
 #include "virtual-datahandler.h"
+#include <QUdpSocket>
 #include <vector>
 
-class RadioInterface;
+//	the UDP payloads go to a local port, for whoever listens
+#define IP_DATA_PORT 8888
 
 class ip_dataHandler : public virtual_dataHandler {
     Q_OBJECT
   public:
-    ip_dataHandler(RadioInterface *, RingBuffer<uint8_t> *);
+    ip_dataHandler();
     ~ip_dataHandler();
     void add_mscDatagroup(std::vector<uint8_t>);
 
@@ -44,8 +45,8 @@ class ip_dataHandler : public virtual_dataHandler {
     void process_ipVector(std::vector<uint8_t>);
     void process_udpVector(uint8_t *, int16_t);
     int16_t handledPackets;
-    RingBuffer<uint8_t> *dataBuffer;
-  signals:
-    void writeDatagram(int);
+
+    // created on the backend thread
+    QUdpSocket *socket;
 };
 #endif
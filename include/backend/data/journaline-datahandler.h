@@ -30,15 +30,27 @@
 #include "dabdatagroupdecoder.h"
 #include "virtual-datahandler.h"
 #include <QByteArray>
+#include <QUdpSocket>
+
+//	the news objects go to a local port, for a Journaline browser
+#define JOURNALINE_DATA_PORT 8890
 
 class journaline_dataHandler : public virtual_dataHandler {
+    Q_OBJECT
   public:
     journaline_dataHandler();
     ~journaline_dataHandler();
     void add_mscDatagroup(std::vector<uint8_t>);
     // void	add_mscDatagroup	(QByteArray &);
+
+    // from the data group decoder
+    void addNewsObject(unsigned long, const unsigned char *);
+
   private:
     DAB_DATAGROUP_DECODER_t theDecoder;
     DAB_DATAGROUP_DECODER_data myCallBack;
+
+    // created on the backend thread
+    QUdpSocket *socket;
 };
 #endif
@@ -33,8 +33,10 @@
 #include <QHash>
 #include <QObject>
 #include <QString>
-#include <iterator>
-#include <map>
+#include <bitset>
+
+#define MOT_MAX_SEGMENTS 8192
+#define MOT_MAX_BODY (4 * 1024 * 1024)
 
 class RadioInterface;
 
@@ -62,13 +64,24 @@ class motObject : public QObject {
     bool isCache;
     uint16_t transportId;
     int16_t numOfSegments;
+    int16_t receivedSegments;
+    int16_t lastSegment;
     int32_t segmentSize;
+    int32_t lastSize;
     uint32_t headerSize;
     uint32_t bodySize;
+
+    // the body size comes from a header, cached objects don't have one
+    bool sized;
     MOTContentType contentType;
     QString name;
     void handleComplete();
-    std::map<int, QByteArray> motMap;
+    bool placeSegment(int16_t, int32_t, bool, int32_t *);
+    bool segmentAt(int16_t, int32_t *, int32_t *);
+
+    // segments go straight to their place in the body
+    QByteArray body;
+    std::bitset<MOT_MAX_SEGMENTS> received;
 
   signals:
     void handleMotObject(QByteArray, QString, int, bool);
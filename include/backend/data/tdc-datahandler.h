@@ -27,15 +27,17 @@
 #ifndef TDC_DATA_HANDLER_H
 #define TDC_DATA_HANDLER_H
 #include "constants.h"
-#include "ringbuffer.h"
 #include "virtual-datahandler.h"
+#include <QUdpSocket>
 #include <vector>
 
-class RadioInterface;
+//	the transport frames go to a local port, for a TPEG decoder or the like
+#define TDC_DATA_PORT 8889
+
 class tdc_dataHandler : public virtual_dataHandler {
     Q_OBJECT
   public:
-    tdc_dataHandler(RadioInterface *, RingBuffer<uint8_t> *, int16_t);
+    tdc_dataHandler(int16_t);
     ~tdc_dataHandler();
     void add_mscDatagroup(std::vector<uint8_t>);
 
@@ -43,9 +45,9 @@ class tdc_dataHandler : public virtual_dataHandler {
     int32_t handleFrame_type_0(uint8_t *data, int32_t offset, int32_t length);
     int32_t handleFrame_type_1(uint8_t *data, int32_t offset, int32_t length);
     bool serviceComponentFrameheaderCRC(uint8_t *, int16_t, int16_t);
-    RadioInterface *myRadioInterface;
-    RingBuffer<uint8_t> *dataBuffer;
-  signals:
-    void bytesOut(int, int);
+    void forward(uint8_t *, int32_t);
+
+    // created on the backend thread
+    QUdpSocket *socket;
 };
 #endif
@@ -35,6 +35,7 @@ class virtual_dataHandler : public QObject {
   public:
     virtual_dataHandler() {}
     virtual ~virtual_dataHandler() {}
+    // the data group, packed msb first
     virtual void add_mscDatagroup(std::vector<uint8_t>) {}
 };
 #endif
@@ -34,10 +34,15 @@
 //	virtual class, just for providing a common base
 //	for the real decoder classes
 
+class serviceDescriptor;
+
 class frameProcessor {
   public:
     frameProcessor() {}
     virtual ~frameProcessor() {}
     virtual void addtoFrame(std::vector<uint8_t>) {}
+
+    //	packet subchannels may carry more than one service
+    virtual bool addService(serviceDescriptor *) { return false; }
 };
 #endif
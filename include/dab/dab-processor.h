@@ -132,5 +132,6 @@ class dabProcessor : public QThread {
     void showTii(int, int);
     void showStrength(float);
     void showClockErr(int);
+    void timeSynced();
 };
 #endif
@@ -0,0 +1,113 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, version 2 of the License.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DAB_SCANNER_H
+#define DAB_SCANNER_H
+/*
+ *	Band scan pre-check.
+ *	Each tuner at hand takes channels off a shared list, looks for
+ *	the OFDM plateau in the spectrum, and, if there is one, for the
+ *	null symbols of a DAB frame, so that only the channels that have
+ *	both get the full FIC decode.
+ */
+#include "constants.h"
+#include "dab-params.h"
+#include "device-handler.h"
+#include "occupancy-detector.h"
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <atomic>
+#include <complex>
+#include <vector>
+
+#define SCAN_SETTLE 100 // ms of samples dropped after tuning
+#define SCAN_FRAMES 4
+#define SCAN_TIMEOUT 2000 // ms, for a tuner that stops delivering
+
+//	in the local storage directory
+#define SCAN_RESULTS "dab-scan.txt"
+
+class dabScanner;
+
+class scanResult {
+  public:
+    QString channel;
+    int32_t frequency;
+    int index;
+
+    // -1 if the tuner could not tell
+    float plateauLevel;
+    float nullLevel;
+    bool checked;
+    bool occupied;
+    int32_t EId;
+    QString ensembleName;
+    int services;
+};
+
+class scanWorker : public QThread {
+  public:
+    scanWorker(dabScanner *, deviceHandler *, uint8_t);
+    ~scanWorker();
+    void stop();
+
+  private:
+    dabScanner *scanner;
+    deviceHandler *device;
+    dabParams params;
+    occupancyDetector detector;
+    std::atomic<bool> running;
+    std::vector<std::complex<float>> buffer;
+    bool readSamples(std::complex<float> *, int32_t);
+    float checkChannel(int32_t, float *);
+    virtual void run();
+};
+
+class dabScanner : public QObject {
+    Q_OBJECT
+  public:
+    dabScanner(const std::vector<deviceHandler *> &, uint8_t);
+    ~dabScanner();
+
+    void addChannel(int, const QString &, int32_t);
+    void start();
+    void stop();
+    std::vector<int> candidates();
+    void setEnsemble(int, int32_t, const QString &, int);
+    bool writeResults(const QString &);
+
+  private:
+    friend class scanWorker;
+    QMutex locker;
+    std::vector<scanResult> results;
+    std::vector<scanWorker *> workers;
+    int nextChannel;
+    int pending;
+    int takeChannel(int32_t *);
+    void channelChecked(int, float, float);
+    void workerDone();
+
+  signals:
+    void channelDone(const QString &, bool);
+    void checkDone();
+};
+#endif
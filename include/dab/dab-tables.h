@@ -44,6 +44,8 @@ enum serviceComponentType {
     SCTDabAudio = 0,
     SCTTDC = 5,
     SCTMPEG2TS = 24,
+    SCTJournaline = 44,
+    SCTIP = 59,
     SCTMOT = 60,
     SCTProprietary = 61,
     SCTDabPlusAudio = 63,
@@ -0,0 +1,188 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DAEMON_H
+#define DAEMON_H
+
+//	The headless counterpart of the processors: it offers the same
+//	slots as the window, but is driven from the command line and from
+//	a local control socket rather than from widgets.
+//	Only built with HEADLESS, in place of the GUI RadioInterface
+#include "radio.h"
+#include <QObject>
+#include <QList>
+#include <vector>
+
+class QLocalServer;
+class QLocalSocket;
+
+class RadioInterface: public QObject {
+Q_OBJECT
+public:
+    RadioInterface(QSettings *, deviceHandler *fileDevice = nullptr,
+		   QObject *parent = nullptr);
+    ~RadioInterface();
+
+    bool listen(const QString &);
+    bool tuneDAB(const QString &, const QString &);
+    bool tuneFM(double);
+    void resume(void);
+
+private:
+
+// DAB
+    RingBuffer<std::complex<float>> iqBuffer;
+    RingBuffer<std::complex<float>> tiiBuffer;
+    RingBuffer<float> responseBuffer;
+    RingBuffer<uint8_t> frameBuffer;
+    RingBuffer<int16_t> audioBuffer;
+#ifdef USE_SPI
+    RingBuffer<uint8_t> dataBuffer;
+#endif
+
+    dabService nextService;
+    bandHandler DABband;
+    QStringList channels;
+    QString channel;
+    dabService currentService;
+
+    // a preset service started ahead of the fic, until the fic confirms it
+    EnsembleCache *ensembles;
+    audiodata cachedService;
+    int32_t cachedEId;
+    bool cachedRunning;
+
+    // the data services of the ensemble, all run in the background
+    std::vector<dabService> dataServices;
+    processParams DABglobals;
+    int serviceOrder;
+    std::vector<serviceId> serviceList;
+    QString ensembleName;
+
+// FM
+    double FMfreq;
+    int32_t workingRate;
+    int32_t audioRate;
+    int16_t FMthreshold;
+    int FMdecoder;
+    int deemphasis;
+    int lowPassFilter;
+    int FMfilter;
+    int FMaudioGain;
+    int rdsDemodulator;
+    int rdsDecoder;
+    bool rdsPartialText;
+
+// state
+    QSettings *settings;
+    std::vector<deviceDescriptor> deviceList;
+    dabProcessor *DABprocessor;
+    fmProcessor *FMprocessor;
+    audioBase *soundOut;
+    deviceHandler *inputDevice;
+    QString deviceType;
+    QString deviceId;
+    int deviceControls;
+    bool isFM;
+    bool playing;
+    int volume;
+    int squelch;
+    QString label;
+    QString text;
+    bool stereo;
+    float strength;
+    int16_t ficBlocks;
+    int16_t ficSuccess;
+    int16_t quality;
+
+// devices
+    int agc;
+    int ifGain;
+    int minIfGain;
+    int maxIfGain;
+    int lnaGain;
+    int minLnaGain;
+    int maxLnaGain;
+
+// control socket
+    QLocalServer *server;
+    QList<QLocalSocket *> clients;
+
+    void findDevices(deviceHandler *);
+    void makeDABprocessor();
+    void makeFMprocessor();
+    void startDAB();
+    void stopDAB();
+    bool startDABService(dabService *);
+    void stopDABService();
+    void lookupCachedService(const QString &);
+    bool keepCachedService(audiodata *);
+    void dropCachedService();
+    void storeEnsemble(const QString &);
+    void startDataService(QString, uint);
+    void stopDataServices();
+    void startFM();
+    void stopFM();
+    void stop();
+    void saveSettings();
+
+    int defaultAgc() {
+	if (deviceControls & COMBO_AGC)
+	    return AGC_COMBINED;
+	else if (deviceControls & SW_AGC)
+	    return AGC_SOFTWARE;
+	else if (deviceControls & HW_AGC)
+	    return AGC_ON;
+	return AGC_OFF;
+    }
+
+// SW AGC
+    void resetSwAgc(void);
+
+// control socket
+    void command(QLocalSocket *, const QString &);
+    void reply(QLocalSocket *, const QString &);
+    void notify(const QString &, const QString &);
+
+public slots:
+    void addToEnsemble(const QString &, uint);
+    void nameOfEnsemble(int, const QString &);
+    void ensembleLoaded(int);
+    void timeSynced();
+    void showQuality(bool);
+    void showStrength(float);
+    void showLabel(QString);
+    void setProgramType(int);
+    void showPiCode(int, int);
+    void showText(QString);
+    void showSoundMode(bool);
+    void handleMotObject(QByteArray, QString, int, bool);
+    void changeInConfiguration();
+    void newAudio(int, int);
+    void scanDone();
+    void scanFound();
+
+private slots:
+    void newConnection();
+    void readCommands();
+    void dropConnection();
+};
+#endif // DAEMON_H
@@ -30,6 +30,7 @@
 #include "constants.h"
 #include "pll.h"
 #include "trigtabs.h"
+#include <vector>
 
 #define PLL_PILOT_GAIN 3000
 
@@ -60,6 +61,12 @@ private:
     DSPFLOAT Imin2;
     DSPFLOAT Qmin2;
 
+    // scratch space for the block decoder
+    std::vector<DSPCOMPLEX> normBuffer;
+    std::vector<DSPFLOAT> xBuffer;
+    std::vector<DSPFLOAT> yBuffer;
+    void normalise(const DSPCOMPLEX*, int32_t);
+
 public:
     fmDemodulator(int32_t Rate_in,
         trigTabs* fastTrigTabs,
@@ -69,6 +76,7 @@ public:
     void setDecoder(int8_t);
     const char* nameOfDecoder(void);
     DSPFLOAT demodulate(DSPCOMPLEX);
+    void demodulate(const DSPCOMPLEX*, DSPFLOAT*, int32_t);
     DSPFLOAT get_DcComponent(void);
 };
 #endif
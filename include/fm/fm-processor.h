@@ -36,6 +36,9 @@
 #include "ringbuffer.h"
 #include "rds-decoder.h"
 
+// fast scan: a wideband survey covers this much of the spectrum per retune
+#define FM_FAST_SCAN_SPAN	1800000
+
 class deviceHandler;
 class RadioInterface;
 class fmDemodulator;
@@ -77,18 +80,24 @@ public:
     void setSignalGain(int16_t);
     void setFMRDSSelector(rdsDecoder::RdsMode, bool);
     void setFMRDSDemod(rdsDemodMode);
-    void resetRDS(void);
+    void resetRDS(int32_t);
     void setSink(audioBase *);
     void startScan(void);
     void stopScan(void);
     void startFullScan(void);
     void stopFullScan(void);
+    void startFastScan(int32_t, int32_t);
+    void stopFastScan(void);
+    void setMuted(bool);
 
 private:
     virtual void run(void);
+    bool doSurvey(DSPCOMPLEX *, int32_t);
+    void findCarriers(void);
 
     deviceHandler *device;
     RadioInterface *radioInterface;
+    int32_t inputRate;
     int32_t fmRate;
     int32_t workingRate;
     int32_t decimatingScale;
@@ -96,12 +105,26 @@ private:
     int16_t threshold;
     bool initScan;
     bool scanning;
+    bool initFastScan;
+    bool fastScanning;
+    bool muted;
     bool running;
 
     int16_t signalGain;
 
     trigTabs *fastTrigTabs;
     common_fft *signalFft;
+
+    // wideband survey for fast scans
+    common_fft *surveyFft;
+    DSPFLOAT *surveyWindow;
+    DSPFLOAT *surveyPower;
+    DSPCOMPLEX *surveyBuffer;
+    int32_t surveyPointer;
+    int32_t surveySegments;
+    int32_t surveySkip;
+    int32_t surveyFrequency;
+    int32_t surveyStep;
     DecimatingFIR *fmBandFilter;
     bool newFilter;
     int32_t fmBandwidth;
@@ -143,5 +166,7 @@ signals:
     void showStrength(float);
     void showSoundMode(bool);
     void scanresult(void);
+    void fastScanFound(int);
+    void fastScanDone(void);
 };
 #endif
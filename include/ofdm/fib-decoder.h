@@ -28,19 +28,72 @@
 #define FIB_DECODER_H
 
 #include <QByteArray>
+#include <QHash>
 #include <QMutex>
 #include <QObject>
 #include <cstdint>
 #include <cstdio>
+#include <memory>
 #include "msc-handler.h"
 #include "dab-config.h"
 
 class RadioInterface;
 
+//	FIGs already seen, as hashes, and how often we forget them
+#define FIG_SEEN_SIZE	128
+#define FIG_SEEN_FLUSH	250
+
 class ensembleDescriptor;
 class dabConfig;
 class Cluster;
 
+//	What the GUI gets to see of the ensemble and the current
+//	configuration, with its indexes.
+//	It is rebuilt by the fic thread whenever a FIB changed something
+//	and swapped in whole, so the GUI never waits on fibLocker
+class fibSnapshot {
+  public:
+    class entry {
+      public:
+        QString serviceLabel;
+        uint32_t SId;
+        int SCIds;
+        bool hasName;
+        int language;
+        int programType;
+        int32_t fmFrequency;
+    };
+
+    fibSnapshot();
+    const entry *findService(const QString &) const;
+    const entry *findService(uint32_t) const;
+    const entry *findService(uint32_t, int) const;
+    const serviceComponentDescriptor *findComponent(uint32_t, int) const;
+    const serviceComponentDescriptor *findComponent(uint16_t) const;
+    const serviceComponentDescriptor *findSubChannelComponent(int16_t) const;
+
+    int32_t ensembleId;
+    QString ensembleName;
+    bool namePresent;
+    bool ecc_Present;
+    uint8_t ecc_byte;
+    std::vector<entry> services;
+    std::vector<serviceComponentDescriptor> components;
+    subChannelDescriptor subChannels[SERVICES_SIZE];
+
+  private:
+    friend class fibDecoder;
+    static uint64_t key(uint32_t SId, int SCIds) {
+        return ((uint64_t)SId << 16) | (uint16_t)SCIds;
+    }
+    QHash<QString, int> serviceByName;
+    QHash<uint32_t, int> serviceBySId;
+    QHash<uint64_t, int> serviceBySCIds;
+    QHash<uint64_t, int> componentBySCIds;
+    QHash<uint16_t, int> componentBySCId;
+    QHash<int16_t, int> componentBySubChId;
+};
+
 class fibDecoder : public QObject {
     Q_OBJECT
   public:
@@ -141,6 +194,23 @@ class fibDecoder : public QObject {
     QMutex fibLocker;
     int CIFcount;
 
+    //	the fic thread's own service indexes, under fibLocker
+    QHash<QString, int> serviceByName;
+    QHash<uint32_t, int> serviceBySId;
+    std::shared_ptr<const fibSnapshot> snapshot;
+    bool snapshotChanged;
+    void markChanged(dabConfig *);
+    void publishIfChanged();
+    void publishSnapshot();
+    void clearServiceIndex();
+    uint32_t figSeen[FIG_SEEN_SIZE];
+    int figSeenCount;
+    int fibCount;
+    uint32_t figGeneration;
+    bool seenFIG(const uint8_t *, int16_t);
+    void flushSeenFIGs();
+    uint32_t configGeneration();
+
   signals:
     void addToEnsemble(const QString &, uint);
     void nameOfEnsemble(int, const QString &);
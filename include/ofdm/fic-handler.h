@@ -51,6 +51,8 @@ class ficHandler : public fibDecoder {
   private:
     viterbiSpiral myViterbi;
     uint8_t bitBuffer_out[768];
+    //	the three FIBs, packed, plus room for a FIG running off the end
+    uint8_t fibBuffer[3 * 32 + 32];
     int16_t ofdm_input[2304];
     bool punctureTable[3072 + 24];
 
@@ -0,0 +1,56 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, version 2 of the License.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef OCCUPANCY_DETECTOR_H
+#define OCCUPANCY_DETECTOR_H
+/*
+ *	Is there a DAB ensemble on the channel at all?
+ *	An averaged spectrum of a few tens of ms is enough to tell the
+ *	flat 1.536 MHz OFDM plateau from noise, well before sync would
+ *	give up.
+ */
+#include "dab-params.h"
+#include "fft-handler.h"
+#include <cstdint>
+#include <vector>
+
+#define PLATEAU_TIME 50	     // ms of samples looked at
+#define PLATEAU_LEVEL 1.5    // plateau floor over the noise floor
+#define PLATEAU_DC 16	     // bins around DC left out, tuner spike
+#define PLATEAU_NOISE_LOW 784
+#define PLATEAU_NOISE_HIGH 912 // 1 kHz bins, clear of the neighbours
+
+class occupancyDetector {
+  public:
+    //	fftw planning is not thread safe, create from one thread only
+    occupancyDetector(uint8_t);
+    ~occupancyDetector();
+    int32_t samplesNeeded();
+    float plateauLevel(const std::complex<float> *, int32_t);
+
+  private:
+    dabParams params;
+    fftHandler my_fftHandler;
+    std::complex<float> *fft_buffer;
+    int16_t T_u;
+    int16_t carriers;
+    std::vector<float> power;
+};
+#endif
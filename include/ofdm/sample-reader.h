@@ -33,17 +33,13 @@
 #include "constants.h"
 #include "device-handler.h"
 #include "ringbuffer.h"
+#include "sndfile-writer.h"
 #include <QObject>
 #include <atomic>
 #include <cstdint>
 #include <sndfile.h>
 #include <vector>
 
-//      Note:
-//      It was found that enlarging the buffersize to e.g. 8192
-//      cannot be handled properly by the underlying system.
-#define DUMPSIZE 4096
-
 class RadioInterface;
 class sampleReader : public QObject {
     Q_OBJECT
@@ -71,11 +67,11 @@ class sampleReader : public QObject {
     float sLevel;
     int32_t sampleCount;
     int32_t corrector;
-    bool dumping;
-    int16_t dumpIndex;
     int16_t dumpScale;
-    int16_t dumpBuffer[DUMPSIZE];
-    std::atomic<SNDFILE *> dumpfilePointer;
+    sndfileWriter dumpWriter;
+    agcStats agcPending;
+    int32_t agcAmount;
+    void agcUpdate(const agcStats *, int32_t);
   signals:
     void showCorrector(int);
 };
@@ -27,11 +27,16 @@
 #define TIMESYNCER_H
 
 #include "constants.h"
+#include <complex>
 
 #define TIMESYNC_ESTABLISHED 0100
 #define NO_DIP_FOUND 0101
 #define NO_END_OF_DIP_FOUND 0102
 
+//	levels, relative to the signal, of the start and end of the null
+#define SYNC_DIP_LEVEL 0.55
+#define SYNC_END_LEVEL 0.75
+
 class sampleReader;
 
 class timeSyncer {
@@ -40,6 +45,10 @@ class timeSyncer {
     ~timeSyncer();
     int sync(int, int);
 
+    //	for the band scan, no reader needed
+    static float nullLevel(const std::complex<float> *, int32_t, int32_t,
+			   int32_t);
+
   private:
     sampleReader *myReader;
     int32_t syncBufferIndex = 0;
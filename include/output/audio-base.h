@@ -29,6 +29,7 @@
 #include "constants.h"
 #include "newconverter.h"
 #include "ringbuffer.h"
+#include "sndfile-writer.h"
 #include <QMutex>
 #include <QObject>
 #include <cstdio>
@@ -52,15 +53,13 @@ public:
     void stopDumping();
 
 private:
-    void audioOut_16000(int16_t*, int32_t);
-    void audioOut_24000(int16_t*, int32_t);
-    void audioOut_32000(int16_t*, int32_t);
+    void audioOut_convert(newConverter*, int16_t*, int32_t);
     void audioOut_48000(int16_t*, int32_t);
+    void dumpAndOutput(float*, int32_t);
     newConverter converter_16;
     newConverter converter_24;
     newConverter converter_32;
-    SNDFILE* dumpFile;
-    QMutex myLocker;
+    sndfileWriter dumpWriter;
 
 protected:
     virtual void audioOutput(float*, int32_t);
@@ -34,6 +34,10 @@
 #include <samplerate.h>
 #include <vector>
 
+// Sample rate converter for interleaved stereo frames.
+// Small integer upsampling ratios, such as the 16, 24 and 32 to
+// 48 KHz AAC cases, go through a short polyphase filter, everything
+// else through libsamplerate.
 class newConverter {
 
 public:
@@ -44,20 +48,28 @@ public:
 
     bool convert(std::complex<float> v,
         std::complex<float>* out, int32_t* amount);
+    int32_t convert(const float* in, int32_t n, float* out);
 
     int32_t getOutputsize();
+    int32_t getOutputsize(int32_t);
     void reset(void);
 
 private:
     int32_t inRate;
     int32_t outRate;
     double ratio;
-    int32_t outputLimit;
     int32_t inputLimit;
     SRC_STATE* converter;
-    SRC_DATA src_data;
     std::vector<float> inBuffer;
-    std::vector<float> outBuffer;
     int32_t inp;
+
+    // polyphase path: up by polyUp, down by polyDown
+    bool polyphase;
+    int32_t polyUp;
+    int32_t polyDown;
+    int32_t polyPhase;
+    std::vector<float> polyKernel;
+    std::vector<float> polyHistory;
+    int32_t polyConvert(const float*, int32_t, float*);
 };
 #endif
@@ -0,0 +1,85 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SNDFILE_WRITER_H
+#define SNDFILE_WRITER_H
+
+//	Moves recording off the real time path: producers copy frames
+//	into large preallocated blocks, which are handed over through a
+//	single producer, single consumer queue to a thread that does
+//	the (possibly encoding) sndfile writes.
+//	When the queue is full, frames are dropped and counted rather
+//	than stalling the producer.
+#include "constants.h"
+#include <QMutex>
+#include <QSemaphore>
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <sndfile.h>
+#include <vector>
+
+class sndfileWriter: public QThread {
+public:
+    sndfileWriter(bool floatSamples, int16_t channels,
+		  int32_t blockFrames, int16_t blockCount);
+    ~sndfileWriter(void);
+
+    void startWriting(SNDFILE *);
+    void stopWriting(void);
+    bool isWriting(void);
+    void write(const float *, int32_t);
+    void write(const int16_t *, int32_t);
+    int64_t droppedFrames(void);
+
+private:
+    void run(void);
+    void put(const void *, int32_t);
+    void publish(void);
+
+    bool floatSamples;
+    int16_t channels;
+    int32_t blockFrames;
+    int16_t blockCount;
+    int32_t frameSize;
+    std::vector<char> blocks;
+    std::vector<int32_t> blockSizes;
+
+    //	start and stop, under locker
+    QMutex locker;
+    SNDFILE *file;
+
+    //	producer side, lock free: fill belongs to whoever is in put,
+    //	or to stop once recording is off and no producer is left
+    std::atomic<bool> recording;
+    std::atomic<int> producers;
+    int32_t fill;
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+    std::atomic<bool> stopping;
+    QSemaphore published;
+
+    //	statistics, lostFrames is read from the GUI while put adds to it
+    int64_t writtenFrames;
+    std::atomic<int64_t> lostFrames;
+    uint32_t highWater;
+};
+#endif
@@ -40,6 +40,9 @@ class protection : public viterbiSpiral {
     virtual ~protection() {};
     virtual bool deconvolve(int16_t *, int32_t, uint8_t *) { return false; };
 
+    //	which bits of the mother code survive puncturing, for encoders
+    const std::vector<uint8_t> &puncturing() const { return indexTable; }
+
   protected:
     int16_t bitRate;
     int32_t outSize;
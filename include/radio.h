@@ -22,43 +22,22 @@
 #ifndef RADIO_H
 #define RADIO_H
 
-#include <QMainWindow>
-#include <QSystemTrayIcon>
-#include <QStringList>
-#include <QStandardItemModel>
-#include <QComboBox>
-#include <QLabel>
 #include <QSettings>
+#include <QStringList>
 #include <QTimer>
 #include <sndfile.h>
-#ifdef HAVE_MPRIS
-#include <Mpris>
-#include <MprisPlayer>
-#endif
-#include "ui_guglielmo.h"
-#include "ui_settings.h"
 #include "constants.h"
 #include "dab-processor.h"
 #include "fm-processor.h"
-#include "dir-cache.h"
 #include "ringbuffer.h"
 #include "band-handler.h"
 #include "device-handler.h"
+#include "device-probe.h"
 #include "process-params.h"
-
-// UI
-#define ICON_LISTVIEW_SIZE 16, 16
-#define ICON_MIN_SIZE 32
-#define ICON_MAX_SIZE 64
-#define SLIDE_MIN_SIZE 128
-
-// dialogs
-void warning(QWidget *parent, QString what);
-bool yesNo(QWidget *parent);
-QString chooseFileName(QWidget *parent, QSettings *settings, QString what, QString filters,
-			QString state, QString fileName);
+#include "ensemble-cache.h"
 
 class audioBase;
+class dabScanner;
 
 class dabService {
 public:
@@ -72,14 +51,6 @@ public:
     void setValid() { valid = (serviceName != ""); }
 };
 
-enum deviceControls {
-    HW_AGC =	0x01,
-    IF_GAIN =	0x02,
-    LNA_GAIN =	0x04,
-    SW_AGC =	0x08,
-    COMBO_AGC =	0x10
-};
-
 enum agcMode {
     AGC_OFF =		0,
     AGC_ON =		1,
@@ -87,25 +58,53 @@ enum agcMode {
     AGC_COMBINED =	3
 };
 
+#if defined(BENCHMARK)
+
+// the benchmark's counterpart only records what the processors report
+#include "bench.h"
+#elif defined(HEADLESS)
+
+// the daemon stands in for the window as the processors' counterpart
+#include "daemon.h"
+#else
+#include <QMainWindow>
+#include <QSystemTrayIcon>
+#include <QStandardItemModel>
+#include <QComboBox>
+#include <QLabel>
+#ifdef HAVE_MPRIS
+#include <Mpris>
+#include <MprisPlayer>
+#endif
+#include "ui_guglielmo.h"
+#include "ui_settings.h"
+#include "dir-cache.h"
+#include "slide-pipeline.h"
+
+// UI
+#define ICON_LISTVIEW_SIZE 16, 16
+#define ICON_MIN_SIZE 32
+#define ICON_MAX_SIZE 64
+#define SLIDE_MIN_SIZE 128
+
+// dialogs
+void warning(QWidget *parent, QString what);
+bool yesNo(QWidget *parent);
+QString chooseFileName(QWidget *parent, QSettings *settings, QString what, QString filters,
+			QString state, QString fileName);
+
 enum dabDisplay {
     DD_STATIONS =	0,
     DD_SLIDES =		1,
     DD_COUNT  = 	2
 };
 
-class deviceDescriptor {
-public:
-    QString deviceType;
-    deviceHandler *device;
-    int controls;
-};
-
 class RadioInterface: public QWidget, private Ui_guglielmo {
 Q_OBJECT
 public:
-    RadioInterface(QSettings *, QWidget	*parent = nullptr);
+    RadioInterface(QSettings *, deviceHandler *fileDevice = nullptr,
+		   QWidget *parent = nullptr);
     ~RadioInterface();
-    void processGain(agcStats *stats, int amount);
 
 private:
 
@@ -124,9 +123,19 @@ private:
     dabService currentService;
 
     ImageCache *cache;
+    slidePipeline *slides;
+
+    // the generation of the cache in use, and of the images for it
+    uint slidesGeneration;
+
+    // a preset service started ahead of the fic, until the fic confirms it
+    EnsembleCache *ensembles;
+    audiodata cachedService;
+    int32_t cachedEId;
+    bool cachedRunning;
 
-    // currently we only support one data service
-    dabService dataService;
+    // the data services of the ensemble, all run in the background
+    std::vector<dabService> dataServices;
     processParams DABglobals;
     int serviceOrder;
     int scanIndex;
@@ -196,13 +205,6 @@ private:
     int minLnaGain;
     int maxLnaGain;
     int agc;
-    int swAgc;
-    int swAgcSkip;
-    int swAgcAccrue;
-    int swAgcAmount;
-    agcStats stats;
-    int minSignal;
-    int maxSignal;
 
     int dabDisplay;
     bool isFM;
@@ -216,6 +218,17 @@ private:
     double scanIncrement;
     int scanInterval;
     int scanRetry;
+    bool fastScanning;
+    bool fastScanRds;
+    int32_t fastScanFrequency;
+    std::vector<int32_t> fastScanCandidates;
+    int fastScanIndex;
+
+    // DAB scan: the pre-check tuners, and the channels that passed it
+    dabScanner *scanner;
+    std::vector<deviceHandler *> scanDevices;
+    std::vector<int> scanChannels;
+    int scanPosition;
 
 // audio
     audioBase *soundOut;
@@ -232,22 +245,27 @@ private:
     dabService saveService;
 
 // operation
-    void findDevices();
+    void findDevices(deviceHandler *);
     void makeDABprocessor();
     void makeFMprocessor();
     void startDAB();
     void stopDAB();
     void startDABService(dabService *);
     void stopDABService();
+    void lookupCachedService(const QString &);
+    bool keepCachedService(audiodata *);
+    void dropCachedService();
+    void storeEnsemble(const QString &);
     void startDataService(QString, uint);
     void stopDataServices();
     void handleSlides(QByteArray data, int contentType, QString pictureName, int dirs);
     void showSlides(QPixmap p);
-    void handleEPGPicture(QByteArray data, const char *type, QString pictureName);
     void startFM(int32_t);
     void stopFM();
     void startFMscan(bool);
     void stopFMscan();
+    bool nextScanChannel();
+    void releaseScanDevices();
     void toFM();
     void toDAB();
     void setPlaying();
@@ -286,23 +304,27 @@ private:
 
 // SW AGC
     void resetSwAgc(void);
-    void resetAgcStats(void);
 
 public slots:
     void addToEnsemble(const QString &, uint);
     void nameOfEnsemble(int, const QString &);
     void ensembleLoaded(int);
+    void timeSynced();
     void showQuality(bool);
     void showStrength(float);
     void showLabel(QString);
     void setProgramType(int);
+    void showPiCode(int, int);
     void showText(QString);
     void showSoundMode(bool);
     void handleMotObject(QByteArray, QString, int, bool);
+    void showSlide(QImage, uint);
+    void showPicture(QImage, int, int, int, uint);
     void changeInConfiguration();
     void newAudio(int, int);
     void scanDone();
     void scanFound();
+    void fastScanFound(int);
     void scanEnsembleLoaded();
     void closeEvent(QCloseEvent *event);
     void changeEvent(QEvent *event);
@@ -385,7 +407,11 @@ private slots:
 // scan
     void nextFrequency();
     void nextFullScanFrequency();
+    void nextFastScanFrequency();
+    void nextFastScanCandidate();
     void nextFullDABScan();
+    void scanChannelChecked(const QString &, bool);
+    void scanCheckDone();
 
 #ifdef HAVE_MPRIS
 // MPRIS
@@ -402,4 +428,5 @@ signals:
     void advanceScan(int);
     void newSkin(QString);
 };
+#endif		// BENCHMARK, HEADLESS
 #endif		// RADIO_H
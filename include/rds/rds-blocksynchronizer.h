@@ -29,8 +29,6 @@
 #include "constants.h"
 #include "rds-group.h"
 #include <QObject>
-#include <array>
-#include <unordered_map>
 
 class RadioInterface;
 
@@ -49,13 +47,17 @@ static const uint32_t CRC_POLY = 0x5B9;
 static const uint32_t REMAINDER_POLY = 0x31B;
 static const uint32_t NUM_BITS_BER_CALC_RESET = 4000;
 
-// Precomputed burst error correction lookup table.
-// Maps syndrome -> error_vector for 1-bit and 2-bit contiguous burst errors
-// at every bit position in the 26-bit block, for each of the 5 offset words.
-// Built once at startup, used for O(1) correction in decodeBlock.
-struct BurstErrorTable {
-    std::unordered_map<uint32_t, uint32_t> table[5]; // 0=A, 1=B, 2=C1, 3=C2, 4=D
-    BurstErrorTable();
+// Precomputed syndrome tables.
+// The syndrome is linear in the received bits, so it is kept up to
+// date as bits come in: shifting one bit into the 26-bit window is a
+// multiply by x plus two conditional xors.
+// burst maps a syndrome onto the error pattern of the shortest burst
+// (up to 5 bits, EN 50067 Annex B) producing it, 0 if there is none.
+struct SyndromeTables {
+    uint16_t outgoing;	// syndrome of the bit leaving the window
+    uint16_t offset[5];	// 0=A, 1=B, 2=C1, 3=C2, 4=D
+    uint32_t burst[1 << NUM_BITS_CRC];
+    SyndromeTables();
 };
 
 class rdsBlockSynchronizer: public QObject {
@@ -84,14 +86,15 @@ public:
 
 private:
     RadioInterface* MyRadioInterface;
-    bool decodeBlock(RDSGroup::RdsBlock, uint32_t, bool);
-    uint32_t getSyndrome(uint32_t, uint32_t);
+    bool decodeBlock(RDSGroup::RdsBlock, bool);
+    void shiftBit(bool);
+    uint32_t getSyndrome(RDSGroup::RdsBlock, bool);
     void setNextBlock(void);
-    uint32_t correctBurstErrors(uint32_t syndrome, RDSGroup::RdsBlock b, bool isTypeBGroup);
-    uint32_t getOffset(RDSGroup::RdsBlock, bool);
+    uint32_t correctBurstErrors(uint32_t);
     bool crcFecEnabled;
     static const RDSGroup::RdsBlock SYNC_END_BLOCK = RDSGroup::BLOCK_C;
     uint32_t rdsBitstream;
+    uint32_t rdsSyndrome;
     uint32_t rdsBitCount;
     bool rdsIsSynchronized;
     RDSGroup::RdsBlock rdsCurrentBlock;
@@ -40,6 +40,7 @@
 
 #include "constants.h"
 #include "fft.h"
+#include "fir-engine.h"
 #include "iir-filters.h"
 #include "rds-blocksynchronizer.h"
 #include "rds-group.h"
@@ -62,7 +63,7 @@ public:
     };
     void setPartialText(bool);
     void doDecode(DSPFLOAT, RdsMode);
-    void reset(void);
+    void reset(int32_t);
 
 private:
     void processBit(bool);
@@ -82,9 +83,8 @@ private:
     DSPFLOAT bitClkPhase;
     DSPFLOAT prevClkState;
 
-    DSPFLOAT* rdsBuffer;
+    firDelayLine<DSPFLOAT>* rdsBuffer;
     DSPFLOAT* rdsKernel;
-    int16_t matchIndex;
     int16_t rdsFilterSize;
     BandPassIIR* sharpFilter;
     DSPFLOAT rdsLastSyncSlope;
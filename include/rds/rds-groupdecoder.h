@@ -51,6 +51,7 @@ public:
     void setPartialText(bool);
     bool decode(RDSGroup*);
     void reset(void);
+    void setFrequency(int32_t);
 
     // group 1 constants
     static const uint32_t NUMBER_OF_NAME_SEGMENTS = 4;
@@ -73,6 +74,7 @@ private:
     void addToStationLabel(uint32_t, uint32_t, int16_t);
     QString prepareText(char*, int16_t);
     uint32_t piCode;
+    int32_t frequency;
     uint16_t* alphabet;
     bool alphabetSwitcher(uint8_t, uint8_t);
     uint16_t* setAlphabetTo(uint8_t, uint8_t);
@@ -93,5 +95,8 @@ private:
 signals:
     void setStationLabel(const QString&);
     void setRadioText(const QString&);
+
+    // with the frequency being decoded, a queued code may be stale
+    void setPiCode(int, int);
 };
 #endif
@@ -33,6 +33,7 @@
 #define	GROUP_RDS	"rds"
 #define	GROUP_PRESETS	"presets"	// this is an array, but still
 #define GROUP_DIALOGS	"dialogs"
+#define GROUP_DAEMON	"daemon"
 
 // keys
 
@@ -103,6 +104,7 @@
 #define FM_LOW_PASS_FILTER	"lowPass"
 #define FM_AUDIO_GAIN		"audioGain"
 #define FM_STEP 		"step"
+#define FM_FAST_SCAN_RDS	"fastScanRds"
 
 #define FM_DEF_WORKING_RATE	"48000"
 #define FM_DEF_THRESHOLD	"20"
@@ -112,6 +114,7 @@
 #define FM_DEF_LOW_PASS_FILTER	"20000"
 #define FM_DEF_AUDIO_GAIN	"75"
 #define FM_DEF_STEP		"100"
+#define FM_DEF_FAST_SCAN_RDS	"0"
 
 #define RDS_DEMODULATOR		"demodulator"
 #define RDS_DECODER		"decoder"
@@ -148,4 +151,9 @@
 
 // dialogs
 #define DIALOGS_RECORDING	"recording"
+
+// daemon
+#define DAEMON_SOCKET		"socket"
+
+#define DAEMON_DEF_SOCKET	TARGET
 #endif		// __SETTINGS_H__
@@ -27,57 +27,14 @@
 #ifndef BITS_HELPER_H
 #define BITS_HELPER_H
 
-static inline bool
-check_CRC_bits(uint8_t* in, int32_t size) {
-    static const uint8_t crcPolynome[]
-        = { 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0 }; // MSB .. LSB
-    int32_t i, f;
-    uint8_t b[16];
-    int16_t Sum = 0;
-
-    memset(b, 1, 16);
-
-    for (i = size - 16; i < size; i++)
-        in[i] ^= 1;
-
-    for (i = 0; i < size; i++) {
-        if ((b[0] ^ in[i]) == 1) {
-            for (f = 0; f < 15; f++)
-                b[f] = crcPolynome[f] ^ b[f + 1];
-            b[15] = 1;
-        } else {
-            memmove(&b[0], &b[1], sizeof(uint8_t) * 15); // Shift
-            b[15] = 0;
-        }
-    }
-
-    for (i = 0; i < 16; i++)
-        Sum += b[i];
-
-    return Sum == 0;
-}
+#include <cstdint>
+#include <cstring>
+#include "crc16.h"
 
+//	the crc is held, inverted, in the two bytes following msg
 static inline bool
-check_crc_bytes(uint8_t* msg, int32_t len) {
-    int i, j;
-    uint16_t accumulator = 0xFFFF;
-    uint16_t crc;
-    uint16_t genpoly = 0x1021;
-
-    for (i = 0; i < len; i++) {
-        int16_t data = msg[i] << 8;
-        for (j = 8; j > 0; j--) {
-            if ((data ^ accumulator) & 0x8000)
-                accumulator = ((accumulator << 1) ^ genpoly) & 0xFFFF;
-            else
-                accumulator = (accumulator << 1) & 0xFFFF;
-            data = (data << 1) & 0xFFFF;
-        }
-    }
-
-    // ok, now check with the crc that is contained in the au
-    crc = ~((msg[len] << 8) | msg[len + 1]) & 0xFFFF;
-    return (crc ^ accumulator) == 0;
+check_crc_bytes(const uint8_t* msg, int32_t len) {
+    return check_crc16(msg, len);
 }
 
 static inline uint16_t
@@ -206,4 +163,33 @@ getLBits(uint8_t* d, int32_t offset, int16_t size) {
     }
     return res;
 }
+
+//	the same, for bits packed msb first, eight to a byte.
+//	Up to 16 bits, a read touches at most three bytes
+static inline uint16_t
+getPackedBits(const uint8_t* d, int32_t offset, int16_t size) {
+    const uint8_t* b = d + (offset >> 3);
+    uint32_t res = (b[0] << 16) | (b[1] << 8) | b[2];
+
+    return (res >> (24 - (offset & 7) - size)) & ((1 << size) - 1);
+}
+
+static inline uint32_t
+getPackedLBits(const uint8_t* d, int32_t offset, int16_t size) {
+    if (size <= 16)
+        return getPackedBits(d, offset, size);
+    return (getPackedBits(d, offset, size - 16) << 16) |
+           getPackedBits(d, offset + size - 16, 16);
+}
+
+//	and the packing itself, from one bit per byte
+static inline void
+packBits(const uint8_t* in, uint8_t* out, int32_t nBytes) {
+    for (int32_t i = 0; i < nBytes; i++) {
+        uint8_t b = 0;
+        for (int16_t j = 0; j < 8; j++)
+            b = (b << 1) | (in[8 * i + j] & 0x01);
+        out[i] = b;
+    }
+}
 #endif
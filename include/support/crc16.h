@@ -0,0 +1,39 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef CRC16_H
+#define CRC16_H
+
+//	CRC16-CCITT, x^16 + x^12 + x^5 + 1, msb first, as used by the FIBs,
+//	the AUs, the packets and the MSC data groups.
+//	It works on packed bytes, eight at a time, off eight tables.
+#include <stdint.h>
+
+uint16_t crc16(const uint8_t *data, int32_t length, uint16_t crc = 0xFFFF);
+
+//	the two bytes following msg hold the crc of the length before,
+//	inverted
+static inline bool check_crc16(const uint8_t *msg, int32_t length) {
+    uint16_t crc = ~((msg[length] << 8) | msg[length + 1]) & 0xFFFF;
+
+    return crc16(msg, length) == crc;
+}
+#endif
@@ -22,13 +22,22 @@
 #ifndef __DIR_CACHE_H__
 #define __DIR_CACHE_H__
 
+#include <QCache>
 #include <QHash>
-#include <QMultiHash>
 #include <QDir>
 #include <QString>
 #include <QList>
+#include <QMutex>
 #include <QPixmap>
-#include <QRegularExpression>
+
+//	Images are stored under the hash of their content, so that the
+//	same logo sent on several channels or services is only kept once.
+//	What channel and service each image belongs to is in an index
+//	file that is appended to as images come in, and read once, when
+//	the cache is created.
+#define IMAGE_INDEX	"index"
+#define IMAGE_DIR	"images"
+#define IMAGE_LRU	(16 * 1024)	// KB of decoded pixmaps kept
 
 struct ImageInfo {
     QString path;
@@ -44,11 +53,14 @@ struct ImageInfo {
     }
 };
 
+// the slide pipeline adds images from its own thread
 class ImageCache {
 public:
     ImageCache(const QString& cacheDir);
     ~ImageCache();
 
+    // the lookups and additions are for the channel set here
+    void setChannel(const QString& channel);
     QString toServiceId(int32_t SId) { return QString::number(SId, 16).toLower(); }
     int imageCount();
     bool hasImage(int32_t SId, int width, int height, 
@@ -56,17 +68,34 @@ public:
     QList<ImageInfo> getImagesForChannel(int32_t SId);
     void addImage(int32_t SId, int width, int height, 
 		  const QString& imageType, const QByteArray& image);
+
+    // GUI thread only
     QPixmap loadImage(const QString& path);
     
 private:
     QString cacheDir;
-    QHash<QString, QString> cache;
-    QMultiHash<QString, ImageInfo> channelIndex;
-    
-    void loadCache(void);
-    void removeFromChannelIndex(const QString& serviceId, int width, 
-				int height, const QString& imageType);
-    QString hashKey(QString serviceId, int width, int height, const QString& imageType);
+    QString channel;
+    QMutex locker;
+
+    // the index file, appended to outside of locker
+    QMutex indexLocker;
+
+    // channel/service to the images, and how many entries use a file
+    QHash<QString, QList<ImageInfo>> services;
+    QHash<QString, int> references;
+    int channelImages;
+
+    // decoded, keyed by path
+    QCache<QString, QPixmap> pixmaps;
+
+    void loadIndex(void);
+    void writeIndex(void);
+    void appendIndex(const QByteArray& line);
+    QByteArray indexLine(const QString& key, const ImageInfo& info);
+    void migrate(void);
+    bool insert(const QString& key, const ImageInfo& info, QString *unused);
+    QString serviceKey(const QString& channel, const QString& serviceId);
+    QString imagePath(const QString& hash, const QString& imageType);
     QString calculateHash(const QByteArray& data);
 };
 #endif		// __DIR_CACHE_H__
@@ -0,0 +1,52 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __ENSEMBLE_CACHE_H__
+#define __ENSEMBLE_CACHE_H__
+
+#include <QString>
+#include <vector>
+#include "constants.h"
+#include "services.h"
+
+//	The subchannel layout of the ensembles seen so far, one file per
+//	channel, one group per EId, so that a service can be started on
+//	retune before the FIC has been decoded.
+//	Entries are only ever a guess: whatever is found here has to be
+//	checked against the FIC once it comes in.
+class EnsembleCache {
+public:
+    EnsembleCache(const QString& cacheDir);
+    ~EnsembleCache();
+
+    bool lookup(const QString& channel, const QString& serviceName,
+		int32_t *EId, audiodata *ad);
+    void store(const QString& channel, int32_t EId,
+	       const std::vector<audiodata>& services);
+    void drop(const QString& channel);
+    static bool sameLayout(const audiodata *a, const audiodata *b);
+
+private:
+    QString cacheDir;
+
+    QString fileName(const QString& channel);
+};
+#endif		// __ENSEMBLE_CACHE_H__
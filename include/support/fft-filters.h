@@ -30,6 +30,12 @@
 #include "constants.h"
 #include "fft.h"
 
+// Overlap-save FFT filter.
+// Samples are collected in blocks of fftSize - filterDegree, and
+// each output block lags the input by one block, both for the single
+// sample and the block versions of Pass.
+// Real signals take the r2c/c2r route, at about half the cost,
+// and only see the real part of the kernel.
 class fftFilter {
 
 public:
@@ -38,22 +44,53 @@ public:
     void setBand(int32_t, int32_t, int32_t);
     void setSimple(int32_t, int32_t, int32_t);
     void setLowPass(int32_t, int32_t);
-    DSPCOMPLEX Pass(DSPCOMPLEX);
-    DSPFLOAT Pass(DSPFLOAT);
+
+    DSPCOMPLEX Pass(DSPCOMPLEX z) {
+        DSPCOMPLEX sample = complexResult[OverlapSize + inp];
+
+        complexWindow[OverlapSize + inp] = z;
+        if (++inp >= NumofSamples)
+            processComplex();
+        return sample;
+    }
+
+    DSPFLOAT Pass(DSPFLOAT x) {
+        DSPFLOAT sample = realResult[OverlapSize + inp];
+
+        realWindow[OverlapSize + inp] = x;
+        if (++inp >= NumofSamples)
+            processReal();
+        return sample;
+    }
+
+    void Pass(const DSPCOMPLEX*, DSPCOMPLEX*, int32_t);
+    void Pass(const DSPFLOAT*, DSPFLOAT*, int32_t);
 
 private:
     int32_t fftSize;
     int16_t filterDegree;
     int16_t OverlapSize;
     int16_t NumofSamples;
-    common_fft* MyFFT;
-    DSPCOMPLEX* FFT_A;
-    common_ifft* MyIFFT;
-    DSPCOMPLEX* FFT_C;
-    common_fft* FilterFFT;
-    DSPCOMPLEX* filterVector;
-    DSPFLOAT* RfilterVector;
-    DSPCOMPLEX* Overloop;
     int32_t inp;
+
+    // filter spectra, with the inverse transform scaling folded in
+    DSPCOMPLEX* filterVector;
+    DSPCOMPLEX* RfilterVector;
+
+    DSPCOMPLEX* complexWindow;
+    DSPCOMPLEX* complexSpectrum;
+    DSPCOMPLEX* complexResult;
+    fftwf_plan complexForward;
+    fftwf_plan complexBackward;
+
+    DSPFLOAT* realWindow;
+    DSPCOMPLEX* realSpectrum;
+    DSPFLOAT* realResult;
+    fftwf_plan realForward;
+    fftwf_plan realBackward;
+
+    void setKernel(const DSPCOMPLEX*);
+    void processComplex(void);
+    void processReal(void);
 };
 #endif
@@ -0,0 +1,134 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FIR_ENGINE_H
+#define FIR_ENGINE_H
+
+#include "constants.h"
+
+// sum of a[i] * b[i]
+DSPFLOAT firDot(const DSPFLOAT* a, const DSPFLOAT* b, int n);
+
+// as above, but even and odd elements are accumulated separately:
+// this is a real kernel over interleaved complex samples, or
+// the componentwise kernel of the hilbert filter
+void firDot2(const DSPFLOAT* a, const DSPFLOAT* b, int n, DSPFLOAT* even, DSPFLOAT* odd);
+
+// The delay line is twice the filter length and each sample is
+// written twice, so that the last size samples are always
+// contiguous, oldest first, and the inner loops never wrap around.
+template <typename T> class firDelayLine {
+public:
+    firDelayLine(int size) {
+        this->size = size;
+        buffer = new T[2 * size];
+        reset();
+    }
+
+    ~firDelayLine(void) {
+        delete[] buffer;
+    }
+
+    void reset(void) {
+        for (int i = 0; i < 2 * size; i++)
+            buffer[i] = T(0);
+        ip = 0;
+    }
+
+    const T* push(T v) {
+        buffer[ip] = v;
+        buffer[ip + size] = v;
+        if (++ip >= size)
+            ip = 0;
+        return &buffer[ip];
+    }
+
+private:
+    int size;
+    int ip;
+    T* buffer;
+
+    firDelayLine(const firDelayLine&);
+    firDelayLine& operator=(const firDelayLine&);
+};
+
+// The FIR engine proper: the kernel is stored reversed, to match
+// the delay line order, and split according to its type.
+// Real kernels, the majority, only cost one multiply per
+// sample component, complex kernels cost two.
+class firEngine {
+public:
+    firEngine(int16_t);
+    ~firEngine(void);
+    void setKernel(const DSPCOMPLEX*);
+    void reset(void);
+
+    void push(DSPCOMPLEX z) {
+        complexLine.push(z);
+    }
+
+    void push(DSPFLOAT v) {
+        realLine.push(v);
+    }
+
+    DSPCOMPLEX Pass(DSPCOMPLEX z) {
+        const DSPFLOAT* w = reinterpret_cast<const DSPFLOAT*>(complexLine.push(z));
+        DSPFLOAT re, im;
+
+        firDot2(w, pairKernel, 2 * size, &re, &im);
+        if (complexKernel) {
+            re -= im;
+            im = firDot(w, swappedKernel, 2 * size);
+        }
+        return DSPCOMPLEX(re, im);
+    }
+
+    // real input only sees the real part of the kernel
+    DSPFLOAT Pass(DSPFLOAT v) {
+        return firDot(realLine.push(v), realKernel, size);
+    }
+
+    void Pass(const DSPCOMPLEX* in, DSPCOMPLEX* out, int n) {
+        for (int i = 0; i < n; i++)
+            out[i] = Pass(in[i]);
+    }
+
+    void Pass(const DSPFLOAT* in, DSPFLOAT* out, int n) {
+        for (int i = 0; i < n; i++)
+            out[i] = Pass(in[i]);
+    }
+
+private:
+    int16_t size;
+    bool complexKernel;
+    DSPFLOAT* realKernel;
+
+    // real kernels: (k, k) pairs
+    // complex kernels: (re, im) pairs, and (im, re) in swappedKernel
+    DSPFLOAT* pairKernel;
+    DSPFLOAT* swappedKernel;
+    firDelayLine<DSPCOMPLEX> complexLine;
+    firDelayLine<DSPFLOAT> realLine;
+
+    firEngine(const firEngine&);
+    firEngine& operator=(const firEngine&);
+};
+#endif
@@ -29,6 +29,7 @@
 
 #include "constants.h"
 #include "fft.h"
+#include "fir-engine.h"
 #include <math.h>
 #include <stdlib.h>
 
@@ -39,60 +40,44 @@ class Basic_FIR {
 public:
     int16_t filterSize;
     DSPCOMPLEX* filterKernel;
-    DSPCOMPLEX* Buffer;
-    int16_t ip;
     int32_t sampleRate;
 
-    Basic_FIR(int16_t size) {
+    Basic_FIR(int16_t size)
+        : engine(size) {
         int16_t i;
         filterSize = size;
         filterKernel = new DSPCOMPLEX[filterSize];
-        Buffer = new DSPCOMPLEX[filterSize];
-        ip = 0;
 
-        for (i = 0; i < filterSize; i++) {
+        for (i = 0; i < filterSize; i++)
             filterKernel[i] = 0;
-            Buffer[i] = 0;
-        }
     }
 
     ~Basic_FIR(void) {
         delete[] filterKernel;
-        delete[] Buffer;
     }
 
-    // we process the samples backwards rather than reversing
-    // the kernel
     DSPCOMPLEX Pass(DSPCOMPLEX z) {
-        int16_t i;
-        DSPCOMPLEX tmp = 0;
-
-        Buffer[ip] = z;
-        for (i = 0; i < filterSize; i++) {
-            int16_t index = ip - i;
-            if (index < 0)
-                index += filterSize;
-            tmp += Buffer[index] * filterKernel[i];
-        }
-
-        ip = (ip + 1) % filterSize;
-        return tmp;
+        return engine.Pass(z);
     }
 
     DSPFLOAT Pass(DSPFLOAT v) {
-        int16_t i;
-        DSPFLOAT tmp = 0;
-
-        Buffer[ip] = DSPCOMPLEX(v, 0);
-        for (i = 0; i < filterSize; i++) {
-            int16_t index = ip - i;
-            if (index < 0)
-                index += filterSize;
-            tmp += real(Buffer[index]) * real(filterKernel[i]);
-        }
-
-        ip = (ip + 1) % filterSize;
-        return tmp;
+        return engine.Pass(v);
+    }
+
+    void Pass(const DSPCOMPLEX* in, DSPCOMPLEX* out, int n) {
+        engine.Pass(in, out, n);
+    }
+
+    void Pass(const DSPFLOAT* in, DSPFLOAT* out, int n) {
+        engine.Pass(in, out, n);
+    }
+
+protected:
+    firEngine engine;
+
+    // to be called every time filterKernel changes
+    void updateKernel(void) {
+        engine.setKernel(filterKernel);
     }
 };
 
@@ -118,6 +103,8 @@ public:
     void newKernel(int32_t, int32_t);
     bool Pass(DSPCOMPLEX, DSPCOMPLEX*);
     bool Pass(DSPFLOAT, DSPFLOAT*);
+    int Pass(const DSPCOMPLEX*, DSPCOMPLEX*, int);
+    int Pass(const DSPFLOAT*, DSPFLOAT*, int);
     DSPCOMPLEX* getKernel(void);
 
 private:
@@ -173,14 +160,15 @@ public:
     ~HilbertFilter();
     DSPCOMPLEX Pass(DSPCOMPLEX);
     DSPCOMPLEX Pass(DSPFLOAT, DSPFLOAT);
+    void Pass(const DSPCOMPLEX*, DSPCOMPLEX*, int);
 
 private:
-    int16_t ip;
     int16_t firsize;
     int32_t rate;
-    DSPFLOAT* cosKernel;
-    DSPFLOAT* sinKernel;
-    DSPCOMPLEX* Buffer;
+
+    // interleaved cos and sin kernels, in delay line order
+    DSPFLOAT* kernel;
+    firDelayLine<DSPCOMPLEX> delayLine;
     void adjustFilter(DSPFLOAT);
 };
 #endif
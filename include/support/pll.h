@@ -39,6 +39,7 @@ public:
 
     DSPFLOAT doPll(DSPCOMPLEX signal);
     DSPFLOAT doPll(DSPCOMPLEX signal, DSPFLOAT phase);
+    void doPll(const DSPCOMPLEX* signal, DSPFLOAT* phaseIncr, int32_t n);
     DSPFLOAT getPhaseIncr(void);
     DSPFLOAT getNcoPhase(void);
     void reset(void);
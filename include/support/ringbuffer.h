@@ -66,130 +66,152 @@
 
 #ifndef RINGBUFFER_H
 #define RINGBUFFER_H
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <mutex>
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 /*
  *	a simple ringbuffer, lockfree, however only for a
  *	single reader and a single writer.
  *	Mostly used for getting samples from or to the soundcard
+ *
+ *	The indices run freely over the whole uint32_t range, the
+ *	element count being a power of two. Each side keeps a snapshot
+ *	of the other side's index and only reloads it when the snapshot
+ *	says there is not enough data or room, and the two sides live on
+ *	separate cache lines.
+ *	Optionally, the storage is mapped twice in a row in virtual memory,
+ *	so that a region never wraps: reads and writes are then always
+ *	a single contiguous span.
+ *	The blocking calls sleep on a condition variable, which the other
+ *	side only signals when somebody is waiting, so that the plain
+ *	calls, in device callbacks, never take a lock.
  */
-#ifdef __APPLE__
-#include <libkern/OSAtomic.h>
-#ifdef OSATOMIC_DEPRECATED
-#include <atomic>
-#endif
-#
-/* Mac OS X only provides
-       full memory barriers, so the three types of barriers are the same,
-       however, these barriers are superior to compiler-based ones. */
-
-inline void Apple_MemoryBarrier() {
-#ifdef OSATOMIC_DEPRECATED
-    std::atomic_thread_fence(std::memory_order_seq_cst);
-#else
-    OSMemoryBarrier();
-#endif
-}
-#define PaUtil_FullMemoryBarrier() Apple_MemoryBarrier()
-#define PaUtil_ReadMemoryBarrier() Apple_MemoryBarrier()
-#define PaUtil_WriteMemoryBarrier() Apple_MemoryBarrier()
-#elif defined(__GNUC__)
-/* GCC >= 4.1 has built-in intrinsics. We'll use those */
-#if (__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 1)
-#define PaUtil_FullMemoryBarrier() __sync_synchronize()
-#define PaUtil_ReadMemoryBarrier() __sync_synchronize()
-#define PaUtil_WriteMemoryBarrier() __sync_synchronize()
-/* as a fallback, GCC understands volatile asm and "memory" to mean it
-     * should not reorder memory read/writes */
-#elif defined(__PPC__)
-#define PaUtil_FullMemoryBarrier() asm volatile("sync" :: \
-                                                    : "memory")
-#define PaUtil_ReadMemoryBarrier() asm volatile("sync" :: \
-                                                    : "memory")
-#define PaUtil_WriteMemoryBarrier() asm volatile("sync" :: \
-                                                     : "memory")
-#elif defined(__i386__) || defined(__i486__) || defined(__i586__) || defined(__i686__) || defined(__x86_64__)
-#define PaUtil_FullMemoryBarrier() asm volatile("mfence" :: \
-                                                    : "memory")
-#define PaUtil_ReadMemoryBarrier() asm volatile("lfence" :: \
-                                                    : "memory")
-#define PaUtil_WriteMemoryBarrier() asm volatile("sfence" :: \
-                                                     : "memory")
-#else
-#ifdef ALLOW_SMP_DANGERS
-#warning Memory barriers not defined on this system or system unknown
-#warning For SMP safety, you should fix this.
-#define PaUtil_FullMemoryBarrier()
-#define PaUtil_ReadMemoryBarrier()
-#define PaUtil_WriteMemoryBarrier()
-#else
-#error Memory barriers are not defined on this system. You can still compile by defining ALLOW_SMP_DANGERS, but SMP safety will not be guaranteed.
-#endif
-#endif
-#elif (_MSC_VER >= 1400) && !defined(_WIN32_WCE)
-#include <intrin.h>
-#pragma intrinsic(_ReadWriteBarrier)
-#pragma intrinsic(_ReadBarrier)
-#pragma intrinsic(_WriteBarrier)
-/* note that MSVC intrinsics _ReadWriteBarrier(), _ReadBarrier(), _WriteBarrier() are just compiler barriers *not* memory barriers */
-#define PaUtil_FullMemoryBarrier() _ReadWriteBarrier()
-#define PaUtil_ReadMemoryBarrier() _ReadBarrier()
-#define PaUtil_WriteMemoryBarrier() _WriteBarrier()
-#elif defined(_WIN32_WCE)
-#define PaUtil_FullMemoryBarrier()
-#define PaUtil_ReadMemoryBarrier()
-#define PaUtil_WriteMemoryBarrier()
-#elif defined(_MSC_VER) || defined(__BORLANDC__)
-#define PaUtil_FullMemoryBarrier() _asm { lock add    [esp], 0 }
-#define PaUtil_ReadMemoryBarrier() _asm { lock add    [esp], 0 }
-#define PaUtil_WriteMemoryBarrier() _asm { lock add    [esp], 0 }
-#else
-#ifdef ALLOW_SMP_DANGERS
-#warning Memory barriers not defined on this system or system unknown
-#warning For SMP safety, you should fix this.
-#define PaUtil_FullMemoryBarrier()
-#define PaUtil_ReadMemoryBarrier()
-#define PaUtil_WriteMemoryBarrier()
-#else
-#error Memory barriers are not defined on this system. You can still compile by defining ALLOW_SMP_DANGERS, but SMP safety will not be guaranteed.
-#endif
-#endif
+#define RING_CACHE_LINE 64
 
 template <class elementtype>
 class RingBuffer {
 private:
+    char leadPad[RING_CACHE_LINE];
+
+    // producer side
+    std::atomic<uint32_t> writeIndex;
+    uint32_t readSnapshot;
+    char producerPad[RING_CACHE_LINE - sizeof(std::atomic<uint32_t>) - sizeof(uint32_t)];
+
+    // consumer side, readCapture is the read index the regions were
+    // worked out from
+    std::atomic<uint32_t> readIndex;
+    uint32_t writeSnapshot;
+    uint32_t readCapture;
+    char consumerPad[RING_CACHE_LINE - sizeof(std::atomic<uint32_t>) - 2 * sizeof(uint32_t)];
+
     uint32_t bufferSize;
-    volatile uint32_t writeIndex;
-    volatile uint32_t readIndex;
-    uint32_t bigMask;
     uint32_t smallMask;
+    uint32_t bigMask;
     char* buffer;
+    size_t mappedSize;
+
+    std::atomic<int> waiters;
+    std::mutex waitLock;
+    std::condition_variable waitCond;
+
+/*
+ * 	maps the same memory twice, back to back, returns nullptr
+ * 	where that is not possible, and the caller allocates normally
+ */
+    static char* mirrorMap(size_t size) {
+#if defined(__linux__) && defined(SYS_memfd_create)
+        long pageSize = sysconf(_SC_PAGESIZE);
+
+        if (pageSize <= 0 || size % pageSize != 0)
+            return nullptr;
+        int fd = syscall(SYS_memfd_create, "ringbuffer", 0);
+        if (fd < 0)
+            return nullptr;
+        if (ftruncate(fd, size) != 0) {
+            close(fd);
+            return nullptr;
+        }
+        char* base = (char*)mmap(nullptr, 2 * size, PROT_NONE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base == MAP_FAILED) {
+            close(fd);
+            return nullptr;
+        }
+        if (mmap(base, size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+            mmap(base + size, size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+            munmap(base, 2 * size);
+            close(fd);
+            return nullptr;
+        }
+        close(fd);
+        return base;
+#else
+        (void)size;
+        return nullptr;
+#endif
+    }
 
 public:
-    RingBuffer(uint32_t elementCount) {
+    RingBuffer(uint32_t elementCount, bool mirrored = false) {
         if (((elementCount - 1) & elementCount) != 0)
             elementCount = 64 * 16384; /* default	*/
 
         bufferSize = elementCount;
-        buffer = new char[2 * bufferSize * sizeof(elementtype)];
-        writeIndex = 0;
-        readIndex = 0;
         smallMask = (elementCount)-1;
         bigMask = (elementCount * 2) - 1;
+        mappedSize = 0;
+        buffer = nullptr;
+        if (mirrored) {
+            buffer = mirrorMap(bufferSize * sizeof(elementtype));
+            if (buffer != nullptr)
+                mappedSize = bufferSize * sizeof(elementtype);
+        }
+        if (buffer == nullptr)
+            buffer = new char[bufferSize * sizeof(elementtype)];
+        writeIndex.store(0);
+        readIndex.store(0);
+        readSnapshot = 0;
+        writeSnapshot = 0;
+        readCapture = 0;
+        waiters.store(0);
     }
 
     ~RingBuffer() {
+#if defined(__linux__)
+        if (mappedSize > 0) {
+            munmap(buffer, 2 * mappedSize);
+            return;
+        }
+#endif
         delete[] buffer;
     }
 
+    bool isMirrored() {
+        return mappedSize > 0;
+    }
+
 /*
  * 	functions for checking available data for reading and space
  * 	for writing
  */
     int32_t GetRingBufferReadAvailable() {
-        return (writeIndex - readIndex) & bigMask;
+        // the read index first, it can only ever catch up with the write index
+        uint32_t r = readIndex.load(std::memory_order_acquire);
+
+        return writeIndex.load(std::memory_order_acquire) - r;
     }
 
     int32_t ReadSpace() {
@@ -204,25 +226,99 @@ public:
         return GetRingBufferWriteAvailable();
     }
 
+/*
+ * 	discards the content, from any thread: only the read index is
+ * 	touched, the consumer notices its write snapshot has fallen
+ * 	behind and reloads it, and a read in progress does not move
+ * 	the index back when it commits
+ */
     void FlushRingBuffer() {
-        writeIndex = 0;
-        readIndex = 0;
+        readIndex.store(writeIndex.load(std::memory_order_acquire),
+                        std::memory_order_release);
+        wakeWaiters();
     }
-/* ensure that previous writes are seen before we update the write index 
- * (write after write)
+
+/*
+ * 	the snapshots only get refreshed when they say that there
+ * 	isn't enough, the producer only ever reloads the read index,
+ * 	the consumer the write index
  */
+private:
+/*
+ * 	the fence pairs with the one in waitFor: either the waiter
+ * 	sees the new index, or we see the waiter and go through the
+ * 	lock, which it only drops once it is actually asleep
+ */
+    void wakeWaiters() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_relaxed) == 0)
+            return;
+        { std::lock_guard<std::mutex> lock(waitLock); }
+        waitCond.notify_all();
+    }
+
+    template <class ready>
+    bool waitFor(int32_t timeout, ready isReady) {
+        if (isReady())
+            return true;
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+        std::unique_lock<std::mutex> lock(waitLock);
+        bool done;
+
+        waiters.fetch_add(1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        done = waitCond.wait_until(lock, deadline, isReady);
+        waiters.fetch_sub(1);
+        return done;
+    }
+
+    uint32_t writeAvailable(uint32_t elementCount) {
+        uint32_t w = writeIndex.load(std::memory_order_relaxed);
+
+        if (bufferSize - (w - readSnapshot) < elementCount)
+            readSnapshot = readIndex.load(std::memory_order_acquire);
+        return bufferSize - (w - readSnapshot);
+    }
+
+    uint32_t readAvailable(uint32_t elementCount) {
+        uint32_t r = readIndex.load(std::memory_order_acquire);
+        uint32_t available = writeSnapshot - r;
+
+        readCapture = r;
+        // after a flush, the snapshot can be behind the read index
+        if (available < elementCount || available > bufferSize) {
+            writeSnapshot = writeIndex.load(std::memory_order_acquire);
+            available = writeSnapshot - r;
+        }
+        return available;
+    }
+
+public:
+/* the release makes the data written visible before the index */
     int32_t AdvanceRingBufferWriteIndex(int32_t elementCount) {
-        PaUtil_WriteMemoryBarrier();
-        return writeIndex = (writeIndex + elementCount) & bigMask;
+        uint32_t w = writeIndex.load(std::memory_order_relaxed) + elementCount;
+
+        writeIndex.store(w, std::memory_order_release);
+        wakeWaiters();
+        return w & bigMask;
     }
 
-/* ensure that previous reads (copies out of the ring buffer) are
- * always completed before updating (writing) the read index. 
- * (write-after-read) => full barrier
+/* the release makes sure that the data has been copied out before
+ * the writer can overwrite it. The count is relative to the read index
+ * the regions were worked out from: should a flush have moved it
+ * meanwhile, the flush wins and the advance is dropped
  */
     int32_t AdvanceRingBufferReadIndex(int32_t elementCount) {
-        PaUtil_FullMemoryBarrier();
-        return readIndex = (readIndex + elementCount) & bigMask;
+        uint32_t r = readCapture;
+
+        if (readIndex.compare_exchange_strong(r, readCapture + elementCount,
+                                              std::memory_order_release,
+                                              std::memory_order_relaxed))
+            r = readCapture + elementCount;
+        readCapture = r;
+        wakeWaiters();
+        return r & bigMask;
     }
 
 /***************************************************************************
@@ -234,31 +330,24 @@ public:
     int32_t GetRingBufferWriteRegions(uint32_t elementCount,
         void** dataPtr1, int32_t* sizePtr1,
         void** dataPtr2, int32_t* sizePtr2) {
-        uint32_t index;
-        uint32_t available = GetRingBufferWriteAvailable();
+        uint32_t available = writeAvailable(elementCount);
+        uint32_t index = writeIndex.load(std::memory_order_relaxed) & smallMask;
 
         if (elementCount > available)
             elementCount = available;
 
-        /* Check to see if write is not contiguous. */
-        index = writeIndex & smallMask;
-        if ((index + elementCount) > bufferSize) {
+        *dataPtr1 = &buffer[index * sizeof(elementtype)];
+        if (mappedSize == 0 && (index + elementCount) > bufferSize) {
             /* Write data in two blocks that wrap the buffer. */
             int32_t firstHalf = bufferSize - index;
-            *dataPtr1 = &buffer[index * sizeof(elementtype)];
             *sizePtr1 = firstHalf;
             *dataPtr2 = &buffer[0];
             *sizePtr2 = elementCount - firstHalf;
-        } else { // fits
-            *dataPtr1 = &buffer[index * sizeof(elementtype)];
+        } else {
             *sizePtr1 = elementCount;
             *dataPtr2 = nullptr;
             *sizePtr2 = 0;
         }
-
-        if (available > 0)
-            PaUtil_FullMemoryBarrier(); /* (write-after-read) => full barrier */
-
         return elementCount;
     }
 
@@ -271,32 +360,45 @@ public:
     int32_t GetRingBufferReadRegions(uint32_t elementCount,
         void** dataPtr1, int32_t* sizePtr1,
         void** dataPtr2, int32_t* sizePtr2) {
-        uint32_t index;
-        uint32_t available = GetRingBufferReadAvailable(); /* doesn't use memory barrier */
+        uint32_t available = readAvailable(elementCount);
+        uint32_t index = readCapture & smallMask;
 
         if (elementCount > available)
             elementCount = available;
 
-        /* Check to see if read is not contiguous. */
-        index = readIndex & smallMask;
-        if ((index + elementCount) > bufferSize) {
-            /* Write data in two blocks that wrap the buffer. */
+        *dataPtr1 = &buffer[index * sizeof(elementtype)];
+        if (mappedSize == 0 && (index + elementCount) > bufferSize) {
             int32_t firstHalf = bufferSize - index;
-            *dataPtr1 = &buffer[index * sizeof(elementtype)];
             *sizePtr1 = firstHalf;
             *dataPtr2 = &buffer[0];
             *sizePtr2 = elementCount - firstHalf;
         } else {
-            *dataPtr1 = &buffer[index * sizeof(elementtype)];
             *sizePtr1 = elementCount;
             *dataPtr2 = nullptr;
             *sizePtr2 = 0;
         }
+        return elementCount;
+    }
+
+/*
+ * 	contiguous spans, for producers and consumers working in place:
+ * 	up to the end of the storage, or all of it when mirrored.
+ * 	Commit with the Advance functions
+ */
+    elementtype* writeSpan(int32_t* elementCount) {
+        void *data1, *data2;
+        int32_t size2;
 
-        if (available)
-            PaUtil_ReadMemoryBarrier(); /* (read-after-read) => read barrier */
+        GetRingBufferWriteRegions(bufferSize, &data1, elementCount, &data2, &size2);
+        return (elementtype*)data1;
+    }
 
-        return elementCount;
+    elementtype* readSpan(int32_t* elementCount) {
+        void *data1, *data2;
+        int32_t size2;
+
+        GetRingBufferReadRegions(bufferSize, &data1, elementCount, &data2, &size2);
+        return (elementtype*)data1;
     }
 
     int32_t putDataIntoBuffer(const void* data, int32_t elementCount) {
@@ -338,12 +440,40 @@ public:
     }
 
     int32_t skipDataInBuffer(uint32_t n_values) {
-        // ensure that we have the correct read and write indices
-        PaUtil_FullMemoryBarrier();
-        if ((int)n_values > GetRingBufferReadAvailable())
-            n_values = GetRingBufferReadAvailable();
+        uint32_t available = readAvailable(n_values);
+
+        if (n_values > available)
+            n_values = available;
         AdvanceRingBufferReadIndex(n_values);
         return n_values;
     }
+
+/*
+ * 	blocking variants: wait until there are elementCount elements
+ * 	(or that much room), or until the timeout in milliseconds
+ * 	expires. waitForData is for the reader, waitForSpace for the
+ * 	writer only
+ */
+    bool waitForData(int32_t elementCount, int32_t timeout) {
+        return waitFor(timeout, [this, elementCount]() {
+            return (int32_t)readAvailable(elementCount) >= elementCount;
+        });
+    }
+
+    bool waitForSpace(int32_t elementCount, int32_t timeout) {
+        return waitFor(timeout, [this, elementCount]() {
+            return (int32_t)writeAvailable(elementCount) >= elementCount;
+        });
+    }
+
+    int32_t putDataIntoBuffer(const void* data, int32_t elementCount, int32_t timeout) {
+        waitForSpace(elementCount, timeout);
+        return putDataIntoBuffer(data, elementCount);
+    }
+
+    int32_t getDataFromBuffer(void* data, int32_t elementCount, int32_t timeout) {
+        waitForData(elementCount, timeout);
+        return getDataFromBuffer(data, elementCount);
+    }
 };
 #endif
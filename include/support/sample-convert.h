@@ -0,0 +1,65 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SAMPLE_CONVERT_H
+#define SAMPLE_CONVERT_H
+
+//	Conversion of the devices' native interleaved I/Q samples to
+//	complex floats, straight out of the device ring buffers and into
+//	the caller's buffer, computing the agc statistics on the way.
+//	Each component becomes (x - offset) * scale, min and max are
+//	accumulated over the components, and components at or beyond
+//	lo or hi are counted as overflows.
+#include "constants.h"
+#include "device-handler.h"
+#include "ringbuffer.h"
+
+void resetAgcStats(agcStats *);
+void mergeAgcStats(agcStats *, const agcStats *);
+void convertIQ(const uint8_t *, std::complex<float> *, int32_t,
+	       float offset, float scale, int32_t lo, int32_t hi, agcStats *);
+void convertIQ(const int16_t *, std::complex<float> *, int32_t,
+	       float offset, float scale, int32_t lo, int32_t hi, agcStats *);
+void convertIQ(const int32_t *, std::complex<float> *, int32_t,
+	       float offset, float scale, int32_t lo, int32_t hi, agcStats *);
+
+//	reads up to n samples of S typed components from the read regions
+//	of a ring of T, without an intermediate copy
+template <class S, class T>
+int32_t getIQFromBuffer(RingBuffer<T> &ring, std::complex<float> *V, int32_t n,
+			float offset, float scale, int32_t lo, int32_t hi,
+			agcStats *stats) {
+    const int32_t perSample = 2 * sizeof(S) / sizeof(T);
+    void *data1, *data2;
+    int32_t size1, size2;
+
+    int32_t amount = ring.GetRingBufferReadRegions(n * perSample,
+						    &data1, &size1,
+						    &data2, &size2);
+    convertIQ((const S *) data1, V, size1 / perSample,
+	      offset, scale, lo, hi, stats);
+    if (size2 > 0)
+	convertIQ((const S *) data2, V + size1 / perSample, size2 / perSample,
+		  offset, scale, lo, hi, stats);
+    ring.AdvanceRingBufferReadIndex(amount);
+    return amount / perSample;
+}
+#endif
@@ -0,0 +1,208 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SIMD_HELPER_H
+#define SIMD_HELPER_H
+
+#include <stdint.h>
+#include <string.h>
+
+// pick the widest instruction set the compiler has been allowed to use
+// AVX2 needs to be explicitly enabled at build time (-mavx2 -mfma),
+// SSE2 is always there on x86_64, NEON on aarch64 and on the RPI builds
+#if defined(__AVX2__) && defined(__FMA__)
+#define SIMD_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SIMD_NEON
+#include <arm_neon.h>
+#endif
+
+// A minimal set of vector operations, so that kernels can be
+// written once for all instruction sets.
+// Without SIMD they degrade to plain floats, one at a time.
+#if defined(SIMD_AVX2)
+#define VFLOAT_SIZE 8
+typedef __m256 vfloat;
+typedef __m256 vmask;
+
+static inline vfloat vLoad(const float* p) { return _mm256_loadu_ps(p); }
+static inline void vStore(float* p, vfloat a) { _mm256_storeu_ps(p, a); }
+static inline vfloat vSet(float a) { return _mm256_set1_ps(a); }
+static inline vfloat vAdd(vfloat a, vfloat b) { return _mm256_add_ps(a, b); }
+static inline vfloat vSub(vfloat a, vfloat b) { return _mm256_sub_ps(a, b); }
+static inline vfloat vMul(vfloat a, vfloat b) { return _mm256_mul_ps(a, b); }
+static inline vfloat vDiv(vfloat a, vfloat b) { return _mm256_div_ps(a, b); }
+static inline vfloat vMin(vfloat a, vfloat b) { return _mm256_min_ps(a, b); }
+static inline vfloat vMax(vfloat a, vfloat b) { return _mm256_max_ps(a, b); }
+static inline vfloat vSqrt(vfloat a) { return _mm256_sqrt_ps(a); }
+static inline vfloat vFloor(vfloat a) { return _mm256_floor_ps(a); }
+static inline vfloat vAbs(vfloat a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+static inline vmask vLess(vfloat a, vfloat b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline vmask vAnd(vmask a, vmask b) { return _mm256_and_ps(a, b); }
+static inline vmask vOr(vmask a, vmask b) { return _mm256_or_ps(a, b); }
+static inline vmask vXor(vmask a, vmask b) { return _mm256_xor_ps(a, b); }
+static inline vfloat vSelect(vmask m, vfloat a, vfloat b) { return _mm256_blendv_ps(b, a, m); }
+
+// widening loads of integer samples
+static inline vfloat vLoadU8(const uint8_t* p) {
+    return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i*) p)));
+}
+static inline vfloat vLoadS16(const int16_t* p) {
+    return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*) p)));
+}
+static inline vfloat vLoadS32(const int32_t* p) {
+    return _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*) p));
+}
+#elif defined(SIMD_SSE2)
+#define VFLOAT_SIZE 4
+typedef __m128 vfloat;
+typedef __m128 vmask;
+
+static inline vfloat vLoad(const float* p) { return _mm_loadu_ps(p); }
+static inline void vStore(float* p, vfloat a) { _mm_storeu_ps(p, a); }
+static inline vfloat vSet(float a) { return _mm_set1_ps(a); }
+static inline vfloat vAdd(vfloat a, vfloat b) { return _mm_add_ps(a, b); }
+static inline vfloat vSub(vfloat a, vfloat b) { return _mm_sub_ps(a, b); }
+static inline vfloat vMul(vfloat a, vfloat b) { return _mm_mul_ps(a, b); }
+static inline vfloat vDiv(vfloat a, vfloat b) { return _mm_div_ps(a, b); }
+static inline vfloat vMin(vfloat a, vfloat b) { return _mm_min_ps(a, b); }
+static inline vfloat vMax(vfloat a, vfloat b) { return _mm_max_ps(a, b); }
+static inline vfloat vSqrt(vfloat a) { return _mm_sqrt_ps(a); }
+static inline vfloat vAbs(vfloat a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+static inline vmask vLess(vfloat a, vfloat b) { return _mm_cmplt_ps(a, b); }
+static inline vmask vAnd(vmask a, vmask b) { return _mm_and_ps(a, b); }
+static inline vmask vOr(vmask a, vmask b) { return _mm_or_ps(a, b); }
+static inline vmask vXor(vmask a, vmask b) { return _mm_xor_ps(a, b); }
+static inline vfloat vSelect(vmask m, vfloat a, vfloat b) {
+    return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+}
+
+// widening loads of integer samples
+static inline vfloat vLoadU8(const uint8_t* p) {
+    int32_t v;
+
+    memcpy(&v, p, sizeof(v));
+    __m128i z = _mm_setzero_si128();
+    __m128i b = _mm_unpacklo_epi8(_mm_cvtsi32_si128(v), z);
+    return _mm_cvtepi32_ps(_mm_unpacklo_epi16(b, z));
+}
+static inline vfloat vLoadS16(const int16_t* p) {
+    __m128i s = _mm_loadl_epi64((const __m128i*) p);
+    return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16));
+}
+static inline vfloat vLoadS32(const int32_t* p) {
+    return _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*) p));
+}
+
+// no SSE2 floor: truncate, then correct the negative values
+static inline vfloat vFloor(vfloat a) {
+    vfloat t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a));
+    return _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a), _mm_set1_ps(1.0f)));
+}
+#elif defined(SIMD_NEON)
+#define VFLOAT_SIZE 4
+typedef float32x4_t vfloat;
+typedef uint32x4_t vmask;
+
+static inline vfloat vLoad(const float* p) { return vld1q_f32(p); }
+static inline void vStore(float* p, vfloat a) { vst1q_f32(p, a); }
+static inline vfloat vSet(float a) { return vdupq_n_f32(a); }
+static inline vfloat vAdd(vfloat a, vfloat b) { return vaddq_f32(a, b); }
+static inline vfloat vSub(vfloat a, vfloat b) { return vsubq_f32(a, b); }
+static inline vfloat vMul(vfloat a, vfloat b) { return vmulq_f32(a, b); }
+static inline vfloat vMin(vfloat a, vfloat b) { return vminq_f32(a, b); }
+static inline vfloat vMax(vfloat a, vfloat b) { return vmaxq_f32(a, b); }
+static inline vfloat vAbs(vfloat a) { return vabsq_f32(a); }
+static inline vmask vLess(vfloat a, vfloat b) { return vcltq_f32(a, b); }
+static inline vmask vAnd(vmask a, vmask b) { return vandq_u32(a, b); }
+static inline vmask vOr(vmask a, vmask b) { return vorrq_u32(a, b); }
+static inline vmask vXor(vmask a, vmask b) { return veorq_u32(a, b); }
+static inline vfloat vSelect(vmask m, vfloat a, vfloat b) { return vbslq_f32(m, a, b); }
+
+// widening loads of integer samples
+static inline vfloat vLoadU8(const uint8_t* p) {
+    uint32_t v;
+
+    memcpy(&v, p, sizeof(v));
+    uint16x8_t w = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(v)));
+    return vcvtq_f32_u32(vmovl_u16(vget_low_u16(w)));
+}
+static inline vfloat vLoadS16(const int16_t* p) { return vcvtq_f32_s32(vmovl_s16(vld1_s16(p))); }
+static inline vfloat vLoadS32(const int32_t* p) { return vcvtq_f32_s32(vld1q_s32(p)); }
+#if defined(__aarch64__)
+static inline vfloat vDiv(vfloat a, vfloat b) { return vdivq_f32(a, b); }
+static inline vfloat vSqrt(vfloat a) { return vsqrtq_f32(a); }
+static inline vfloat vFloor(vfloat a) { return vrndmq_f32(a); }
+#else
+// armv7 has neither division nor square root: two newton steps
+// on the estimates get us to float precision
+static inline vfloat vDiv(vfloat a, vfloat b) {
+    vfloat r = vrecpeq_f32(b);
+    r = vmulq_f32(r, vrecpsq_f32(b, r));
+    r = vmulq_f32(r, vrecpsq_f32(b, r));
+    return vmulq_f32(a, r);
+}
+
+static inline vfloat vSqrt(vfloat a) {
+    vfloat r = vrsqrteq_f32(a);
+    r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(a, r), r));
+    r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(a, r), r));
+    return vbslq_f32(vceqq_f32(a, vdupq_n_f32(0)), a, vmulq_f32(a, r));
+}
+
+static inline vfloat vFloor(vfloat a) {
+    vfloat t = vcvtq_f32_s32(vcvtq_s32_f32(a));
+    return vsubq_f32(t, vbslq_f32(vcgtq_f32(t, a), vdupq_n_f32(1.0f), vdupq_n_f32(0)));
+}
+#endif
+#else
+#include <cmath>
+#define VFLOAT_SIZE 1
+typedef float vfloat;
+typedef bool vmask;
+
+static inline vfloat vLoad(const float* p) { return *p; }
+static inline void vStore(float* p, vfloat a) { *p = a; }
+static inline vfloat vSet(float a) { return a; }
+static inline vfloat vAdd(vfloat a, vfloat b) { return a + b; }
+static inline vfloat vSub(vfloat a, vfloat b) { return a - b; }
+static inline vfloat vMul(vfloat a, vfloat b) { return a * b; }
+static inline vfloat vDiv(vfloat a, vfloat b) { return a / b; }
+static inline vfloat vMin(vfloat a, vfloat b) { return a < b ? a : b; }
+static inline vfloat vMax(vfloat a, vfloat b) { return a > b ? a : b; }
+static inline vfloat vSqrt(vfloat a) { return std::sqrt(a); }
+static inline vfloat vFloor(vfloat a) { return std::floor(a); }
+static inline vfloat vAbs(vfloat a) { return std::fabs(a); }
+static inline vmask vLess(vfloat a, vfloat b) { return a < b; }
+static inline vmask vAnd(vmask a, vmask b) { return a && b; }
+static inline vmask vOr(vmask a, vmask b) { return a || b; }
+static inline vmask vXor(vmask a, vmask b) { return a != b; }
+static inline vfloat vSelect(vmask m, vfloat a, vfloat b) { return m ? a : b; }
+static inline vfloat vLoadU8(const uint8_t* p) { return *p; }
+static inline vfloat vLoadS16(const int16_t* p) { return *p; }
+static inline vfloat vLoadS32(const int32_t* p) { return (float) *p; }
+#endif
+
+#endif
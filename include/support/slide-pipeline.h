@@ -0,0 +1,98 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __SLIDE_PIPELINE_H__
+#define __SLIDE_PIPELINE_H__
+
+//	Slides and EPG pictures are decoded, trimmed and written to the
+//	image cache on a thread of their own, the GUI only gets to show
+//	the resulting image.
+#include <QByteArray>
+#include <QImage>
+#include <QMutex>
+#include <QSize>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+#include <deque>
+#include "dir-cache.h"
+
+#define SLIDE_QUEUE	8	// slides waiting, older ones are dropped
+#define SLIDE_VARIANTS	8	// decoded images kept for the carousels
+
+class slidePipeline: public QThread {
+Q_OBJECT
+public:
+    slidePipeline(void);
+    ~slidePipeline(void);
+
+    // from the GUI
+    void setCache(ImageCache *);
+    void addSlide(const QByteArray &, const char *, const QString &, QSize);
+    void addPicture(const QByteArray &, const char *, const QString &,
+		    int32_t, QSize);
+    void stop(void);
+
+signals:
+    void slideReady(QImage, uint);
+
+    // the size is the one of the picture as sent
+    void pictureReady(QImage, int, int, int, uint);
+
+private:
+    struct slideJob {
+	QByteArray data;
+	QString type;
+	QString name;
+	int32_t SId;
+	QSize target;
+	bool isSlide;
+	uint generation;
+    };
+    struct slideVariant {
+	QByteArray data;
+	QSize target;
+	bool isSlide;		// trimmed or not
+	QString type;
+	QImage image;
+	QSize original;
+    };
+
+    void run(void);
+    void process(const slideJob &);
+    bool decode(const slideJob &, QImage *, QSize *);
+
+    QMutex locker;
+    QWaitCondition wakeUp;
+    std::deque<slideJob> jobs;
+    bool running;
+    uint generation;
+
+    // held while writing to the cache, so that the GUI can swap it
+    QMutex cacheLocker;
+    ImageCache *cache;
+
+    // most recent first, only touched by the pipeline thread
+    std::deque<slideVariant> variants;
+};
+
+QImage trimBorders(const QImage &);
+#endif		// __SLIDE_PIPELINE_H__
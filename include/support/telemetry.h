@@ -0,0 +1,203 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+//	Pipeline instrumentation: per stage latency histograms, event
+//	counters and a few gauges.
+//	Each thread records into its own block, with plain relaxed
+//	stores, so recording is lock free and never contended; the
+//	writer thread sums the blocks and exports them periodically.
+//	With telemetry off, a timer costs a single test of a global.
+#include <QSemaphore>
+#include <QString>
+#include <QThread>
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+#include <vector>
+
+enum telemetryStage {
+    TEL_SAMPLE_WAIT,
+    TEL_SYNC,
+    TEL_FFT,
+    TEL_DEMAP,
+    TEL_FIC_VITERBI,
+    TEL_MSC_VITERBI,
+    TEL_RS,
+    TEL_AAC,
+    TEL_STAGES
+};
+
+enum telemetryCounter {
+    TEL_SYNC_LOST,
+    TEL_FIC_CRC_ERRORS,
+    TEL_FIG_REPEATS,
+    TEL_RS_FAILURES,
+    TEL_AAC_ERRORS,
+    TEL_AUDIO_UNDERRUN,
+    TEL_AUDIO_OVERRUN,
+    TEL_COUNTERS
+};
+
+enum telemetryGauge {
+    TEL_AUDIO_FILL,		// per mille of the sink buffer
+    TEL_GAUGES
+};
+
+//	log-linear buckets over nanoseconds, 8 per octave up to about a minute
+#define TEL_SUB_BITS	3
+#define TEL_BUCKETS	272
+
+struct telemetryHistogram {
+    std::atomic<uint64_t> bucket[TEL_BUCKETS];
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> max;
+};
+
+struct telemetryBlock {
+    telemetryHistogram stage[TEL_STAGES];
+    std::atomic<uint64_t> counter[TEL_COUNTERS];
+    std::atomic<bool> inUse;
+    telemetryBlock *next;
+};
+
+extern bool telemetryEnabled;
+
+telemetryBlock *telemetryThreadBlock(void);
+
+static inline
+int64_t telemetryNow(void) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+	std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static inline
+int telemetryBucket(uint64_t v) {
+    if (v < (2 << TEL_SUB_BITS))
+	return v;
+#ifdef __GNUC__
+    int msb = 63 - __builtin_clzll(v);
+#else
+    int msb = 0;
+    for (uint64_t t = v; t > 1; t >>= 1)
+	msb++;
+#endif
+    int b = (2 << TEL_SUB_BITS) + ((msb - TEL_SUB_BITS - 1) << TEL_SUB_BITS) +
+	    ((v >> (msb - TEL_SUB_BITS)) & ((1 << TEL_SUB_BITS) - 1));
+    return b < TEL_BUCKETS? b: TEL_BUCKETS - 1;
+}
+
+//	only the owning thread writes its block, no need for RMW
+static inline
+void telemetryAdd(std::atomic<uint64_t> &c, uint64_t v) {
+    c.store(c.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+}
+
+static inline
+void telemetryRecord(telemetryStage s, int64_t ns) {
+    if (!telemetryEnabled)
+	return;
+    telemetryHistogram &h = telemetryThreadBlock()->stage[s];
+    uint64_t v = ns < 0? 0: ns;
+
+    telemetryAdd(h.bucket[telemetryBucket(v)], 1);
+    telemetryAdd(h.count, 1);
+    telemetryAdd(h.sum, v);
+    if (v > h.max.load(std::memory_order_relaxed))
+	h.max.store(v, std::memory_order_relaxed);
+}
+
+static inline
+void telemetryCount(telemetryCounter c, uint64_t n = 1) {
+    if (telemetryEnabled)
+	telemetryAdd(telemetryThreadBlock()->counter[c], n);
+}
+
+void telemetrySetGauge(telemetryGauge, int64_t);
+
+//	for code that can't use a scoped timer, eg across gotos
+static inline
+int64_t telemetryStart(void) {
+    return telemetryEnabled? telemetryNow(): 0;
+}
+
+static inline
+void telemetryStop(telemetryStage s, int64_t start) {
+    if (start != 0)
+	telemetryRecord(s, telemetryNow() - start);
+}
+
+class telemetryTimer {
+public:
+    telemetryTimer(telemetryStage s): stage(s), start(telemetryStart()) {}
+    ~telemetryTimer(void) {
+	telemetryStop(stage, start);
+    }
+
+private:
+    telemetryStage stage;
+    int64_t start;
+};
+
+//	writes a snapshot every interval to a file, atomically replaced,
+//	or serves one to whoever connects to a UNIX socket, for targets
+//	of the form unix:<path>.
+//	Files ending in .json get JSON, anything else Prometheus text.
+//	Quantiles are over the period since the previous snapshot,
+//	counts and sums are since start
+class telemetryWriter: public QThread {
+public:
+    telemetryWriter(const QString &target, int32_t interval);
+    ~telemetryWriter(void);
+
+    void stop(void);
+
+private:
+    struct stageSummary {
+	uint64_t count;
+	uint64_t sum;
+	uint64_t max;
+	uint64_t quantile[4];
+    };
+
+    void run(void);
+    void snapshot(void);
+    QByteArray format(void);
+    bool writeFile(const QByteArray &);
+    void serve(void);
+
+    QString target;
+    QString socketPath;
+    bool json;
+    int32_t interval;
+    QSemaphore stopping;
+    int listenSocket;
+
+    std::vector<uint64_t> previous;
+    std::vector<uint64_t> current;
+    stageSummary stages[TEL_STAGES];
+    uint64_t counters[TEL_COUNTERS];
+    int64_t gauges[TEL_GAUGES];
+};
+#endif
@@ -41,6 +41,37 @@
 
 DSPFLOAT toBaseRadians(DSPFLOAT phase);
 
+// scalar versions of the polynomials used by the batch functions,
+// for loops that can't be vectorized, such as PLLs.
+// They avoid the cache misses of the tables
+static inline float polyAtan2(float y, float x) {
+    float ax = std::fabs(x);
+    float ay = std::fabs(y);
+    float mx = ax > ay ? ax : ay;
+    float a = (ax < ay ? ax : ay) / (mx > 1e-30f ? mx : 1e-30f);
+    float s = a * a;
+    float r = ((((-0.01172120f * s + 0.05265332f) * s - 0.11643287f) * s + 0.19354346f) * s - 0.33262347f) * s + 0.99997726f;
+
+    r *= a;
+    r = (ax < ay) ? float(M_PI / 2) - r : r;
+    r = (x < 0) ? float(M_PI) - r : r;
+    return std::copysign(r, y);
+}
+
+// phase in 0 .. 2 pi
+static inline DSPCOMPLEX polyPhasor(float phase) {
+    int q = int(phase * float(2 / M_PI) + 0.5f);
+    float r = (phase - q * 1.5707963705062866f) + q * 4.37113900018624283e-8f;
+    float r2 = r * r;
+    float sr = (((-1.0f / 5040) * r2 + 1.0f / 120) * r2 - 1.0f / 6) * r2 * r + r;
+    float cr = ((((1.0f / 40320) * r2 - 1.0f / 720) * r2 + 1.0f / 24) * r2 - 0.5f) * r2 + 1.0f;
+
+    float sn = (q & 1) ? cr : sr;
+    float cs = (q & 1) ? sr : cr;
+
+    return DSPCOMPLEX(((q + 1) & 2) ? -cs : cs, (q & 2) ? -sn : sn);
+}
+
 class trigTabs {
 public:
     trigTabs(int32_t);
@@ -50,6 +81,11 @@ public:
     float atan2(float, float);
     float argX(DSPCOMPLEX);
 
+    // batch versions, polynomial rather than table based
+    void atan2(const float*, const float*, float*, int32_t);
+    void argX(const DSPCOMPLEX*, float*, int32_t);
+    void sinCos(const DSPFLOAT*, DSPFLOAT*, DSPFLOAT*, int32_t);
+
 private:
     int32_t fromPhasetoIndex(DSPFLOAT);
     DSPCOMPLEX* table;
@@ -41,6 +41,7 @@
 #include "charsets.h"
 #include "logging.h"
 #include "pad-handler.h"
+#include "telemetry.h"
 #include <cstring>
 
 /*
@@ -165,12 +166,15 @@ bool mp4Processor::processSuperframe(uint8_t frameBytes[], int16_t base) {
      *	the superframe, containing parity bytes for error repair
      *	take into account the interleaving that is applied.
      */
+    int64_t rsStart = telemetryStart();
     for (j = 0; j < RSDims; j++) {
         int16_t ler = 0;
         for (k = 0; k < 120; k++)
             rsIn[k] = frameBytes[(base + j + k * RSDims) % (RSDims * 120)];
         ler = my_rsDecoder.dec(rsIn, rsOut, 135);
         if (ler < 0) {
+            telemetryStop(TEL_RS, rsStart);
+            telemetryCount(TEL_RS_FAILURES);
             rsErrors++;
             log(LOG_AUDIO, LOG_MIN, "processSuperframe RS failure ler %i", ler);
             return false;
@@ -186,6 +190,7 @@ bool mp4Processor::processSuperframe(uint8_t frameBytes[], int16_t base) {
         for (k = 0; k < 110; k++)
             outVector[j + k * RSDims] = rsOut[k];
     }
+    telemetryStop(TEL_RS, rsStart);
 
     //	bits 0 .. 15 is firecode
     //	bit 16 is unused
@@ -289,6 +294,7 @@ bool mp4Processor::processSuperframe(uint8_t frameBytes[], int16_t base) {
                 }
 
 //	then handle the audio
+                int64_t aacStart = telemetryStart();
 #ifdef __WITH_FDK_AAC__
                 std::vector<uint8_t> fileBuffer;
                 int segmentSize =
@@ -305,10 +311,13 @@ bool mp4Processor::processSuperframe(uint8_t frameBytes[], int16_t base) {
                 tmp = aacDecoder->MP42PCM(&streamParameters, theAudioUnit,
                                           aac_frame_length);
 #endif
+                telemetryStop(TEL_AAC, aacStart);
                 emit isStereo((streamParameters.aacChannelMode == 1) ||
                               (streamParameters.psFlag == 1));
-                if (tmp <= 0)
+                if (tmp <= 0) {
                     aacErrors++;
+                    telemetryCount(TEL_AAC_ERRORS);
+                }
                 if (++aacFrames > 25) {
                     show_aacErrors(aacErrors);
                     aacErrors = 0;
@@ -45,7 +45,7 @@ backendDriver::backendDriver(RadioInterface *mr, serviceDescriptor *d,
                                             frameBuffer, d->procMode);
         }
     } else if (d->type == PACKET_SERVICE)
-        theProcessor = new dataProcessor(mr, (packetdata *)d, dataBuffer);
+        theProcessor = new dataProcessor(mr, (packetdata *)d);
 }
 
 backendDriver::~backendDriver() { delete theProcessor; }
@@ -53,3 +53,7 @@ backendDriver::~backendDriver() { delete theProcessor; }
 void backendDriver::addtoFrame(std::vector<uint8_t> theData) {
     theProcessor->addtoFrame(theData);
 }
+
+bool backendDriver::addService(serviceDescriptor *d) {
+    return theProcessor->addService(d);
+}
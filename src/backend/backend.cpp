@@ -28,6 +28,7 @@
 #include "constants.h"
 #include "logging.h"
 #include "radio.h"
+#include "telemetry.h"
 
 //	Interleaving is - for reasons of simplicity - done
 //	inline rather than through a special class-object
@@ -139,7 +140,9 @@ void Backend::processSegment(int16_t *Data) {
         return;
     }
 
+    int64_t viterbiStart = telemetryStart();
     deconvolver.deconvolve(tempX.data(), fragmentSize, outV.data());
+    telemetryStop(TEL_MSC_VITERBI, viterbiStart);
     //	and the energy dispersal
     for (i = 0; i < bitRate * 24; i++)
         outV[i] ^= disperseVector[i];
@@ -160,6 +163,14 @@ void Backend::run() {
 #endif
 
 //	It might take a msec for the task to stop
+//	another packet service on our subchannel
+bool Backend::addService(serviceDescriptor *d) {
+    log(LOG_DAB, LOG_MIN, "adding %s (%X) to the backend for %s (%X)",
+        d->serviceName.toLatin1().data(), d->SId,
+        serviceName.toLatin1().data(), serviceId);
+    return driver.addService(d);
+}
+
 void Backend::stopRunning() {
 #ifdef __THREADED_BACKEND
     running = false;
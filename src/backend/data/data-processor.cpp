@@ -36,157 +36,155 @@
 #include "virtual-datahandler.h"
 
 //	\class dataProcessor
-//	The main function of this class is to assemble the
-//	MSCdatagroups and dispatch to the appropriate handler
+//	The main function of this class is to demultiplex the packets
+//	of a subchannel by address, assemble the MSC datagroups and
+//	dispatch them to the appropriate handler
 //
 //	fragmentsize == Length * CUSize
-dataProcessor::dataProcessor(RadioInterface *mr, packetdata *pd,
-                             RingBuffer<uint8_t> *dataBuffer) {
+dataProcessor::dataProcessor(RadioInterface *mr, packetdata *pd) {
     this->myRadioInterface = mr;
     this->bitRate = pd->bitRate;
-    this->DSCTy = pd->DSCTy;
-    this->appType = pd->appType;
-    this->packetAddress = pd->packetAddress;
-    this->DGflag = pd->DGflag;
-    this->FEC_scheme = pd->FEC_scheme;
-    this->dataBuffer = dataBuffer;
-    this->expectedIndex = 0;
-    log(LOG_DATA, LOG_MIN, "Handling DSCTy %d appType %d", pd->DSCTy, pd->appType);
-
-    // According to ETSI 101756 V2.4.1 only TDC (5) and MOT (60) are valid service component types
-    // Currently only the MOT handler has signals serviced by radio interface slots, so we ignore
-    // everything else
-    switch (DSCTy) {
+    addService(pd);
+}
+
+dataProcessor::~dataProcessor() {
+    for (auto &s : streams)
+        delete s.second.handler;
+}
+
+bool dataProcessor::addService(serviceDescriptor *d) {
+    packetdata *pd = (packetdata *)d;
+    packetStream s;
+
+    locker.lock();
+    if (streams.find(pd->packetAddress) != streams.end()) {
+        locker.unlock();
+        return false;
+    }
+    log(LOG_DATA, LOG_MIN, "Handling DSCTy %d appType %d on address %d",
+        pd->DSCTy, pd->appType, pd->packetAddress);
+    s.DSCTy = pd->DSCTy;
+    s.appType = pd->appType;
+    s.DGflag = pd->DGflag;
+    s.expectedIndex = 0;
+    s.packetState = 0;
+    s.handler = newHandler(pd);
+    streams[pd->packetAddress] = s;
+    locker.unlock();
+    return true;
+}
+
+//	ETSI TS 101 756 table 2b, and the Journaline application type
+//	for the ones that come as TDC
+virtual_dataHandler *dataProcessor::newHandler(packetdata *pd) {
+    switch (pd->DSCTy) {
     case SCTMOT:
-        my_dataHandler = new motHandler(mr);
-        break;
+        return new motHandler(myRadioInterface);
+
+    case SCTTDC:
+        if (pd->appType == UATJournaline)
+            return new journaline_dataHandler();
+        return new tdc_dataHandler(pd->appType);
+
+    case SCTJournaline:
+        return new journaline_dataHandler();
+
+    case SCTIP:
+        return new ip_dataHandler();
 
     default:
-        log(LOG_DATA, LOG_MIN, "DSCTy %d not supported", DSCTy);
-        my_dataHandler = new virtual_dataHandler();
-        break;
+        log(LOG_DATA, LOG_MIN, "DSCTy %d not supported", pd->DSCTy);
+        return new virtual_dataHandler();
     }
-
-    packetState = 0;
 }
 
-dataProcessor::~dataProcessor() { delete my_dataHandler; }
-
+//	the packets are handled as bytes from here on
 void dataProcessor::addtoFrame(std::vector<uint8_t> outV) {
-    //	There is - obviously - some exception, that is
-    //	when the DG flag is on and there are no datagroups for DSCTy5
-    if ((this->DSCTy == 5) && (this->DGflag)) // no datagroups
-        handleTDCAsyncstream(outV.data(), 24 * bitRate);
-    else
-        handlePackets(outV.data(), 24 * bitRate);
+    locker.lock();
+    frame.resize(3 * bitRate);
+    packBits(outV.data(), frame.data(), 3 * bitRate);
+    handlePackets(frame.data(), 3 * bitRate);
+    locker.unlock();
 }
 
 //	While for a full mix data and audio there will be a single packet in a
 //	data compartment, for an empty mix, there may be many more
 void dataProcessor::handlePackets(uint8_t *data, int32_t length) {
-    while (true) {
-        int32_t pLength = (getBits_2(data, 0) + 1) * 24 * 8;
+    while (length >= 24) {
+        int32_t pLength = ((data[0] >> 6) + 1) * 24;
         if (length < pLength) // be on the safe side
             return;
-        handlePacket(data);
+        handlePacket(data, pLength);
         length -= pLength;
-        if (length < 2)
-            return;
-        data = &(data[pLength]);
+        data += pLength;
     }
 }
 
-//	Handle a single DAB packet:
-//	Note, although not yet encountered, the standard says that
-//	there may be multiple streams, to be identified by
-//	the address. For the time being we only handle a single
-//	stream!!!!
-void dataProcessor::handlePacket(uint8_t *data) {
-    int32_t packetLength = (getBits_2(data, 0) + 1) * 24;
-    int16_t continuityIndex = getBits_2(data, 2);
-    int16_t firstLast = getBits_2(data, 4);
-    int16_t address = getBits(data, 6, 10);
-    uint16_t command = getBits_1(data, 16);
-    int32_t usefulLength = getBits_7(data, 17);
-    if (usefulLength > 0)
-        log(LOG_DATA, LOG_VERBOSE, "CI = %d, address = %d, usefulLength = %d",
-            continuityIndex, address, usefulLength);
-
-    if (continuityIndex != expectedIndex) {
-        expectedIndex = 0;
-        return;
-    }
-    //
-    expectedIndex = (expectedIndex + 1) % 4;
-    (void)command;
-
-    if (!check_CRC_bits(data, packetLength * 8)) {
-        return;
-    }
+//	Handle a single DAB packet.
+//	Packets for addresses we don't serve are dropped on the header
+//	alone, the others are checked on the bytes.
+void dataProcessor::handlePacket(uint8_t *data, int32_t packetLength) {
+    int16_t address = ((data[0] & 03) << 8) | data[1];
 
     if (address == 0)
         return; // padding packet
+    auto it = streams.find(address);
+    if (it == streams.end())
+        return;
+    if (!check_crc_bytes(data, packetLength - 2))
+        return;
 
-//  if (packetAddress != address)	// sorry
-//	return;
+    packetStream *s = &it->second;
+    int16_t continuityIndex = (data[0] >> 4) & 03;
+    int16_t firstLast = (data[0] >> 2) & 03;
+    int32_t usefulLength = data[2] & 0x7F;
+    if (usefulLength > packetLength - 5)
+        return;
+    log(LOG_DATA, LOG_VERBOSE, "CI = %d, address = %d, usefulLength = %d",
+        continuityIndex, address, usefulLength);
+
+    //	a packet went missing, so does the datagroup it was part of
+    if (continuityIndex != s->expectedIndex)
+        s->packetState = 0;
+    s->expectedIndex = (continuityIndex + 1) % 4;
+
+    //	no datagroups, the packets are the data
+    if (s->DSCTy == SCTTDC && s->DGflag) {
+        s->series.assign(&data[3], &data[3 + usefulLength]);
+        s->handler->add_mscDatagroup(s->series);
+        return;
+    }
 
     //	assemble the full MSC datagroup
-
-    if (packetState == 0) {    // waiting for a start
+    if (s->packetState == 0) { // waiting for a start
         if (firstLast == 02) { // first packet
-            packetState = 1;
-            series.resize(usefulLength * 8);
-            for (uint16_t i = 0; i < series.size(); i++)
-                series[i] = data[24 + i];
+            s->packetState = 1;
+            s->series.resize(0);
+            addToSeries(s, data, usefulLength);
         } else if (firstLast == 03) { // single packet, mostly padding
-            series.resize(usefulLength * 8);
-            for (uint16_t i = 0; i < series.size(); i++)
-                series[i] = data[24 + i];
-            my_dataHandler->add_mscDatagroup(series);
+            s->series.resize(0);
+            addToSeries(s, data, usefulLength);
+            s->handler->add_mscDatagroup(s->series);
         } else
-            series.resize(0);       // packetState remains 0
-    } else if (packetState == 01) { // within a series
-        if (firstLast == 0) {       // intermediate packet
-            int32_t currentLength = series.size();
-            series.resize(currentLength + 8 * usefulLength);
-            for (uint16_t i = 0; i < 8 * usefulLength; i++)
-                series[currentLength + i] = data[24 + i];
+            s->series.resize(0);     // packetState remains 0
+    } else if (s->packetState == 01) { // within a series
+        if (firstLast == 0) {          // intermediate packet
+            addToSeries(s, data, usefulLength);
         } else if (firstLast == 01) { // last packet
-            int32_t currentLength = series.size();
-            series.resize(currentLength + 8 * usefulLength);
-            for (uint16_t i = 0; i < 8 * usefulLength; i++)
-                series[currentLength + i] = data[24 + i];
-
-            my_dataHandler->add_mscDatagroup(series);
-            packetState = 0;
+            addToSeries(s, data, usefulLength);
+            s->handler->add_mscDatagroup(s->series);
+            s->packetState = 0;
         } else if (firstLast == 02) { // first packet, previous one erroneous
-            packetState = 1;
-            series.resize(usefulLength * 8);
-            for (uint16_t i = 0; i < series.size(); i++)
-                series[i] = data[24 + i];
+            s->series.resize(0);
+            addToSeries(s, data, usefulLength);
         } else {
-            packetState = 0;
-            series.resize(0);
+            s->packetState = 0;
+            s->series.resize(0);
         }
     }
 }
 
-//	Really no idea what to do here
-void dataProcessor::handleTDCAsyncstream(uint8_t *data, int32_t length) {
-    int16_t packetLength = (getBits_2(data, 0) + 1) * 24;
-    int16_t continuityIndex = getBits_2(data, 2);
-    int16_t firstLast = getBits_2(data, 4);
-    int16_t address = getBits(data, 6, 10);
-    uint16_t command = getBits_1(data, 16);
-    int16_t usefulLength = getBits_7(data, 17);
-
-    (void)length;
-    (void)packetLength;
-    (void)continuityIndex;
-    (void)firstLast;
-    (void)address;
-    (void)command;
-    (void)usefulLength;
-    if (!check_CRC_bits(data, packetLength * 8))
-        return;
+void dataProcessor::addToSeries(packetStream *s, uint8_t *data,
+                                int32_t usefulLength) {
+    s->series.insert(s->series.end(), &data[3], &data[3 + usefulLength]);
 }
@@ -25,67 +25,53 @@
  */
 #include "ip-datahandler.h"
 #include "bits-helper.h"
-#include "radio.h"
+#include "logging.h"
 
-ip_dataHandler::ip_dataHandler(RadioInterface *mr,
-                               RingBuffer<uint8_t> *dataBuffer) {
-    this->dataBuffer = dataBuffer;
+ip_dataHandler::ip_dataHandler() {
     this->handledPackets = 0;
-    connect(this, SIGNAL(writeDatagram(int)), mr, SLOT(sendDatagram(int)));
+    this->socket = nullptr;
 }
 
-ip_dataHandler::~ip_dataHandler() {}
+ip_dataHandler::~ip_dataHandler() { delete socket; }
 
+//	the data group comes packed
 void ip_dataHandler::add_mscDatagroup(std::vector<uint8_t> msc) {
     uint8_t *data = (uint8_t *)(msc.data());
-    bool extensionFlag = getBits_1(data, 0) != 0;
-    bool crcFlag = getBits_1(data, 1) != 0;
-    bool segmentFlag = getBits_1(data, 2) != 0;
-    bool userAccessFlag = getBits_1(data, 3) != 0;
-    int16_t next = 16; // bits
-    bool lastSegment = false;
-    uint16_t segmentNumber = 0;
-    bool transportIdFlag = false;
-    uint16_t transportId = 0;
+    int32_t size = msc.size();
+    int32_t next = 2; // bytes
     uint8_t lengthInd;
-    int16_t i;
 
-    if (crcFlag && !check_CRC_bits(data, msc.size()))
+    if (size < 2)
+        return;
+    bool extensionFlag = (data[0] & 0x80) != 0;
+    bool crcFlag = (data[0] & 0x40) != 0;
+    bool segmentFlag = (data[0] & 0x20) != 0;
+    bool userAccessFlag = (data[0] & 0x10) != 0;
+
+    if (crcFlag && (size < 4 || !check_crc_bytes(data, size - 2)))
         return;
+    if (crcFlag)
+        size -= 2;
 
     if (extensionFlag)
-        next += 16;
+        next += 2;
 
-    if (segmentFlag) {
-        lastSegment = getBits_1(data, next) != 0;
-        segmentNumber = getBits(data, next + 1, 15);
-        next += 16;
-    }
+    // neither the segment number nor the transport id are of use here
+    if (segmentFlag)
+        next += 2;
 
-    (void)lastSegment;
-    (void)segmentNumber;
-    if (userAccessFlag) {
-        transportIdFlag = getBits_1(data, next + 3);
-        lengthInd = getBits_4(data, next + 4);
-        next += 8;
-        if (transportIdFlag) {
-            transportId = getBits(data, next, 16);
-        }
-        next += lengthInd * 8;
+    if (userAccessFlag && next < size) {
+        lengthInd = data[next] & 0x0F;
+        next += 1 + lengthInd;
     }
-    (void)transportId;
-    uint16_t ipLength = 0;
-    int16_t sizeinBits = msc.size() - next - (crcFlag != 0 ? 16 : 0);
 
-    (void)sizeinBits;
-    ipLength = getBits(data, next + 16, 16);
-    if (ipLength < msc.size() / 8) { // just to be sure
-        std::vector<uint8_t> ipVector;
-        ipVector.resize(ipLength);
-        for (i = 0; i < ipLength; i++)
-            ipVector[i] = getBits_8(data, next + 8 * i);
-        if ((ipVector[0] >> 4) != 4)
+    if (next + 20 > size) // not even an IP header
+        return;
+    uint16_t ipLength = (data[next + 2] << 8) | data[next + 3];
+    if (ipLength <= size - next) { // just to be sure
+        if ((data[next] >> 4) != 4)
             return; // should be version 4
+        std::vector<uint8_t> ipVector(&data[next], &data[next + ipLength]);
         process_ipVector(ipVector);
     }
 }
@@ -116,9 +102,15 @@ void ip_dataHandler::process_ipVector(std::vector<uint8_t> v) {
 }
 
 //	We keep it simple now, just hand over the data from the
-//	udp packet to port 8888
+//	udp packet to the local port
 void ip_dataHandler::process_udpVector(uint8_t *data, int16_t length) {
-    char *message = (char *)(&(data[8]));
-    dataBuffer->putDataIntoBuffer((uint8_t *)message, length - 8);
-    writeDatagram(length - 8);
+    if (length <= 8)
+        return;
+    if (socket == nullptr)
+        socket = new QUdpSocket();
+    if (socket->writeDatagram((const char *)&data[8], length - 8,
+                              QHostAddress::LocalHost, IP_DATA_PORT) < 0)
+        log(LOG_DATA, LOG_CHATTY, "cannot forward datagram: %s",
+            qPrintable(socket->errorString()));
+    handledPackets++;
 }
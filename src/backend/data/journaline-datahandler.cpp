@@ -27,8 +27,10 @@
 #include "journaline-datahandler.h"
 #include "bits-helper.h"
 #include "dabdatagroupdecoder.h"
+#include "logging.h"
 
 
+//	the data group payload is a whole Journaline object
 static
 void my_callBack (
     const DAB_DATAGROUP_DECODER_msc_datagroup_header_t *header,
@@ -36,30 +38,39 @@ void my_callBack (
     const unsigned char *buf,
     void *arg) {
     (void) header;
-    (void) len;
-    (void) buf;
-    (void) arg;
+    ((journaline_dataHandler *) arg)->addNewsObject(len, buf);
 }
 
 journaline_dataHandler::journaline_dataHandler() {
+    socket = nullptr;
     theDecoder = DAB_DATAGROUP_DECODER_createDec(my_callBack, this);
 }
 
 journaline_dataHandler::~journaline_dataHandler() {
     DAB_DATAGROUP_DECODER_deleteDec(theDecoder);
+    delete socket;
 }
 
+//	we keep no objects ourselves, whoever listens builds the tree
+void	journaline_dataHandler::addNewsObject(unsigned long len,
+					      const unsigned char *buf) {
+    if (len < 2)
+	return;
+    log(LOG_DATA, LOG_CHATTY, "journaline object %04x, %lu bytes",
+	(buf[0] << 8) | buf[1], len);
+    if (socket == nullptr)
+	socket = new QUdpSocket();
+    if (socket->writeDatagram((const char *) buf, len,
+			      QHostAddress::LocalHost, JOURNALINE_DATA_PORT) < 0)
+	log(LOG_DATA, LOG_CHATTY, "cannot forward journaline object: %s",
+	    qPrintable(socket->errorString()));
+}
+
+//	the data group comes packed, as the decoder wants it
 void	journaline_dataHandler::add_mscDatagroup (std::vector<uint8_t> msc) {
-    int16_t len = msc.size();
-    uint8_t *data = (uint8_t *) (msc.data());
-    _VLA(uint8_t, buffer, len / 8);
-    int16_t i;
     int32_t res;
 
-    for (i = 0; i < len / 8; i ++)
-	buffer[i] = getBits(data, 8 * i, 8);
-
-    res = DAB_DATAGROUP_DECODER_putData(theDecoder, len / 8, buffer);
+    res = DAB_DATAGROUP_DECODER_putData(theDecoder, msc.size(), msc.data());
     if (res < 0)
 	return;
 }
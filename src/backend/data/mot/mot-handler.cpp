@@ -53,62 +53,70 @@ motHandler::~motHandler() {
     }
 }
 
+//	the data group comes packed, so the header is read straight
+//	off the bytes and the segments are passed on in place
 void motHandler::add_mscDatagroup(std::vector<uint8_t> msc) {
     uint8_t *data = (uint8_t *)(msc.data());
-    bool extensionFlag = getBits_1(data, 0) != 0;
-    bool crcFlag = getBits_1(data, 1) != 0;
-    bool segmentFlag = getBits_1(data, 2) != 0;
-    bool userAccessFlag = getBits_1(data, 3) != 0;
-    uint8_t groupType = getBits_4(data, 4);
-    uint8_t CI = getBits_4(data, 8);
-    int32_t next = 16; // bits
+    int32_t size = msc.size();
+    int32_t next = 2; // bytes
     bool lastFlag = false;
     uint16_t segmentNumber = 0;
     bool transportIdFlag = false;
     uint16_t transportId = 0;
     uint8_t lengthInd;
-    int32_t i;
     motObject *h;
 
-    (void)CI;
-    if (msc.size() <= 0) {
+    if (size < 2) {
         return;
     }
+    bool extensionFlag = (data[0] & 0x80) != 0;
+    bool crcFlag = (data[0] & 0x40) != 0;
+    bool segmentFlag = (data[0] & 0x20) != 0;
+    bool userAccessFlag = (data[0] & 0x10) != 0;
+    uint8_t groupType = data[0] & 0x0F;
 
-    if (crcFlag && !check_CRC_bits(data, msc.size()))
+    if (crcFlag && (size < 4 || !check_crc_bytes(data, size - 2)))
         return;
+    if (crcFlag)
+        size -= 2;
 
     if (extensionFlag)
-        next += 16;
+        next += 2;
 
     if (segmentFlag) {
-        lastFlag = getBits_1(data, next) != 0;
-        segmentNumber = getBits(data, next + 1, 15);
-        next += 16;
+        if (next + 2 > size)
+            return;
+        lastFlag = (data[next] & 0x80) != 0;
+        segmentNumber = ((data[next] & 0x7F) << 8) | data[next + 1];
+        next += 2;
     }
 
     if (userAccessFlag) {
-        transportIdFlag = getBits_1(data, next + 3);
-        lengthInd = getBits_4(data, next + 4);
-        next += 8;
-        if (transportIdFlag) {
-            transportId = getBits(data, next, 16);
+        if (next + 1 > size)
+            return;
+        transportIdFlag = (data[next] & 0x10) != 0;
+        lengthInd = data[next] & 0x0F;
+        next += 1;
+        if (transportIdFlag && next + 2 <= size) {
+            transportId = (data[next] << 8) | data[next + 1];
         }
-        next += lengthInd * 8;
+        next += lengthInd;
     }
 
-    int32_t sizeinBits = msc.size() - next - (crcFlag != 0 ? 16 : 0);
-
     if (!transportIdFlag)
         return;
 
-    std::vector<uint8_t> motVector;
-    motVector.resize(sizeinBits / 8);
-    for (i = 0; i < sizeinBits / 8; i++)
-        motVector[i] = getBits_8(data, next + 8 * i);
+    // the segmentation header at least
+    if (next + 2 > size)
+        return;
+    uint8_t *motVector = &data[next];
 
     uint32_t segmentSize = ((motVector[0] & 0x1F) << 8) | motVector[1];
 
+    // the segment has to fit in what is left of the group, CRC excluded
+    if (next + 2 + segmentSize > (uint32_t) size)
+        return;
+
     // This is all described in ETSI EN301234 section 5.1
     switch (groupType) {
 
@@ -30,6 +30,7 @@
 #include "mot-object.h"
 #include "logging.h"
 #include "radio.h"
+#include <cstring>
 
 motObject::motObject(RadioInterface *mr, Type objectType, uint16_t transportId,
 		     uint8_t *segment, int32_t segmentSize, bool lastFlag) {
@@ -44,7 +45,10 @@ motObject::motObject(RadioInterface *mr, Type objectType, uint16_t transportId,
 	    SLOT(handleMotObject(QByteArray, QString, int, bool)));
     this->transportId = transportId;
     this->numOfSegments = -1;
+    this->receivedSegments = 0;
+    this->lastSegment = -1;
     this->segmentSize = -1;
+    this->lastSize = 0;
 
     headerSize = ((segment[3] & 0x0F) << 9) | (segment[4] << 1) |
 		 ((segment[5] >> 7) & 0x01);
@@ -91,6 +95,16 @@ motObject::motObject(RadioInterface *mr, Type objectType, uint16_t transportId,
 	    pointer += length;
 	}
     }
+
+    // a cached object is made out of its first body segment, so there
+    // is no size to go by, and the body grows as the segments come in
+    sized = objectType != Cache && bodySize > 0;
+    if (sized && bodySize > MOT_MAX_BODY) {
+	log(LOG_MOT, LOG_MIN, "mot object transport %x too large %i", transportId, bodySize);
+	bodySize = 0;
+    }
+    if (sized)
+	body.resize(bodySize);
     switch (objectType) {
     case Directory:
 	log(LOG_MOT, LOG_CHATTY, "directory object transport %x name %s", transportId, qPrintable(name));
@@ -117,60 +131,125 @@ uint16_t motObject::getTransportId() { return transportId; }
 // Note that segments do not need to come in in the right order
 bool motObject::addBodySegment(uint8_t *bodySegment, int16_t segmentNumber,
 			       int32_t segmentSize, bool lastFlag) {
-    int32_t i;
+    int32_t offset;
 
-    if ((segmentNumber < 0) || (segmentNumber >= 8192))
+    if ((segmentNumber < 0) || (segmentNumber >= MOT_MAX_SEGMENTS) || (segmentSize <= 0))
 	return false;
-
-    if (motMap.find(segmentNumber) != motMap.end())
+    if (received[segmentNumber])
+	return false;
+    if (numOfSegments != -1 && segmentNumber >= numOfSegments)
 	return false;
 
     // Note that the last segment may have a different size
-    if (!lastFlag && (this->segmentSize == -1))
-	this->segmentSize = segmentSize;
-
-    QByteArray segment;
-    segment.resize(segmentSize);
-    for (i = 0; i < segmentSize; i++)
-	segment[i] = bodySegment[i];
-    motMap.insert(std::make_pair(segmentNumber, segment));
+    if (!lastFlag) {
+	if (this->segmentSize == -1)
+	    this->segmentSize = segmentSize;
+	else if (segmentSize != this->segmentSize) {
+	    log(LOG_MOT, LOG_CHATTY, "mot object transport %x segment %i size %i, expected %i",
+		transportId, segmentNumber, segmentSize, this->segmentSize);
+	    return false;
+	}
+    }
+    if (!placeSegment(segmentNumber, segmentSize, lastFlag, &offset))
+	return false;
+    memcpy(body.data() + offset, bodySegment, segmentSize);
+    received[segmentNumber] = true;
+    receivedSegments++;
 
-    if (lastFlag)
+    if (lastFlag) {
+	lastSegment = segmentNumber;
+	lastSize = segmentSize;
 	numOfSegments = segmentNumber + 1;
 
-    if (numOfSegments == -1)
-	return false;
+	// anything past the end was bogus
+	for (int i = numOfSegments; i < MOT_MAX_SEGMENTS; i++)
+	    if (received[i]) {
+		received[i] = false;
+		receivedSegments--;
+	    }
+    }
 
     // once we know how many segments there are/should be,
-    // we check for completeness
-    for (i = 0; i < numOfSegments; i++) {
-	if (motMap.find(i) == motMap.end())
-	    return false;
-    }
+    // the count tells if we are complete
+    if (numOfSegments == -1 || receivedSegments < numOfSegments)
+	return false;
 
     // The motObject is (seems to be) complete
     handleComplete();
     return true;
 }
 
-void motObject::handleComplete() {
-    QByteArray result;
-    for (const auto &it : motMap)
-	result.append(it.second);
+// All segments but the last have the same size. If the last one comes
+// in first, the body size from the header tells where it goes
+bool motObject::placeSegment(int16_t segmentNumber, int32_t size, bool lastFlag,
+			     int32_t *offset) {
+    if (this->segmentSize > 0)
+	*offset = segmentNumber * this->segmentSize;
+    else if (lastFlag && (segmentNumber == 0 || sized))
+	*offset = segmentNumber == 0? 0: bodySize - size;
+    else
+	return false;
+
+    // sized or not, no segment takes a body past the limit
+    if (*offset < 0 || *offset + size > MOT_MAX_BODY) {
+	log(LOG_MOT, LOG_CHATTY, "mot object transport %x segment %i past %i bytes",
+	    transportId, segmentNumber, MOT_MAX_BODY);
+	return false;
+    }
+    if (!sized) {
+	if (body.size() < *offset + size)
+	    body.resize(*offset + size);
+	return true;
+    }
+    if (*offset < 0 || (uint32_t) (*offset + size) > bodySize) {
+	log(LOG_MOT, LOG_CHATTY, "mot object transport %x segment %i past body size %i",
+	    transportId, segmentNumber, bodySize);
+	return false;
+    }
+
+    // the segments have the last word on where the body ends
+    if (lastFlag && (uint32_t) (*offset + size) < bodySize) {
+	bodySize = *offset + size;
+	body.resize(bodySize);
+    }
+    return true;
+}
 
-    emit handleMotObject(result, name, (int)contentType, dirElement);
+bool motObject::segmentAt(int16_t segmentNumber, int32_t *offset, int32_t *size) {
+    if (!received[segmentNumber])
+	return false;
+    if (segmentNumber == lastSegment) {
+	*size = lastSize;
+	*offset = sized? bodySize - lastSize: segmentNumber * segmentSize;
+    } else {
+	*size = segmentSize;
+	*offset = segmentNumber * segmentSize;
+    }
+    return true;
+}
+
+// the body is handed over as is, QByteArray is shared
+void motObject::handleComplete() {
+    emit handleMotObject(body, name, (int)contentType, dirElement);
 }
 
 bool motObject::mergeObject(motObject *cached) {
     bool res = false;
-    if (cached->motMap.empty())
+    int left = cached->receivedSegments;
+
+    if (left == 0)
 	return res;
     log(LOG_MOT, LOG_CHATTY, "restoring cached elements from cached %x", cached->transportId);
-    int lastSeg = cached->motMap.rbegin()->first;
-    for (auto& it: cached->motMap)
-	if (addBodySegment(reinterpret_cast<uint8_t*>(it.second.data()), it.first,
-		cached->segmentSize, it.first==lastSeg && cached->numOfSegments != -1))
+    for (int16_t i = 0; left > 0 && i < MOT_MAX_SEGMENTS; i++) {
+	int32_t offset, size;
+
+	if (!cached->segmentAt(i, &offset, &size))
+	    continue;
+	left--;
+	if (addBodySegment(reinterpret_cast<uint8_t*>(cached->body.data()) + offset, i,
+		size, i == cached->lastSegment))
 	    res = true;
+    }
     return res;
 }
 
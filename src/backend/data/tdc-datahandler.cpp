@@ -28,34 +28,22 @@
 #include "bits-helper.h"
 #include "constants.h"
 #include "logging.h"
-#include "radio.h"
 
-tdc_dataHandler::tdc_dataHandler(RadioInterface *mr,
-                                 RingBuffer<uint8_t> *dataBuffer,
-                                 int16_t appType) {
-    (void) appType;
-    myRadioInterface = mr;
-    this->dataBuffer = dataBuffer;
+tdc_dataHandler::tdc_dataHandler(int16_t appType) {
     // for the moment we assume appType 4
-    connect(this, SIGNAL(bytesOut(int, int)), myRadioInterface,
-            SLOT(handle_tdcdata(int, int)));
+    (void) appType;
+    socket = nullptr;
 }
 
-tdc_dataHandler::~tdc_dataHandler() {}
-
-#define swap(a) (((a) << 8) | ((a) >> 8))
+tdc_dataHandler::~tdc_dataHandler() { delete socket; }
 
-uint16_t usCalculCRC(uint8_t *buf, int lg) {
-    uint16_t crc;
-    int count;
-    crc = 0xFFFF;
-    for (count = 0; count < lg; count++) {
-        crc = (uint16_t)(swap(crc) ^ (uint16_t)buf[count]);
-        crc ^= ((uint8_t)crc) >> 4;
-        crc = (uint16_t)(crc ^ (swap((uint8_t)(crc)) << 4) ^
-                         ((uint8_t)(crc) << 5));
-    }
-    return ((uint16_t)(crc ^ 0xFFFF));
+void tdc_dataHandler::forward(uint8_t *buffer, int32_t length) {
+    if (socket == nullptr)
+        socket = new QUdpSocket();
+    if (socket->writeDatagram((const char *)buffer, length,
+                              QHostAddress::LocalHost, TDC_DATA_PORT) < 0)
+        log(LOG_DATA, LOG_CHATTY, "cannot forward tdc frame: %s",
+            qPrintable(socket->errorString()));
 }
 
 void tdc_dataHandler::add_mscDatagroup(std::vector<uint8_t> m) {
@@ -64,25 +52,21 @@ void tdc_dataHandler::add_mscDatagroup(std::vector<uint8_t> m) {
     int32_t size = m.size();
     int16_t i;
 
-    //	we maintain offsets in bits, the "m" array has one bit per byte
+    //	the "m" array is packed, offsets are in bytes
     while (offset < size) {
-        while (offset + 16 < size) {
-            if (getBits(data, offset, 16) == 0xFF0F) {
+        while (offset + 2 < size) {
+            if (((data[offset] << 8) | data[offset + 1]) == 0xFF0F) {
                 break;
             } else
-                offset += 8;
+                offset++;
         }
-        if (offset + 16 >= size)
+        if (offset + 7 >= size)
             return;
 
         //	we have a syncword
-        //	   uint16_t syncword	= getBits (data, offset,      16);
-        int16_t length = getBits(data, offset + 16, 16);
-        uint16_t crc = getBits(data, offset + 32, 16);
-
-        (void)crc;
-        uint8_t frametypeIndicator = getBits(data, offset + 48, 8);
-        if ((length < 0) || (length >= (size - offset) / 8))
+        int16_t length = (data[offset + 2] << 8) | data[offset + 3];
+        uint8_t frametypeIndicator = data[offset + 6];
+        if ((length < 0) || (length > size - offset - 7))
             return; // garbage
 
         //	OK, prepare to check the crc
@@ -90,25 +74,24 @@ void tdc_dataHandler::add_mscDatagroup(std::vector<uint8_t> m) {
 
         //	first the syncword and the length
         for (i = 0; i < 4; i++)
-            checkVector[i] = getBits(data, offset + i * 8, 8);
+            checkVector[i] = data[offset + i];
 
         //	we skip the crc in the incoming data and take the frametype
-        checkVector[4] = getBits(data, offset + 6 * 8, 8);
+        checkVector[4] = data[offset + 6];
 
         int size = length < 11 ? length : 11;
-        for (i = 0; i < size; i++)
-            checkVector[5 + i] = getBits(data, offset + 7 * 8 + i * 8, 8);
-        checkVector[5 + size] = getBits(data, offset + 4 * 8, 8);
-        checkVector[5 + size + 1] = getBits(data, offset + 5 * 8, 8);
+        memcpy(&checkVector[5], &data[offset + 7], size);
+        checkVector[5 + size] = data[offset + 4];
+        checkVector[5 + size + 1] = data[offset + 5];
         if (!check_crc_bytes(checkVector, 5 + size)) {
             log(LOG_DATA, LOG_MIN, "crc failed");
             return;
         }
 
         if (frametypeIndicator == 0)
-            offset = handleFrame_type_0(data, offset + 7 * 8, length);
+            offset = handleFrame_type_0(data, offset + 7, length);
         else if (frametypeIndicator == 1)
-            offset = handleFrame_type_1(data, offset + 7 * 8, length);
+            offset = handleFrame_type_1(data, offset + 7, length);
         else
             return; // failure
     }
@@ -116,48 +99,37 @@ void tdc_dataHandler::add_mscDatagroup(std::vector<uint8_t> m) {
 
 int32_t tdc_dataHandler::handleFrame_type_0(uint8_t *data, int32_t offset,
                                             int32_t length) {
-    int16_t i;
-    // int16_t noS	= getBits (data, offset, 8);
-    _VLA(uint8_t, buffer, length);
+    uint8_t *buffer = &data[offset];
 
-    for (i = 0; i < length; i++)
-        buffer[i] = getBits(data, offset + i * 8, 8);
     if (!check_crc_bytes(buffer, length - 2))
         log(LOG_DATA, LOG_MIN, "type 0 frame crc error");
     log(LOG_DATA, LOG_VERBOSE, "nrServices %d, SID-A %d SID-B %d SID-C %d",
         buffer[0], buffer[1], buffer[2], buffer[3]);
-    dataBuffer->putDataIntoBuffer(buffer, length);
-    bytesOut(0, length);
-    return offset + length * 8;
+    forward(buffer, length);
+    return offset + length;
 }
 
 int32_t tdc_dataHandler::handleFrame_type_1(uint8_t *data, int32_t offset,
                                             int32_t length) {
-    int16_t i;
-    _VLA(uint8_t, buffer, length);
+    uint8_t *buffer = &data[offset];
     int lOffset;
     int llengths = length - 4;
     log(LOG_DATA, LOG_VERBOSE,
         " frametype 1  (length %d) met %d %d %d encryption %d", length,
-        getBits(data, offset, 8), getBits(data, offset + 8, 8),
-        getBits(data, offset + 16, 8), getBits(data, offset + 24, 8));
-    for (i = 0; i < length; i++)
-        buffer[i] = getBits(data, offset + i * 8, 8);
-    dataBuffer->putDataIntoBuffer(buffer, length);
-    if (getBits(data, offset + 24, 8) == 0) { // no encryption
-        lOffset = offset + 4 * 8;
+        buffer[0], buffer[1], buffer[2], buffer[3]);
+    if (buffer[3] == 0) { // no encryption
+        lOffset = 4;
         do {
-            int flength = getBits(data, lOffset + 8, 16);
-            //	      int crc		= getBits (data, lOffset + 3 * 8, 8);
+            int flength = (buffer[lOffset + 1] << 8) | buffer[lOffset + 2];
             log(LOG_DATA, LOG_VERBOSE, "segment %d, length %d (%c %c %c %c %c)",
-                getBits(data, lOffset, 8), flength, buffer[0], buffer[1],
+                buffer[lOffset], flength, buffer[0], buffer[1],
                 buffer[2], buffer[3], buffer[4]);
-            lOffset += (flength + 5) * 8;
+            lOffset += flength + 5;
             llengths -= flength + 5;
         } while (llengths > 10);
     }
-    bytesOut(1, length);
-    return offset + length * 8;
+    forward(buffer, length);
+    return offset + length;
 }
 
 //	The component header CRC is two bytes long,
@@ -170,21 +142,17 @@ int32_t tdc_dataHandler::handleFrame_type_1(uint8_t *data, int32_t offset,
 bool tdc_dataHandler::serviceComponentFrameheaderCRC(uint8_t *data,
                                                      int16_t offset,
                                                      int16_t maxL) {
-    uint8_t testVector[18];
-    int16_t i;
-    int16_t length = getBits(data, offset + 8, 16);
+    uint8_t testVector[16];
+    int16_t length = (data[offset + 1] << 8) | data[offset + 2];
     int16_t size = length < 13 ? length : 13;
     uint16_t crc;
 
     (void) maxL;
     if (length < 0)
         return false;                     // assumed garbage
-    crc = getBits(data, offset + 24, 16); // the crc
-    testVector[0] = getBits(data, offset + 0, 8);
-    testVector[1] = getBits(data, offset + 8, 8);
-    testVector[2] = getBits(data, offset + 16, 8);
-    for (i = 0; i < size; i++)
-        testVector[3 + i] = getBits(data, offset + 40 + i * 8, 8);
-
-    return usCalculCRC(testVector, 3 + size) == crc;
+    crc = (data[offset + 3] << 8) | data[offset + 4]; // the crc
+    memcpy(testVector, &data[offset], 3);
+    memcpy(&testVector[3], &data[offset + 5], size);
+
+    return (uint16_t)~crc16(testVector, 3 + size) == crc;
 }
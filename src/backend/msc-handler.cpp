@@ -261,6 +261,15 @@ bool mscHandler::set_Channel(serviceDescriptor *d,
             return false;
         }
     }
+
+    //	packet services multiplexed on a subchannel share its backend
+    if (d->type == PACKET_SERVICE)
+        for (auto const &b : theBackends)
+            if (b->subChId == d->subchId) {
+                bool added = b->addService(d);
+                locker.unlock();
+                return added;
+            }
     theBackends.push_back(
         new Backend(myRadioInterface, d, audioBuffer, dataBuffer, frameBuffer));
     log(LOG_DAB, LOG_MIN, "backends running: %i", (int) theBackends.size());
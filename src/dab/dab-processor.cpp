@@ -25,12 +25,14 @@
  */
 #include "dab-processor.h"
 
+#include "agc-controller.h"
 #include "dab-params.h"
 #include "fic-handler.h"
 #include "logging.h"
 #include "msc-handler.h"
 #include "process-params.h"
 #include "radio.h"
+#include "telemetry.h"
 #include "timesyncer.h"
 #include <utility>
 
@@ -77,6 +79,7 @@ dabProcessor::dabProcessor(RadioInterface *mr, deviceHandler *inputDevice,
     totalFrames = 0;
     scanMode = false;
     connect(this, SIGNAL(showStrength(float)), mr, SLOT(showStrength(float)));
+    connect(this, SIGNAL(timeSynced()), mr, SLOT(timeSynced()));
     my_TII_Detector.reset();
 }
 
@@ -116,6 +119,8 @@ void dabProcessor::run() {
     int totalSamples = 0;
     double cLevel = 0;
     int cCount = 0;
+    int64_t syncStart;
+    bool firstSync = true;
     ibits.resize(2 * params.get_carriers());
     fineOffset = 0;
     coarseOffset = 0;
@@ -148,6 +153,7 @@ void dabProcessor::run() {
         sampleCount = 0;
 
         emit setSynced(false);
+        inputDevice->agcControl()->setSynced(false);
         my_TII_Detector.reset();
         switch (myTimeSyncer.sync(T_null, T_F)) {
         case TIMESYNC_ESTABLISHED:
@@ -170,10 +176,13 @@ void dabProcessor::run() {
          *	Note that we probably already had 30 to 40 samples of the T_g
          *	part
          */
+        syncStart = telemetryStart();
         startIndex = phaseSynchronizer.findIndex(&ofdmBuffer, threshold);
+        telemetryStop(TEL_SYNC, syncStart);
         if (startIndex < 0 || (size_t) startIndex >= ofdmBuffer.size()) { // no sync, try again
             if (!correctionNeeded) {
                 emit setSyncLost();
+                telemetryCount(TEL_SYNC_LOST);
             }
             badFrames++;
             goto notSynced;
@@ -196,10 +205,13 @@ void dabProcessor::run() {
          *	period. We use a correlation that will find the first sample after the
          *	cyclic prefix.
          */
+        syncStart = telemetryStart();
         startIndex = phaseSynchronizer.findIndex(&ofdmBuffer, 3 * threshold);
+        telemetryStop(TEL_SYNC, syncStart);
         if (startIndex < 0 || (size_t) startIndex >= ofdmBuffer.size()) { // no sync, try again
             if (!correctionNeeded) {
                 emit setSyncLost();
+                telemetryCount(TEL_SYNC_LOST);
             }
             badFrames++;
             goto notSynced;
@@ -227,6 +239,13 @@ void dabProcessor::run() {
          *	missing samples in the ofdm buffer
          */
         emit setSynced(true);
+        inputDevice->agcControl()->setSynced(true);
+        //	the first time round, a service can be started from cached
+        //	parameters ahead of the fic
+        if (firstSync) {
+            firstSync = false;
+            emit timeSynced();
+        }
         myReader.getSamples(&((ofdmBuffer.data())[ofdmBufferIndex]),
                             T_u - ofdmBufferIndex, coarseOffset + fineOffset);
         sampleCount += T_u;
@@ -301,6 +320,9 @@ void dabProcessor::run() {
         myReader.getSamples(ofdmBuffer.data(), T_null,
                             coarseOffset + fineOffset);
         sampleCount += T_null;
+
+        //	a pending gain change can go now, before the next frame
+        inputDevice->agcControl()->frameEnd(T_F, T_null);
         float sum = 0;
         for (i = 0; i < T_null; i++)
             sum += abs(ofdmBuffer[i]);
@@ -362,6 +384,7 @@ void dabProcessor::run() {
         if (e != 20 && e != 21)
             log(LOG_DAB, LOG_CHATTY, "dabProcessor caugth %i", e);
     }
+    inputDevice->agcControl()->setSynced(false);
 }
 
 void dabProcessor::set_scanMode(bool b) {
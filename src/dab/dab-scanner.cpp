@@ -0,0 +1,235 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, version 2 of the License.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "dab-scanner.h"
+#include "logging.h"
+#include "timesyncer.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+
+scanWorker::scanWorker(dabScanner *scanner, deviceHandler *device,
+                       uint8_t dabMode)
+    : params(dabMode), detector(dabMode) {
+    this->scanner = scanner;
+    this->device = device;
+    running.store(true);
+    buffer.resize(SCAN_FRAMES * params.get_T_F());
+}
+
+scanWorker::~scanWorker() { stop(); }
+
+void scanWorker::stop() {
+    running.store(false);
+    wait();
+}
+
+//	the samples come straight from the device, the sample reader
+//	belongs to the DAB processor
+bool scanWorker::readSamples(std::complex<float> *v, int32_t n) {
+    QElapsedTimer timer;
+    agcStats stats;
+    int32_t got = 0;
+
+    timer.start();
+    while (got < n) {
+        if (!running.load() || timer.elapsed() > SCAN_TIMEOUT)
+            return false;
+        int32_t available = device->Samples();
+        if (available == 0) {
+            usleep(1000);
+            continue;
+        }
+        if (available > n - got)
+            available = n - got;
+        got += device->getSamples(v + got, available, &stats);
+    }
+    return true;
+}
+
+//	an empty channel is turned down on the spectrum alone, the frames
+//	are only read if there is something there
+float scanWorker::checkChannel(int32_t frequency, float *plateau) {
+    int32_t settle = INPUT_RATE / 1000 * SCAN_SETTLE;
+    int32_t spectrum = detector.samplesNeeded();
+    int32_t n = buffer.size();
+    float level = -1;
+
+    *plateau = -1;
+    if (!device->restartReader(frequency))
+        return -1;
+    if (readSamples(buffer.data(), settle) &&
+        readSamples(buffer.data(), spectrum)) {
+        *plateau = detector.plateauLevel(buffer.data(), spectrum);
+        if (*plateau < PLATEAU_LEVEL)
+            level = 1;
+        else if (readSamples(buffer.data(), n))
+            level = timeSyncer::nullLevel(buffer.data(), n,
+                                          params.get_T_null(),
+                                          params.get_T_F());
+    }
+    device->stopReader();
+    return level;
+}
+
+void scanWorker::run() {
+    int32_t frequency;
+    float plateau;
+    int index;
+
+    while (running.load() && (index = scanner->takeChannel(&frequency)) >= 0) {
+        float level = checkChannel(frequency, &plateau);
+
+        scanner->channelChecked(index, plateau, level);
+    }
+    scanner->workerDone();
+}
+
+dabScanner::dabScanner(const std::vector<deviceHandler *> &tuners,
+                       uint8_t dabMode) {
+    for (auto t : tuners)
+        workers.push_back(new scanWorker(this, t, dabMode));
+    nextChannel = 0;
+    pending = 0;
+}
+
+dabScanner::~dabScanner() {
+    stop();
+    for (auto w : workers)
+        delete w;
+}
+
+void dabScanner::addChannel(int index, const QString &channel,
+                            int32_t frequency) {
+    scanResult r;
+
+    r.channel = channel;
+    r.frequency = frequency;
+    r.index = index;
+    r.plateauLevel = -1;
+    r.nullLevel = -1;
+    r.checked = false;
+    r.occupied = false;
+    r.EId = 0;
+    r.services = 0;
+    results.push_back(r);
+}
+
+void dabScanner::start() {
+    log(LOG_DAB, LOG_MIN, "scan pre-check of %i channels on %i tuners",
+        (int)results.size(), (int)workers.size());
+    nextChannel = 0;
+    pending = workers.size();
+    if (pending == 0) {
+        emit checkDone();
+        return;
+    }
+    for (auto w : workers)
+        w->start();
+}
+
+void dabScanner::stop() {
+    for (auto w : workers)
+        w->stop();
+}
+
+int dabScanner::takeChannel(int32_t *frequency) {
+    int i = -1;
+
+    locker.lock();
+    if (nextChannel < (int)results.size()) {
+        i = nextChannel++;
+        *frequency = results[i].frequency;
+    }
+    locker.unlock();
+    return i;
+}
+
+//	a tuner that could not tell leaves the channel to the full decode
+void dabScanner::channelChecked(int i, float plateau, float level) {
+    locker.lock();
+    results[i].plateauLevel = plateau;
+    results[i].nullLevel = level;
+    results[i].checked = true;
+    results[i].occupied = level < 0 || level < SYNC_DIP_LEVEL;
+    QString channel = results[i].channel;
+    bool occupied = results[i].occupied;
+    locker.unlock();
+    log(LOG_DAB, LOG_CHATTY, "scan pre-check %s plateau %f null level %f",
+        qPrintable(channel), plateau, level);
+    emit channelDone(channel, occupied);
+}
+
+void dabScanner::workerDone() {
+    locker.lock();
+    bool done = --pending == 0;
+    locker.unlock();
+    if (done)
+        emit checkDone();
+}
+
+std::vector<int> dabScanner::candidates() {
+    std::vector<int> c;
+
+    locker.lock();
+    for (const auto &r : results)
+        if (r.checked && r.occupied)
+            c.push_back(r.index);
+    locker.unlock();
+    return c;
+}
+
+void dabScanner::setEnsemble(int index, int32_t EId, const QString &name,
+                             int services) {
+    locker.lock();
+    for (auto &r : results)
+        if (r.index == index) {
+            r.EId = EId;
+            r.ensembleName = name;
+            r.services = services;
+        }
+    locker.unlock();
+}
+
+//	one line per channel, tab separated
+bool dabScanner::writeResults(const QString &fileName) {
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        log(LOG_DAB, LOG_MIN, "cannot write scan results to %s",
+            qPrintable(fileName));
+        return false;
+    }
+    QTextStream out(&file);
+    locker.lock();
+    out << "#channel\tfrequency\tplateau\tnullLevel\tEId\tensemble\tservices\n";
+    for (const auto &r : results) {
+        if (!r.checked)
+            continue;
+        out << r.channel << "\t" << r.frequency << "\t"
+            << QString::number(r.plateauLevel, 'f', 3) << "\t"
+            << QString::number(r.nullLevel, 'f', 3) << "\t"
+            << QString::number(r.EId, 16) << "\t" << r.ensembleName.trimmed()
+            << "\t" << r.services << "\n";
+    }
+    locker.unlock();
+    file.close();
+    return true;
+}
@@ -0,0 +1,883 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include <QCoreApplication>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QSettings>
+#include <QStringList>
+#include <unistd.h>
+#include "constants.h"
+#include "settings.h"
+#include "fm-processor.h"
+#include "fm-demodulator.h"
+#include "rds-decoder.h"
+#include "dab-tables.h"
+#include "radio.h"
+#include "band-handler.h"
+#include "Qt-audio.h"
+#include "audiosink.h"
+#include "logging.h"
+#include "agc-controller.h"
+
+RadioInterface::RadioInterface(QSettings *Si, deviceHandler *fileDevice,
+			       QObject *parent):
+	QObject(parent),
+	iqBuffer(2 * 1536),
+	tiiBuffer(32768),
+	responseBuffer(32768),
+	frameBuffer(2 * 32768),
+	audioBuffer(8 * 32768),
+#ifdef USE_SPI
+	dataBuffer(32768),
+#endif
+	DABband() {
+    bool isQtAudio;
+    int latency;
+    int soundChannel;
+
+    settings = Si;
+    server = nullptr;
+
+    // DAB
+    DABprocessor = nullptr;
+    settings->beginGroup(GROUP_DAB);
+    DABglobals.threshold = settings->value(DAB_THRESHOLD, DAB_DEF_THRESHOLD).toInt();
+    DABglobals.diff_length = settings->value(DAB_DIFF_LENGTH, DIFF_LENGTH).toInt();
+    DABglobals.tii_delay = settings->value(DAB_TII_DELAY, DAB_DEF_TII_DELAY).toInt();
+    if (DABglobals.tii_delay < DAB_MIN_TII_DELAY)
+	DABglobals.tii_delay = DAB_MIN_TII_DELAY;
+    DABglobals.tii_depth = settings->value(DAB_TII_DEPTH, DAB_DEF_TII_DEPTH).toInt();
+    DABglobals.echo_depth = settings->value(DAB_ECHO_DEPTH, DAB_DEF_ECHO_DEPTH).toInt();
+    serviceOrder = settings->value(DAB_SERVICE_ORDER, DAB_DEF_SERVICE_ORDER).toInt();
+    settings->endGroup();
+
+    // FM settings
+    FMprocessor = nullptr;
+    settings->beginGroup(GROUP_FM);
+    workingRate = settings->value(FM_WORKING_RATE, FM_DEF_WORKING_RATE).toInt();
+    FMthreshold = settings->value(FM_THRESHOLD, FM_DEF_THRESHOLD).toInt();
+    FMfilter = settings->value(FM_FILTER, FM_DEF_FILTER).toInt();
+    FMdecoder = settings->value(FM_DECODER, FM_DEF_DECODER).toInt();
+    deemphasis = settings->value(FM_DEEMPHASIS, FM_DEF_DEEMPHASIS).toInt();
+    lowPassFilter = settings->value(FM_LOW_PASS_FILTER, FM_DEF_LOW_PASS_FILTER).toInt();
+    FMaudioGain = settings->value(FM_AUDIO_GAIN, FM_DEF_AUDIO_GAIN).toInt();
+    settings->endGroup();
+
+    // RDS settings
+    settings->beginGroup(GROUP_RDS);
+    rdsDemodulator = settings->value(RDS_DEMODULATOR, RDS_DEF_DEMODULATOR).toInt();
+    rdsDecoder = settings->value(RDS_DECODER, RDS_DEF_DECODER).toInt();
+    rdsPartialText = settings->value(RDS_PARTIAL_TEXT, RDS_DEF_PARTIAL_TEXT).toInt();
+    settings->endGroup();
+
+    settings->beginGroup(GROUP_SOUND);
+    isQtAudio = (settings->value(SOUND_MODE, SOUND_DEF_MODE).toString() == SOUND_QT);
+    latency = settings->value(SOUND_LATENCY, SOUND_DEF_LATENCY).toInt();
+    audioRate = settings->value(SOUND_AUDIO_RATE, SOUND_DEF_AUDIO_RATE).toInt();
+    soundChannel = settings->value(SOUND_CHANNEL, SOUND_DEF_CHANNEL).toInt();
+    if (isQtAudio) {
+	soundOut = new Qt_Audio;
+    } else {
+	soundOut = new audioSink(latency);
+	if (!((audioSink *) soundOut)->selectDevice(soundChannel)) {
+	    soundChannel = ((audioSink *) soundOut)->defaultDevice();
+	    ((audioSink *) soundOut)->selectDevice(soundChannel);
+	}
+    }
+    settings->endGroup();
+
+    // base settings
+    volume = settings->value(GEN_VOLUME, GEN_DEF_VOLUME).toInt();
+    if (volume < 0)
+	volume = 0;
+    else if (volume > AUDIO_SCALE)
+	volume = AUDIO_SCALE;
+    soundOut->setVolume(qreal(volume)/AUDIO_SCALE);
+    deviceType = settings->value(GEN_DEVICE_TYPE, "").toString();
+
+    findDevices(fileDevice);
+    DABband.setupChannels(BAND_III);
+    for (;;) {
+	std::string c = DABband.nextChannel();
+
+	if (c.length() == 0)
+	    break;
+	channels << QString::fromStdString(c);
+    }
+    channel = settings->value(GEN_CHANNEL, GEN_DEF_CHANNEL).toString();
+    if (!channels.contains(channel))
+	channel = channels.at(0);
+    nextService.valid = false;
+    dataServices.clear();
+    currentService.valid = false;
+    ensembles = new EnsembleCache(QString("%1/ensembles").arg(LOCAL_STORAGE));
+    cachedService.defined = false;
+    cachedRunning = false;
+    currentService.serviceName = settings->value(GEN_SERVICE_NAME, "").toString();
+    FMfreq = settings->value(GEN_FM_FREQUENCY, DEF_FM).toDouble();
+    if (FMfreq < MIN_FM)
+	FMfreq = MIN_FM;
+    else if (FMfreq > MAX_FM)
+	FMfreq = MAX_FM;
+
+    makeDABprocessor();
+    makeFMprocessor();
+
+    squelch = settings->value(GEN_SQUELCH, GEN_DEF_SQUELCH).toInt();
+    if (squelch < 0)
+	squelch = 0;
+    else if (squelch > AUDIO_SCALE)
+	squelch = AUDIO_SCALE;
+    if (FMprocessor != nullptr)
+	FMprocessor->setSquelchValue(AUDIO_SCALE-squelch);
+
+    playing = false;
+    stereo = false;
+    strength = 0;
+    quality = 0;
+    ficSuccess = 0;
+    ficBlocks = 0;
+    isFM = (settings->value(GEN_TUNER_MODE, GEN_DEF_TUNER_MODE).toString() == GEN_FM);
+}
+
+RadioInterface::~RadioInterface() {
+    stop();
+    usleep(1000);
+    saveSettings();
+    for (const auto &c: clients) {
+	disconnect(c, nullptr, this, nullptr);
+	c->abort();
+    }
+    delete server;
+    delete soundOut;
+    if (DABprocessor != nullptr)
+	delete DABprocessor;
+    if (FMprocessor != nullptr)
+	delete FMprocessor;
+    delete ensembles;
+    for (const auto &dev: deviceList) {
+	dev.device->agcControl()->stop();
+	delete dev.device;
+    }
+}
+
+void RadioInterface::saveSettings() {
+    settings->setValue(GEN_SERVICE_NAME, currentService.serviceName);
+    settings->setValue(GEN_CHANNEL, channel);
+    settings->setValue(GEN_FM_FREQUENCY, FMfreq);
+    settings->setValue(GEN_TUNER_MODE, isFM? GEN_FM: GEN_DAB);
+    settings->setValue(GEN_VOLUME, volume);
+    settings->setValue(GEN_DEVICE_TYPE, deviceType);
+    settings->sync();
+}
+
+void RadioInterface::resetSwAgc() {
+    if (inputDevice)
+	inputDevice->agcControl()->configure(agc == AGC_SOFTWARE || agc == AGC_COMBINED,
+					     ifGain, minIfGain, maxIfGain);
+}
+
+void RadioInterface::findDevices(deviceHandler *fileDevice) {
+    probeDevices(deviceList, fileDevice);
+    deviceControls = 0;
+    agc = AGC_OFF;
+    ifGain = 0;
+    minIfGain = 0;
+    maxIfGain = 0;
+    if (deviceList.size() == 0) {
+	inputDevice = nullptr;
+	deviceType = "";
+	log(LOG_DEV, LOG_MIN, "no devices found");
+    } else {
+	QString saveType = deviceType;
+	deviceStrings devNames[MAX_DEVICES];
+
+	inputDevice = deviceList[0].device;
+	deviceControls = deviceList[0].controls;
+	deviceType = deviceList[0].deviceType;
+	if (QString::compare(saveType, "") && fileDevice == nullptr)
+	    for (uint i = 0; i < deviceList.size(); ++i)
+		if (!QString::compare(deviceList[i].deviceType, saveType)) {
+		    inputDevice = deviceList[i].device;
+		    deviceControls = deviceList[i].controls;
+		    deviceType = deviceList[i].deviceType;
+		    break;
+		}
+	log(LOG_DEV, LOG_MIN, "using device %s", qPrintable(deviceType));
+	settings->beginGroup(deviceType);
+	uint dc = inputDevice->devices((deviceStrings *) &devNames, MAX_DEVICES);
+	bool found = false;
+	if (dc > 0) {
+	    deviceId = settings->value(DEV_ID, "").toString();
+	    for (uint i = 0; i < dc; i++)
+		if (QString::compare(devNames[i].id, deviceId) == 0) {
+		    found = true;
+		    break;
+		}
+	    if (!found)
+		deviceId = devNames[0].id;
+	    inputDevice->setDevice(qPrintable(deviceId));
+	}
+	inputDevice->getIfRange(&minIfGain, &maxIfGain);
+	inputDevice->getLnaRange(&minLnaGain, &maxLnaGain);
+	agc = settings->value(DEV_AGC, defaultAgc()).toInt();
+	ifGain = settings->value(DEV_IF_GAIN, (minIfGain + maxIfGain) / 2).toInt();
+	lnaGain = settings->value(DEV_LNA_GAIN, minLnaGain).toInt();
+	settings->endGroup();
+
+	if (deviceControls & (HW_AGC | SW_AGC | COMBO_AGC))
+	    inputDevice->setAgcControl((agc == AGC_ON || agc == AGC_COMBINED));
+	if (deviceControls & IF_GAIN) {
+	    ifGain = std::max(minIfGain, std::min(ifGain, maxIfGain));
+	    inputDevice->setIfGain(ifGain);
+	}
+	if (deviceControls & LNA_GAIN) {
+	    lnaGain = std::max(minLnaGain, std::min(lnaGain, maxLnaGain));
+	    inputDevice->setLnaGain(lnaGain);
+	}
+    }
+
+    // setup software agc
+    resetSwAgc();
+}
+
+void RadioInterface::makeDABprocessor() {
+    if (inputDevice == nullptr)
+	return;
+    DABglobals.iqBuffer = &iqBuffer;
+    DABglobals.responseBuffer = &responseBuffer;
+    DABglobals.tiiBuffer = &tiiBuffer;
+    DABglobals.frameBuffer = &frameBuffer;
+    DABglobals.dabMode = 1;
+    DABprocessor = new dabProcessor(this, inputDevice, &DABglobals);
+}
+
+// same decimation as the GUI
+static
+int32_t mapRates(int32_t inputRate) {
+    return inputRate %256000 == 0? 256000:
+	   inputRate % 192000 == 0? 192000:
+	   inputRate < 400000? inputRate:
+	   inputRate < 850000? inputRate/4:
+	   inputRate < 1300000? inputRate/6:
+	   inputRate < 1900000? inputRate/8:
+	   inputRate < 3000000? inputRate/10:
+	   inputRate < 4000000? inputRate/15:
+	   inputRate < 5000000? inputRate/20:
+	   inputRate < 6000000? inputRate/25:
+	   inputRate/30;
+}
+
+void RadioInterface::makeFMprocessor() {
+    if (inputDevice == nullptr)
+	return;
+    if (FMfilter < 0)
+	FMfilter = 0;
+    FMprocessor = new fmProcessor(inputDevice, this, INPUT_RATE, mapRates(INPUT_RATE),
+				  workingRate, audioRate, FMthreshold);
+    FMprocessor->setSink(soundOut);
+    FMprocessor->setFMRDSSelector(rdsDecoder::RdsMode(rdsDecoder), rdsPartialText);
+    FMprocessor->setFMRDSDemod(fmProcessor::rdsDemodMode(rdsDemodulator));
+    FMprocessor->setFMMode(true);
+    FMprocessor->setBandwidth(KHz(FMfilter));
+    FMprocessor->setFMDecoder(fmDemodulator::fm_demod(FMdecoder));
+    FMprocessor->setDeemphasis(deemphasis);
+    FMprocessor->setAudioBandwidth(lowPassFilter);
+    FMprocessor->setAudioGain(FMaudioGain);
+}
+
+//	tuning
+
+// restart whatever was playing when we last exited
+void RadioInterface::resume() {
+    if (isFM)
+	tuneFM(FMfreq);
+    else
+	tuneDAB(channel, currentService.serviceName);
+}
+
+bool RadioInterface::tuneDAB(const QString &c, const QString &service) {
+    if (!channels.contains(c) || DABprocessor == nullptr)
+	return false;
+    stop();
+    isFM = false;
+    channel = c;
+    currentService.valid = false;
+    currentService.serviceName = "";
+    nextService.serviceName = service;
+    nextService.valid = true;
+    nextService.autoPlay = true;
+    nextService.fromEnd = false;
+    startDAB();
+    return true;
+}
+
+bool RadioInterface::tuneFM(double freq) {
+    if (freq < MIN_FM || freq > MAX_FM || FMprocessor == nullptr)
+	return false;
+    stop();
+    isFM = true;
+    FMfreq = freq;
+    startFM();
+    return true;
+}
+
+void RadioInterface::stop() {
+    if (isFM)
+	stopFM();
+    else
+	stopDAB();
+}
+
+void RadioInterface::startDAB() {
+    if (inputDevice == nullptr || DABprocessor == nullptr)
+	return;
+    log(LOG_UI, LOG_MIN, "starting dab channel %s", qPrintable(channel));
+    ficSuccess = 0;
+    ficBlocks = 0;
+    lookupCachedService(channel);
+    inputDevice->restartReader(DABband.frequency(channel.toStdString()));
+    DABprocessor->start();
+}
+
+void RadioInterface::stopDAB() {
+    if (inputDevice == nullptr || DABprocessor == nullptr)
+	return;
+    dropCachedService();
+    if (currentService.valid) {
+	audiodata ad;
+
+	DABprocessor->dataforAudioService(currentService.serviceName, &ad);
+	DABprocessor->stopService(&ad);
+	usleep(1000);
+	soundOut->stop();
+    }
+    stopDataServices();
+    playing = false;
+    currentService.valid = false;
+    DABprocessor->stop();
+    inputDevice->stopReader();
+    usleep(1000);
+    nextService.valid = false;
+    nextService.autoPlay = false;
+    serviceList.clear();
+    ensembleName = "";
+    label = "";
+    text = "";
+}
+
+bool RadioInterface::startDABService(dabService *s) {
+    QString serviceName = s->serviceName;
+    audiodata ad;
+
+    if (playing && !isFM && currentService.valid)
+	stopDABService();
+    ficBlocks = 0;
+    ficSuccess = 0;
+    currentService = *s;
+    currentService.valid = false;
+    for (const auto &serv: serviceList) {
+	if (serv.name != serviceName)
+	    continue;
+	if (!DABprocessor->is_audioService(serviceName))
+	    break;
+	DABprocessor->dataforAudioService(serviceName, &ad);
+	if (!ad.defined)
+	    break;
+	currentService.valid = true;
+	currentService.SId = serv.SId;
+	ad.procMode = __ONLY_SOUND;
+	if (!keepCachedService(&ad)) {
+	    DABprocessor->set_audioChannel(&ad, &audioBuffer);
+	    soundOut->restart();
+	}
+	playing = true;
+	label = serviceName;
+	text = "";
+	notify("service", serviceName.trimmed());
+	return true;
+    }
+    log(LOG_UI, LOG_MIN, "cannot run service %s", qPrintable(serviceName));
+    notify("error", "cannot run service " + serviceName.trimmed());
+    return false;
+}
+
+void RadioInterface::stopDABService() {
+    dropCachedService();
+    if (currentService.valid) {
+	audiodata ad;
+
+	DABprocessor->dataforAudioService(currentService.serviceName, &ad);
+	DABprocessor->stopService(&ad);
+	usleep(1000);
+	soundOut->stop();
+    }
+    playing = false;
+    currentService.valid = false;
+    label = "";
+    text = "";
+}
+
+//	Ensemble cache
+//	If we are tuning for a known service, we have it playing as soon as
+//	we are in sync, and let the fic confirm it later
+void RadioInterface::lookupCachedService(const QString &channel) {
+    cachedService.defined = false;
+    cachedRunning = false;
+    if (!nextService.valid || nextService.serviceName == "")
+	return;
+    ensembles->lookup(channel, nextService.serviceName, &cachedEId, &cachedService);
+}
+
+//	the fic has caught up: keep the running backend if the layout
+//	is still the one we had cached
+bool RadioInterface::keepCachedService(audiodata *ad) {
+    bool keep;
+
+    if (!cachedService.defined)
+	return false;
+    keep = cachedRunning && EnsembleCache::sameLayout(&cachedService, ad);
+    if (cachedRunning && !keep) {
+	log(LOG_EVENT, LOG_MIN, "cached service %s is stale", qPrintable(cachedService.serviceName));
+	DABprocessor->stopService(&cachedService);
+    }
+    cachedService.defined = false;
+    cachedRunning = false;
+    return keep;
+}
+
+void RadioInterface::dropCachedService() {
+    if (cachedRunning) {
+	log(LOG_EVENT, LOG_MIN, "dropping cached service %s", qPrintable(cachedService.serviceName));
+	DABprocessor->stopService(&cachedService);
+	usleep(1000);
+	soundOut->stop();
+	playing = false;
+	label = "";
+    }
+    cachedService.defined = false;
+    cachedRunning = false;
+}
+
+void RadioInterface::storeEnsemble(const QString &channel) {
+    std::vector<audiodata> services;
+
+    for (const auto &serv: DABprocessor->getServices(serviceOrder)) {
+	audiodata ad;
+
+	DABprocessor->dataforAudioService(serv.name, &ad);
+	if (ad.defined)
+	    services.push_back(ad);
+    }
+    ensembles->store(channel, DABprocessor->get_ensembleId(), services);
+}
+
+void RadioInterface::startDataService(QString serviceName, uint SId) {
+#ifdef USE_SPI
+    packetdata pd;
+
+    if (inputDevice == nullptr || DABprocessor == nullptr)
+	return;
+    for (const auto &serv: dataServices)
+	if (serv.SId == SId && serv.serviceName == serviceName)
+	    return;
+    DABprocessor->dataforPacketService(serviceName, &pd, 0);
+    if (!pd.defined) {
+	log(LOG_SPI, LOG_MIN, "cound not find background service %s %d", qPrintable(serviceName), SId);
+	return;
+    }
+    log(LOG_SPI, LOG_MIN, "starting background service %s %d", qPrintable(serviceName), SId);
+    if (!DABprocessor->set_dataChannel(&pd, &dataBuffer))
+	return;
+
+    dabService s;
+    s.serviceName = serviceName;
+    s.SId = SId;
+    s.valid = true;
+    dataServices.push_back(s);
+#else
+    (void) serviceName;
+    (void) SId;
+#endif
+}
+
+//	services sharing a subchannel go together
+void RadioInterface::stopDataServices() {
+#ifdef USE_SPI
+    packetdata pd;
+
+    if (inputDevice == nullptr || DABprocessor == nullptr)
+	return;
+    for (const auto &serv: dataServices) {
+	log(LOG_SPI, LOG_MIN, "stopping background service %s", qPrintable(serv.serviceName));
+	DABprocessor->dataforPacketService(serv.serviceName, &pd, 0);
+	if (pd.defined)
+	    DABprocessor->stopService(&pd);
+    }
+    dataServices.clear();
+#endif
+}
+
+void RadioInterface::startFM() {
+    if (inputDevice == nullptr || FMprocessor == nullptr)
+	return;
+    log(LOG_UI, LOG_MIN, "starting fm %3.3f", FMfreq);
+    ficBlocks = 0;
+    ficSuccess = 0;
+    FMprocessor->resetRDS(qRound(MHz(FMfreq)));
+    inputDevice->restartReader(qRound(MHz(FMfreq)));
+    soundOut->restart();
+    FMprocessor->start();
+    playing = true;
+    label = "";
+    text = "";
+}
+
+void RadioInterface::stopFM() {
+    if (inputDevice == nullptr || FMprocessor == nullptr)
+	return;
+    FMprocessor->stop();
+    soundOut->stop();
+    inputDevice->stopReader();
+    playing = false;
+    label = "";
+    text = "";
+}
+
+//	slots exercised by the processors
+
+void RadioInterface::addToEnsemble(const QString &serviceName, uint SId) {
+    serviceId ed;
+    std::vector<serviceId>::iterator i;
+
+    // just in case as we switched to FM before we picked this signal from the queue
+    if (isFM)
+       return;
+
+    log(LOG_EVENT, LOG_MIN, "received service %s %i", qPrintable(serviceName), SId);
+    if (!DABprocessor->is_audioService(serviceName)) {
+	startDataService(serviceName, SId);
+	return;
+    }
+    for (const auto &serv: serviceList)
+	if (serv.name == serviceName)
+	    return;
+    ed.name = serviceName;
+    ed.SId = SId;
+    for (i = serviceList.begin(); i < serviceList.end(); ++i)
+	if (serviceOrder == ID_BASED? SId <= i->SId: serviceName <= i->name)
+	    break;
+    serviceList.insert(i, ed);
+    if (nextService.valid && nextService.serviceName == serviceName) {
+	startDABService(&nextService);
+	nextService.valid = false;
+    }
+}
+
+void RadioInterface::nameOfEnsemble(int id, const QString &v) {
+    log(LOG_EVENT, LOG_CHATTY, "station name %s %i", qPrintable(v), id);
+    ensembleName = v.trimmed();
+    notify("ensemble", ensembleName + " " + QString::number(id, 16));
+
+    // not the ensemble we have cached for this channel
+    if (cachedService.defined && id != cachedEId)
+	dropCachedService();
+}
+
+void RadioInterface::ensembleLoaded(int count) {
+    if (isFM)
+	return;
+    log(LOG_EVENT, LOG_MIN, "ensemble complete with %i services", count);
+    if (count > 0)
+	storeEnsemble(channel);
+
+    // the cached service did not turn up
+    if (cachedService.defined)
+	dropCachedService();
+
+    // no service asked for, or it's not there: play the first one
+    if (nextService.valid && count > 0 && serviceList.size() > 0) {
+	dabService s = nextService;
+
+	s.serviceName = serviceList.at(0).name;
+	startDABService(&s);
+    }
+    nextService.serviceName = "";
+    nextService.valid = false;
+    nextService.autoPlay = false;
+}
+
+void RadioInterface::timeSynced() {
+    audiodata ad;
+
+    if (isFM || !cachedService.defined || cachedRunning)
+	return;
+    log(LOG_EVENT, LOG_MIN, "starting cached service %s", qPrintable(cachedService.serviceName));
+    ad = cachedService;
+    ad.procMode = __ONLY_SOUND;
+    if (!DABprocessor->set_audioChannel(&ad, &audioBuffer)) {
+	cachedService.defined = false;
+	return;
+    }
+    cachedRunning = true;
+    soundOut->restart();
+    playing = true;
+    label = cachedService.serviceName;
+    text = "";
+    notify("service", cachedService.serviceName.trimmed());
+}
+
+// If a change is detected, we rebuild the services list from the fib
+// and restart the service that was running, if it's still there
+void RadioInterface::changeInConfiguration() {
+    dabService s;
+
+    s.valid = false;
+    if (currentService.valid) {
+	s = currentService;
+	stopDABService();
+    }
+    serviceList = DABprocessor->getServices(serviceOrder);
+    if (!s.valid)
+	return;
+
+    // secondary service may be gone
+    if (s.SCIds != 0 && DABprocessor->findService(s.SId, s.SCIds) != s.serviceName) {
+	s.SCIds = 0;
+	s.serviceName = DABprocessor->findService(s.SId, s.SCIds);
+    }
+    startDABService(&s);
+}
+
+void RadioInterface::newAudio(int amount, int rate) {
+    _VLA(int16_t, vec, amount);
+
+    while (audioBuffer.GetRingBufferReadAvailable() > amount) {
+	audioBuffer.getDataFromBuffer(vec, amount);
+	soundOut->audioOut(vec, amount, rate);
+    }
+}
+
+void RadioInterface::showStrength(float s) {
+    log(LOG_EVENT, LOG_VERBOSE, "signal strength %f", s);
+    strength = s;
+}
+
+void RadioInterface::showQuality(bool b) {
+    log(LOG_EVENT, LOG_VERBOSE, "quality %i", b);
+    if (b)
+	ficSuccess += FIC_SUCCESS_INCREMENT;
+    if (++ficBlocks >= FIC_BLOCKS_MAX) {
+	quality = ficSuccess;
+	ficBlocks = 0;
+	ficSuccess = 0;
+    }
+}
+
+void RadioInterface::showLabel(const QString s) {
+    log(LOG_EVENT, LOG_CHATTY, "radio label %s", qPrintable(s));
+    label = s.trimmed();
+    notify("label", label);
+}
+
+void RadioInterface::showText(QString s) {
+    log(LOG_EVENT, LOG_CHATTY, "radio text %s", qPrintable(s));
+    text = s.trimmed();
+    notify("text", text);
+}
+
+void RadioInterface::setProgramType(int code) {
+    log(LOG_EVENT, LOG_CHATTY, "program type %i", code);
+}
+
+void RadioInterface::showPiCode(int code, int frequency) {
+    (void) frequency;
+    log(LOG_EVENT, LOG_CHATTY, "program identification %x", code);
+}
+
+void RadioInterface::showSoundMode(bool s) {
+    log(LOG_EVENT, LOG_VERBOSE, "stereo mode %i", s);
+    stereo = s;
+}
+
+// there's no one to show slides to, just let clients know one arrived
+void RadioInterface::handleMotObject(QByteArray result, QString name,
+				     int contentType, bool dirElement) {
+    log(LOG_EVENT, LOG_MIN, "MOT name %s cont 0x%x dir %i", qPrintable(name),
+	getContentBaseType((MOTContentType)contentType), dirElement);
+    if (getContentBaseType((MOTContentType)contentType) == MOTBaseTypeImage)
+	notify("slide", QString("%1 %2").arg(result.size()).arg(name));
+}
+
+// scans are only started from the GUI
+void RadioInterface::scanDone() {
+}
+
+void RadioInterface::scanFound() {
+}
+
+//	control socket
+//
+//	one command per line, each answered by zero or more data lines
+//	and a final "ok" or "error <reason>"; "event <kind> <data>" lines
+//	are sent to every client as things happen
+
+bool RadioInterface::listen(const QString &name) {
+    server = new QLocalServer(this);
+    QLocalServer::removeServer(name);
+    if (!server->listen(name)) {
+	log(LOG_UI, LOG_MIN, "cannot listen on %s: %s", qPrintable(name),
+	    qPrintable(server->errorString()));
+	return false;
+    }
+    log(LOG_UI, LOG_MIN, "control socket %s", qPrintable(server->fullServerName()));
+    connect(server, SIGNAL(newConnection()), this, SLOT(newConnection()));
+    return true;
+}
+
+void RadioInterface::newConnection() {
+    QLocalSocket *c;
+
+    while ((c = server->nextPendingConnection()) != nullptr) {
+	clients.append(c);
+	connect(c, SIGNAL(readyRead()), this, SLOT(readCommands()));
+	connect(c, SIGNAL(disconnected()), this, SLOT(dropConnection()));
+    }
+}
+
+void RadioInterface::dropConnection() {
+    QLocalSocket *c = qobject_cast<QLocalSocket *>(sender());
+
+    if (c == nullptr)
+	return;
+    clients.removeAll(c);
+    c->deleteLater();
+}
+
+void RadioInterface::readCommands() {
+    QLocalSocket *c = qobject_cast<QLocalSocket *>(sender());
+
+    if (c == nullptr)
+	return;
+    while (c->canReadLine())
+	command(c, QString::fromUtf8(c->readLine()).trimmed());
+}
+
+void RadioInterface::reply(QLocalSocket *c, const QString &line) {
+    QString l = line;
+
+    // keep the protocol line based
+    l.replace('\n', ' ');
+    l.replace('\r', ' ');
+    c->write(l.toUtf8() + '\n');
+}
+
+void RadioInterface::notify(const QString &kind, const QString &data) {
+    for (const auto &c: clients)
+	reply(c, "event " + kind + " " + data);
+}
+
+void RadioInterface::command(QLocalSocket *c, const QString &line) {
+    QString verb = line.section(' ', 0, 0).toLower();
+    QString args = line.section(' ', 1).trimmed();
+    bool ok;
+
+    if (verb == "")
+	return;
+    log(LOG_UI, LOG_CHATTY, "command %s", qPrintable(line));
+    if (verb == "status") {
+	reply(c, QString("mode ") + (isFM? GEN_FM: GEN_DAB));
+	reply(c, QString("playing %1").arg(playing));
+	if (isFM)
+	    reply(c, QString().asprintf("frequency %3.3f", FMfreq));
+	else {
+	    reply(c, "channel " + channel);
+	    reply(c, "ensemble " + ensembleName);
+	    reply(c, "service " + (currentService.valid? currentService.serviceName.trimmed(): QString()));
+	    reply(c, QString("quality %1").arg(quality));
+	}
+	reply(c, QString("strength %1").arg(strength));
+	reply(c, QString("stereo %1").arg(stereo));
+	reply(c, QString("volume %1").arg(volume));
+	reply(c, "label " + label);
+	reply(c, "text " + text);
+	reply(c, "device " + deviceType);
+    } else if (verb == "channels") {
+	for (const auto &ch: channels)
+	    reply(c, ch);
+    } else if (verb == "services") {
+	for (const auto &serv: serviceList)
+	    reply(c, serv.name.trimmed());
+    } else if (verb == "dab") {
+	if (!tuneDAB(args.section(' ', 0, 0).toUpper(), args.section(' ', 1).trimmed())) {
+	    reply(c, "error bad channel");
+	    return;
+	}
+    } else if (verb == "service") {
+	dabService s;
+	bool found = false;
+
+	if (isFM) {
+	    reply(c, "error not tuned to dab");
+	    return;
+	}
+
+	// match the padded ensemble names loosely
+	for (const auto &serv: serviceList)
+	    if (serv.name.trimmed().compare(args, Qt::CaseInsensitive) == 0) {
+		s.serviceName = serv.name;
+		found = true;
+		break;
+	    }
+	if (found) {
+	    DABprocessor->getParameters(s.serviceName, &s.SId, &s.SCIds);
+	    found = s.SId != 0 && startDABService(&s);
+	}
+	if (!found) {
+	    reply(c, "error cannot run this service");
+	    return;
+	}
+    } else if (verb == "fm") {
+	if (!tuneFM(args.toDouble(&ok)) || !ok) {
+	    reply(c, "error bad frequency");
+	    return;
+	}
+    } else if (verb == "stop") {
+	stop();
+    } else if (verb == "volume") {
+	int v = args.toInt(&ok);
+
+	if (!ok || v < 0 || v > AUDIO_SCALE) {
+	    reply(c, "error bad volume");
+	    return;
+	}
+	volume = v;
+	soundOut->setVolume(qreal(volume)/AUDIO_SCALE);
+    } else if (verb == "quit") {
+	reply(c, "ok");
+	QCoreApplication::quit();
+	return;
+    } else {
+	reply(c, "error unknown command " + verb);
+	return;
+    }
+    reply(c, "ok");
+}
@@ -34,6 +34,8 @@
 #include "audiosink.h"
 #include "settings.h"
 #include "radio.h"
+#include "agc-controller.h"
+#include "dab-scanner.h"
 #include "fm-demodulator.h"
 #include "ui_about.h"
 #include "listwidget.h"
@@ -442,7 +444,42 @@ void RadioInterface::startFullScan() {
 	FMprocessor->start();
 	FMprocessor->startFullScan();
 	scanTimer->start();
+    } else if (scanType == "FM fast" && FMprocessor != NULL) {
+	handleFMButton();
+	stopFM();
+	if (scanTimer == nullptr) {
+	    scanTimer = new QTimer();
+	    scanTimer->setInterval(scanInterval);
+	}
+	connect(FMprocessor, SIGNAL(fastScanFound(int)),
+	    this, SLOT(fastScanFound(int)));
+	connect(FMprocessor, SIGNAL(fastScanDone(void)),
+	    this, SLOT(nextFastScanFrequency(void)));
+	playing = false;
+	scanning = true;
+	fastScanning = true;
+	fastScanCandidates.clear();
+	fastScanIndex = -1;
+	cleanScreen();
+	setPlaying();
+	setRecording();
+	setScanning();
+#ifdef HAVE_MPRIS
+	mprisLabelAndText("FM", "Scanning");
+	player.setPlaybackStatus(Mpris::Stopped);
+#endif
+
+	// keep the tuner DC spike off the channel raster
+	fastScanFrequency = qRound(MHz(MIN_FM))+FM_FAST_SCAN_SPAN/2-KHz(FMstep)/2;
+	FMfreq = double(fastScanFrequency)/MHz(1);
+	frequencyKnob->setValue(double(FMfreq));
+	frequencyLCD->display(qRound(KHz(FMfreq)));
+	inputDevice->restartReader(fastScanFrequency);
+	FMprocessor->start();
+	FMprocessor->startFastScan(fastScanFrequency, KHz(FMstep));
     } else if (scanType == "DAB") {
+	std::vector<deviceHandler *> tuners;
+
 	handleDABButton();
 	handleStationsAction();
 	stopDAB();
@@ -465,10 +502,23 @@ void RadioInterface::startFullScan() {
 	mprisLabelAndText("DAB", "Scanning");
 	player.setPlaybackStatus(Mpris::Stopped);
 #endif
-	scanIndex = 0;
-	channelSelector->setCurrentIndex(scanIndex);
-	startDAB();
-	scanTimer->start();
+
+	// all tuners look for null symbols first, only channels that
+	// have them get to load the ensemble
+	probeScanDevices(deviceList, inputDevice, tuners, scanDevices);
+	scanner = new dabScanner(tuners, DABglobals.dabMode);
+	for (int i = 0; i < channelSelector->count(); i++) {
+	    QString channel = channelSelector->itemText(i);
+
+	    scanner->addChannel(i, channel, DABband.frequency(channel.toStdString()));
+	}
+	connect(scanner, SIGNAL(channelDone(const QString &, bool)),
+	    this, SLOT(scanChannelChecked(const QString &, bool)));
+	connect(scanner, SIGNAL(checkDone()),
+	    this, SLOT(scanCheckDone()));
+	scanChannels.clear();
+	scanPosition = -1;
+	scanner->start();
     }
 }
 
@@ -478,9 +528,21 @@ void RadioInterface::stopFullScan() {
     scanning = false;
     if (isFM) {
 	log(LOG_UI, LOG_MIN, "stop full FM scan");
-	disconnect(scanTimer, SIGNAL(timeout()),
-	    this, SLOT(nextFullScanFrequency()));
-	FMprocessor->stopFullScan();
+	if (fastScanning) {
+	    disconnect(FMprocessor, SIGNAL(fastScanFound(int)),
+		this, SLOT(fastScanFound(int)));
+	    disconnect(FMprocessor, SIGNAL(fastScanDone(void)),
+		this, SLOT(nextFastScanFrequency(void)));
+	    disconnect(scanTimer, SIGNAL(timeout()),
+		this, SLOT(nextFastScanCandidate()));
+	    FMprocessor->stopFastScan();
+	    FMprocessor->setMuted(false);
+	    fastScanning = false;
+	} else {
+	    disconnect(scanTimer, SIGNAL(timeout()),
+		this, SLOT(nextFullScanFrequency()));
+	    FMprocessor->stopFullScan();
+	}
 	stopFM();
     } else {
 	if (saveDabDisplay == DD_SLIDES)
@@ -491,6 +553,13 @@ void RadioInterface::stopFullScan() {
 	    this, SLOT(nextFullDABScan()));
 	disconnect(this, SIGNAL(advanceScan(int)),
 	    this, SLOT(ensembleLoaded(int)));
+	if (scanner != nullptr) {
+	    scanner->stop();
+	    releaseScanDevices();
+	    scanner->writeResults(QString("%1/%2").arg(QDir::home().absoluteFilePath(LOCAL_STORAGE)).arg(SCAN_RESULTS));
+	    delete scanner;
+	    scanner = nullptr;
+	}
     }
     isFM = saveIsFM;
     FMfreq = saveFMfreq;
@@ -530,17 +599,81 @@ void RadioInterface::nextFullScanFrequency(void) {
     }
 }
 
-void RadioInterface::scanFound(void) {
-    QString station = "FM:" + QString::number(FMfreq);
-
-    if (settingsUi.scanList->findItems(station, Qt::MatchStartsWith).size() > 0) {
+static
+void addScanStation(QListWidget *scanList, QString station) {
+    if (scanList->findItems(station, Qt::MatchStartsWith).size() > 0) {
 	log(LOG_EVENT, LOG_MIN, "station %s already present", qPrintable(station));
     } else {
 	log(LOG_EVENT, LOG_MIN, "station found %s", qPrintable(station));
-	settingsUi.scanList->addItem(station);
+	scanList->addItem(station);
     }
 }
 
+void RadioInterface::scanFound(void) {
+    addScanStation(settingsUi.scanList, "FM:" + QString::number(FMfreq));
+}
+
+// fast scan: one wideband survey per FM_FAST_SCAN_SPAN of the band,
+// 13 of them over 87-108.9 MHz, the first tune and then 12 retunes
+void RadioInterface::fastScanFound(int frequency) {
+    if (fastScanRds && rdsDecoder != rdsDecoder::NO_RDS)
+	fastScanCandidates.push_back(frequency);
+    else
+	addScanStation(settingsUi.scanList, "FM:" + QString::number(double(frequency)/MHz(1)));
+}
+
+void RadioInterface::nextFastScanFrequency(void) {
+    log(LOG_EVENT, LOG_MIN, "fm fast scan survey done at %i", fastScanFrequency);
+    FMprocessor->stopFastScan();
+    FMprocessor->stop();
+    inputDevice->stopReader();
+    fastScanFrequency += FM_FAST_SCAN_SPAN;
+
+    // band done, move on to the RDS confirmation, if any
+    if (fastScanFrequency-FM_FAST_SCAN_SPAN/2 > MHz(MAX_FM)) {
+	if (fastScanCandidates.size() == 0) {
+	    stopFullScan();
+	    return;
+	}
+	disconnect(FMprocessor, SIGNAL(fastScanDone(void)),
+	    this, SLOT(nextFastScanFrequency(void)));
+	connect(scanTimer, SIGNAL(timeout()),
+	    this, SLOT(nextFastScanCandidate()));
+	FMprocessor->setMuted(true);
+	fastScanIndex = -1;
+	nextFastScanCandidate();
+	return;
+    }
+    FMfreq = double(fastScanFrequency)/MHz(1);
+    frequencyKnob->setValue(double(FMfreq));
+    frequencyLCD->display(qRound(KHz(FMfreq)));
+    log(LOG_EVENT, LOG_MIN, "fm fast scan next frequency %f", FMfreq);
+    inputDevice->restartReader(fastScanFrequency);
+    FMprocessor->start();
+    FMprocessor->startFastScan(fastScanFrequency, KHz(FMstep));
+}
+
+// each candidate has a scan interval to produce a PI code
+// confirmed stations are picked up by showPiCode()
+void RadioInterface::nextFastScanCandidate(void) {
+    if (scanTimer->isActive())
+	scanTimer->stop();
+    FMprocessor->stop();
+    inputDevice->stopReader();
+    if (++fastScanIndex >= (int) fastScanCandidates.size()) {
+	stopFullScan();
+	return;
+    }
+    FMfreq = double(fastScanCandidates[fastScanIndex])/MHz(1);
+    frequencyKnob->setValue(double(FMfreq));
+    frequencyLCD->display(qRound(KHz(FMfreq)));
+    log(LOG_EVENT, LOG_MIN, "fm fast scan confirming %f", FMfreq);
+    FMprocessor->resetRDS(fastScanCandidates[fastScanIndex]);
+    inputDevice->restartReader(fastScanCandidates[fastScanIndex]);
+    FMprocessor->start();
+    scanTimer->start();
+}
+
 void RadioInterface::nextFullDABScan(void) {
     log(LOG_EVENT, LOG_CHATTY, "dab full scan timer signal attempt %i", scanRetryCount+1);
 
@@ -548,16 +681,10 @@ void RadioInterface::nextFullDABScan(void) {
     if (serviceList.size() == 0) {
 	if (signalStrength->value() < MIN_SCAN_SIGNAL || ++scanRetryCount > scanRetry) {
 	    scanRetryCount = 0;
-	    if (scanIndex ==  channelSelector->count() - 1) {
-		stopFullScan();
+	    // whatever we had cached here is gone
+	    ensembles->drop(channelSelector->itemText(scanIndex));
+	    if (!nextScanChannel())
 		return;
-	    } else {
-		scanIndex++;
-		stopDAB();
-		channelSelector->setCurrentIndex(scanIndex);
-		log(LOG_EVENT, LOG_MIN, "dab full scan next frequency %s", qPrintable(channelSelector->currentText()));
-		startDAB();
-	    }
 	}
     } else if (++scanRetryCount > scanRetry) {
         log(LOG_EVENT, LOG_CHATTY, "dab full scan timeout for %s", qPrintable(channelSelector->currentText()));
@@ -579,16 +706,53 @@ void RadioInterface::scanEnsembleLoaded() {
 	    settingsUi.scanList->addItem(station);
 	}
     }
-    if (scanIndex ==  channelSelector->count() - 1) {
+    if (scanner != nullptr && serviceList.size() > 0)
+	scanner->setEnsemble(scanIndex, DABprocessor->get_ensembleId(),
+			     DABprocessor->get_ensembleName(), serviceList.size());
+    if (nextScanChannel())
+	scanTimer->start();
+}
+
+// the channels the pre-check let through, one at a time on the
+// tuner in use
+bool RadioInterface::nextScanChannel() {
+    if (++scanPosition >= (int) scanChannels.size()) {
 	stopFullScan();
-    } else {
-	scanIndex++;
+	return false;
+    }
+    if (scanPosition > 0)
 	stopDAB();
-	channelSelector->setCurrentIndex(scanIndex);
-	log(LOG_EVENT, LOG_MIN, "dab full scan next frequency %s", qPrintable(channelSelector->currentText()));
-	startDAB();
+    scanIndex = scanChannels[scanPosition];
+    channelSelector->setCurrentIndex(scanIndex);
+    log(LOG_EVENT, LOG_MIN, "dab full scan next frequency %s", qPrintable(channelSelector->currentText()));
+    startDAB();
+    return true;
+}
+
+void RadioInterface::scanChannelChecked(const QString &channel, bool occupied) {
+    log(LOG_EVENT, LOG_CHATTY, "dab scan pre-check %s %s", qPrintable(channel),
+	occupied? "has a signal": "empty");
+}
+
+void RadioInterface::scanCheckDone() {
+    if (scanner == nullptr || !scanning)
+	return;
+
+    // the other tuners are done with
+    scanner->stop();
+    releaseScanDevices();
+    scanChannels = scanner->candidates();
+    log(LOG_EVENT, LOG_MIN, "dab scan pre-check found %i channels", (int) scanChannels.size());
+    scanRetryCount = 0;
+    scanPosition = -1;
+    if (nextScanChannel())
 	scanTimer->start();
-    }
+}
+
+void RadioInterface::releaseScanDevices() {
+    for (auto d: scanDevices)
+	delete d;
+    scanDevices.clear();
 }
 
 void RadioInterface::clearScanList() {
@@ -888,6 +1052,7 @@ void RadioInterface::setDevice(int d) {
     delete DABprocessor;
     delete FMprocessor;
 
+    inputDevice->agcControl()->stop();
     inputDevice = deviceList[d].device;
     deviceType = deviceList[d].deviceType;
     deviceUiControls = deviceList[d].controls;
@@ -966,7 +1131,6 @@ void RadioInterface::setDevice(int d) {
 
     // reset software agc
     resetSwAgc();
-    resetAgcStats();
 
     makeDABprocessor();
     makeFMprocessor();
@@ -1014,7 +1178,6 @@ void RadioInterface::setDeviceName(int d) {
  
     // reset software agc
     resetSwAgc();
-    resetAgcStats();
 
     makeDABprocessor();
     makeFMprocessor();
@@ -1031,11 +1194,11 @@ void RadioInterface::setAgcControl(int newAgc) {
 	if (inputDevice != NULL)
 	    inputDevice->setAgcControl((newAgc == AGC_ON || newAgc == AGC_COMBINED));
 	agc = newAgc;
-	if (oldAgc == AGC_SOFTWARE || oldAgc == AGC_COMBINED)
+
+	// the controller is stopped before the manual gain goes back
+	resetSwAgc();
+	if ((oldAgc == AGC_SOFTWARE || oldAgc == AGC_COMBINED) && inputDevice != NULL)
 	    inputDevice->setIfGain(ifGain);
-	else
-	    swAgc = ifGain;
-	resetAgcStats();
     }
 }
 
@@ -1043,13 +1206,13 @@ void RadioInterface::setIfGain(int gain) {
     int oldGain = ifGain;
 
     log(LOG_UI, LOG_MIN, "IF %i", gain);
+    ifGain = gain;
+
+    // the software agc restarts from here
+    if (gain != oldGain)
+	resetSwAgc();
     if (inputDevice != NULL)
 	inputDevice->setIfGain(gain);
-    ifGain = gain;
-    if (gain != oldGain) {
-	swAgc = ifGain;
-	resetAgcStats();
-    }
 }
 
 void RadioInterface::setLnaGain(int gain) {
@@ -24,6 +24,8 @@
  *    Lazy Chair Programming
  */
 #include "fm-demodulator.h"
+#include "simd-helper.h"
+#include <algorithm>
 
 // Just to play around a little, I implemented 5 common
 // fm decoders. The main source of inspiration is found in
@@ -150,6 +152,107 @@ DSPFLOAT fmDemodulator::demodulate(DSPCOMPLEX z) {
     return res;
 }
 
+// the block decoder: same decoders as above, but each stage
+// runs over the whole block, and the decoder choice is made once
+void fmDemodulator::normalise(const DSPCOMPLEX* in, int32_t n) {
+    DSPFLOAT* power = yBuffer.data();
+    DSPFLOAT* scale = xBuffer.data();
+    DSPCOMPLEX* norm = normBuffer.data();
+    int32_t i;
+
+    for (i = 0; i < n; i++)
+        power[i] = real(in[i]) * real(in[i]) + imag(in[i]) * imag(in[i]);
+    for (i = 0; i + VFLOAT_SIZE <= n; i += VFLOAT_SIZE)
+        vStore(&scale[i], vDiv(vSet(1.0), vSqrt(vMax(vLoad(&power[i]), vSet(1e-12)))));
+    for (; i < n; i++)
+        scale[i] = 1.0 / sqrt(std::max(power[i], (DSPFLOAT)1e-12));
+
+    // do not make these 0 too often
+    for (i = 0; i < n; i++)
+        norm[i] = (power[i] <= 0.001 * 0.001) ? DSPCOMPLEX(0.001, 0.001) : in[i] * scale[i];
+}
+
+void fmDemodulator::demodulate(const DSPCOMPLEX* in, DSPFLOAT* out, int32_t n) {
+    DSPFLOAT* x;
+    DSPFLOAT* y;
+    DSPCOMPLEX* norm;
+    DSPFLOAT I, Q, I1, Q1, I2, Q2;
+    int32_t i;
+
+    if (n <= 0)
+        return;
+    if ((int32_t)normBuffer.size() < n) {
+        normBuffer.resize(n);
+        xBuffer.resize(n);
+        yBuffer.resize(n);
+    }
+    x = xBuffer.data();
+    y = yBuffer.data();
+    norm = normBuffer.data();
+    normalise(in, n);
+
+    switch (selectedDecoder) {
+    default:
+    case FM1DECODER:
+        I1 = Imin1;
+        Q1 = Qmin1;
+        I2 = Imin2;
+        Q2 = Qmin2;
+        for (i = 0; i < n; i++) {
+            I = real(norm[i]);
+            Q = imag(norm[i]);
+            out[i] = (I1 * (Q - Q2) - Q1 * (I - I2)) / (I1 * I1 + Q1 * Q1);
+            I2 = I1;
+            Q2 = Q1;
+            I1 = I;
+            Q1 = Q;
+        }
+        Imin2 = I2;
+        Qmin2 = Q2;
+        break;
+
+    // the conjugate product of successive samples, and its argument
+    case FM2DECODER:
+    case FM3DECODER:
+        x[0] = real(norm[0]) * Imin1 + imag(norm[0]) * Qmin1;
+        y[0] = imag(norm[0]) * Imin1 - real(norm[0]) * Qmin1;
+        for (i = 1; i < n; i++) {
+            x[i] = real(norm[i]) * real(norm[i - 1]) + imag(norm[i]) * imag(norm[i - 1]);
+            y[i] = imag(norm[i]) * real(norm[i - 1]) - real(norm[i]) * imag(norm[i - 1]);
+        }
+        fastTrigTabs->atan2(y, x, out, n);
+        break;
+
+    case FM4DECODER:
+        myfm_pll->doPll(norm, out, n);
+        break;
+
+    case FM5DECODER:
+        I1 = Imin1;
+        Q1 = Qmin1;
+        for (i = 0; i < n; i++) {
+            I = real(norm[i]);
+            Q = imag(norm[i]);
+            out[i] = Arcsine[(int)((I1 * Q - Q1 * I + 1.0) / 2.0 * ArcsineSize)];
+            I1 = I;
+            Q1 = Q;
+        }
+        break;
+    }
+
+    // and remove the DC component, in locals, as out might alias us
+    DSPFLOAT scale = fm_cvt / K_FM;
+    DSPFLOAT afc = fm_afc;
+    for (i = 0; i < n; i++) {
+        afc = (1 - DCAlpha) * afc + DCAlpha * out[i];
+        out[i] = (out[i] - afc) * scale;
+    }
+    fm_afc = afc;
+
+    Imin1 = real(norm[n - 1]);
+    Qmin1 = imag(norm[n - 1]);
+}
+
 DSPFLOAT fmDemodulator::get_DcComponent(void) {
     return fm_afc;
 }
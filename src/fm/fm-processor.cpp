@@ -23,6 +23,8 @@
  *    Jan van Katwijk (J.vanKatwijk@gmail.com)
  *    Lazy Chair Programming
  */
+#include <algorithm>
+#include <vector>
 #include "fm-processor.h"
 #include "radio.h"
 #include "fm-demodulator.h"
@@ -33,6 +35,7 @@
 #include "squelchClass.h"
 #include "trigtabs.h"
 #include "device-handler.h"
+#include "agc-controller.h"
 #include "newconverter.h"
 #include "logging.h"
 
@@ -80,6 +83,15 @@
 #define PHASE_BUFFER_SIZE	128 // (PILOT_FILTER_SIZE + FM_FILTER_SIZE)
 #define PILOT_BUFFER_SIZE	128 // (RDS_BAND_FILTER_SIZE + HILBERT_SIZE)
 
+// the fast scan survey runs on the undecimated input:
+// 2048 bins at 2.048 MHz give 1 kHz resolution, and 64 half overlapping
+// segments take about 33 ms worth of samples
+#define SURVEY_FFT_SIZE		2048
+#define SURVEY_SEGMENTS		64
+#define SURVEY_SETTLE		(inputRate/100)
+#define SURVEY_CARRIER_WIDTH	80000
+#define SURVEY_DC_WIDTH		4000
+
 #define DEF_SIGNAL_GAIN		100
 #define DEF_AUDIO_GAIN		40
 #define DEF_AUDIO_BANDWIDTH	-1
@@ -90,8 +102,12 @@ fmProcessor::fmProcessor(deviceHandler *device, RadioInterface *radioInterface,
     running = false;
     initScan = false;
     scanning = false;
+    initFastScan = false;
+    fastScanning = false;
+    muted = false;
     this->device = device;
     this->radioInterface = radioInterface;
+    this->inputRate = inputRate;
     this->fmRate = fmRate;
     this->decimatingScale = inputRate/fmRate;
     this->workingRate = workingRate;
@@ -102,6 +118,19 @@ fmProcessor::fmProcessor(deviceHandler *device, RadioInterface *radioInterface,
 
     fastTrigTabs = new trigTabs(fmRate);
     signalFft = new common_fft(SIGNAL_SIZE);
+
+    // Hann window for the Welch averaged survey
+    surveyFft = new common_fft(SURVEY_FFT_SIZE);
+    surveyWindow = new DSPFLOAT[SURVEY_FFT_SIZE];
+    surveyPower = new DSPFLOAT[SURVEY_FFT_SIZE];
+    surveyBuffer = new DSPCOMPLEX[SURVEY_FFT_SIZE];
+    for (int i = 0; i < SURVEY_FFT_SIZE; i++)
+	surveyWindow[i] = 0.5-0.5*cos(2*M_PI*i/SURVEY_FFT_SIZE);
+    surveyPointer = 0;
+    surveySegments = 0;
+    surveySkip = 0;
+    surveyFrequency = 0;
+    surveyStep = KHz(100);
     fmBandFilter = new DecimatingFIR(15*decimatingScale, fmRate/2, inputRate, decimatingScale);
     fmBandwidth = 0.95*fmRate;
     fmFilter = NULL;
@@ -165,6 +194,10 @@ fmProcessor::~fmProcessor(void) {
 	    radioInterface, SLOT(showSoundMode(bool)));
     delete fmBandFilter;
     delete signalFft;
+    delete surveyFft;
+    delete[] surveyWindow;
+    delete[] surveyPower;
+    delete[] surveyBuffer;
     delete demodulator;
     delete rdsPllDecoder;
     delete pilotPllFilter;
@@ -268,6 +301,23 @@ void fmProcessor::stopFullScan(void) {
 	    radioInterface, SLOT(scanFound(void)));
 }
 
+// frequency is the tuned frequency, step the channel raster, both in Hz
+void fmProcessor::startFastScan(int32_t frequency, int32_t step) {
+    surveyFrequency = frequency;
+    surveyStep = step;
+    initFastScan = true;
+}
+
+void fmProcessor::stopFastScan(void) {
+    initFastScan = false;
+    fastScanning = false;
+}
+
+// used to decode RDS without producing any audio
+void fmProcessor::setMuted(bool m) {
+    muted = m;
+}
+
 void fmProcessor::setFMRDSSelector(rdsDecoder::RdsMode m, bool p) {
     log(LOG_FM, LOG_MIN, "RDS mode %i %i", m, p);
     rdsMode = m;
@@ -280,12 +330,13 @@ void fmProcessor::setFMRDSDemod(rdsDemodMode m) {
     initRDS = true;
 }
 
-void fmProcessor::resetRDS(void) {
+// the frequency tags what gets decoded from here on
+void fmProcessor::resetRDS(int32_t frequency) {
     initRDS = true;
     if (rdsDataDecoder == NULL)
 	return;
     rdsPllDecoder->reset();
-    rdsDataDecoder->reset();
+    rdsDataDecoder->reset(frequency);
 }
 
 static
@@ -298,9 +349,94 @@ DSPFLOAT getLevel(DSPCOMPLEX *v, int min, int max) {
     return sum/(max-min);
 }
 
+// accumulate a Welch averaged power spectrum of the whole capture
+// returns true once, when enough segments have been collected
+bool fmProcessor::doSurvey(DSPCOMPLEX *v, int32_t amount) {
+    DSPCOMPLEX *fftBuffer = surveyFft->getVector();
+
+    for (int i = 0; i < amount; i++) {
+	if (surveySkip > 0) {
+	    surveySkip--;
+	    continue;
+	}
+	if (surveySegments >= SURVEY_SEGMENTS)
+	    return false;
+	surveyBuffer[surveyPointer++] = v[i];
+	if (surveyPointer < SURVEY_FFT_SIZE)
+	    continue;
+	for (int k = 0; k < SURVEY_FFT_SIZE; k++)
+	    fftBuffer[k] = surveyBuffer[k]*surveyWindow[k];
+	surveyFft->do_FFT();
+	for (int k = 0; k < SURVEY_FFT_SIZE; k++)
+	    surveyPower[k] += norm(fftBuffer[k]);
+
+	// segments overlap by half
+	memmove(surveyBuffer, &surveyBuffer[SURVEY_FFT_SIZE/2],
+		SURVEY_FFT_SIZE/2*sizeof(DSPCOMPLEX));
+	surveyPointer = SURVEY_FFT_SIZE/2;
+	if (++surveySegments >= SURVEY_SEGMENTS)
+	    return true;
+    }
+    return false;
+}
+
+// look for carriers on the channel raster within the usable span
+// a carrier is reported when its band power exceeds the noise floor by
+// the scan threshold and it is a local maximum, so that the skirts
+// of strong stations are not reported as neighbouring channels
+void fmProcessor::findCarriers(void) {
+    DSPFLOAT binWidth = DSPFLOAT(inputRate)/SURVEY_FFT_SIZE;
+    int32_t spanBins = int32_t(FM_FAST_SCAN_SPAN/2/binWidth);
+    int32_t carrierBins = int32_t(SURVEY_CARRIER_WIDTH/2/binWidth);
+    int32_t dcBins = int32_t(SURVEY_DC_WIDTH/2/binWidth);
+    int32_t lowest = surveyFrequency-FM_FAST_SCAN_SPAN/2;
+    int32_t first = ((lowest+surveyStep-1)/surveyStep)*surveyStep;
+    std::vector<DSPFLOAT> floor;
+    std::vector<DSPFLOAT> levels;
+    std::vector<int32_t> frequencies;
+
+    // the noise floor is the lower quartile of the usable span
+    // the FFT is not shifted, negative frequencies are at the top
+    for (int32_t k = -spanBins; k <= spanBins; k++)
+	if (abs(k) > dcBins)
+	    floor.push_back(surveyPower[(k+SURVEY_FFT_SIZE)%SURVEY_FFT_SIZE]);
+    std::nth_element(floor.begin(), floor.begin()+floor.size()/4, floor.end());
+    DSPFLOAT noise = floor[floor.size()/4];
+    if (noise <= 0)
+	return;
+
+    for (int32_t f = first; f <= surveyFrequency+FM_FAST_SCAN_SPAN/2; f += surveyStep) {
+	int32_t center = int32_t(round((f-surveyFrequency)/binWidth));
+	DSPFLOAT sum = 0;
+	int count = 0;
+
+	for (int32_t k = center-carrierBins; k <= center+carrierBins; k++) {
+	    if (abs(k) <= dcBins || abs(k) > spanBins)
+		continue;
+	    sum += surveyPower[(k+SURVEY_FFT_SIZE)%SURVEY_FFT_SIZE];
+	    count++;
+	}
+	frequencies.push_back(f);
+	levels.push_back(count > 0? sum/count: 0);
+    }
+
+    for (uint i = 0; i < levels.size(); i++) {
+	DSPFLOAT snr = 10*log10(levels[i]/noise+1e-9);
+
+	if (snr <= threshold)
+	    continue;
+	if ((i > 0 && levels[i-1] > levels[i]) ||
+	    (i < levels.size()-1 && levels[i+1] >= levels[i]))
+	    continue;
+	log(LOG_FM, LOG_MIN, "fast scan carrier at %i snr %f", frequencies[i], snr);
+	fastScanFound(frequencies[i]);
+    }
+}
+
 void fmProcessor::run(void) {
     DSPCOMPLEX result;
     DSPCOMPLEX dataBuffer[BUFFER_SIZE];
+    DSPFLOAT demodBuffer[BUFFER_SIZE];
     DSPFLOAT phaseBuffer[PHASE_BUFFER_SIZE];
     int phaseInIndex = 0;
     DSPFLOAT pilotBuffer[PILOT_BUFFER_SIZE];
@@ -405,7 +541,28 @@ void fmProcessor::run(void) {
 	// collect samples and process
 	agcStats stats;
 	int32_t amount = device->getSamples(dataBuffer, BUFFER_SIZE, &stats);
-	radioInterface->processGain(&stats, amount);
+	device->agcControl()->update(&stats, amount);
+
+	// a fast scan surveys the whole capture in one go, and
+	// then idles until the next retune
+	if (initFastScan) {
+	    memset(surveyPower, 0, SURVEY_FFT_SIZE*sizeof(DSPFLOAT));
+	    surveyPointer = 0;
+	    surveySegments = 0;
+	    surveySkip = SURVEY_SETTLE;
+	    fastScanning = true;
+	    initFastScan = false;
+	}
+	if (fastScanning) {
+	    if (doSurvey(dataBuffer, amount)) {
+		findCarriers();
+		fastScanDone();
+	    }
+	    continue;
+	}
+	// the front end works sample by sample, and leaves the filtered
+	// signal at the start of dataBuffer, to be demodulated in one go
+	int32_t demodAmount = 0;
 	for (int i = 0; i < amount; i++) {
 	    DSPCOMPLEX v = cmul(dataBuffer[i], signalGain);
 
@@ -484,8 +641,14 @@ void fmProcessor::run(void) {
 		}
 	    }
 
-	    // demodulate and output
-	    DSPFLOAT demod = demodulator->demodulate(v);
+	    dataBuffer[demodAmount++] = v;
+	}
+
+	// demodulate and output
+	demodulator->demodulate(dataBuffer, demodBuffer, demodAmount);
+	for (int i = 0; i < demodAmount; i++) {
+	    DSPFLOAT demod = demodBuffer[i];
+
 	    if (fmMode == FM_STEREO) {
 		pilotBuffer[pilotInIndex] = demod;
 		pilotInIndex = (pilotInIndex + 1) % PILOT_BUFFER_SIZE;
@@ -515,23 +678,19 @@ void fmProcessor::run(void) {
 	    DSPCOMPLEX out = DSPCOMPLEX(leftChannel*real(result),
 					rightChannel*imag(result));
 
-	    if (audioDecimator->convert(out, audioOut, &audioAmount)) {
-		DSPCOMPLEX pcmSample;
-
-		for (int k = 0; k < audioAmount; k ++) {
-		    if (squelchOn)
-			pcmSample = squelchControl.do_squelch(audioOut[k]);
-		    else
-			pcmSample = audioOut [k];
-		    if (audioRate == workingRate)
-			audioSink->putSample(pcmSample);
-		    else {
-			_VLA(DSPCOMPLEX, out, audioConverter->getOutputsize());
-			int32_t amount;
-
-			if (audioConverter->convert(pcmSample, out, &amount))
-			    audioSink->putSamples(out, amount);
-		    }
+	    if (!muted && audioDecimator->convert(out, audioOut, &audioAmount)) {
+		if (squelchOn)
+		    for (int k = 0; k < audioAmount; k ++)
+			audioOut[k] = squelchControl.do_squelch(audioOut[k]);
+		if (audioRate == workingRate)
+		    audioSink->putSamples(audioOut, audioAmount);
+		else {
+		    _VLA(DSPCOMPLEX, pcmOut, audioConverter->getOutputsize(audioAmount));
+		    int32_t amount = audioConverter->convert(reinterpret_cast<float*>(audioOut), audioAmount,
+							     reinterpret_cast<float*>(pcmOut));
+
+		    if (amount > 0)
+			audioSink->putSamples(pcmOut, amount);
 		}
 	    }
 
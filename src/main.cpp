@@ -18,7 +18,14 @@
  *    along with guglielmo; if not, write to the Free Software
  *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
+#ifdef HEADLESS
+#include <QCoreApplication>
+#include <QSocketNotifier>
+#include <signal.h>
+#include <unistd.h>
+#else
 #include <QApplication>
+#endif
 #include <QSettings>
 #include <QTranslator>
 #include <QString>
@@ -27,18 +34,56 @@
 #include "constants.h"
 #include "logger.h"
 #include "radio.h"
+#include "file-handler.h"
+#include "telemetry.h"
+#ifdef HEADLESS
+#include "settings.h"
+#endif
 
 static
 void usage(const char *name) {
-    fprintf(stderr, "usage: %s [[-i <config file>] [-d <debug level>][-v]|-h|-V]\n", name);
+    fprintf(stderr, "usage: %s [[-i <config file>] [-d <debug level>][-v]"
+		    "[-f <IQ file>|- [-F wav|cu8|cs16|cf32][-b <bits>][-n][-o]]"
+		    "[-t <telemetry file>|unix:<socket> [-T <ms>]]"
+#ifdef HEADLESS
+		    "[-c <control socket>][-D <channel> [-S <service>]|-M <MHz>]"
+#endif
+		    "|-h|-V]\n", name);
 }
 
+#if defined(HEADLESS) && !IS_WINDOWS
+static int signalPipe[2];
+
+// only async signal safe calls here: the event loop does the rest
+static
+void signalHandler(int) {
+    char c = 1;
+
+    (void) !write(signalPipe[1], &c, 1);
+}
+#endif
+
 int main(int argc, char **argv) {
     QString configFile = QString(DEFAULT_CFG);
     QString locale = QLocale::system().name();
     QTranslator *translator;
     QSettings *settings;
     RadioInterface *radioInterface;
+    deviceHandler *fileDevice = nullptr;
+    QString iqFile;
+    fileHandler::fileFormat iqFormat = fileHandler::FILE_AUTO;
+    int iqBits = 16;
+    bool iqRealTime = true;
+    bool iqLoop = true;
+    QString telemetryTarget;
+    int telemetryInterval = 1000;
+    telemetryWriter *telemetry = nullptr;
+#ifdef HEADLESS
+    QString controlSocket;
+    QString channel;
+    QString service;
+    double FMfreq = 0;
+#endif
     int opt;
     qint64 mask;
 
@@ -51,14 +96,38 @@ int main(int argc, char **argv) {
     configFile = QDir::homePath();
     configFile.append("/");
     configFile.append(QString(DEFAULT_CFG));
+#ifndef HEADLESS
     QGuiApplication::setDesktopFileName(TARGET);
+#endif
     QCoreApplication::setOrganizationName(ORGNAME);
     QCoreApplication::setOrganizationDomain(ORGDOMAIN);
     QCoreApplication::setApplicationName(TARGET);
     QCoreApplication::setApplicationVersion(QString(CURRENT_VERSION));
 
-    while ((opt = getopt(argc, argv, "d:hi:vV")) != -1)
+#ifdef HEADLESS
+#define OPTIONS "b:c:d:D:f:F:hi:M:noS:t:T:vV"
+#else
+#define OPTIONS "b:d:f:F:hi:not:T:vV"
+#endif
+    while ((opt = getopt(argc, argv, OPTIONS)) != -1)
 	switch (opt) {
+	case 'b':
+	    iqBits = atoi(optarg);
+	    break;
+#ifdef HEADLESS
+	case 'c':
+	    controlSocket = optarg;
+	    break;
+	case 'D':
+	    channel = QString(optarg).toUpper();
+	    break;
+	case 'S':
+	    service = optarg;
+	    break;
+	case 'M':
+	    FMfreq = atof(optarg);
+	    break;
+#endif
 	case 'd':
 	    mask = QString(optarg).toLongLong(NULL, 0);
 	    setLogMask(mask);
@@ -68,6 +137,33 @@ int main(int argc, char **argv) {
 	    // this is an absolute path or relative to CWD, not relative to the home directory
 	    configFile = optarg;
 	    break;
+	case 'f':
+
+	    // replay a recording rather than using an SDR, "-" is stdin
+	    iqFile = optarg;
+	    break;
+	case 'F':
+	    iqFormat = fileHandler::formatFor(optarg);
+	    if (iqFormat == fileHandler::FILE_AUTO) {
+		fprintf(stderr, "unknown IQ format %s\n", optarg);
+		exit(1);
+	    }
+	    break;
+	case 'n':
+	    iqRealTime = false;
+	    break;
+	case 'o':
+	    iqLoop = false;
+	    break;
+	case 't':
+	    // stage timings and error counters, a .json file, any other file or a socket for prometheus
+	    telemetryTarget = optarg;
+	    break;
+	case 'T':
+	    telemetryInterval = atoi(optarg);
+	    if (telemetryInterval < 100)
+		telemetryInterval = 100;
+	    break;
 	case 'v':
 	    incLogVerbosity();
 	    break;
@@ -88,7 +184,7 @@ int main(int argc, char **argv) {
     settings = new QSettings(configFile, QSettings::NativeFormat);
 #endif
 
-#if QT_VERSION >= 0x050600 && QT_VERSION <= 0x060000
+#if QT_VERSION >= 0x050600 && QT_VERSION <= 0x060000 && !defined(HEADLESS)
     QGuiApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
 #endif
 
@@ -104,16 +200,66 @@ int main(int argc, char **argv) {
     }
     QLocale::setDefault(QLocale((const QString&)locale));
 
+#ifdef HEADLESS
+    QCoreApplication a(argc, argv);
+#else
     QApplication a(argc, argv);
+    a.setWindowIcon(MAIN_ICON_PATH);
+#endif
     a.setOrganizationName(ORGNAME);
     a.setApplicationName(TARGET);
-    a.setWindowIcon(MAIN_ICON_PATH);
-    radioInterface = new RadioInterface(settings);
+    if (iqFile != "")
+	try {
+	    fileDevice = new fileHandler(iqFile, iqFormat, iqBits, iqRealTime, iqLoop);
+	} catch (int e) {
+	    fprintf(stderr, "could not open %s\n", qPrintable(iqFile));
+	    exit(1);
+	}
+    if (telemetryTarget != "")
+	telemetry = new telemetryWriter(telemetryTarget, telemetryInterval);
+    radioInterface = new RadioInterface(settings, fileDevice);
+#ifdef HEADLESS
+    if (controlSocket == "") {
+	settings->beginGroup(GROUP_DAEMON);
+	controlSocket = settings->value(DAEMON_SOCKET, DAEMON_DEF_SOCKET).toString();
+	settings->endGroup();
+    }
+    if (controlSocket != "-" && !radioInterface->listen(controlSocket)) {
+	fprintf(stderr, "could not listen on %s\n", qPrintable(controlSocket));
+	exit(1);
+    }
+    if (FMfreq != 0) {
+	if (!radioInterface->tuneFM(FMfreq)) {
+	    fprintf(stderr, "bad FM frequency %3.3f\n", FMfreq);
+	    exit(1);
+	}
+    } else if (channel != "") {
+	if (!radioInterface->tuneDAB(channel, service)) {
+	    fprintf(stderr, "bad DAB channel %s\n", qPrintable(channel));
+	    exit(1);
+	}
+    } else
+	radioInterface->resume();
+
+#if !IS_WINDOWS
+    QSocketNotifier *signalNotifier = nullptr;
+
+    if (pipe(signalPipe) == 0) {
+	signalNotifier = new QSocketNotifier(signalPipe[0], QSocketNotifier::Read);
+	QObject::connect(signalNotifier, &QSocketNotifier::activated,
+			 &a, &QCoreApplication::quit);
+	signal(SIGINT, signalHandler);
+	signal(SIGTERM, signalHandler);
+    }
+#endif
+#else
     radioInterface->show();
+#endif
     a.exec();
     fflush(stdout);
     fflush(stderr);
     delete radioInterface;
+    delete telemetry;
     delete settings;
     return 0;
 }
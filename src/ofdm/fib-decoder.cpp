@@ -34,6 +34,7 @@
 #include "fib-table.h"
 #include "logging.h"
 #include "radio.h"
+#include "telemetry.h"
 #include <cstring>
 #include <vector>
 
@@ -54,6 +55,9 @@ fibDecoder::fibDecoder(RadioInterface *mr) {
     nextConfig = new dabConfig();
     ensemble = new ensembleDescriptor();
     CIFcount = 0;
+    figGeneration = 0;
+    flushSeenFIGs();
+    publishSnapshot();
 }
 
 fibDecoder::~fibDecoder() {
@@ -62,19 +66,43 @@ fibDecoder::~fibDecoder() {
     delete ensemble;
 }
 
-//	FIB's are segments of 256 bits. When here, we already
+//	FIB's are segments of 32 bytes. When here, we already
 //	passed the crc and we start unpacking into FIGs
-//	This is merely a dispatcher
+//	This is merely a dispatcher.
+//	Most FIGs are repeats of what we have already seen, so once the
+//	ensemble is loaded those are weeded out before taking the lock:
+//	a FIB with nothing new in it costs a few hashes
 void fibDecoder::process_FIB(uint8_t *p) {
-    int8_t processedBytes = 0;
-    uint8_t *d = p;
+    int16_t processedBytes = 0;
+    int16_t figs[30];
+    int16_t nFigs = 0;
+    bool loaded = !currentConfig->doSignal;
 
-    fibLocker.lock();
+    if (++fibCount >= FIG_SEEN_FLUSH)
+	flushSeenFIGs();
     while (processedBytes < 30) {
-	uint8_t FIGtype = getBits_3(d, 0);
-	uint8_t FIGlength = getBits_5(d, 3);
-	if ((FIGtype == 0x07) && (FIGlength == 0x3F))
-	    return;
+	uint8_t *d = p + processedBytes;
+	uint8_t FIGlength = getPackedBits(d, 3, 5);
+
+	// end marker, the rest is padding
+	if (d[0] == 0xFF)
+	    break;
+	if (loaded && seenFIG(d, FIGlength + 1))
+	    telemetryCount(TEL_FIG_REPEATS);
+	else
+	    figs[nFigs++] = processedBytes;
+
+	//	Thanks to Ronny Kunze, who discovered that I used
+	//	a p rather than a d
+	processedBytes += FIGlength + 1;
+    }
+    if (nFigs == 0)
+	return;
+
+    fibLocker.lock();
+    for (int16_t i = 0; i < nFigs; i++) {
+	uint8_t *d = p + figs[i];
+	uint8_t FIGtype = getPackedBits(d, 0, 3);
 
 	switch (FIGtype) {
 	case 0:
@@ -94,18 +122,64 @@ void fibDecoder::process_FIB(uint8_t *p) {
 	default:
 	    break;
 	}
-  
-	//	Thanks to Ronny Kunze, who discovered that I used
-	//	a p rather than a d
-	processedBytes += getBits_5(d, 3) + 1;
-	//	      processedBytes += getBits (p, 3, 5) + 1;
-	d = p + processedBytes * 8;
     }
+
+    //	something new came out of it, and the loading logic may want
+    //	to see the repeats again
+    uint32_t generation = configGeneration();
+    if (generation != figGeneration) {
+	figGeneration = generation;
+	flushSeenFIGs();
+    }
+    publishIfChanged();
     fibLocker.unlock();
 }
 
+//	FNV-1a over the whole FIG, header included, so that a FIG for
+//	the next configuration never matches one for the current
+bool fibDecoder::seenFIG(const uint8_t *d, int16_t length) {
+    uint32_t hash = 2166136261u;
+
+    //	FIG 0/0 carries the CIF count and the change flags: never the same
+    if ((d[0] >> 5) == 0 && (d[1] & 0x1F) == 0)
+	return false;
+    for (int16_t i = 0; i < length; i++)
+	hash = (hash ^ d[i]) * 16777619u;
+    if (hash == 0)
+	hash = 1;
+
+    for (int16_t i = 0; i < FIG_SEEN_SIZE; i++) {
+	uint32_t *slot = &figSeen[(hash + i) & (FIG_SEEN_SIZE - 1)];
+
+	if (*slot == hash)
+	    return true;
+	if (*slot == 0) {
+
+	    // keep the table sparse, the next flush will make room
+	    if (figSeenCount < FIG_SEEN_SIZE / 2) {
+		*slot = hash;
+		figSeenCount++;
+	    }
+	    return false;
+	}
+    }
+    return false;
+}
+
+void fibDecoder::flushSeenFIGs() {
+    memset(figSeen, 0, sizeof(figSeen));
+    figSeenCount = 0;
+    fibCount = 0;
+}
+
+uint32_t fibDecoder::configGeneration() {
+    return (ensemble->count << 24) ^ (currentConfig->count << 16) ^
+	   (currentConfig->addedCount << 8) ^ nextConfig->count ^
+	   (currentConfig->doSignal? 0x80000000: 0);
+}
+
 void fibDecoder::process_FIG0(uint8_t *d) {
-    uint8_t extension = getBits_5(d, 8 + 3);
+    uint8_t extension = getPackedBits(d, 8 + 3, 5);
 
     switch (extension) {
     case 0: // ensemble information (6.4.1)
@@ -219,13 +293,13 @@ void fibDecoder::process_FIG0(uint8_t *d) {
 //	we are not equipped for that, so we just ignore it for the moment
 //	The info is MCI
 void fibDecoder::FIG0Extension0(uint8_t *d) {
-//    uint8_t CN_bit = getBits_1(d, 8 + 0);
-//    uint32_t EId = getBits(d, 16, 16);
-    uint8_t changeFlag = getBits_2(d, 16 + 16);;
-//    uint8_t alarmFlag = getBits_1(d, 16 + 16 + 2);
-    uint16_t highpart = getBits_5(d, 16 + 19);
-    uint16_t lowpart = getBits_8(d, 16 + 24);;
-//    int16_t occurrenceChange getBits_8(d, 16 + 32);
+//    uint8_t CN_bit = getPackedBits(d, 8 + 0, 1);
+//    uint32_t EId = getPackedBits(d, 16, 16);
+    uint8_t changeFlag = getPackedBits(d, 16 + 16, 2);;
+//    uint8_t alarmFlag = getPackedBits(d, 16 + 16 + 2, 1);
+    uint16_t highpart = getPackedBits(d, 16 + 19, 5);
+    uint16_t lowpart = getPackedBits(d, 16 + 24, 8);;
+//    int16_t occurrenceChange getPackedBits(d, 16 + 32, 8);
     static uint8_t prevChangeFlag = 0;
 
     CIFcount = highpart * 250 + lowpart;
@@ -236,6 +310,8 @@ void fibDecoder::FIG0Extension0(uint8_t *d) {
 	nextConfig = temp;
 	nextConfig->reset();
 	cleanupServiceList();
+	snapshotChanged = true; // the components and subchannels swapped
+	publishIfChanged();
 	emit changeInConfiguration();
     }
 
@@ -248,10 +324,10 @@ void fibDecoder::FIG0Extension0(uint8_t *d) {
 //	relevant CIF.
 void fibDecoder::FIG0Extension1(uint8_t *d) {
     int16_t used = 2; // offset in bytes
-    int16_t Length = getBits_5(d, 3);
-    uint8_t CN_bit = getBits_1(d, 8 + 0);
-//    uint8_t OE_bit = getBits_1(d, 8 + 1);
-//    uint8_t PD_bit = getBits_1(d, 8 + 2);
+    int16_t Length = getPackedBits(d, 3, 5);
+    uint8_t CN_bit = getPackedBits(d, 8 + 0, 1);
+//    uint8_t OE_bit = getPackedBits(d, 8 + 1, 1);
+//    uint8_t PD_bit = getPackedBits(d, 8 + 2, 1);
 
     while (used < Length - 1)
 	used = HandleFIG0Extension1(d, used, CN_bit);
@@ -262,8 +338,8 @@ int16_t fibDecoder::HandleFIG0Extension1(uint8_t *d, int16_t offset,
 					 uint8_t CN_bit) {
 
     int16_t bitOffset = offset * 8;
-    int16_t subChId = getBits_6(d, bitOffset);
-    int16_t startAdr = getBits(d, bitOffset + 6, 10);
+    int16_t subChId = getPackedBits(d, bitOffset, 6);
+    int16_t startAdr = getPackedBits(d, bitOffset + 6, 10);
     int16_t tabelIndex;
     int16_t option, protLevel, subChanSize;
     subChannelDescriptor subChannel;
@@ -275,8 +351,8 @@ int16_t fibDecoder::HandleFIG0Extension1(uint8_t *d, int16_t offset,
     subChannel.startAddr = startAdr;
     subChannel.inUse = true;
 
-    if (getBits_1(d, bitOffset + 16) == 0) { // short form
-	tabelIndex = getBits_6(d, bitOffset + 18);
+    if (getPackedBits(d, bitOffset + 16, 1) == 0) { // short form
+	tabelIndex = getPackedBits(d, bitOffset + 18, 6);
 	subChannel.Length = ProtLevel[tabelIndex][0];
 	subChannel.shortForm = true; // short form
 	subChannel.protLevel = ProtLevel[tabelIndex][1];
@@ -284,18 +360,18 @@ int16_t fibDecoder::HandleFIG0Extension1(uint8_t *d, int16_t offset,
 	bitOffset += 24;
     } else { // EEP long form
 	subChannel.shortForm = false;
-	option = getBits_3(d, bitOffset + 17);
+	option = getPackedBits(d, bitOffset + 17, 3);
 	if (option == 0) { // A Level protection
-	    protLevel = getBits(d, bitOffset + 20, 2);
+	    protLevel = getPackedBits(d, bitOffset + 20, 2);
 	    subChannel.protLevel = protLevel;
-	    subChanSize = getBits(d, bitOffset + 22, 10);
+	    subChanSize = getPackedBits(d, bitOffset + 22, 10);
 	    subChannel.Length = subChanSize;
 	    subChannel.bitRate = subChanSize / table_1[protLevel] * 8;
         } else                   // option should be 001
 	    if (option == 001) { // B Level protection
-	    protLevel = getBits_2(d, bitOffset + 20);
+	    protLevel = getPackedBits(d, bitOffset + 20, 2);
 	    subChannel.protLevel = protLevel + (1 << 2);
-	    subChanSize = getBits(d, bitOffset + 22, 10);
+	    subChanSize = getPackedBits(d, bitOffset + 22, 10);
 	    subChannel.Length = subChanSize;
 	    subChannel.bitRate = subChanSize / table_2[protLevel] * 32;
 	}
@@ -315,6 +391,7 @@ int16_t fibDecoder::HandleFIG0Extension1(uint8_t *d, int16_t offset,
     localBase->subChannels[subChId].shortForm = subChannel.shortForm;
     localBase->subChannels[subChId].protLevel = subChannel.protLevel;
     localBase->subChannels[subChId].bitRate = subChannel.bitRate;
+    markChanged(localBase);
 
     return bitOffset / 8; // we return bytes
 }
@@ -323,10 +400,10 @@ int16_t fibDecoder::HandleFIG0Extension1(uint8_t *d, int16_t offset,
 //	bind channels to SIds
 void fibDecoder::FIG0Extension2(uint8_t *d) {
     int16_t used = 2; // offset in bytes
-    int16_t Length = getBits_5(d, 3);
-    uint8_t CN_bit = getBits_1(d, 8 + 0);
-//  uint8_t OE_bit = getBits_1(d, 8 + 1);
-    uint8_t PD_bit = getBits_1(d, 8 + 2);
+    int16_t Length = getPackedBits(d, 3, 5);
+    uint8_t CN_bit = getPackedBits(d, 8 + 0, 1);
+//  uint8_t OE_bit = getPackedBits(d, 8 + 1, 1);
+    uint8_t PD_bit = getPackedBits(d, 8 + 2, 1);
 
     while (used < Length) {
 	used = HandleFIG0Extension2(d, used, CN_bit, PD_bit);
@@ -343,31 +420,31 @@ int16_t fibDecoder::HandleFIG0Extension2(uint8_t *d, int16_t offset,
     int16_t numberofComponents;
 
     if (PD_bit == 1) { // long Sid, data
-//      ecc = getBits_8(d, bitOffset);
-//      cId = getBits_4(d, bitOffset + 1);
-        SId = getLBits(d, bitOffset, 32);
+//      ecc = getPackedBits(d, bitOffset, 8);
+//      cId = getPackedBits(d, bitOffset + 1, 4);
+        SId = getPackedLBits(d, bitOffset, 32);
         bitOffset += 32;
     } else {
-//      cId = getBits_4(d, bitOffset);
-        SId = getBits(d, bitOffset, 16);
+//      cId = getPackedBits(d, bitOffset, 4);
+        SId = getPackedBits(d, bitOffset, 16);
         bitOffset += 16;
     }
 
-    numberofComponents = getBits_4(d, bitOffset + 4);
+    numberofComponents = getPackedBits(d, bitOffset + 4, 4);
     bitOffset += 8;
 
     for (i = 0; i < numberofComponents; i++) {
-        uint8_t TMid = getBits_2(d, bitOffset);
+        uint8_t TMid = getPackedBits(d, bitOffset, 2);
         if (TMid == TMStreamAudio) {
-            uint8_t ASCTy = getBits_6(d, bitOffset + 2);
-            uint8_t SubChId = getBits_6(d, bitOffset + 8);
-            uint8_t PS_flag = getBits_1(d, bitOffset + 14);
+            uint8_t ASCTy = getPackedBits(d, bitOffset + 2, 6);
+            uint8_t SubChId = getPackedBits(d, bitOffset + 8, 6);
+            uint8_t PS_flag = getPackedBits(d, bitOffset + 14, 1);
             bind_audioService(CN_bit == 0 ? currentConfig : nextConfig, TMid,
                               SId, i, SubChId, PS_flag, ASCTy);
         } else if (TMid == TMPacketData) { // MSC packet data
-            int16_t SCId = getBits(d, bitOffset + 2, 12);
-            uint8_t PS_flag = getBits_1(d, bitOffset + 14);
-            uint8_t CA_flag = getBits_1(d, bitOffset + 15);
+            int16_t SCId = getPackedBits(d, bitOffset + 2, 12);
+            uint8_t PS_flag = getPackedBits(d, bitOffset + 14, 1);
+            uint8_t CA_flag = getPackedBits(d, bitOffset + 15, 1);
             bind_packetService(CN_bit == 0 ? currentConfig : nextConfig, TMid,
                                SId, i, SCId, PS_flag, CA_flag);
         }
@@ -382,10 +459,10 @@ int16_t fibDecoder::HandleFIG0Extension2(uint8_t *d, int16_t offset,
 //      description in packet mode.
 void fibDecoder::FIG0Extension3(uint8_t *d) {
     int16_t used = 2; // offset in bytes
-    int16_t Length = getBits_5(d, 3);
-    uint8_t CN_bit = getBits_1(d, 8 + 0);
-//  uint8_t OE_bit = getBits_1(d, 8 + 1);
-//  uint8_t PD_bit = getBits_1(d, 8 + 2);
+    int16_t Length = getPackedBits(d, 3, 5);
+    uint8_t CN_bit = getPackedBits(d, 8 + 0, 1);
+//  uint8_t OE_bit = getPackedBits(d, 8 + 1, 1);
+//  uint8_t PD_bit = getPackedBits(d, 8 + 2, 1);
 
     while (used < Length)
         used = HandleFIG0Extension3(d, used, CN_bit);
@@ -395,19 +472,19 @@ void fibDecoder::FIG0Extension3(uint8_t *d) {
 //	a unique 12 bit number in the ensemble
 int16_t fibDecoder::HandleFIG0Extension3(uint8_t *d, int16_t used,
                                          uint8_t CN_bit) {
-    int16_t SCId = getBits(d, used * 8, 12);
-    int16_t CAOrgflag = getBits_1(d, used * 8 + 15);
-    int16_t DGflag = getBits_1(d, used * 8 + 16);
-    int16_t DSCTy = getBits_6(d, used * 8 + 18);
-    int16_t SubChId = getBits_6(d, used * 8 + 24);
-    int16_t packetAddress = getBits(d, used * 8 + 30, 10);
+    int16_t SCId = getPackedBits(d, used * 8, 12);
+    int16_t CAOrgflag = getPackedBits(d, used * 8 + 15, 1);
+    int16_t DGflag = getPackedBits(d, used * 8 + 16, 1);
+    int16_t DSCTy = getPackedBits(d, used * 8 + 18, 6);
+    int16_t SubChId = getPackedBits(d, used * 8 + 24, 6);
+    int16_t packetAddress = getPackedBits(d, used * 8 + 30, 10);
 
     int serviceCompIndex;
     int serviceIndex;
     dabConfig *localBase = CN_bit == 0 ? currentConfig : nextConfig;
 
     if (CAOrgflag == 1) {
-//      CAOrg = getBits(d, used * 8 + 40, 16);
+//      CAOrg = getPackedBits(d, used * 8 + 40, 16);
         used += 16 / 8;
     }
     used += 40 / 8;
@@ -443,10 +520,12 @@ int16_t fibDecoder::HandleFIG0Extension3(uint8_t *d, int16_t used,
     localBase->serviceComps[serviceCompIndex].DSCTy = DSCTy;
     localBase->serviceComps[serviceCompIndex].DGflag = DGflag;
     localBase->serviceComps[serviceCompIndex].packetAddress = packetAddress;
+    markChanged(localBase);
     if (!ensemble->services[serviceIndex].is_shown && localBase->serviceComps[serviceCompIndex].appType != UATUndef) {
         localBase->addedCount++;
 	log(LOG_DAB, LOG_VERBOSE, "adding to ensemble %s %d", qPrintable(serviceName.trimmed()),
 		ensemble->services[serviceIndex].SId);
+        publishIfChanged();
         addToEnsemble(serviceName, ensemble->services[serviceIndex].SId);
         ensemble->services[serviceIndex].is_shown = true;
     }
@@ -456,10 +535,10 @@ int16_t fibDecoder::HandleFIG0Extension3(uint8_t *d, int16_t used,
 //	Service component language 8.1.2
 void fibDecoder::FIG0Extension5(uint8_t *d) {
     int16_t used = 2; // offset in bytes
-    int16_t Length = getBits_5(d, 3);
-    uint8_t CN_bit = getBits_1(d, 8 + 0);
-//  uint8_t OE_bit = getBits_1(d, 8 + 1);
-//  uint8_t PD_bit = getBits_1(d, 8 + 2);
+    int16_t Length = getPackedBits(d, 3, 5);
+    uint8_t CN_bit = getPackedBits(d, 8 + 0, 1);
+//  uint8_t OE_bit = getPackedBits(d, 8 + 1, 1);
+//  uint8_t PD_bit = getPackedBits(d, 8 + 2, 1);
 
     while (used < Length) {
         used = HandleFIG0Extension5(d, CN_bit, used);
@@ -469,24 +548,27 @@ void fibDecoder::FIG0Extension5(uint8_t *d) {
 int16_t fibDecoder::HandleFIG0Extension5(uint8_t *d, uint8_t CN_bit,
                                          int16_t offset) {
     int16_t bitOffset = offset * 8;
-    uint8_t lsFlag = getBits_1(d, bitOffset);
+    uint8_t lsFlag = getPackedBits(d, bitOffset, 1);
     int16_t language;
     dabConfig *localBase = CN_bit == 0 ? currentConfig : nextConfig;
 
     if (lsFlag == 0) { // short form
-        if (getBits_1(d, bitOffset + 1) == 0) {
-            int16_t subChId = getBits_6(d, bitOffset + 2);
-            language = getBits_8(d, bitOffset + 8);
+        if (getPackedBits(d, bitOffset + 1, 1) == 0) {
+            int16_t subChId = getPackedBits(d, bitOffset + 2, 6);
+            language = getPackedBits(d, bitOffset + 8, 8);
             localBase->subChannels[subChId].language = language;
+            markChanged(localBase);
         }
         bitOffset += 16;
     } else { // long form
-        int16_t SCId = getBits(d, bitOffset + 4, 12);
-        language = getBits_8(d, bitOffset + 16);
+        int16_t SCId = getPackedBits(d, bitOffset + 4, 12);
+        language = getPackedBits(d, bitOffset + 16, 8);
         int compIndex = findServiceComponent(localBase, SCId);
 
-        if (compIndex != -1)
+        if (compIndex != -1) {
             localBase->serviceComps[compIndex].language = language;
+            markChanged(localBase);
+        }
         bitOffset += 24;
     }
 
@@ -496,13 +578,13 @@ int16_t fibDecoder::HandleFIG0Extension5(uint8_t *d, uint8_t CN_bit,
 // FIG0/7: Configuration linking information 6.4.2,
 void fibDecoder::FIG0Extension7(uint8_t *d) {
     int16_t used = 2; // offset in bytes
-//  int16_t Length = getBits_5(d, 3);
-    uint8_t CN_bit = getBits_1(d, 8 + 0);
-//  uint8_t OE_bit = getBits_1(d, 8 + 1);
-//  uint8_t PD_bit = getBits_1(d, 8 + 2);
+//  int16_t Length = getPackedBits(d, 3, 5);
+    uint8_t CN_bit = getPackedBits(d, 8 + 0, 1);
+//  uint8_t OE_bit = getPackedBits(d, 8 + 1, 1);
+//  uint8_t PD_bit = getPackedBits(d, 8 + 2, 1);
 
-    int nrServices = getBits_6(d, used * 8);
-    int counter = getBits(d, used * 8 + 6, 10);
+    int nrServices = getPackedBits(d, used * 8, 6);
+    int counter = getPackedBits(d, used * 8 + 6, 10);
     dabConfig *base = (CN_bit == 0 ? currentConfig : nextConfig);
 
     log(LOG_DAB, LOG_VERBOSE, "nrServices %d, count %d\n", nrServices, counter);
@@ -512,10 +594,10 @@ void fibDecoder::FIG0Extension7(uint8_t *d) {
 // FIG0/8:  Service Component Global Definition (6.3.5)
 void fibDecoder::FIG0Extension8(uint8_t *d) {
     int16_t used = 2; // offset in bytes
-    int16_t Length = getBits_5(d, 3);
-    uint8_t CN_bit = getBits_1(d, 8 + 0);
-//  uint8_t OE_bit = getBits_1(d, 8 + 1);
-    uint8_t PD_bit = getBits_1(d, 8 + 2);
+    int16_t Length = getPackedBits(d, 3, 5);
+    uint8_t CN_bit = getPackedBits(d, 8 + 0, 1);
+//  uint8_t OE_bit = getPackedBits(d, 8 + 1, 1);
+    uint8_t PD_bit = getPackedBits(d, 8 + 2, 1);
 
     while (used < Length) {
         used = HandleFIG0Extension8(d, used, CN_bit, PD_bit);
@@ -525,35 +607,37 @@ void fibDecoder::FIG0Extension8(uint8_t *d) {
 int16_t fibDecoder::HandleFIG0Extension8(uint8_t *d, int16_t used,
                                          uint8_t CN_bit, uint8_t PD_bit) {
     int16_t bitOffset = used * 8;
-    uint32_t SId = getLBits(d, bitOffset, PD_bit == 1 ? 32 : 16);
+    uint32_t SId = getPackedLBits(d, bitOffset, PD_bit == 1 ? 32 : 16);
     uint8_t lsFlag;
     uint16_t SCIds;
     uint8_t extensionFlag;
     dabConfig *localBase = CN_bit == 0 ? currentConfig : nextConfig;
 
     bitOffset += PD_bit == 1 ? 32 : 16;
-    extensionFlag = getBits_1(d, bitOffset);
-    SCIds = getBits_4(d, bitOffset + 4);
+    extensionFlag = getPackedBits(d, bitOffset, 1);
+    SCIds = getPackedBits(d, bitOffset + 4, 4);
 
     //	int serviceIndex = findService (SId);
     bitOffset += 8;
-    lsFlag = getBits_1(d, bitOffset);
+    lsFlag = getPackedBits(d, bitOffset, 1);
 
     if (lsFlag == 0) { // short form
         int16_t compIndex;
-        int16_t subChId = getBits_6(d, bitOffset + 2);
+        int16_t subChId = getPackedBits(d, bitOffset + 2, 6);
         if (localBase->subChannels[subChId].inUse) {
             compIndex = findComponent(localBase, SId, subChId);
             if (compIndex != -1) {
                 localBase->serviceComps[compIndex].SCIds = SCIds;
+                markChanged(localBase);
             }
         }
         bitOffset += 8;
     } else { // long form
-        int SCId = getBits(d, bitOffset + 4, 12);
+        int SCId = getPackedBits(d, bitOffset + 4, 12);
         int16_t compIndex = findServiceComponent(localBase, SCId);
         if (compIndex != -1) {
             localBase->serviceComps[compIndex].SCIds = SCIds;
+            markChanged(localBase);
         }
         bitOffset += 8;
     }
@@ -565,10 +649,10 @@ int16_t fibDecoder::HandleFIG0Extension8(uint8_t *d, int16_t used,
 //	User Application Information 6.3.6
 void fibDecoder::FIG0Extension13(uint8_t *d) {
     int16_t used = 2; // offset in bytes
-    int16_t Length = getBits_5(d, 3);
-    uint8_t CN_bit = getBits_1(d, 8 + 0);
-//  uint8_t OE_bit = getBits_1(d, 8 + 1);
-    uint8_t PD_bit = getBits_1(d, 8 + 2);
+    int16_t Length = getPackedBits(d, 3, 5);
+    uint8_t CN_bit = getPackedBits(d, 8 + 0, 1);
+//  uint8_t OE_bit = getPackedBits(d, 8 + 1, 1);
+    uint8_t PD_bit = getPackedBits(d, 8 + 2, 1);
 
     while (used < Length)
         used = HandleFIG0Extension13(d, used, CN_bit, PD_bit);
@@ -577,7 +661,7 @@ void fibDecoder::FIG0Extension13(uint8_t *d) {
 int16_t fibDecoder::HandleFIG0Extension13(uint8_t *d, int16_t used,
                                           uint8_t CN_bit, uint8_t pdBit) {
     int16_t bitOffset = used * 8;
-    uint32_t SId = getLBits(d, bitOffset, pdBit == 1 ? 32 : 16);
+    uint32_t SId = getPackedLBits(d, bitOffset, pdBit == 1 ? 32 : 16);
     uint16_t SCIds;
     int16_t NoApplications;
     int16_t i;
@@ -586,8 +670,8 @@ int16_t fibDecoder::HandleFIG0Extension13(uint8_t *d, int16_t used,
     dabConfig *localBase = CN_bit == 0 ? currentConfig : nextConfig;
 
     bitOffset += pdBit == 1 ? 32 : 16;
-    SCIds = getBits_4(d, bitOffset);
-    NoApplications = getBits_4(d, bitOffset + 4);
+    SCIds = getPackedBits(d, bitOffset, 4);
+    NoApplications = getPackedBits(d, bitOffset + 4, 4);
     bitOffset += 8;
 
     int serviceIndex = findService(SId);
@@ -599,8 +683,8 @@ int16_t fibDecoder::HandleFIG0Extension13(uint8_t *d, int16_t used,
     log(LOG_DAB, LOG_VERBOSE, "Processing Fig0Ext13 for %s SId %d SCIds %d", qPrintable(serviceName.trimmed()),
 	SId, SCIds);
     for (i = 0; i < NoApplications; i++) {
-        appType = getBits(d, bitOffset, 11);
-        int16_t length = getBits_5(d, bitOffset + 11);
+        appType = getPackedBits(d, bitOffset, 11);
+        int16_t length = getPackedBits(d, bitOffset + 11, 5);
         bitOffset += (11 + 5 + 8 * length);
 
 	log(LOG_DAB, LOG_VERBOSE, "processing application %i appType %i", i, appType);
@@ -608,6 +692,7 @@ int16_t fibDecoder::HandleFIG0Extension13(uint8_t *d, int16_t used,
         if (compIndex != -1) {
 	    log(LOG_DAB, LOG_VERBOSE, "service component %i TM %i appType %i",
 		localBase->serviceComps[compIndex].DSCTy, localBase->serviceComps[compIndex].TMid, appType);
+            markChanged(localBase);
             if (localBase->serviceComps[compIndex].TMid == TMPacketData)
                 localBase->serviceComps[compIndex].appType = appType;
             if (localBase->serviceComps[compIndex].DSCTy == SCTUndef)
@@ -621,6 +706,7 @@ int16_t fibDecoder::HandleFIG0Extension13(uint8_t *d, int16_t used,
 	localBase->addedCount++;
 	log(LOG_DAB, LOG_CHATTY, "adding to ensemble %s %d", qPrintable(serviceName.trimmed()),
 		ensemble->services[serviceIndex].SId);
+        publishIfChanged();
         addToEnsemble(serviceName, SId);
 	ensemble->services[serviceIndex].is_shown = true;
     }
@@ -629,40 +715,42 @@ int16_t fibDecoder::HandleFIG0Extension13(uint8_t *d, int16_t used,
 
 //	FEC sub-channel organization 6.2.2
 void fibDecoder::FIG0Extension14(uint8_t *d) {
-    int16_t Length = getBits_5(d, 3); // in Bytes
-    uint8_t CN_bit = getBits_1(d, 8 + 0);
-//  uint8_t OE_bit = getBits_1(d, 8 + 1);
-//  uint8_t PD_bit = getBits_1(d, 8 + 2);
+    int16_t Length = getPackedBits(d, 3, 5); // in Bytes
+    uint8_t CN_bit = getPackedBits(d, 8 + 0, 1);
+//  uint8_t OE_bit = getPackedBits(d, 8 + 1, 1);
+//  uint8_t PD_bit = getPackedBits(d, 8 + 2, 1);
     int16_t used = 2; // in Bytes
     dabConfig *localBase = CN_bit == 0 ? currentConfig : nextConfig;
 
     while (used < Length) {
-        int16_t subChId = getBits_6(d, used * 8);
-        uint8_t FEC_scheme = getBits_2(d, used * 8 + 6);
+        int16_t subChId = getPackedBits(d, used * 8, 6);
+        uint8_t FEC_scheme = getPackedBits(d, used * 8 + 6, 2);
         used = used + 1;
-        if (localBase->subChannels[subChId].inUse)
+        if (localBase->subChannels[subChId].inUse) {
             localBase->subChannels[subChId].FEC_scheme = FEC_scheme;
+            markChanged(localBase);
+        }
     }
 }
 
 void fibDecoder::FIG0Extension17(uint8_t *d) {
-    int16_t length = getBits_5(d, 3);
+    int16_t length = getPackedBits(d, 3, 5);
     int16_t offset = 16;
     int serviceIndex;
 
     while (offset < length * 8) {
-        uint16_t SId = getBits(d, offset, 16);
-        bool L_flag = getBits_1(d, offset + 18);
-        bool CC_flag = getBits_1(d, offset + 19);
+        uint16_t SId = getPackedBits(d, offset, 16);
+        bool L_flag = getPackedBits(d, offset + 18, 1);
+        bool CC_flag = getPackedBits(d, offset + 19, 1);
         int16_t type;
         int16_t Language = 0x00; // init with unknown language
         serviceIndex = findService(SId);
         if (L_flag) { // language field present
-            Language = getBits_8(d, offset + 24);
+            Language = getPackedBits(d, offset + 24, 8);
             offset += 8;
         }
 
-        type = getBits_5(d, offset + 27);
+        type = getPackedBits(d, offset + 27, 5);
         if (CC_flag) // cc flag
             offset += 40;
         else
@@ -670,36 +758,37 @@ void fibDecoder::FIG0Extension17(uint8_t *d) {
         if (serviceIndex != -1) {
             ensemble->services[serviceIndex].language = Language;
             ensemble->services[serviceIndex].programType = type;
+            snapshotChanged = true;
         }
     }
 }
 
 //	Announcement support 8.1.6.1
 void fibDecoder::FIG0Extension18(uint8_t *d) {
-    int16_t Length = getBits_5(d, 3); // in Bytes
-    uint8_t CN_bit = getBits_1(d, 8 + 0);
-//  uint8_t OE_bit = getBits_1(d, 8 + 1);
-//  uint8_t PD_bit = getBits_1(d, 8 + 2);
+    int16_t Length = getPackedBits(d, 3, 5); // in Bytes
+    uint8_t CN_bit = getPackedBits(d, 8 + 0, 1);
+//  uint8_t OE_bit = getPackedBits(d, 8 + 1, 1);
+//  uint8_t PD_bit = getPackedBits(d, 8 + 2, 1);
     int16_t used = 2; // in Bytes
     int16_t bitOffset = used * 8;
     dabConfig *localBase = CN_bit == 0 ? currentConfig : nextConfig;
 
     while (bitOffset < Length * 8) {
-        uint16_t SId = getBits(d, bitOffset, 16);
+        uint16_t SId = getPackedBits(d, bitOffset, 16);
         int16_t serviceIndex = findService(SId);
         bitOffset += 16;
-        uint16_t asuFlags = getBits(d, bitOffset, 16);
+        uint16_t asuFlags = getPackedBits(d, bitOffset, 16);
         bitOffset += 16;
-//      uint8_t Rfa = getBits(d, bitOffset, 5);
-        uint8_t nrClusters = getBits(d, bitOffset + 5, 3);
+//      uint8_t Rfa = getPackedBits(d, bitOffset, 5);
+        uint8_t nrClusters = getPackedBits(d, bitOffset + 5, 3);
         bitOffset += 8;
 
         for (int i = 0; i < nrClusters; i++) {
-            if (getBits(d, bitOffset + 8 * i, 8) == 0)
+            if (getPackedBits(d, bitOffset + 8 * i, 8) == 0)
                 continue;
             if ((serviceIndex != -1) &&
                 (ensemble->services[serviceIndex].hasName))
-                setCluster(localBase, getBits(d, bitOffset + 8 * i, 8),
+                setCluster(localBase, getPackedBits(d, bitOffset + 8 * i, 8),
                            serviceIndex, asuFlags);
         }
         bitOffset += nrClusters * 8;
@@ -708,29 +797,29 @@ void fibDecoder::FIG0Extension18(uint8_t *d) {
 
 //	Announcement switching 8.1.6.2
 void fibDecoder::FIG0Extension19(uint8_t *d) {
-    int16_t Length = getBits_5(d, 3); // in Bytes
-    uint8_t CN_bit = getBits_1(d, 8 + 0);
-//  uint8_t OE_bit = getBits_1(d, 8 + 1);
-//  uint8_t PD_bit = getBits_1(d, 8 + 2);
+    int16_t Length = getPackedBits(d, 3, 5); // in Bytes
+    uint8_t CN_bit = getPackedBits(d, 8 + 0, 1);
+//  uint8_t OE_bit = getPackedBits(d, 8 + 1, 1);
+//  uint8_t PD_bit = getPackedBits(d, 8 + 2, 1);
     int16_t used = 2; // in Bytes
     int16_t bitOffset = used * 8;
     dabConfig *localBase = CN_bit == 0 ? currentConfig : nextConfig;
 
     while (bitOffset < Length * 8) {
-        uint8_t clusterId = getBits(d, bitOffset, 8);
+        uint8_t clusterId = getPackedBits(d, bitOffset, 8);
         bitOffset += 8;
-        uint16_t AswFlags = getBits(d, bitOffset, 16);
+        uint16_t AswFlags = getPackedBits(d, bitOffset, 16);
         bitOffset += 16;
 
-//      uint8_t newFlag = getBits(d, bitOffset, 1);
+//      uint8_t newFlag = getPackedBits(d, bitOffset, 1);
         bitOffset += 1;
-        uint8_t regionFlag = getBits(d, bitOffset, 1);
+        uint8_t regionFlag = getPackedBits(d, bitOffset, 1);
         bitOffset += 1;
-        uint8_t subChId = getBits(d, bitOffset, 6);
+        uint8_t subChId = getPackedBits(d, bitOffset, 6);
         bitOffset += 6;
         if (regionFlag == 1) {
             bitOffset += 2; // skip Rfa
-//          uint8_t regionId = getBits(d, bitOffset, 6);
+//          uint8_t regionId = getPackedBits(d, bitOffset, 6);
             bitOffset += 6;
         }
 
@@ -767,10 +856,10 @@ void fibDecoder::FIG0Extension19(uint8_t *d) {
 //	Frequency information (FI) 8.1.8
 void fibDecoder::FIG0Extension21(uint8_t *d) {
     int16_t used = 2; // offset in bytes
-    int16_t Length = getBits_5(d, 3);
-//  uint8_t CN_bit = getBits_1(d, 8 + 0);
-//  uint8_t OE_bit = getBits_1(d, 8 + 1);
-//  uint8_t PD_bit = getBits_1(d, 8 + 2);
+    int16_t Length = getPackedBits(d, 3, 5);
+//  uint8_t CN_bit = getPackedBits(d, 8 + 0, 1);
+//  uint8_t OE_bit = getPackedBits(d, 8 + 1, 1);
+//  uint8_t PD_bit = getPackedBits(d, 8 + 2, 1);
 
     while (used < Length)
         used = HandleFIG0Extension21(d, used);
@@ -778,23 +867,25 @@ void fibDecoder::FIG0Extension21(uint8_t *d) {
 
 int16_t fibDecoder::HandleFIG0Extension21(uint8_t *d, int16_t offset) {
     int16_t l_offset = offset * 8;
-    int16_t l = getBits_5(d, l_offset + 11);
+    int16_t l = getPackedBits(d, l_offset + 11, 5);
     int16_t upperLimit = l_offset + 16 + l * 8;
     int16_t base = l_offset + 16;
 
     while (base < upperLimit) {
-        uint16_t idField = getBits(d, base, 16);
-        uint8_t RandM = getBits_4(d, base + 16);
-//      uint8_t continuity = getBits_1(d, base + 20);
-        uint8_t length = getBits_3(d, base + 21);
+        uint16_t idField = getPackedBits(d, base, 16);
+        uint8_t RandM = getPackedBits(d, base + 16, 4);
+//      uint8_t continuity = getPackedBits(d, base + 20, 1);
+        uint8_t length = getPackedBits(d, base + 21, 3);
         if (RandM == 0x08) {
-            uint16_t fmFrequency_key = getBits(d, base + 24, 8);
+            uint16_t fmFrequency_key = getPackedBits(d, base + 24, 8);
             int32_t fmFrequency = 87500 + fmFrequency_key * 100;
             int16_t serviceIndex = findService(idField);
             if (serviceIndex != -1) {
                 if ((ensemble->services[serviceIndex].hasName) &&
-                    (ensemble->services[serviceIndex].fmFrequency == -1))
+                    (ensemble->services[serviceIndex].fmFrequency == -1)) {
                     ensemble->services[serviceIndex].fmFrequency = fmFrequency;
+                    snapshotChanged = true;
+                }
             }
         }
         base += 24 + length * 8;
@@ -804,7 +895,7 @@ int16_t fibDecoder::HandleFIG0Extension21(uint8_t *d, int16_t offset) {
 }
 //	FIG 1 - Cover the different possible labels, section 5.2
 void fibDecoder::process_FIG1(uint8_t *d) {
-    uint8_t extension = getBits_3(d, 8 + 5);
+    uint8_t extension = getPackedBits(d, 8 + 5, 3);
 
     switch (extension) {
     case 0: // ensemble name
@@ -839,10 +930,10 @@ void fibDecoder::process_FIG1(uint8_t *d) {
 
 //	Name of the ensemble
 void fibDecoder::FIG1Extension0(uint8_t *d) {
-    uint8_t charSet = getBits_4(d, 8);
-//  uint8_t Rfu = getBits_1(d, 8 + 4);
-//  uint8_t extension = getBits_3(d, 8 + 5);;
-    uint32_t EId = getBits(d, 16, 16);;
+    uint8_t charSet = getPackedBits(d, 8, 4);
+//  uint8_t Rfu = getPackedBits(d, 8 + 4, 1);
+//  uint8_t extension = getPackedBits(d, 8 + 5, 3);;
+    uint32_t EId = getPackedBits(d, 16, 16);;
     int16_t offset = 0;
     char label[17];
 
@@ -851,7 +942,7 @@ void fibDecoder::FIG1Extension0(uint8_t *d) {
     offset = 32;
     if ((charSet <= 16)) { // EBU Latin based repertoire
         for (int i = 0; i < 16; i++) {
-            label[i] = getBits_8(d, offset + 8 * i);
+            label[i] = getPackedBits(d, offset + 8 * i, 8);
         }
         log(LOG_DAB, LOG_VERBOSE, "Ensemble name: %16s", label);
         const QString name =
@@ -860,6 +951,8 @@ void fibDecoder::FIG1Extension0(uint8_t *d) {
             ensemble->ensembleName = name;
             ensemble->ensembleId = EId;
             ensemble->namePresent = true;
+            snapshotChanged = true;
+            publishIfChanged();
             nameOfEnsemble(EId, name);
         }
         ensemble->isSynced = true;
@@ -868,10 +961,10 @@ void fibDecoder::FIG1Extension0(uint8_t *d) {
 
 //	Name of service
 void fibDecoder::FIG1Extension1(uint8_t *d) {
-    uint8_t charSet = getBits_4(d, 8);
-//  uint8_t Rfu getBits_1(d, 8 + 4);
-//  uint8_t extension = getBits_3(d, 8 + 5);
-    int32_t SId = getBits(d, 16, 16);
+    uint8_t charSet = getPackedBits(d, 8, 4);
+//  uint8_t Rfu getPackedBits(d, 8 + 4, 1);
+//  uint8_t extension = getPackedBits(d, 8 + 5, 3);
+    int32_t SId = getPackedBits(d, 16, 16);
     int16_t offset = 32;
     int serviceIndex;
     int16_t i;
@@ -883,7 +976,7 @@ void fibDecoder::FIG1Extension1(uint8_t *d) {
         return;
 
     for (i = 0; i < 16; i++)
-        label[i] = getBits_8(d, offset + 8 * i);
+        label[i] = getPackedBits(d, offset + 8 * i, 8);
     QString dataName =
         toQStringUsingCharset((const char *)label, (CharacterSet)charSet);
     serviceIndex = findService(dataName);
@@ -892,33 +985,34 @@ void fibDecoder::FIG1Extension1(uint8_t *d) {
     else {
         ensemble->services[serviceIndex].SCIds = 0;
         ensemble->services[serviceIndex].hasName = true;
+        snapshotChanged = true;
     }
 }
 
 // service component label 8.1.14.3
 void fibDecoder::FIG1Extension4(uint8_t *d) {
-    uint8_t PD_bit = getBits_1(d, 16);
-//  uint8_t Rfu = getBits_3(d, 17);
-    uint8_t SCIds = getBits_4(d, 20);
+    uint8_t PD_bit = getPackedBits(d, 16, 1);
+//  uint8_t Rfu = getPackedBits(d, 17, 3);
+    uint8_t SCIds = getPackedBits(d, 20, 4);
     uint32_t SId;
     int16_t offset;
 
 
     if (PD_bit) { // 32 bit identifier field for data components
-        SId = getLBits(d, 24, 32);
+        SId = getPackedLBits(d, 24, 32);
         offset = 56;
     } else { // 16 bit identifier field for program components
-        SId = getLBits(d, 24, 16);
+        SId = getPackedLBits(d, 24, 16);
         offset = 40;
     }
 
     char label[17];
     label[16] = 0;
     for (int i = 0; i < 16; i++) {
-        label[i] = getBits_8(d, offset + 8 * i);
+        label[i] = getPackedBits(d, offset + 8 * i, 8);
     }
 
-    int charSet = getBits_4(d, 8);
+    int charSet = getPackedBits(d, 8, 4);
     QString dataName =
         toQStringUsingCharset((const char *)label, (CharacterSet)charSet);
     int16_t compIndex = findServiceComponent(currentConfig, SId, SCIds);
@@ -927,6 +1021,7 @@ void fibDecoder::FIG1Extension4(uint8_t *d) {
             if (currentConfig->serviceComps[compIndex].TMid == TMStreamAudio) {
                 currentConfig->addedCount++;
                 createService(dataName, SId, SCIds);
+                publishIfChanged();
                 addToEnsemble(dataName, SId);
             }
         }
@@ -935,13 +1030,13 @@ void fibDecoder::FIG1Extension4(uint8_t *d) {
 
 //	Data service label - 32 bits 8.1.14.2
 void fibDecoder::FIG1Extension5(uint8_t *d) {
-    uint8_t charSet = getBits_4(d, 8);
-//  uint8_t Rfu = getBits_1(d, 8 + 4);;
-//  uint8_t extension = getBits_3(d, 8 + 5);
+    uint8_t charSet = getPackedBits(d, 8, 4);
+//  uint8_t Rfu = getPackedBits(d, 8 + 4, 1);;
+//  uint8_t extension = getPackedBits(d, 8 + 5, 3);
     int serviceIndex;
     int16_t i;
     char label[17];
-    uint32_t SId = getLBits(d, 16, 32);
+    uint32_t SId = getPackedLBits(d, 16, 32);
     int16_t offset = 48;
 
     label[16] = 0x00;
@@ -954,7 +1049,7 @@ void fibDecoder::FIG1Extension5(uint8_t *d) {
         return; // something wrong
 
     for (i = 0; i < 16; i++) {
-        label[i] = getBits_8(d, offset + 8 * i);
+        label[i] = getPackedBits(d, offset + 8 * i, 8);
     }
 
     QString serviceName =
@@ -965,19 +1060,19 @@ void fibDecoder::FIG1Extension5(uint8_t *d) {
 //	XPAD label - 8.1.14.4
 void fibDecoder::FIG1Extension6(uint8_t *d) {
 //  uint32_t SId = 0;
-    uint8_t PD_bit = getBits_1(d, 16);
-//  uint8_t Rfu = getBits_3(d, 17);
-//  uint8_t SCIds = getBits_4(d, 20);
+    uint8_t PD_bit = getPackedBits(d, 16, 1);
+//  uint8_t Rfu = getPackedBits(d, 17, 3);
+//  uint8_t SCIds = getPackedBits(d, 20, 4);
 //  int16_t offset = 0;
 //  uint8_t XPAD_apptype;
 
     if (PD_bit) { // 32 bits identifier for XPAD label
-//      SId = getLBits(d, 24, 32);
-//      XPAD_apptype = getBits_5(d, 59);
+//      SId = getPackedLBits(d, 24, 32);
+//      XPAD_apptype = getPackedBits(d, 59, 5);
 //      offset = 64;
     } else { // 16 bit identifier for XPAD label
-//      SId = getLBits(d, 24, 16);
-//      XPAD_apptype = getBits_5(d, 43);
+//      SId = getPackedLBits(d, 24, 16);
+//      XPAD_apptype = getPackedBits(d, 43, 5);
 //      offset = 48;
     }
 }
@@ -1025,6 +1120,7 @@ void fibDecoder::bind_audioService(dabConfig *base, int8_t TMid, uint32_t SId,
                                     base->reportedCount > 0) ||
                                    (base->addedCount >= ensemble->count &&
 				    base->addedCount == base->count))) {
+                publishIfChanged();
                 ensembleLoaded(base->addedCount);
                 base->doSignal = false;
             } else if (!base->serviceComps[i].inUse) {
@@ -1034,7 +1130,9 @@ void fibDecoder::bind_audioService(dabConfig *base, int8_t TMid, uint32_t SId,
                         ensemble->services[serviceIndex].serviceLabel;
                     base->serviceComps[i].inUse = true;
                     ensemble->services[serviceIndex].SCIds = 0;
+                    snapshotChanged = true;
                     base->addedCount++;
+                    publishIfChanged();
                     addToEnsemble(dataName, SId);
                     ensemble->services[serviceIndex].is_shown = true;
                 }
@@ -1055,6 +1153,7 @@ void fibDecoder::bind_audioService(dabConfig *base, int8_t TMid, uint32_t SId,
     base->serviceComps[firstFree].PS_flag = ps_flag;
     base->serviceComps[firstFree].ASCTy = ASCTy;
     base->serviceComps[firstFree].inUse = false;
+    markChanged(base);
     serviceIndex = findService(SId);
     if (serviceIndex != -1) {
         QString dataName = ensemble->services[serviceIndex].serviceLabel;
@@ -1063,8 +1162,10 @@ void fibDecoder::bind_audioService(dabConfig *base, int8_t TMid, uint32_t SId,
             showFlag = false;
         base->serviceComps[firstFree].inUse = true;
         ensemble->services[serviceIndex].SCIds = 0;
+        snapshotChanged = true;
         if (showFlag) {
             base->addedCount++;
+            publishIfChanged();
             addToEnsemble(dataName, SId);
         }
         ensemble->services[serviceIndex].is_shown = true;
@@ -1115,29 +1216,23 @@ void fibDecoder::bind_packetService(dabConfig *base, int8_t TMid, uint32_t SId,
     base->serviceComps[firstFree].DSCTy = SCTUndef;
     base->serviceComps[firstFree].appType = UATUndef;
     base->serviceComps[firstFree].is_madePublic = false;
+    markChanged(base);
 }
 
-static inline bool match(QString s1, QString s2) { return s1 == s2; }
-
+//	Services only ever get appended, and are only dropped all
+//	together, so the indexes just keep the first service seen with a
+//	given name or SId, as the linear scans they replace did
 int fibDecoder::findService(const QString &s) {
-    int i;
-    for (i = 0; i < ensemble->count; i++) {
-        if (!ensemble->services[i].inUse) // FIXME
-            continue;
-        if (match(s, ensemble->services[i].serviceLabel))
-            return i;
-    }
-    return -1;
+    return serviceByName.value(s, -1);
 }
+
 int fibDecoder::findService(uint32_t SId) {
-    int i;
-    for (i = 0; i < ensemble->count; i++) {
-        if (!ensemble->services[i].inUse) // FIXME
-            continue;
-        if (ensemble->services[i].SId == SId)
-            return i;
-    }
-    return -1;
+    return serviceBySId.value(SId, -1);
+}
+
+void fibDecoder::clearServiceIndex() {
+    serviceByName.clear();
+    serviceBySId.clear();
 }
 
 //	find data component using the SCId
@@ -1189,6 +1284,11 @@ void fibDecoder::createService(QString name, uint32_t SId, int SCIds) {
     ensemble->services[i].serviceLabel = name;
     ensemble->services[i].SId = SId;
     ensemble->services[i].SCIds = SCIds;
+    snapshotChanged = true;
+    if (!serviceByName.contains(name))
+        serviceByName.insert(name, i);
+    if (!serviceBySId.contains(SId))
+        serviceBySId.insert(SId, i);
 }
 
 //	called after a change in configuration to verify
@@ -1201,9 +1301,11 @@ void fibDecoder::cleanupServiceList() {
         int SCIds = ensemble->services[i].SCIds;
         if (findServiceComponent(currentConfig, SId, SCIds) == -1) {
             ensemble->services[i].inUse = false;
+            snapshotChanged = true;
         }
     }
     ensemble->count = 0;
+    clearServiceIndex();
 }
 
 QString fibDecoder::announcements(uint16_t a) {
@@ -1282,140 +1384,222 @@ void fibDecoder::clearEnsemble() {
     currentConfig->reset();
     nextConfig->reset();
     ensemble->reset();
+    clearServiceIndex();
+    flushSeenFIGs();
+    publishSnapshot();
     fibLocker.unlock();
 }
 
 bool fibDecoder::syncReached() { return ensemble->isSynced; }
 
-int fibDecoder::getSubChId(const QString &s, uint32_t req_SId) {
-    int serviceIndex = findService(s);
+//	Snapshot
+//	Always called with fibLocker held
 
-    // FIXME return good error
-    if (serviceIndex < 0)
-	return 2000;
+//	only the current configuration is visible, the next one is not
+//	until it is swapped in
+void fibDecoder::markChanged(dabConfig *base) {
+    if (base == currentConfig)
+        snapshotChanged = true;
+}
 
-    fibLocker.lock();
+//	most FIBs carry nothing new, so the snapshot is only rebuilt
+//	when something in it did change
+void fibDecoder::publishIfChanged() {
+    if (snapshotChanged)
+        publishSnapshot();
+}
 
-    uint SId = ensemble->services[serviceIndex].SId;
-    int SCIds = ensemble->services[serviceIndex].SCIds;
+void fibDecoder::publishSnapshot() {
+    std::shared_ptr<fibSnapshot> s = std::make_shared<fibSnapshot>();
 
-    int compIndex = findServiceComponent(currentConfig, SId, SCIds);
+    snapshotChanged = false;
 
-    // FIXME return good error
-    if (compIndex == -1 || req_SId != SId) {
-        fibLocker.unlock();
-        return 2000;
+    s->ensembleId = ensemble->ensembleId;
+    s->ensembleName = ensemble->ensembleName;
+    s->namePresent = ensemble->namePresent;
+    s->ecc_Present = ensemble->ecc_Present;
+    s->ecc_byte = ensemble->ecc_byte;
+    s->services.reserve(ensemble->count);
+    for (int i = 0; i < ensemble->count; i++) {
+        const service &S = ensemble->services[i];
+        fibSnapshot::entry e;
+
+        if (!S.inUse) // FIXME
+            continue;
+        e.serviceLabel = S.serviceLabel;
+        e.SId = S.SId;
+        e.SCIds = S.SCIds;
+        e.hasName = S.hasName;
+        e.language = S.language;
+        e.programType = S.programType;
+        e.fmFrequency = S.fmFrequency;
+
+        int k = s->services.size();
+        s->services.push_back(e);
+        if (!s->serviceByName.contains(e.serviceLabel))
+            s->serviceByName.insert(e.serviceLabel, k);
+        if (!s->serviceBySId.contains(e.SId))
+            s->serviceBySId.insert(e.SId, k);
+        if (!s->serviceBySCIds.contains(fibSnapshot::key(e.SId, e.SCIds)))
+            s->serviceBySCIds.insert(fibSnapshot::key(e.SId, e.SCIds), k);
     }
+    s->components.reserve(currentConfig->count);
+    for (int i = 0; i < currentConfig->count; i++) {
+        const serviceComponentDescriptor &c = currentConfig->serviceComps[i];
 
-    int subChId = currentConfig->serviceComps[compIndex].subchannelId;
-    fibLocker.unlock();
-    return subChId;
+        if (!c.inUse)
+            continue;
+        int k = s->components.size();
+        s->components.push_back(c);
+        if (!s->componentBySCIds.contains(fibSnapshot::key(c.SId, c.SCIds)))
+            s->componentBySCIds.insert(fibSnapshot::key(c.SId, c.SCIds), k);
+        if (!s->componentBySCId.contains(c.SCId))
+            s->componentBySCId.insert(c.SCId, k);
+        if (!s->componentBySubChId.contains(c.subchannelId))
+            s->componentBySubChId.insert(c.subchannelId, k);
+    }
+    for (int i = 0; i < SERVICES_SIZE; i++)
+        s->subChannels[i] = currentConfig->subChannels[i];
+    std::atomic_store(&snapshot, std::shared_ptr<const fibSnapshot>(s));
 }
 
-void fibDecoder::dataforAudioService(const QString &s, audiodata *ad) {
-    int serviceIndex;
+fibSnapshot::fibSnapshot() {
+    ensembleId = 0;
+    namePresent = false;
+    ecc_Present = false;
+    ecc_byte = 0;
+}
 
-    ad->defined = false; // default
-    serviceIndex = findService(s);
-    if (serviceIndex == -1)
-        return;
+const fibSnapshot::entry *fibSnapshot::findService(const QString &s) const {
+    int i = serviceByName.value(s, -1);
+    return i < 0? nullptr: &services[i];
+}
 
-    fibLocker.lock();
+const fibSnapshot::entry *fibSnapshot::findService(uint32_t SId) const {
+    int i = serviceBySId.value(SId, -1);
+    return i < 0? nullptr: &services[i];
+}
+
+const fibSnapshot::entry *fibSnapshot::findService(uint32_t SId, int SCIds) const {
+    int i = serviceBySCIds.value(key(SId, SCIds), -1);
+    return i < 0? nullptr: &services[i];
+}
+
+//	as findServiceComponent, the service has to be known
+const serviceComponentDescriptor *fibSnapshot::findComponent(uint32_t SId,
+							     int SCIds) const {
+    if (!serviceBySId.contains(SId))
+        return nullptr;
+    int i = componentBySCIds.value(key(SId, SCIds), -1);
+    return i < 0? nullptr: &components[i];
+}
+
+const serviceComponentDescriptor *fibSnapshot::findComponent(uint16_t SCId) const {
+    int i = componentBySCId.value(SCId, -1);
+    return i < 0? nullptr: &components[i];
+}
+
+const serviceComponentDescriptor *fibSnapshot::findSubChannelComponent(int16_t subChId) const {
+    int i = componentBySubChId.value(subChId, -1);
+    return i < 0? nullptr: &components[i];
+}
+
+//	GUI side lookups, these only ever look at the snapshot
+
+int fibDecoder::getSubChId(const QString &s, uint32_t req_SId) {
+    std::shared_ptr<const fibSnapshot> snap = std::atomic_load(&snapshot);
+    const fibSnapshot::entry *S = snap->findService(s);
+
+    // FIXME return good error
+    if (S == nullptr)
+	return 2000;
+
+    const serviceComponentDescriptor *c = snap->findComponent(S->SId, S->SCIds);
 
-    int SId = ensemble->services[serviceIndex].SId;
-    int SCIds = ensemble->services[serviceIndex].SCIds;
+    // FIXME return good error
+    if (c == nullptr || req_SId != S->SId)
+        return 2000;
+    return c->subchannelId;
+}
+
+void fibDecoder::dataforAudioService(const QString &s, audiodata *ad) {
+    std::shared_ptr<const fibSnapshot> snap = std::atomic_load(&snapshot);
+    const fibSnapshot::entry *S = snap->findService(s);
 
-    int compIndex = findServiceComponent(currentConfig, SId, SCIds);
-    if (compIndex == -1) {
-        fibLocker.unlock();
+    ad->defined = false; // default
+    if (S == nullptr)
         return;
-    }
 
-    if (currentConfig->serviceComps[compIndex].TMid != 0) {
-        fibLocker.unlock();
+    const serviceComponentDescriptor *c = snap->findComponent(S->SId, S->SCIds);
+    if (c == nullptr || c->TMid != 0)
         return;
-    }
 
-    int subChId = currentConfig->serviceComps[compIndex].subchannelId;
-    if (!currentConfig->subChannels[subChId].inUse) {
-        fibLocker.unlock();
+    int subChId = c->subchannelId;
+    const subChannelDescriptor &sc = snap->subChannels[subChId];
+    if (!sc.inUse)
         return;
-    }
 
-    ad->SId = SId;
-    ad->SCIds = SCIds;
+    ad->SId = S->SId;
+    ad->SCIds = S->SCIds;
     ad->subchId = subChId;
     ad->serviceName = s;
-    ad->startAddr = currentConfig->subChannels[subChId].startAddr;
-    ad->shortForm = currentConfig->subChannels[subChId].shortForm;
-    ad->protLevel = currentConfig->subChannels[subChId].protLevel;
-    ad->length = currentConfig->subChannels[subChId].Length;
-    ad->bitRate = currentConfig->subChannels[subChId].bitRate;
-    ad->ASCTy = currentConfig->serviceComps[compIndex].ASCTy;
-    ad->language = ensemble->services[serviceIndex].language;
-    ad->programType = ensemble->services[serviceIndex].programType;
-    ad->fmFrequency = ensemble->services[serviceIndex].fmFrequency;
+    ad->startAddr = sc.startAddr;
+    ad->shortForm = sc.shortForm;
+    ad->protLevel = sc.protLevel;
+    ad->length = sc.Length;
+    ad->bitRate = sc.bitRate;
+    ad->ASCTy = c->ASCTy;
+    ad->language = S->language;
+    ad->programType = S->programType;
+    ad->fmFrequency = S->fmFrequency;
     ad->defined = true;
-
-    fibLocker.unlock();
 }
 
 void fibDecoder::dataforPacketService(const QString &s, packetdata *pd,
                                       int16_t SCIds) {
-    int serviceIndex;
+    std::shared_ptr<const fibSnapshot> snap = std::atomic_load(&snapshot);
+    const fibSnapshot::entry *S = snap->findService(s);
 
     pd->defined = false;
-    serviceIndex = findService(s);
-    if (serviceIndex == -1)
+    if (S == nullptr)
         return;
 
-    fibLocker.lock();
-
-    int SId = ensemble->services[serviceIndex].SId;
-
-    int compIndex = findServiceComponent(currentConfig, SId, SCIds);
-
-    if ((compIndex == -1) ||
-        (currentConfig->serviceComps[compIndex].TMid != 3)) {
-        fibLocker.unlock();
+    const serviceComponentDescriptor *c = snap->findComponent(S->SId, SCIds);
+    if (c == nullptr || c->TMid != 3)
         return;
-    }
 
-    int subchId = currentConfig->serviceComps[compIndex].subchannelId;
-    if (!currentConfig->subChannels[subchId].inUse) {
-        fibLocker.unlock();
+    int subchId = c->subchannelId;
+    const subChannelDescriptor &sc = snap->subChannels[subchId];
+    if (!sc.inUse)
         return;
-    }
 
     pd->serviceName = s;
-    pd->SId = SId;
+    pd->SId = S->SId;
     pd->SCIds = SCIds;
     pd->subchId = subchId;
-    pd->startAddr = currentConfig->subChannels[subchId].startAddr;
-    pd->shortForm = currentConfig->subChannels[subchId].shortForm;
-    pd->protLevel = currentConfig->subChannels[subchId].protLevel;
-    pd->length = currentConfig->subChannels[subchId].Length;
-    pd->bitRate = currentConfig->subChannels[subchId].bitRate;
-    pd->FEC_scheme = currentConfig->subChannels[subchId].FEC_scheme;
-    pd->DSCTy = currentConfig->serviceComps[compIndex].DSCTy;
-    pd->DGflag = currentConfig->serviceComps[compIndex].DGflag;
-    pd->packetAddress = currentConfig->serviceComps[compIndex].packetAddress;
-    pd->compnr = currentConfig->serviceComps[compIndex].componentNr;
-    pd->appType = currentConfig->serviceComps[compIndex].appType;
+    pd->startAddr = sc.startAddr;
+    pd->shortForm = sc.shortForm;
+    pd->protLevel = sc.protLevel;
+    pd->length = sc.Length;
+    pd->bitRate = sc.bitRate;
+    pd->FEC_scheme = sc.FEC_scheme;
+    pd->DSCTy = c->DSCTy;
+    pd->DGflag = c->DGflag;
+    pd->packetAddress = c->packetAddress;
+    pd->compnr = c->componentNr;
+    pd->appType = c->appType;
     pd->defined = true;
-
-    fibLocker.unlock();
 }
 
 std::vector<serviceId> fibDecoder::getServices(int order) {
+    std::shared_ptr<const fibSnapshot> snap = std::atomic_load(&snapshot);
     std::vector<serviceId> services;
 
-    for (int i = 0; i < ensemble->count; i++)
-        if (ensemble->services[i].inUse && // FIXME
-            ensemble->services[i].hasName) {
+    for (const auto &S: snap->services)
+        if (S.hasName) {
             serviceId ed;
-            ed.name = ensemble->services[i].serviceLabel;
-            ed.SId = ensemble->services[i].SId;
+            ed.name = S.serviceLabel;
+            ed.SId = S.SId;
 
             services = insert(services, ed, order);
         }
@@ -1449,37 +1633,40 @@ std::vector<serviceId> fibDecoder::insert(std::vector<serviceId> l, serviceId n,
 }
 
 QString fibDecoder::findService(uint32_t SId, int SCIds) {
-    QString result;
-    for (int i = 0; i < ensemble->count; i++)
-        if (ensemble->services[i].inUse && // FIXME
-            (ensemble->services[i].SId == SId) &&
-            (ensemble->services[i].SCIds == SCIds))
-            return ensemble->services[i].serviceLabel;
-    return "";
+    std::shared_ptr<const fibSnapshot> snap = std::atomic_load(&snapshot);
+    const fibSnapshot::entry *S = snap->findService(SId, SCIds);
+
+    return S == nullptr? "": S->serviceLabel;
 }
 
 void fibDecoder::getParameters(const QString &s, uint32_t *p_SId,
                                int *p_SCIds) {
-    int serviceIndex = findService(s);
-    if (serviceIndex == -1) {
+    std::shared_ptr<const fibSnapshot> snap = std::atomic_load(&snapshot);
+    const fibSnapshot::entry *S = snap->findService(s);
+
+    if (S == nullptr) {
         *p_SId = 0;
         *p_SCIds = 0;
     } else {
-        *p_SId = ensemble->services[serviceIndex].SId;
-        *p_SCIds = ensemble->services[serviceIndex].SCIds;
+        *p_SId = S->SId;
+        *p_SCIds = S->SCIds;
     }
 }
 
 int32_t fibDecoder::get_ensembleId() {
-    if (ensemble->namePresent)
-        return ensemble->ensembleId;
+    std::shared_ptr<const fibSnapshot> snap = std::atomic_load(&snapshot);
+
+    if (snap->namePresent)
+        return snap->ensembleId;
     else
         return 0;
 }
 
 QString fibDecoder::get_ensembleName() {
-    if (ensemble->namePresent)
-        return ensemble->ensembleName;
+    std::shared_ptr<const fibSnapshot> snap = std::atomic_load(&snapshot);
+
+    if (snap->namePresent)
+        return snap->ensembleName;
     else
         return " ";
 }
@@ -1487,8 +1674,10 @@ QString fibDecoder::get_ensembleName() {
 int32_t fibDecoder::get_CIFcount() { return CIFcount; }
 
 uint8_t fibDecoder::get_ecc() {
-    if (ensemble->ecc_Present)
-        return ensemble->ecc_byte;
+    std::shared_ptr<const fibSnapshot> snap = std::atomic_load(&snapshot);
+
+    if (snap->ecc_Present)
+        return snap->ecc_byte;
     return 0;
 }
 
@@ -1498,18 +1687,19 @@ void fibDecoder::FIG0Extension9(uint8_t *d) {
     uint8_t ecc;
 
     //	6 indicates the number of hours
-    int signbit = getBits_1(d, offset + 2);
-    dateTime[6] = (signbit == 1) ? -1 * getBits_4(d, offset + 3)
-                                 : getBits_4(d, offset + 3);
+    int signbit = getPackedBits(d, offset + 2, 1);
+    dateTime[6] = (signbit == 1) ? -1 * getPackedBits(d, offset + 3, 4)
+                                 : getPackedBits(d, offset + 3, 4);
 
     //	7 indicates a possible remaining half our
-    dateTime[7] = (getBits_1(d, offset + 7) == 1) ? 30 : 0;
+    dateTime[7] = (getPackedBits(d, offset + 7, 1) == 1) ? 30 : 0;
     if (signbit == 1)
         dateTime[7] = -dateTime[7];
-    ecc = getBits(d, offset + 8, 8);
+    ecc = getPackedBits(d, offset + 8, 8);
     if (!ensemble->ecc_Present) {
         ensemble->ecc_byte = ecc;
         ensemble->ecc_Present = true;
+        snapshotChanged = true;
     }
 }
 
@@ -1570,7 +1760,7 @@ void adjustTime(int32_t *dateTime) {
 //	Michael Hoehn
 void fibDecoder::FIG0Extension10(uint8_t *dd) {
     int16_t offset = 16;
-    int32_t mjd = getLBits(dd, offset + 1, 17);
+    int32_t mjd = getPackedLBits(dd, offset + 1, 17);
     //	Modified Julian Date (recompute according to wikipedia)
     int32_t J = mjd + 2400001;
     int32_t j = J + 32044;
@@ -1593,14 +1783,14 @@ void fibDecoder::FIG0Extension10(uint8_t *dd) {
     theTime[0] = Y;                          // Year
     theTime[1] = M;                          // Month
     theTime[2] = D;                          // Day
-    theTime[3] = getBits_5(dd, offset + 21); // Hours
-    theTime[4] = getBits_6(dd, offset + 26); // Minutes
+    theTime[3] = getPackedBits(dd, offset + 21, 5); // Hours
+    theTime[4] = getPackedBits(dd, offset + 26, 6); // Minutes
 
-    if (getBits_6(dd, offset + 26) != dateTime[4])
+    if (getPackedBits(dd, offset + 26, 6) != dateTime[4])
         theTime[5] = 0; // Seconds (Ubergang abfangen)
 
-    if (dd[offset + 20] == 1)
-        theTime[5] = getBits_6(dd, offset + 32); // Seconds
+    if (getPackedBits(dd, offset + 20, 1) == 1)
+        theTime[5] = getPackedBits(dd, offset + 32, 6); // Seconds
 
     //	take care of different time zones
     bool change = false;
@@ -1619,61 +1809,56 @@ void fibDecoder::FIG0Extension10(uint8_t *dd) {
     }
 }
 
+//	The epg data lives in the ensemble proper, which the fic thread
+//	keeps changing, hence the lock
 void fibDecoder::set_epgData(uint32_t SId, int32_t theTime,
                              const QString theText) {
-    for (int i = 0; i < ensemble->count; i++) {
-        if (ensemble->services[i].inUse && // FIXME
-            ensemble->services[i].SId == SId) {
-            service *S = &(ensemble->services[i]);
-            for (uint16_t j = 0; j < S->epgData.size(); j++) {
-                if (S->epgData.at(j).theTime == theTime) {
-                    S->epgData.at(j).theText = theText;
-                    return;
-                }
+    fibLocker.lock();
+    int index = findService(SId);
+    if (index != -1) {
+        service *S = &(ensemble->services[index]);
+        bool found = false;
+        for (uint16_t j = 0; j < S->epgData.size(); j++) {
+            if (S->epgData.at(j).theTime == theTime) {
+                S->epgData.at(j).theText = theText;
+                found = true;
+                break;
             }
+        }
+        if (!found) {
             epgElement ep;
             ep.theTime = theTime;
             ep.theText = theText;
             S->epgData.push_back(ep);
-            return;
         }
     }
+    fibLocker.unlock();
 }
 
 std::vector<epgElement> fibDecoder::get_timeTable(uint32_t SId) {
     std::vector<epgElement> res;
+    fibLocker.lock();
     int index = findService(SId);
-    if (index == -1)
-        return res;
-    return ensemble->services[index].epgData;
+    if (index != -1)
+        res = ensemble->services[index].epgData;
+    fibLocker.unlock();
+    return res;
 }
 
 std::vector<epgElement> fibDecoder::get_timeTable(const QString &service) {
     std::vector<epgElement> res;
+    fibLocker.lock();
     int index = findService(service);
-    if (index == -1)
-        return res;
-    return ensemble->services[index].epgData;
+    if (index != -1)
+        res = ensemble->services[index].epgData;
+    fibLocker.unlock();
+    return res;
 }
 
 bool fibDecoder::has_timeTable(uint32_t SId) {
-    int index = findService(SId);
-    std::vector<epgElement> t;
-    if (index == -1)
-        return false;
-    t = ensemble->services[index].epgData;
-    return t.size() > 2;
+    return get_timeTable(SId).size() > 2;
 }
 
 std::vector<epgElement> fibDecoder::find_epgData(uint32_t SId) {
-    int index = findService(SId);
-    std::vector<epgElement> res;
-
-    if (index == -1)
-        return res;
-
-    service *s = &(ensemble->services[index]);
-
-    res = s->epgData;
-    return res;
+    return get_timeTable(SId);
 }
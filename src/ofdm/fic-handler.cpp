@@ -30,6 +30,7 @@
 #include "logging.h"
 #include "protTables.h"
 #include "radio.h"
+#include "telemetry.h"
 
 //	The 3072 bits of the serial motherword shall be split into
 //	24 blocks of 128 bits each.
@@ -61,6 +62,7 @@ ficHandler::ficHandler(RadioInterface *mr, dabParams *params)
     ficBlocks = 0;
     ficMissed = 0;
     ficRatio = 0;
+    memset(fibBuffer, 0, sizeof(fibBuffer));
 
     for (i = 0; i < 768; i++) {
         PRBS[i] = shiftRegister[8] ^ shiftRegister[4];
@@ -171,7 +173,9 @@ void ficHandler::process_ficInput(int16_t ficno) {
      *	Now we have the full word ready for deconvolution
      *	deconvolution is according to DAB standard section 11.2
      */
+    int64_t viterbiStart = telemetryStart();
     myViterbi.deconvolve(viterbiBlock, bitBuffer_out);
+    telemetryStop(TEL_FIC_VITERBI, viterbiStart);
     /**
      *	if everything worked as planned, we now have a
      *	768 bit vector containing three FIB's
@@ -190,10 +194,13 @@ void ficHandler::process_ficInput(int16_t ficno) {
      *	was lost.
      */
 
+    //	the fib decoder works on bytes from here on
+    packBits(bitBuffer_out, fibBuffer, 3 * 32);
     for (i = ficno * 3; i < ficno * 3 + 3; i++) {
-        uint8_t *p = &bitBuffer_out[(i % 3) * 256];
-        if (!check_CRC_bits(p, 256)) {
+        uint8_t *p = &fibBuffer[(i % 3) * 32];
+        if (!check_crc_bytes(p, 30)) {
             emit showFicSuccess(false);
+            telemetryCount(TEL_FIC_CRC_ERRORS);
             continue;
         }
 
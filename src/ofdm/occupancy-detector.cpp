@@ -0,0 +1,82 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, version 2 of the License.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "occupancy-detector.h"
+#include <algorithm>
+
+occupancyDetector::occupancyDetector(uint8_t dabMode)
+    : params(dabMode), my_fftHandler(dabMode) {
+    T_u = params.get_T_u();
+    carriers = params.get_carriers();
+    fft_buffer = my_fftHandler.getVector();
+    power.resize(T_u);
+}
+
+occupancyDetector::~occupancyDetector() {}
+
+int32_t occupancyDetector::samplesNeeded() {
+    return INPUT_RATE / 1000 * PLATEAU_TIME;
+}
+
+static float percentile(std::vector<float> &v, int p) {
+    if (v.empty())
+        return 0;
+    std::nth_element(v.begin(), v.begin() + v.size() * p / 100, v.end());
+    return v[v.size() * p / 100];
+}
+
+//	the power of a low percentile of the carrier bins, so that a few
+//	strong spurs don't make a plateau, over the median of the bins
+//	between the ensemble and its neighbours. Each side of the gap is
+//	taken on its own, and the quieter one wins, as a strong adjacent
+//	ensemble spills into its side and would lift the floor enough to
+//	hide an occupied channel. Noise gives about 1
+float occupancyDetector::plateauLevel(const std::complex<float> *v,
+                                      int32_t n) {
+    int32_t blocks = n / T_u;
+    std::vector<float> plateau;
+    std::vector<float> upper;
+    std::vector<float> lower;
+
+    if (blocks < 1)
+        return 0;
+    std::fill(power.begin(), power.end(), 0);
+    for (int32_t b = 0; b < blocks; b++) {
+        std::copy(v + b * T_u, v + (b + 1) * T_u, fft_buffer);
+        my_fftHandler.do_FFT();
+        for (int16_t i = 0; i < T_u; i++)
+            power[i] += std::norm(fft_buffer[i]);
+    }
+
+    //	negative frequencies are at the top
+    for (int16_t k = PLATEAU_DC; k <= carriers / 2; k++) {
+        plateau.push_back(power[k]);
+        plateau.push_back(power[T_u - k]);
+    }
+    for (int16_t k = PLATEAU_NOISE_LOW * T_u / 2048;
+         k < PLATEAU_NOISE_HIGH * T_u / 2048 && k < T_u / 2; k++) {
+        upper.push_back(power[k]);
+        lower.push_back(power[T_u - k]);
+    }
+    float floor = std::min(percentile(upper, 50), percentile(lower, 50));
+    if (floor <= 0)
+        return 0;
+    return percentile(plateau, 20) / floor;
+}
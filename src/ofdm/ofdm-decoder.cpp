@@ -31,6 +31,7 @@
 #include "msc-handler.h"
 #include "phasetable.h"
 #include "radio.h"
+#include "telemetry.h"
 #include <vector>
 
 /*
@@ -64,7 +65,9 @@ void ofdmDecoder::reset() {}
 void ofdmDecoder::processBlock_0(std::vector<std::complex<float>> buffer) {
     memcpy(fft_buffer, buffer.data(), T_u * sizeof(std::complex<float>));
 
+    int64_t fftStart = telemetryStart();
     my_fftHandler.do_FFT();
+    telemetryStop(TEL_FFT, fftStart);
     /*
      *	we are now in the frequency domain, and we keep the carriers
      *	as coming from the FFT as phase reference.
@@ -127,7 +130,10 @@ void ofdmDecoder::decode(std::vector<std::complex<float>> *buffer, int32_t blkno
     /**
      *	first step: do the FFT
      */
+    int64_t stageStart = telemetryStart();
     my_fftHandler.do_FFT();
+    telemetryStop(TEL_FFT, stageStart);
+    stageStart = telemetryStart();
     /**
      *	a little optimization: we do not interchange the
      *	positive/negative frequencies to their right positions.
@@ -157,6 +163,7 @@ void ofdmDecoder::decode(std::vector<std::complex<float>> *buffer, int32_t blkno
         ibits[i] = -real(r1) / ab1 * 127.0;
         ibits[carriers + i] = -imag(r1) / ab1 * 127.0;
     }
+    telemetryStop(TEL_DEMAP, stageStart);
 
     //	From time to time we show the constellation of symbol 2.
 
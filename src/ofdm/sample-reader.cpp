@@ -25,6 +25,9 @@
  */
 #include "sample-reader.h"
 #include "radio.h"
+#include "telemetry.h"
+#include "agc-controller.h"
+#include "sample-convert.h"
 
 static inline int16_t valueFor(int16_t b) {
     int16_t res = 1;
@@ -35,7 +38,13 @@ static inline int16_t valueFor(int16_t b) {
 
 static std::complex<float> oscillatorTable[INPUT_RATE];
 
-sampleReader::sampleReader(RadioInterface *mr, deviceHandler *theRig) {
+//	the agc only wants blocks, the single samples read while looking
+//	for sync are gathered up to this
+#define AGC_BLOCK 2048
+
+//	the dump writer buffers about a second of samples
+sampleReader::sampleReader(RadioInterface *mr, deviceHandler *theRig):
+    dumpWriter(false, 2, 65536, 32) {
     int i;
     this->theRig = theRig;
     this->myRadioInterface = mr;
@@ -51,9 +60,9 @@ sampleReader::sampleReader(RadioInterface *mr, deviceHandler *theRig) {
 
     bufferContent = 0;
     corrector = 0;
-    dumpfilePointer.store(nullptr);
-    dumpIndex = 0;
     dumpScale = valueFor(theRig->bitDepth());
+    resetAgcStats(&agcPending);
+    agcAmount = 0;
     running.store(true);
 }
 
@@ -66,15 +75,26 @@ void sampleReader::reset(void) {
     sampleCount = 0;
     bufferContent = 0;
     corrector = 0;
-    dumpfilePointer.store(nullptr);
-    dumpIndex = 0;
+    dumpWriter.stopWriting();
     dumpScale = valueFor(theRig->bitDepth());
+    resetAgcStats(&agcPending);
+    agcAmount = 0;
 }
 
 void sampleReader::setRunning(bool b) { running.store(b); }
 
 float sampleReader::get_sLevel() { return sLevel; }
 
+void sampleReader::agcUpdate(const agcStats *stats, int32_t n) {
+    mergeAgcStats(&agcPending, stats);
+    agcAmount += n;
+    if (agcAmount < AGC_BLOCK)
+        return;
+    theRig->agcControl()->update(&agcPending, agcAmount);
+    resetAgcStats(&agcPending);
+    agcAmount = 0;
+}
+
 std::complex<float> sampleReader::getSample(int32_t phaseOffset) {
     std::complex<float> temp;
 
@@ -84,6 +104,8 @@ std::complex<float> sampleReader::getSample(int32_t phaseOffset) {
 
     ///	bufferContent is an indicator for the value of ... -> Samples()
     if (bufferContent == 0) {
+        telemetryTimer waiting(TEL_SAMPLE_WAIT);
+
         bufferContent = theRig->Samples();
         while ((bufferContent <= 2048) && running.load()) {
             usleep(10);
@@ -97,15 +119,14 @@ std::complex<float> sampleReader::getSample(int32_t phaseOffset) {
     //	so here, bufferContent > 0
     agcStats stats;
     int32_t n = theRig->getSamples(&temp, 1, &stats);
-    myRadioInterface->processGain(&stats, n);
+    agcUpdate(&stats, n);
     bufferContent--;
-    if (dumpfilePointer.load() != nullptr) {
-        dumpBuffer[2 * dumpIndex] = real(temp) * dumpScale;
-        dumpBuffer[2 * dumpIndex + 1] = imag(temp) * dumpScale;
-        if (++dumpIndex >= DUMPSIZE / 2) {
-            sf_writef_short(dumpfilePointer.load(), dumpBuffer, dumpIndex);
-            dumpIndex = 0;
-        }
+    if (dumpWriter.isWriting()) {
+        int16_t dumpBuffer[2];
+
+        dumpBuffer[0] = real(temp) * dumpScale;
+        dumpBuffer[1] = imag(temp) * dumpScale;
+        dumpWriter.write(dumpBuffer, 1);
     }
 
     if (localCounter < bufferSize)
@@ -135,6 +156,8 @@ void sampleReader::getSamples(std::complex<float> *v, int32_t n,
     if (!running.load())
         throw 21;
     if (n > bufferContent) {
+        telemetryTimer waiting(TEL_SAMPLE_WAIT);
+
         bufferContent = theRig->Samples();
         while ((bufferContent < n) && running.load()) {
             usleep(10);
@@ -148,17 +171,16 @@ void sampleReader::getSamples(std::complex<float> *v, int32_t n,
     //	so here, bufferContent >= n
     agcStats stats;
     n = theRig->getSamples(v, n, &stats);
-    myRadioInterface->processGain(&stats, n);
+    agcUpdate(&stats, n);
     bufferContent -= n;
-    if (dumpfilePointer.load() != nullptr) {
+    if (dumpWriter.isWriting()) {
+        _VLA(int16_t, dumpBuffer, 2 * n);
+
         for (i = 0; i < n; i++) {
-            dumpBuffer[2 * dumpIndex] = real(v[i]) * dumpScale;
-            dumpBuffer[2 * dumpIndex + 1] = imag(v[i]) * dumpScale;
-            if (++dumpIndex >= DUMPSIZE / 2) {
-                sf_writef_short(dumpfilePointer.load(), dumpBuffer, dumpIndex);
-                dumpIndex = 0;
-            }
+            dumpBuffer[2 * i] = real(v[i]) * dumpScale;
+            dumpBuffer[2 * i + 1] = imag(v[i]) * dumpScale;
         }
+        dumpWriter.write(dumpBuffer, n);
     }
 
     //	OK, we have samples!!
@@ -182,6 +204,6 @@ void sampleReader::getSamples(std::complex<float> *v, int32_t n,
     }
 }
 
-void sampleReader::startDumping(SNDFILE *f) { dumpfilePointer.store(f); }
+void sampleReader::startDumping(SNDFILE *f) { dumpWriter.startWriting(f); }
 
-void sampleReader::stopDumping() { dumpfilePointer.store(nullptr); }
+void sampleReader::stopDumping() { dumpWriter.stopWriting(); }
@@ -26,6 +26,7 @@
 #include "timesyncer.h"
 #include "math-helper.h"
 #include "sample-reader.h"
+#include <vector>
 
 #define C_LEVEL_SIZE 50
 
@@ -49,7 +50,7 @@ int timeSyncer::sync(int T_null, int T_F) {
     }
     // SyncOnNull:
     counter = 0;
-    while (cLevel / C_LEVEL_SIZE > 0.55 * myReader->get_sLevel()) {
+    while (cLevel / C_LEVEL_SIZE > SYNC_DIP_LEVEL * myReader->get_sLevel()) {
         std::complex<float> sample = myReader->getSample(0);
         //	         myReader. getSample (coarseOffset + fineCorrector);
         envBuffer[syncBufferIndex] = fastMagnitude(sample);
@@ -68,7 +69,7 @@ int timeSyncer::sync(int T_null, int T_F) {
      */
     counter = 0;
     // SyncOnEndNull:
-    while (cLevel / C_LEVEL_SIZE < 0.75 * myReader->get_sLevel()) {
+    while (cLevel / C_LEVEL_SIZE < SYNC_END_LEVEL * myReader->get_sLevel()) {
         std::complex<float> sample = myReader->getSample(0);
         envBuffer[syncBufferIndex] = fastMagnitude(sample);
         //      update the levels
@@ -83,3 +84,42 @@ int timeSyncer::sync(int T_null, int T_F) {
 
     return TIMESYNC_ESTABLISHED;
 }
+
+/*
+ *	Early reject for the band scan.
+ *	The envelope of a few frames is folded over the frame length, so
+ *	that the null periods pile up on each other, and the lowest average
+ *	over half a null period is compared with the overall average.
+ *	Noise stays close to 1, while anything sync() would lock on goes
+ *	below SYNC_DIP_LEVEL.
+ */
+float timeSyncer::nullLevel(const std::complex<float> *v, int32_t n,
+			    int32_t T_null, int32_t T_F) {
+    int32_t frames = n / T_F;
+    int32_t window = T_null / 2;
+    std::vector<float> folded(T_F, 0);
+    double total = 0;
+    double level = 0;
+    double minLevel;
+
+    if (frames < 1 || window < 1)
+	return 1;
+    for (int32_t f = 0; f < frames; f++)
+	for (int32_t i = 0; i < T_F; i++)
+	    folded[i] += fastMagnitude(v[f * T_F + i]);
+    for (int32_t i = 0; i < T_F; i++)
+	total += folded[i];
+    if (total <= 0)
+	return 1;
+
+    //	the window wraps around, the null may well straddle the fold
+    for (int32_t i = 0; i < window; i++)
+	level += folded[i];
+    minLevel = level;
+    for (int32_t i = 0; i < T_F; i++) {
+	level += folded[(i + window) % T_F] - folded[i];
+	if (level < minLevel)
+	    minLevel = level;
+    }
+    return (minLevel / window) / (total / T_F);
+}
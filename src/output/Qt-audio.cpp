@@ -32,6 +32,7 @@
 #include <QMediaDevices>
 #endif
 #include "logging.h"
+#include "telemetry.h"
 
 Qt_Audio::Qt_Audio(void) {
     Buffer = new RingBuffer<float>(8 * 32768);
@@ -56,7 +57,11 @@ Qt_Audio::~Qt_Audio(void) {
 // converted.  This functions overrides the one in audioBase
 void Qt_Audio::audioOutput(float* fragment, int32_t size) {
     if (theAudioDevice != nullptr) {
-        Buffer->putDataIntoBuffer(fragment, 2 * size);
+        int32_t written = Buffer->putDataIntoBuffer(fragment, 2 * size);
+
+        if (written < 2 * size)
+            telemetryCount(TEL_AUDIO_OVERRUN, 2 * size - written);
+        telemetrySetGauge(TEL_AUDIO_FILL, Buffer->GetRingBufferReadAvailable() * 1000LL / (8 * 32768));
     }
 }
 
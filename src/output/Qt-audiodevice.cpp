@@ -24,6 +24,7 @@
  *    Lazy Chair Computing
  */
 #include "Qt-audiodevice.h"
+#include "telemetry.h"
 
 // Create a "device"
 Qt_AudioDevice::Qt_AudioDevice(RingBuffer<float>* Buffer,
@@ -54,6 +55,7 @@ qint64 Qt_AudioDevice::readData(char* buffer, qint64 maxSize) {
 
     if (amount >= 0 && amount * ((int) sizeof(float)) < maxSize) {
         qint64 i;
+        telemetryCount(TEL_AUDIO_UNDERRUN, maxSize / sizeof(float) - amount);
         for (i = amount * sizeof(float); i < maxSize; i++)
             buffer[i] = 0;
     }
@@ -37,8 +37,8 @@
 audioBase::audioBase():
     converter_16(16000, 48000, 2 * 1600),
     converter_24(24000, 48000, 2 * 2400),
-    converter_32(32000, 48000, 2 * 3200) {
-    dumpFile = nullptr;
+    converter_32(32000, 48000, 2 * 3200),
+    dumpWriter(true, 2, 8192, 32) {
 }
 
 int32_t audioBase::putSample(DSPCOMPLEX v) {
@@ -54,11 +54,7 @@ int32_t audioBase::putSamples(DSPCOMPLEX* V, int32_t amount) {
         buffer[2 * i + 1] = imag(V[i]);
     }
 
-    myLocker.lock();
-    if (dumpFile != nullptr)
-        sf_writef_float(dumpFile, (float*)buffer, amount);
-    myLocker.unlock();
-    audioOutput(buffer, amount);
+    dumpAndOutput(buffer, amount);
     return amount;
 }
 
@@ -69,13 +65,13 @@ void audioBase::audioOut(int16_t* V, int32_t amount, int32_t rate) {
 
     switch (rate) {
     case 16000:
-        audioOut_16000(V, amount / 2);
+        audioOut_convert(&converter_16, V, amount / 2);
         return;
     case 24000:
-        audioOut_24000(V, amount / 2);
+        audioOut_convert(&converter_24, V, amount / 2);
         return;
     case 32000:
-        audioOut_32000(V, amount / 2);
+        audioOut_convert(&converter_32, V, amount / 2);
         return;
     default:
     case 48000:
@@ -84,112 +80,46 @@ void audioBase::audioOut(int16_t* V, int32_t amount, int32_t rate) {
     }
 }
 
-// scale up from 16 -> 48
+// scale up to 48000, the whole frame in one go
 // amount gives number of pairs
-void audioBase::audioOut_16000(int16_t* V, int32_t amount) {
-    _VLA(std::complex<float>, outputBuffer, converter_16.getOutputsize());
-    _VLA(float, buffer, 2 * converter_16.getOutputsize());
-    int16_t i, j;
+void audioBase::audioOut_convert(newConverter* converter, int16_t* V, int32_t amount) {
+    float* buffer = (float*)alloca(2 * amount * sizeof(float));
+    _VLA(float, outputBuffer, 2 * converter->getOutputsize(amount));
+    int32_t i;
     int32_t result;
 
-    for (i = 0; i < amount; i++)
-        if (converter_16.convert(std::complex<float>(V[2 * i] / 32767.0,
-                                     V[2 * i + 1] / 32767.0),
-                outputBuffer, &result)) {
-            for (j = 0; j < result; j++) {
-                buffer[2 * j] = real(outputBuffer[j]);
-                buffer[2 * j + 1] = imag(outputBuffer[j]);
-            }
-
-            myLocker.lock();
-            if (dumpFile != nullptr)
-                sf_writef_float(dumpFile, (float*)buffer, result);
-            myLocker.unlock();
-
-            audioOutput(buffer, result);
-        }
-}
+    for (i = 0; i < 2 * amount; i++)
+        buffer[i] = V[i] / 32767.0;
 
-// scale up from 24000 -> 48000
-// amount gives number of pairs
-void audioBase::audioOut_24000(int16_t* V, int32_t amount) {
-    _VLA(std::complex<float>, outputBuffer, converter_24.getOutputsize());
-    _VLA(float, buffer, 2 * converter_24.getOutputsize());
-    int16_t i, j;
-    int32_t result;
-
-    for (i = 0; i < amount; i++)
-        if (converter_24.convert(std::complex<float>(V[2 * i] / 32767.0,
-                                     V[2 * i + 1] / 32767.0),
-                outputBuffer, &result)) {
-            for (j = 0; j < result; j++) {
-                buffer[2 * j] = real(outputBuffer[j]);
-                buffer[2 * j + 1] = imag(outputBuffer[j]);
-            }
-
-            myLocker.lock();
-            if (dumpFile != nullptr)
-                sf_writef_float(dumpFile, (float*)buffer, result);
-            myLocker.unlock();
-
-            audioOutput(buffer, result);
-        }
-}
-
-// scale up from 32000 -> 48000
-// amount is number of pairs
-void audioBase::audioOut_32000(int16_t* V, int32_t amount) {
-    _VLA(std::complex<float>, outputBuffer, converter_32.getOutputsize());
-    _VLA(float, buffer, 2 * converter_32.getOutputsize());
-    int32_t i, j;
-    int32_t result;
-
-    for (i = 0; i < amount; i++) {
-        if (converter_32.convert(std::complex<float>(V[2 * i] / 32767.0,
-                                     V[2 * i + 1] / 32767.0),
-                outputBuffer, &result)) {
-            for (j = 0; j < result; j++) {
-                buffer[2 * j] = real(outputBuffer[j]);
-                buffer[2 * j + 1] = imag(outputBuffer[j]);
-            }
-
-            myLocker.lock();
-            if (dumpFile != nullptr)
-                sf_writef_float(dumpFile, (float*)buffer, result);
-            myLocker.unlock();
-            audioOutput(buffer, result);
-        }
-    }
+    result = converter->convert(buffer, amount, outputBuffer);
+    if (result > 0)
+        dumpAndOutput(outputBuffer, result);
 }
 
 void audioBase::audioOut_48000(int16_t* V, int32_t amount) {
     float* buffer = (float*)alloca(2 * amount * sizeof(float));
     int32_t i;
 
-    for (i = 0; i < amount; i++) {
-        buffer[2 * i] = V[2 * i] / 32767.0;
-        buffer[2 * i + 1] = V[2 * i + 1] / 32767.0;
-    }
+    for (i = 0; i < 2 * amount; i++)
+        buffer[i] = V[i] / 32767.0;
+
+    dumpAndOutput(buffer, amount);
+}
 
-    myLocker.lock();
-    if (dumpFile != nullptr)
-        sf_writef_float(dumpFile, (float*)buffer, amount);
-    myLocker.unlock();
+// the writer thread does the encoding, here we only copy
+void audioBase::dumpAndOutput(float* buffer, int32_t amount) {
+    dumpWriter.write(buffer, amount);
     audioOutput(buffer, amount);
 }
 
-// we ensure that no one is fiddling with the dumpfile
-// while we are writing
+// some 5 seconds of buffering at 48000
 void audioBase::startDumping(SNDFILE* f) {
-    myLocker.lock();
-    dumpFile = f;
-    myLocker.unlock();
+    dumpWriter.startWriting(f);
 }
 
+// returns once everything is written, the file can then be closed
 void audioBase::stopDumping() {
-    myLocker.lock();
-    dumpFile = nullptr;
-    myLocker.unlock();
+    dumpWriter.stopWriting();
 }
 
 // the audioOut function is the one that really should be
@@ -26,7 +26,7 @@
 
 #include "audiosink.h"
 #include "logging.h"
-#include <QComboBox>
+#include "telemetry.h"
 #include <cstdio>
 
 audioSink::audioSink(int16_t latency): _O_Buffer(8 * 32768) {
@@ -204,6 +204,8 @@ int audioSink::paCallback_o(
         outB = &((reinterpret_cast<audioSink*>(userData))->_O_Buffer);
         actualSize = outB->getDataFromBuffer(outp, 2 * framesPerBuffer);
         theMissed += 2 * framesPerBuffer - actualSize;
+        if (actualSize < 2 * framesPerBuffer)
+            telemetryCount(TEL_AUDIO_UNDERRUN, 2 * framesPerBuffer - actualSize);
         for (i = actualSize; i < 2 * framesPerBuffer; i++)
             outp[i] = 0;
     }
@@ -215,7 +217,11 @@ void audioSink::audioOutput(float* b, int32_t amount) {
 
     for (int i = 0; i < 2 * amount; i++)
         b[i] *= volume;
-    _O_Buffer.putDataIntoBuffer(b, 2 * amount);
+    int32_t written = _O_Buffer.putDataIntoBuffer(b, 2 * amount);
+
+    if (written < 2 * amount)
+        telemetryCount(TEL_AUDIO_OVERRUN, 2 * amount - written);
+    telemetrySetGauge(TEL_AUDIO_FILL, _O_Buffer.GetRingBufferReadAvailable() * 1000LL / (8 * 32768));
 }
 
 const char* audioSink::outputChannel(int16_t ch) {
@@ -26,41 +26,81 @@
 
 #include "newconverter.h"
 #include "logging.h"
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
+
+#define CONVERTER_SLACK	10
+#define POLYPHASE_TAPS	8
+#define POLYPHASE_MAX	4
+
+static int32_t gcd(int32_t a, int32_t b) {
+    while (b != 0) {
+        int32_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
 
 newConverter::newConverter(int32_t inRate, int32_t outRate,
     int32_t inSize) {
+    int32_t g = gcd(inRate, outRate);
     int err;
+
     this->inRate = inRate;
     this->outRate = outRate;
     inputLimit = inSize;
     ratio = double(outRate) / inRate;
-    outputLimit = inSize * ratio;
+    polyUp = outRate / g;
+    polyDown = inRate / g;
+    polyPhase = 0;
+    polyphase = (polyUp > polyDown) && (polyUp <= POLYPHASE_MAX);
+    converter = nullptr;
 
-    // converter = src_new (SRC_SINC_BEST_QUALITY, 2, &err);
-    // converter = src_new (SRC_SINC_MEDIUM_QUALITY, 2, &err);
+    if (polyphase) {
+        int32_t size = polyUp * POLYPHASE_TAPS;
+        DSPFLOAT f = 0.5 / polyUp;
+        DSPFLOAT* tmp = (DSPFLOAT*)alloca(size * sizeof(DSPFLOAT));
+        DSPFLOAT sum = 0;
 
-    converter = src_new(SRC_LINEAR, 2, &err);
-    inBuffer.resize(2 * inputLimit + 20);
-    outBuffer.resize(2 * outputLimit + 20);
-    src_data.data_in = inBuffer.data();
-    src_data.data_out = outBuffer.data();
-    src_data.src_ratio = ratio;
-    src_data.end_of_input = 0;
+        // blackman windowed sinc at the input nyquist frequency,
+        // stored phase by phase, so that each output only
+        // needs POLYPHASE_TAPS contiguous coefficients
+        for (int32_t i = 0; i < size; i++) {
+            DSPFLOAT x = i - (size - 1) / 2.0;
+
+            tmp[i] = (x == 0) ? 2 * M_PI * f : sin(2 * M_PI * f * x) / x;
+            tmp[i] *= 0.42 - 0.5 * cos(2 * M_PI * i / (size - 1)) + 0.08 * cos(4 * M_PI * i / (size - 1));
+            sum += tmp[i];
+        }
+        polyKernel.resize(size);
+        for (int32_t p = 0; p < polyUp; p++)
+            for (int32_t j = 0; j < POLYPHASE_TAPS; j++)
+                polyKernel[p * POLYPHASE_TAPS + j] = tmp[p + j * polyUp] * polyUp / sum;
+        polyHistory.assign(2 * (POLYPHASE_TAPS - 1), 0);
+    } else {
+        // converter = src_new (SRC_SINC_BEST_QUALITY, 2, &err);
+        // converter = src_new (SRC_SINC_MEDIUM_QUALITY, 2, &err);
+
+        converter = src_new(SRC_LINEAR, 2, &err);
+    }
+    inBuffer.resize(2 * inputLimit);
     inp = 0;
-    log(LOG_SOUND, LOG_CHATTY, "converter created in %i out %i size %i", inRate, outRate, inSize);
+    log(LOG_SOUND, LOG_CHATTY, "converter created in %i out %i size %i%s", inRate, outRate, inSize,
+        polyphase ? " polyphase" : "");
 }
 
 newConverter::~newConverter() {
     log(LOG_SOUND, LOG_CHATTY, "converter destroyed in %i out %i size %i", inRate, outRate, inputLimit);
-    src_delete(converter);
+    if (converter != nullptr)
+        src_delete(converter);
 }
 
+// single sample interface, converts every inSize samples
+// out needs to be getOutputsize() long
 bool newConverter::convert(std::complex<float> v,
     std::complex<float>* out, int32_t* amount) {
-    int32_t i;
-    int32_t framesOut;
-    int res;
 
     inBuffer[2 * inp] = real(v);
     inBuffer[2 * inp + 1] = imag(v);
@@ -68,25 +108,93 @@ bool newConverter::convert(std::complex<float> v,
     if (inp < inputLimit)
         return false;
 
-    src_data.input_frames = inp;
-    src_data.output_frames = outputLimit + 10;
-    res = src_process(converter, &src_data);
-    if (res != 0) {
-        log(LOG_SOUND, LOG_MIN, "converter error %s", src_strerror(res));
-        return false;
-    }
     inp = 0;
-    framesOut = src_data.output_frames_gen;
-    for (i = 0; i < framesOut; i++)
-        out[i] = std::complex<float>(outBuffer[2 * i],
-            outBuffer[2 * i + 1]);
-    *amount = framesOut;
+    *amount = convert(inBuffer.data(), inputLimit, reinterpret_cast<float*>(out));
     return true;
 }
 
+// block interface: converts n frames, and returns the number of frames
+// produced, out needs to be getOutputsize(n) frames long
+int32_t newConverter::convert(const float* in, int32_t n, float* out) {
+    SRC_DATA src_data;
+    int32_t framesOut = 0;
+    int res;
+
+    if (polyphase)
+        return polyConvert(in, n, out);
+
+    src_data.data_in = const_cast<float*>(in);
+    src_data.data_out = out;
+    src_data.input_frames = n;
+    src_data.output_frames = getOutputsize(n);
+    src_data.src_ratio = ratio;
+    src_data.end_of_input = 0;
+    while (src_data.input_frames > 0) {
+        res = src_process(converter, &src_data);
+        if (res != 0) {
+            log(LOG_SOUND, LOG_MIN, "converter error %s", src_strerror(res));
+            break;
+        }
+        if (src_data.input_frames_used == 0 && src_data.output_frames_gen == 0)
+            break;
+        framesOut += src_data.output_frames_gen;
+        src_data.data_in += 2 * src_data.input_frames_used;
+        src_data.input_frames -= src_data.input_frames_used;
+        src_data.data_out += 2 * src_data.output_frames_gen;
+        src_data.output_frames -= src_data.output_frames_gen;
+    }
+    return framesOut;
+}
+
+// polyPhase is the position of the next output, in units of
+// 1 / polyUp input samples, relative to the first sample of the block
+int32_t newConverter::polyConvert(const float* in, int32_t n, float* out) {
+    int32_t history = POLYPHASE_TAPS - 1;
+    int32_t framesOut = 0;
+
+    while (polyPhase < n * polyUp) {
+        int32_t k = polyPhase / polyUp;
+        const float* kernel = &polyKernel[(polyPhase % polyUp) * POLYPHASE_TAPS];
+        float left = 0;
+        float right = 0;
+
+        for (int32_t j = 0; j < POLYPHASE_TAPS; j++) {
+            int32_t index = k - j;
+            const float* s = (index >= 0) ? &in[2 * index] : &polyHistory[2 * (history + index)];
+
+            left += kernel[j] * s[0];
+            right += kernel[j] * s[1];
+        }
+        out[2 * framesOut] = left;
+        out[2 * framesOut + 1] = right;
+        framesOut++;
+        polyPhase += polyDown;
+    }
+    polyPhase -= n * polyUp;
+
+    // keep the last few input frames for the next block
+    if (n >= history) {
+        memcpy(polyHistory.data(), &in[2 * (n - history)], 2 * history * sizeof(float));
+    } else {
+        memmove(polyHistory.data(), &polyHistory[2 * n], 2 * (history - n) * sizeof(float));
+        memcpy(&polyHistory[2 * (history - n)], in, 2 * n * sizeof(float));
+    }
+    return framesOut;
+}
+
 int32_t newConverter::getOutputsize() {
-    return outputLimit;
+    return getOutputsize(inputLimit);
+}
+
+int32_t newConverter::getOutputsize(int32_t n) {
+    return int32_t(ceil(n * ratio)) + CONVERTER_SLACK;
 }
+
+//	whatever the filters remember belongs to the previous stream
 void newConverter::reset() {
     inp = 0;
+    polyPhase = 0;
+    std::fill(polyHistory.begin(), polyHistory.end(), 0);
+    if (converter != nullptr)
+        src_reset(converter);
 }
@@ -0,0 +1,188 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "sndfile-writer.h"
+#include "logging.h"
+#include <cstring>
+
+sndfileWriter::sndfileWriter(bool floatSamples, int16_t channels,
+			     int32_t blockFrames, int16_t blockCount) {
+    this->floatSamples = floatSamples;
+    this->channels = channels;
+    this->blockFrames = blockFrames;
+    this->blockCount = blockCount;
+    frameSize = channels * (floatSamples? sizeof(float): sizeof(int16_t));
+    file = nullptr;
+    fill = 0;
+    recording.store(false);
+    producers.store(0);
+    head.store(0);
+    tail.store(0);
+    stopping.store(false);
+    writtenFrames = 0;
+    lostFrames.store(0);
+    highWater = 0;
+}
+
+sndfileWriter::~sndfileWriter(void) {
+    stopWriting();
+}
+
+//	the buffers are only allocated on first use, but well ahead
+//	of the producer needing them
+void sndfileWriter::startWriting(SNDFILE *f) {
+    stopWriting();
+    locker.lock();
+    if (blocks.size() == 0) {
+	blocks.resize((size_t) blockCount * blockFrames * frameSize);
+	blockSizes.resize(blockCount);
+    }
+    head.store(0);
+    tail.store(0);
+    stopping.store(false);
+    fill = 0;
+    writtenFrames = 0;
+    lostFrames.store(0);
+    highWater = 0;
+    file = f;
+    start();
+
+    // the producer may only look at the buffers from here on
+    recording.store(true);
+    locker.unlock();
+}
+
+//	hands over the last partial block and waits for the writer
+//	to drain the queue, so that the caller can close the file
+void sndfileWriter::stopWriting(void) {
+    locker.lock();
+    if (!recording.load()) {
+	locker.unlock();
+	return;
+    }
+
+    // once the producer is out of put, the partial block is ours
+    recording.store(false);
+    while (producers.load() > 0)
+	QThread::yieldCurrentThread();
+    if (fill > 0)
+	publish();
+    stopping.store(true);
+    published.release();
+    locker.unlock();
+    wait();
+
+    locker.lock();
+    file = nullptr;
+    int64_t lost = lostFrames.load(std::memory_order_relaxed);
+    log(LOG_SOUND, lost > 0? LOG_MIN: LOG_CHATTY,
+	"recording stopped: %lli frames written, %lli dropped, queue peak %u of %i blocks",
+	(long long) writtenFrames, (long long) lost, highWater, blockCount);
+    locker.unlock();
+}
+
+bool sndfileWriter::isWriting(void) {
+    return isRunning();
+}
+
+int64_t sndfileWriter::droppedFrames(void) {
+    return lostFrames.load(std::memory_order_relaxed);
+}
+
+void sndfileWriter::write(const float *data, int32_t frames) {
+    if (floatSamples)
+	put(data, frames);
+}
+
+void sndfileWriter::write(const int16_t *data, int32_t frames) {
+    if (!floatSamples)
+	put(data, frames);
+}
+
+//	never takes the lock: start and stop are seen through recording,
+//	and stop waits for producers to leave before touching the buffers
+void sndfileWriter::put(const void *data, int32_t frames) {
+    const char *in = (const char *) data;
+
+    if (!recording.load(std::memory_order_relaxed))
+	return;
+    producers.fetch_add(1);
+    if (!recording.load()) {
+	producers.fetch_sub(1);
+	return;
+    }
+    while (frames > 0) {
+	const uint32_t h = head.load(std::memory_order_relaxed);
+
+	// the writer is behind and all blocks are queued
+	if (h - tail.load(std::memory_order_acquire) >= (uint32_t) blockCount) {
+	    lostFrames.fetch_add(frames, std::memory_order_relaxed);
+	    break;
+	}
+	const int32_t n = std::min(frames, blockFrames - fill);
+	char *block = blocks.data() +
+		      ((size_t) (h % blockCount) * blockFrames + fill) * frameSize;
+
+	memcpy(block, in, (size_t) n * frameSize);
+	in += (size_t) n * frameSize;
+	frames -= n;
+	fill += n;
+	if (fill == blockFrames)
+	    publish();
+    }
+    producers.fetch_sub(1, std::memory_order_release);
+}
+
+void sndfileWriter::publish(void) {
+    const uint32_t h = head.load(std::memory_order_relaxed);
+    const uint32_t queued = h + 1 - tail.load(std::memory_order_acquire);
+
+    blockSizes[h % blockCount] = fill;
+    fill = 0;
+    head.store(h + 1, std::memory_order_release);
+    if (queued > highWater)
+	highWater = queued;
+    published.release();
+}
+
+//	one semaphore token per published block, plus one for stopping
+void sndfileWriter::run(void) {
+    for (;;) {
+	published.acquire();
+	const uint32_t t = tail.load(std::memory_order_relaxed);
+
+	if (t == head.load(std::memory_order_acquire)) {
+	    if (stopping.load())
+		break;
+	    continue;
+	}
+
+	const char *block = blocks.data() +
+			    (size_t) (t % blockCount) * blockFrames * frameSize;
+	const int32_t n = blockSizes[t % blockCount];
+	if (floatSamples)
+	    sf_writef_float(file, (const float *) block, n);
+	else
+	    sf_writef_short(file, (const short *) block, n);
+	writtenFrames += n;
+	tail.store(t + 1, std::memory_order_release);
+    }
+}
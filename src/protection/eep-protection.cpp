@@ -38,7 +38,7 @@
 eep_protection::eep_protection(int16_t bitRate, int16_t protLevel)
     : protection(bitRate, protLevel) {
     int16_t i, j;
-    int16_t viterbiCounter = 0;
+    int32_t viterbiCounter = 0;
     int16_t L1 = 0, L2 = 0;
     int8_t *PI1, *PI2, *PI_X;
 
@@ -146,8 +146,8 @@ eep_protection::~eep_protection() {}
 
 bool eep_protection::deconvolve(int16_t *v, int32_t size, uint8_t *outBuffer) {
 
-    int16_t i;
-    int16_t inputCounter = 0;
+    int32_t i;
+    int32_t inputCounter = 0;
     (void) size; // size was known already
 
     memset(viterbiBlock.data(), 0, (outSize * 4 + 24) * sizeof(int16_t));
@@ -146,7 +146,7 @@ static int16_t findIndex(int16_t bitRate, int16_t protLevel) {
 uep_protection::uep_protection(int16_t bitRate, int16_t protLevel)
     : protection(bitRate, protLevel) {
     int16_t index, i, j;
-    int16_t viterbiCounter = 0;
+    int32_t viterbiCounter = 0;
     int16_t L1;
     int16_t L2;
     int16_t L3;
@@ -230,8 +230,8 @@ uep_protection::uep_protection(int16_t bitRate, int16_t protLevel)
 uep_protection::~uep_protection() {}
 
 bool uep_protection::deconvolve(int16_t *v, int32_t size, uint8_t *outBuffer) {
-    int16_t i;
-    int16_t inputCounter = 0;
+    int32_t i;
+    int32_t inputCounter = 0;
 
     (void) size;
 
@@ -43,42 +43,19 @@
 #include "band-handler.h"
 #include "Qt-audio.h"
 #include "audiosink.h"
-#ifdef	HAVE_RTLSDR
-#include "rtlsdr-handler.h"
-#endif
-#ifdef	HAVE_SDRPLAY
-#include "sdrplay-handler.h"
-#endif
-#ifdef	HAVE_SDRPLAY_V3
-#include "sdrplay-handler-v3.h"
-#endif
-#ifdef	HAVE_AIRSPY
-#include "airspy-handler.h"
-#endif
-#ifdef	HAVE_HACKRF
-#include "hackrf-handler.h"
-#endif
-#ifdef	HAVE_LIME
-#include "lime-handler.h"
-#endif
-#ifdef	HAVE_PLUTO
-#include "pluto-handler.h"
-#endif
 #include "logging.h"
+#include "agc-controller.h"
 
 // A few repeated Ui constants
 #define BAD_SERVICE	"cannot run this service"
 #define BAD_PRESET	"this preset is not valid"
 
-// Some software AGC constants
-#define SW_AGC_SKIP_COUNT 16
-#define SW_AGC_BYTES 65536
-
 // Text buffers
 #define INFOBUFLEN 100
 
 // most buffer not used locally, but within the DAB processor
-RadioInterface::RadioInterface(QSettings *Si, QWidget *parent):
+RadioInterface::RadioInterface(QSettings *Si, deviceHandler *fileDevice,
+			       QWidget *parent):
 	QWidget(parent),
 	iqBuffer(2 * 1536),
 	tiiBuffer(32768),
@@ -182,6 +159,7 @@ RadioInterface::RadioInterface(QSettings *Si, QWidget *parent):
     // FM settings
     FMprocessor = nullptr;
     scanTimer = nullptr;
+    scanner = nullptr;
     settings->beginGroup(GROUP_FM);
     FMstep = settings->value(FM_STEP, FM_DEF_STEP).toInt();
     workingRate = settings->value(FM_WORKING_RATE, FM_DEF_WORKING_RATE).toInt();
@@ -192,6 +170,7 @@ RadioInterface::RadioInterface(QSettings *Si, QWidget *parent):
     deemphasis = settings->value(FM_DEEMPHASIS, FM_DEF_DEEMPHASIS).toInt();
     lowPassFilter = settings->value(FM_LOW_PASS_FILTER, FM_DEF_LOW_PASS_FILTER).toInt();
     FMaudioGain = settings->value(FM_AUDIO_GAIN, FM_DEF_AUDIO_GAIN).toInt();
+    fastScanRds = settings->value(FM_FAST_SCAN_RDS, FM_DEF_FAST_SCAN_RDS).toInt() != 0;
     settings->endGroup();
 
     // RDS settings
@@ -233,7 +212,7 @@ RadioInterface::RadioInterface(QSettings *Si, QWidget *parent):
     scanInterval = settings->value(GEN_SCAN_INTERVAL, GEN_DEF_SCAN_INTERVAL).toInt();
     scanRetry = settings->value(GEN_SCAN_RETRY, GEN_DEF_SCAN_RETRY).toInt();
 
-    findDevices();
+    findDevices(fileDevice);
     DABband.setupChannels(BAND_III);
     for (;;) {
 	std::string channel = DABband.nextChannel();
@@ -243,7 +222,18 @@ RadioInterface::RadioInterface(QSettings *Si, QWidget *parent):
 	channelSelector->addItem(QString::fromStdString(channel));
     }
     nextService.valid = false;
-    dataService.valid = false;
+    dataServices.clear();
+    ensembles = new EnsembleCache(QString("%1/ensembles").arg(LOCAL_STORAGE));
+    cache = new ImageCache(LOCAL_CACHE);
+    slides = new slidePipeline();
+    slidesGeneration = 0;
+    connect(slides, SIGNAL(slideReady(QImage, uint)),
+	    this, SLOT(showSlide(QImage, uint)));
+    connect(slides, SIGNAL(pictureReady(QImage, int, int, int, uint)),
+	    this, SLOT(showPicture(QImage, int, int, int, uint)));
+    slides->start();
+    cachedService.defined = false;
+    cachedRunning = false;
     currentService.serviceName = settings->value(GEN_SERVICE_NAME, "").toString();
 
     // FIXME we don't know that it's valid yet
@@ -283,6 +273,8 @@ RadioInterface::RadioInterface(QSettings *Si, QWidget *parent):
     restorePlaying = false;
     recording = false;
     scanning = false;
+    fastScanning = false;
+    fastScanIndex = -1;
     isFM = (settings->value(GEN_TUNER_MODE, GEN_DEF_TUNER_MODE).toString() == GEN_FM);
     if (settings->value(GEN_DAB_MODE, GEN_DEF_DAB_MODE).toString() == GEN_DAB_SLIDES)
 	dabDisplay = DD_SLIDES;
@@ -404,6 +396,8 @@ RadioInterface::~RadioInterface() {
     ensembleDisplay->setModel(&ensembleModel);
     stationSelector->setModel(&ensembleModel);
     delete soundOut;
+    delete slides;
+    delete cache;
     if (DABprocessor != nullptr)
 	delete DABprocessor;
     if (FMprocessor != nullptr)
@@ -412,8 +406,11 @@ RadioInterface::~RadioInterface() {
 	delete scanTimer;
     if (settingsDialog != nullptr)
 	delete settingsDialog;
-    for (const auto &dev: deviceList)
+    delete ensembles;
+    for (const auto &dev: deviceList) {
+	dev.device->agcControl()->stop();
 	delete dev.device;
+    }
 }
 
 QString extractStyleName(const QString& text)
@@ -479,75 +476,10 @@ void RadioInterface::changeSkin(QString skin) {
     this->update();
 }
 
-void RadioInterface::processGain(agcStats *newStats, int amount) {
-    int oldAgc = swAgc;
-
-    if ((agc != AGC_SOFTWARE && agc != AGC_COMBINED) && !log_active(LOG_AGC, LOG_VERBOSE))
-	return;
-    swAgcAmount += amount;
-    if (swAgcAmount < SW_AGC_BYTES)
-	return;
-    log(LOG_AGC, LOG_VERBOSE, "skip %i amount %i min %i max %i overflows %i",
-	swAgcSkip+swAgcAccrue, swAgcAmount, stats.min, stats.max, stats.overflows);
-
-    // we most likely already have data in the buffer, which will not be yet
-    // affected by our gain change, so skip some buffers before retesting:
-    // this avoids AGC induced signal oscillations
-    if (swAgcSkip > 0) {
-	swAgcAmount = 0;
-	swAgcSkip--;
-	return;
-    }
-    if (newStats->min < stats.min)
-	stats.min = newStats->min;
-    if (newStats->max > stats.max)
-	stats.max = newStats->max;
-    stats.overflows += newStats->overflows;
-
-    if (swAgcAccrue > 0) {
-	swAgcAmount = 0;
-	swAgcAccrue--;
-	return;
-    }
-    if (agc != AGC_SOFTWARE && agc != AGC_COMBINED) {
-	resetAgcStats();
-	return;
-    }
-
-    // if we have overflows, the signal is too strong
-    // otherwise we change the gain to try to land the signal strength
-    // between a high enough percentile and one near the top: after that,
-    // empirically, AGC settles
-    if ((stats.overflows > 0 || stats.max-stats.min > maxSignal) && swAgc > minIfGain)
-	swAgc--;
-    else if (stats.max-stats.min < minSignal && swAgc < maxIfGain)
-	swAgc++;
-    if (swAgc != oldAgc) {
-	log(LOG_AGC, LOG_MIN, "switching gain to %i (min %i max %i overflows %i)",
-			swAgc, stats.min, stats.max, stats.overflows);
-	inputDevice->setIfGain(swAgc);
-	swAgcSkip = SW_AGC_SKIP_COUNT;
-    }
-    resetAgcStats();
-}
-
-void RadioInterface::resetAgcStats() {
-    swAgcAmount = 0;
-    swAgcAccrue = SW_AGC_SKIP_COUNT;
-    stats.min = INT_MAX;
-    stats.max = 0;
-    stats.overflows = 0;
-}
-
 void RadioInterface::resetSwAgc() {
-    swAgc = ifGain;
-    swAgcSkip = SW_AGC_SKIP_COUNT;
     if (inputDevice)
-	 inputDevice->getSwAGCRange(&minSignal, &maxSignal);
-    else {
-	minSignal = 0;
-	maxSignal = 0;
-    }
+	inputDevice->agcControl()->configure(agc == AGC_SOFTWARE || agc == AGC_COMBINED,
+					     ifGain, minIfGain, maxIfGain);
 }
 
 void RadioInterface::makeDABprocessor() {
@@ -635,77 +567,8 @@ void RadioInterface::terminateProcess() {
     settings->sync();
 }
 
-void RadioInterface::findDevices() {
-    deviceDescriptor discoveredDevice;
-
-#ifdef HAVE_SDRPLAY_V3
-    bool foundV3 = false;
-    try {
-	    discoveredDevice.device = new sdrplayHandler_v3();
-	    discoveredDevice.deviceType = "Sdrplay V3";
-	    discoveredDevice.controls = HW_AGC|IF_GAIN|LNA_GAIN;
-	    deviceList.push_back(discoveredDevice);
-	    foundV3 = true;
-    } catch (int e) {}
-#endif
-#ifdef HAVE_SDRPLAY
-#ifdef HAVE_SDRPLAY_V3
-
-    // rdsplay v2 is a fallback
-    if (!foundV3)
-#endif
-	try {
-		discoveredDevice.device = new sdrplayHandler();
-		discoveredDevice.deviceType = "Sdrplay";
-		discoveredDevice.controls = HW_AGC|IF_GAIN|LNA_GAIN;
-		deviceList.push_back(discoveredDevice);
-	} catch (int e) {}
-#endif
-#ifdef HAVE_RTLSDR
-// no LNA
-    try {
-	    discoveredDevice.device = new rtlsdrHandler();
-	    discoveredDevice.deviceType = "RtlSdr";
-	    discoveredDevice.controls = SW_AGC|HW_AGC|COMBO_AGC|IF_GAIN;
-	    deviceList.push_back(discoveredDevice);
-    } catch (int e) {}
-#endif
-#ifdef HAVE_AIRSPY
-// no LNA
-    try {
-	    discoveredDevice.device = new airspyHandler();
-	    discoveredDevice.deviceType = "AirSpy";
-	    discoveredDevice.controls = SW_AGC|HW_AGC|IF_GAIN;
-	    deviceList.push_back(discoveredDevice);
-    } catch (int e) {}
-#endif
-#ifdef HAVE_LIME
-// no LNA
-    try {
-	    discoveredDevice.device = new limeHandler();
-	    discoveredDevice.deviceType = "Lime";
-	    discoveredDevice.controls = HW_AGC|IF_GAIN;
-	    deviceList.push_back(discoveredDevice);
-    } catch (int e) {}
-#endif
-#ifdef HAVE_PLUTO
-// no LNA
-    try {
-	    discoveredDevice.device = new plutoHandler();
-	    discoveredDevice.deviceType = "Pluto";
-	    discoveredDevice.controls = HW_AGC|IF_GAIN;
-	    deviceList.push_back(discoveredDevice);
-    } catch (int e) {}
-#endif
-#ifdef HAVE_HACKRF
-// no AGC
-    try {
-	    discoveredDevice.device = new hackrfHandler();
-	    discoveredDevice.deviceType = "HackRF";
-	    discoveredDevice.controls = IF_GAIN|LNA_GAIN;
-	    deviceList.push_back(discoveredDevice);
-    } catch (int e) {}
-#endif
+void RadioInterface::findDevices(deviceHandler *fileDevice) {
+    probeDevices(deviceList, fileDevice);
     if (deviceList.size() == 0) {
 	inputDevice = nullptr;
 	deviceType = "";
@@ -716,7 +579,7 @@ void RadioInterface::findDevices() {
 	inputDevice = deviceList[0].device;
 	deviceUiControls = deviceList[0].controls;
 	deviceType = deviceList[0].deviceType;
-	if (QString::compare(saveType, ""))
+	if (QString::compare(saveType, "") && fileDevice == nullptr)
 	    for (uint i = 0; i < deviceList.size(); ++i)
 		if (!QString::compare(deviceList[i].deviceType, saveType)) {
 		    inputDevice = deviceList[i].device;
@@ -763,7 +626,6 @@ void RadioInterface::findDevices() {
 
     // setup software agc
     resetSwAgc();
-    resetAgcStats();
 }
 
 void RadioInterface::checkIfGain() {
@@ -1026,6 +888,10 @@ void RadioInterface::addToEnsemble(const QString &serviceName, uint SId) {
 void RadioInterface::nameOfEnsemble(int id, const QString &v) {
     log(LOG_EVENT, LOG_CHATTY, "station name %s %i", qPrintable(v), id);
     ensembleId->setText(v + " (" + QString::number(id, 16) + ")");
+
+    // not the ensemble we have cached for this channel
+    if (cachedService.defined && id != cachedEId)
+	dropCachedService();
 }
 
 void RadioInterface::ensembleLoaded(int count) {
@@ -1035,6 +901,13 @@ void RadioInterface::ensembleLoaded(int count) {
     if (isFM)
 	return;
 
+    if (count > 0)
+	storeEnsemble(channelSelector->currentText());
+
+    // the cached service did not turn up
+    if (cachedService.defined)
+	dropCachedService();
+
     // we are loading a scan list, no need to start a service
     if (scanning) {
 	if (count >= 0)
@@ -1107,6 +980,23 @@ void RadioInterface::showText(QString s) {
 #endif
 }
 
+// during a fast scan confirmation, a PI code is proof enough of a station,
+// as long as it was decoded on the candidate being confirmed: the signal
+// is queued, and may arrive after the next candidate has been tuned
+void RadioInterface::showPiCode(int code, int frequency) {
+    log(LOG_EVENT, LOG_CHATTY, "program identification %x", code);
+    if (!scanning || !fastScanning || fastScanIndex < 0 || code == 0)
+	return;
+    if (fastScanIndex >= (int) fastScanCandidates.size() ||
+	frequency != fastScanCandidates[fastScanIndex]) {
+	log(LOG_EVENT, LOG_CHATTY, "stale pi %x from %i", code, frequency);
+	return;
+    }
+    log(LOG_EVENT, LOG_MIN, "fast scan station confirmed %3.3f pi %x", FMfreq, code);
+    scanFound();
+    nextFastScanCandidate();
+}
+
 void RadioInterface::showSoundMode(bool s) {
     log(LOG_EVENT, LOG_VERBOSE, "stereo mode %i", s);
     stereoLabel->setStyleSheet(s?  "QLabel {background-color: green; color: white}":
@@ -1133,133 +1023,6 @@ void RadioInterface::setProgramType(int code) {
     }
 }
 
-#define BLACK_THRESHOLD 10
-
-bool isBlack(QRgb pixel) {
-    if (qAlpha(pixel) == 0)
-	return true;
-    return qRed(pixel) <= BLACK_THRESHOLD &&
-	qGreen(pixel) <= BLACK_THRESHOLD &&
-	qBlue(pixel) <= BLACK_THRESHOLD;
-};
-
-bool rowHasContent(QImage img, QRgb pixel, int width, int y) {
-    const QRgb* line = reinterpret_cast<const QRgb*>(img.constScanLine(y));
-    return (line[0] == pixel) &&
-	(line[width/2] == pixel) &&
-	(line[width-1] == pixel);
-};
-
-bool colHasContent(QImage img, QRgb pixel, int x, int top, int bottom) {
-    const QRgb* lineTop = reinterpret_cast<const QRgb*>(img.constScanLine(top));
-    const QRgb* lineMid = reinterpret_cast<const QRgb*>(img.constScanLine((top+bottom)/2));
-    const QRgb* lineBot = reinterpret_cast<const QRgb*>(img.constScanLine(bottom));
-    return (lineTop[x] == pixel) &&
-	(lineMid[x] == pixel) &&
-	(lineBot[x] == pixel);
-};
-
-QPixmap trimBorders(const QImage& image) {
-    QImage img = image.convertToFormat(QImage::Format_ARGB32);
-    int width = img.width();
-    int height = img.height();
-    int top = 0;
-    int bottom = height - 1;
-    int left = 0;
-    int right = width - 1;
-    const QRgb* topLine = reinterpret_cast<const QRgb*>(img.constScanLine(top));
-    const QRgb* bottomLine = reinterpret_cast<const QRgb*>(img.constScanLine(bottom));
-    QRgb topLeft = topLine[0];
-    QRgb bottomRight = bottomLine[right];
-
-    if (isBlack(topLeft)) {
-	for (; top < height && !rowHasContent(img, topLeft, width, top); ++top);
-	for (; left < width && !colHasContent(img, topLeft, left, top, bottom); ++left);
-    }
-
-    if (isBlack(bottomRight)) {
-	for (; bottom > top && !rowHasContent(img, bottomRight, width, bottom); --bottom);
-	for (; right > left && !colHasContent(img, bottomRight, right, top, bottom); --right);
-    }
-
-    int doTop = (top > 0 || bottom < height - 1);
-    int doSides = (left > 0 || right < width - 1);
-    if (left > right || top > bottom)
-	return QPixmap();
-    else if (!doTop && !doSides)
-	return QPixmap::fromImage(img);
-
-    // if only one pair of sides, we can just trim the image,
-    // as the content scaling won't change
-    if (doTop != doSides)
-	return QPixmap::fromImage(img.copy(left, top, right - left + 1, bottom - top + 1));
-
-    // otherwise crop top and bottom and fill left and right)
-    img = img.copy(0, top, width - 1, bottom - top + 1);
-    QPainter painter(&img);
-    painter.setCompositionMode(QPainter::CompositionMode_Source);
-    if (left > 0)
-	painter.fillRect(0, 0, left, img.height(), Qt::transparent);
-    if (right < width - 1)
-	painter.fillRect(right - left + 1, 0, width - right -1, img.height(), Qt::transparent);
-
-    return QPixmap::fromImage(img);
-}
-
-bool checkImageData(QByteArray data, const char *type, QString pictureName) {
-    QBuffer buffer;
-    buffer.setData(data);
-    buffer.open(QIODevice::ReadOnly);
-
-    QImageReader reader(&buffer);
-
-    if (!reader.canRead()) {
-	return false;
-    }
-
-    QString found = reader.format();
-    bool res = (found == type);
-    if (!res)
-	log(LOG_EVENT, LOG_MIN, "expected %s to be %s found %s", qPrintable(pictureName), type, qPrintable(found));
-    return res;
-}
-
-void RadioInterface::handleSlides(QByteArray data, int contentType, QString pictureName, int dirs) {
-    const char *type;
-
-    log(LOG_EVENT, LOG_MIN, "slide %s 0x%x", qPrintable(pictureName), contentType);
-    if (pictureName == QString(""))
-	return;
-    switch (static_cast<MOTContentType>(contentType)) {
-    case MOTCTImageGIF:
-	type = "gif";
-	break;
-    case MOTCTImageJFIF:
-	type = "jpg";
-	break;
-    case MOTCTImageBMP:
-	type = "bmp";
-	break;
-    case MOTCTImagePNG:
-	type = "png";
-	break;
-    default:
-	return;
-    }
-
-    if (dirs != 0)
-	handleEPGPicture(data, type, pictureName);
-    else {
-	QImage i;
-
-	if (checkImageData(data, type, pictureName)) {
-	    i.loadFromData(data, type);
-	    currentService.slidePriority = INT_MAX;
-	    showSlides(trimBorders(i));
-	}
-    }
-}
-
 int32_t extractServiceIdFromFilename(const QString &filename) {
     QString serviceIdHex;
     QString name = filename.split('/').last().split('\\').last();
@@ -1299,22 +1062,57 @@ int32_t extractServiceIdFromFilename(const QString &filename) {
     return -1;
 }
 
-void RadioInterface::handleEPGPicture(QByteArray data, const char *type, QString pictureName) {
+void RadioInterface::handleSlides(QByteArray data, int contentType, QString pictureName, int dirs) {
+    const char *type;
+
+    log(LOG_EVENT, LOG_MIN, "slide %s 0x%x", qPrintable(pictureName), contentType);
+    if (pictureName == QString(""))
+	return;
+    switch (static_cast<MOTContentType>(contentType)) {
+    case MOTCTImageGIF:
+	type = "gif";
+	break;
+    case MOTCTImageJFIF:
+	type = "jpg";
+	break;
+    case MOTCTImageBMP:
+	type = "bmp";
+	break;
+    case MOTCTImagePNG:
+	type = "png";
+	break;
+    default:
+	return;
+    }
+
+    // decoding, trimming and caching happen in the pipeline
+    if (dirs != 0) {
+	int32_t SId = extractServiceIdFromFilename(pictureName);
+
+	if (SId >= 0)
+	    slides->addPicture(data, type, pictureName, SId, slidesLabel->size());
+    } else
+	slides->addSlide(data, type, pictureName, slidesLabel->size());
+}
+
+void RadioInterface::showSlide(QImage image, uint generation) {
+    if (generation != slidesGeneration)
+	return;
+    currentService.slidePriority = INT_MAX;
+    showSlides(QPixmap::fromImage(image));
+}
+
+// the picture is already in the cache, the size is the one it was sent with
+void RadioInterface::showPicture(QImage image, int SId, int width, int height, uint generation) {
     QPixmap p;
-    QString serviceName;
-    int32_t SId;
     int priority;
 
-    SId = extractServiceIdFromFilename(pictureName);
-    if (SId < 0)
+    if (generation != slidesGeneration)
 	return;
-    if (!checkImageData(data, type, pictureName))
-	return;
-    p.loadFromData(data, type);
-    priority = p.width() * p.height();
-    log(LOG_EVENT, LOG_MIN, "slide SId %x %s %i %i", SId, type, p.width(), p.height());
-    cache->addImage(SId, p.width(), p.height(), type, data);
-    if (p.width() == p.height() && p.height() >= ICON_MIN_SIZE && p.height() <= ICON_MAX_SIZE) {
+    p = QPixmap::fromImage(image);
+    priority = width * height;
+    log(LOG_EVENT, LOG_MIN, "slide SId %x %i %i", SId, width, height);
+    if (width == height && height >= ICON_MIN_SIZE && height <= ICON_MAX_SIZE) {
 	QPixmap empty(ICON_LISTVIEW_SIZE);
 
 	// there's no other way to align text when some icons are missing
@@ -1329,7 +1127,7 @@ void RadioInterface::handleEPGPicture(QByteArray data, const char *type, QString
 	}
     } else if (playing && currentService.SId == (uint32_t) SId &&
 	       priority > currentService.slidePriority &&
-	       p.width() >= SLIDE_MIN_SIZE && p.height() >= SLIDE_MIN_SIZE) {
+	       width >= SLIDE_MIN_SIZE && height >= SLIDE_MIN_SIZE) {
 	currentService.slidePriority = priority;
 	showSlides(p);
     }
@@ -1609,6 +1407,7 @@ void RadioInterface::handleDeleteFMPreset() {
 
 void RadioInterface::stopDABService() {
     presetSelector->setCurrentIndex(0);
+    dropCachedService();
     if (currentService.valid) {
 	audiodata ad;
 
@@ -1761,8 +1560,10 @@ void RadioInterface::startDABService(dabService *s) {
 		    warning(this, tr(BAD_SERVICE));
 		else {
 		    ad.procMode = __ONLY_SOUND;
-	 	    DABprocessor->set_audioChannel(&ad, &audioBuffer);
-		    soundOut->restart();
+		    if (!keepCachedService(&ad)) {
+			DABprocessor->set_audioChannel(&ad, &audioBuffer);
+			soundOut->restart();
+		    }
 		    ad.audioInfo((char *) &buf, INFOBUFLEN);
 		    stereoLabel->setToolTip((char *) &buf);
 		    ad.serviceInfo((char *) &buf, INFOBUFLEN);
@@ -1815,58 +1616,143 @@ void RadioInterface::startDAB() {
 
     if (inputDevice == nullptr || DABprocessor == nullptr)
 	return;
-    cache = new ImageCache(QString("%1/%2").arg(LOCAL_CACHE).arg(channel));
+    cache->setChannel(channel);
+    slides->setCache(cache);
+    slidesGeneration++;
     emptyArt(true);
 #ifdef HAVE_MPRIS
     mprisLabelAndText("DAB", channel);
     player.setPlaybackStatus(Mpris::Stopped);
 #endif
+    lookupCachedService(channel);
     inputDevice->restartReader(tunedFrequency);
     DABprocessor->start();
 }
 
+//	Ensemble cache
+//	If we are tuning for a known service, we have it playing as soon as
+//	we are in sync, and let the fic confirm it later
+void RadioInterface::lookupCachedService(const QString &channel) {
+    cachedService.defined = false;
+    cachedRunning = false;
+    if (scanning || !nextService.valid || nextService.serviceName == "")
+	return;
+    ensembles->lookup(channel, nextService.serviceName, &cachedEId, &cachedService);
+}
+
+void RadioInterface::timeSynced() {
+    audiodata ad;
+
+    if (isFM || scanning || !cachedService.defined || cachedRunning)
+	return;
+    log(LOG_EVENT, LOG_MIN, "starting cached service %s", qPrintable(cachedService.serviceName));
+    ad = cachedService;
+    ad.procMode = __ONLY_SOUND;
+    if (!DABprocessor->set_audioChannel(&ad, &audioBuffer)) {
+	cachedService.defined = false;
+	return;
+    }
+    cachedRunning = true;
+    soundOut->restart();
+    serviceLabel->setStyleSheet("QLabel {color: black}");
+    showLabel(cachedService.serviceName);
+}
+
+//	the fic has caught up: keep the running backend if the layout
+//	is still the one we had cached
+bool RadioInterface::keepCachedService(audiodata *ad) {
+    bool keep;
+
+    if (!cachedService.defined)
+	return false;
+    keep = cachedRunning && EnsembleCache::sameLayout(&cachedService, ad);
+    if (cachedRunning && !keep) {
+	log(LOG_EVENT, LOG_MIN, "cached service %s is stale", qPrintable(cachedService.serviceName));
+	DABprocessor->stopService(&cachedService);
+    }
+    cachedService.defined = false;
+    cachedRunning = false;
+    return keep;
+}
+
+void RadioInterface::dropCachedService() {
+    if (cachedRunning) {
+	log(LOG_EVENT, LOG_MIN, "dropping cached service %s", qPrintable(cachedService.serviceName));
+	DABprocessor->stopService(&cachedService);
+	usleep(1000);
+	soundOut->stop();
+    }
+    cachedService.defined = false;
+    cachedRunning = false;
+}
+
+void RadioInterface::storeEnsemble(const QString &channel) {
+    std::vector<audiodata> services;
+
+    for (const auto &serv: DABprocessor->getServices(serviceOrder)) {
+	audiodata ad;
+
+	DABprocessor->dataforAudioService(serv.name, &ad);
+	if (ad.defined)
+	    services.push_back(ad);
+    }
+    ensembles->store(channel, DABprocessor->get_ensembleId(), services);
+}
+
 void RadioInterface::startDataService(QString serviceName, uint SId) {
 #ifdef USE_SPI
     packetdata pd;
 
     if (inputDevice == nullptr || DABprocessor == nullptr)
 	return;
-    if (scanning || dataService.valid)
+    if (scanning)
 	return;
+    for (const auto &serv: dataServices)
+	if (serv.SId == SId && serv.serviceName == serviceName)
+	    return;
     DABprocessor->dataforPacketService(serviceName, &pd, 0);
     if (!pd.defined) {
 	log(LOG_SPI, LOG_MIN, "cound not find background service %s %d", qPrintable(serviceName), SId);
 	return;
     }
     log(LOG_SPI, LOG_MIN, "starting background service %s %d", qPrintable(serviceName), SId);
-    dataService.serviceName = serviceName;
-    dataService.SId = SId;
-    dataService.valid = true;
-    DABprocessor->set_dataChannel(&pd, &dataBuffer);
+    if (!DABprocessor->set_dataChannel(&pd, &dataBuffer))
+	return;
+
+    dabService s;
+    s.serviceName = serviceName;
+    s.SId = SId;
+    s.valid = true;
+    dataServices.push_back(s);
 #else
     (void) serviceName;
     (void) SId;
 #endif
 }
 
+//	services sharing a subchannel go together
 void RadioInterface::stopDataServices() {
 #ifdef USE_SPI
     packetdata pd;
 
     if (inputDevice == nullptr || DABprocessor == nullptr)
 	return;
-    if (scanning || dataService.serviceName == "" || !dataService.valid)
+    if (scanning)
 	return;
-    log(LOG_SPI, LOG_MIN, "stopping background service %s", qPrintable(dataService.serviceName));
-    DABprocessor->dataforPacketService(dataService.serviceName, &pd, 0);
-    DABprocessor->stopService(&pd);
-    dataService.valid = false;
+    for (const auto &serv: dataServices) {
+	log(LOG_SPI, LOG_MIN, "stopping background service %s", qPrintable(serv.serviceName));
+	DABprocessor->dataforPacketService(serv.serviceName, &pd, 0);
+	if (pd.defined)
+	    DABprocessor->stopService(&pd);
+    }
+    dataServices.clear();
 #endif
 }
 
 void RadioInterface::stopDAB() {
     if (inputDevice == nullptr || DABprocessor == nullptr)
 	return;
+    dropCachedService();
     if (currentService.valid) {
 	audiodata ad;
 
@@ -1901,10 +1787,9 @@ void RadioInterface::stopDAB() {
     player.setPlaybackStatus(Mpris::Stopped);
 #endif
 
-    if (cache != nullptr) {
-	delete cache;
-	cache = nullptr;
-    }
+    slides->setCache(nullptr);
+    slidesGeneration++;
+    cache->setChannel("");
 }
 
 void RadioInterface::handleSelectChannel(int index) {
@@ -2031,7 +1916,7 @@ void RadioInterface::startFM(int32_t freq) {
 	return;
     ficBlocks = 0;
     ficSuccess = 0;
-    FMprocessor->resetRDS();
+    FMprocessor->resetRDS(freq);
     inputDevice->restartReader(freq);
     soundOut->restart();
     FMprocessor->start();
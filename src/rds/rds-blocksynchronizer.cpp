@@ -59,6 +59,7 @@ void rdsBlockSynchronizer::setFecEnabled(bool b) {
 
 void rdsBlockSynchronizer::reset(void) {
     rdsBitstream = 0;
+    rdsSyndrome = 0;
     rdsNumofSyncErrors = 0;
     rdsIsSynchronized = false;
     rdsCurrentBlock = RDSGroup::BLOCK_A;
@@ -107,86 +108,24 @@ void rdsBlockSynchronizer::resetCRCErrorCounter(void) {
     rdsNumofCRCErrors = 0;
 }
 
-uint32_t rdsBlockSynchronizer::getSyndrome(uint32_t bits,
-    uint32_t offsetWord) {
-    const uint32_t block = bits ^ offsetWord;
-    uint32_t reg = 0;
-    int16_t k;
+//	syndrome arithmetic, the register computes R * w(x) mod g(x)
+static inline uint32_t mulX(uint32_t syndrome) {
+    return (syndrome << 1) ^
+	   (((syndrome >> (NUM_BITS_CRC - 1)) & 01) ? CRC_POLY: 0);
+}
 
-    for (k = NUM_BITS_PER_BLOCK - 1; k >= 0; k--) {
-	uint32_t msb = reg & (1 << (NUM_BITS_CRC - 1));
-	reg <<= 1;
-	if (msb > 0)
-	    reg ^= CRC_POLY;
+static uint32_t bitSyndrome(uint32_t block) {
+    uint32_t reg = 0;
+    for (int k = (int)NUM_BITS_PER_BLOCK - 1; k >= 0; k--) {
+	reg = mulX(reg);
 	if (((block >> k) & 0x1) != 0)
 	    reg ^= REMAINDER_POLY;
     }
-
     return reg;
 }
 
-bool rdsBlockSynchronizer::decodeBlock(RDSGroup::RdsBlock b,
-    uint32_t bits,
-    bool isTypeBGroup) {
-    uint32_t offsetWord = 0;
-    uint32_t syndrome = 0;
-
-    offsetWord = getOffset(b, isTypeBGroup);
-
-    // calculate  crc and get the syndrome
-    syndrome = getSyndrome(bits, offsetWord);
-
-    // During synchronization we allow zero errors,
-    // thus we check the syndrome register directly here
-    if (!rdsIsSynchronized)
-	return syndrome == 0;
-
-    // Increment for BER calculations
-    rdsBitsProcessed += NUM_BITS_BLOCK_PAYLOAD;
-
-    if (syndrome != 0 && crcFecEnabled)
-	syndrome = correctBurstErrors(syndrome, b, isTypeBGroup);
-
-    // if the syndrome is not equal to zero there was an error in the crc
-    // When no fec is used, we mark all bits as erroneous
-    if (syndrome != 0)
-	rdsNumofBitErrors += NUM_BITS_BLOCK_PAYLOAD;
-
-    // calc BER
-    if (rdsBitsProcessed >= NUM_BITS_BER_CALC_RESET) {
-	rdsNumofBitErrors = 0;
-	rdsBitsProcessed = 0;
-    }
-
-    return syndrome == 0;
-}
-
-// Precomputed syndrome -> error vector lookup table for burst error correction.
-// Implements IEC 62106 / EN 50067 Annex B burst error correction.
-// For each offset word, we precompute the syndrome produced by every possible
-// 1-bit and 2-bit contiguous burst error at every bit position in the 26-bit block.
-// Correction is then a single map lookup: O(1) per block, no iteration.
-// This correctly handles burst errors anywhere in the block including check bits,
-// and handles 2-bit bursts which Meggitt cannot.
-//
-// The table is built once at first use via a static local.
-// BurstErrorTable constructor ? builds the syndrome->error_vector lookup
-// for 1-bit and 2-bit contiguous burst errors at every bit position,
-// for each of the 5 RDS offset words.
-BurstErrorTable::BurstErrorTable() {
-    auto calcSyndrome = [](uint32_t bits, uint32_t offsetWord) -> uint32_t {
-	const uint32_t block = bits ^ offsetWord;
-	uint32_t reg = 0;
-	for (int k = (int)NUM_BITS_PER_BLOCK - 1; k >= 0; k--) {
-	    uint32_t msb = reg & (1U << (NUM_BITS_CRC - 1));
-	    reg <<= 1;
-	    if (msb > 0)
-		reg ^= CRC_POLY;
-	    if (((block >> k) & 0x1) != 0)
-		reg ^= REMAINDER_POLY;
-	}
-	return reg;
-    };
+SyndromeTables::SyndromeTables() {
+    outgoing = mulX(bitSyndrome(1U << (NUM_BITS_PER_BLOCK - 1)));
 
     const uint32_t offsetWords[5] = {
 	OFFSET_WORD_BLOCK_A,
@@ -195,29 +134,36 @@ BurstErrorTable::BurstErrorTable() {
 	OFFSET_WORD_BLOCK_C2,
 	OFFSET_WORD_BLOCK_D
     };
-
-    for (int b = 0; b < 5; b++) {
-
-	// 1-bit errors at every position
-	for (uint32_t shift = 0; shift < NUM_BITS_PER_BLOCK; shift++) {
-	    uint32_t errorVector = (1U << shift) & BLOCK_MASK;
-	    uint32_t syndrome = calcSyndrome(errorVector, offsetWords[b]);
-	    table[b][syndrome] = errorVector;
-	}
-
-	// 2-bit contiguous burst errors at every position
-	for (uint32_t shift = 0; shift < NUM_BITS_PER_BLOCK; shift++) {
-	    uint32_t errorVector = (0b11U << shift) & BLOCK_MASK;
-	    uint32_t syndrome = calcSyndrome(errorVector, offsetWords[b]);
-	    if (table[b].find(syndrome) == table[b].end())
-		table[b][syndrome] = errorVector;
+    for (int i = 0; i < 5; i++)
+	offset[i] = bitSyndrome(offsetWords[i]);
+
+    //	all bursts of length 1 .. 5 at every position in the block,
+    //	the first and last bit of a burst are always set, shorter
+    //	bursts are entered first and take precedence
+    for (uint32_t i = 0; i < (1U << NUM_BITS_CRC); i++)
+	burst[i] = 0;
+    for (uint32_t length = 1; length <= 5; length++) {
+	const uint32_t ends = length == 1? 01: (01 | (1U << (length - 1)));
+	const uint32_t inner = length <= 2? 1: 1U << (length - 2);
+	for (uint32_t fill = 0; fill < inner; fill++) {
+	    const uint32_t pattern = ends | (fill << 1);
+	    for (uint32_t shift = 0;
+		 shift + length <= NUM_BITS_PER_BLOCK; shift++) {
+		const uint32_t errorVector = pattern << shift;
+		const uint32_t syndrome = bitSyndrome(errorVector);
+		if (burst[syndrome] == 0)
+		    burst[syndrome] = errorVector;
+	    }
 	}
     }
 }
 
+static const SyndromeTables syndromeTables;
+
 // Returns the table index for a given block / isTypeBGroup combination
-static int burstTableIndex(RDSGroup::RdsBlock b, bool isTypeBGroup) {
+static inline int offsetIndex(RDSGroup::RdsBlock b, bool isTypeBGroup) {
     switch (b) {
+      default:
       case RDSGroup::BLOCK_A:
 	return 0;
       case RDSGroup::BLOCK_B:
@@ -226,45 +172,69 @@ static int burstTableIndex(RDSGroup::RdsBlock b, bool isTypeBGroup) {
 	return isTypeBGroup? 3: 2;
       case RDSGroup::BLOCK_D:
 	return 4;
-      default:
-	return 0;
     }
 }
 
-// error correction using precomputed burst error lookup table.
-// Replaces the Meggitt shift register approach with an O(1) table lookup.
-// Corrects any single-bit error or 2-bit contiguous burst anywhere in the
-// full 26-bit block including check bits.
-uint32_t rdsBlockSynchronizer::correctBurstErrors(uint32_t syndrome,
-    RDSGroup::RdsBlock b, bool isTypeBGroup) {
-    static const BurstErrorTable burstTable;
-
-    const int idx = burstTableIndex(b, isTypeBGroup);
-
-    const auto& tbl = burstTable.table[idx];
-    const auto it = tbl.find(syndrome);
-    if (it != tbl.end()) {
-	rdsBitstream ^= it->second;
-	rdsNumofBitErrors++;
-	return 0;
-    }
+//	shift a bit into the bitstream and update the syndrome of
+//	the last 26 bits: multiply by x, drop the contribution of the
+//	bit leaving the window and add the one of the new bit
+void rdsBlockSynchronizer::shiftBit(bool b) {
+    const bool out = ((rdsBitstream >> (NUM_BITS_PER_BLOCK - 1)) & 01) != 0;
+    rdsBitstream = (rdsBitstream << 1) | (b ? 01 : 00);
+    rdsSyndrome = mulX(rdsSyndrome) ^
+		  (out? syndromeTables.outgoing: 0) ^
+		  (b? REMAINDER_POLY: 0);
+}
 
-    return syndrome & 0x3FF;
+//	the syndrome of the last 26 bits after removing the offset word
+uint32_t rdsBlockSynchronizer::getSyndrome(RDSGroup::RdsBlock b,
+    bool isTypeBGroup) {
+    return rdsSyndrome ^ syndromeTables.offset[offsetIndex(b, isTypeBGroup)];
 }
 
-uint32_t rdsBlockSynchronizer::getOffset(RDSGroup::RdsBlock b,
+bool rdsBlockSynchronizer::decodeBlock(RDSGroup::RdsBlock b,
     bool isTypeBGroup) {
-    switch (b) {
-    default:
-    case RDSGroup::BLOCK_A:
-	return OFFSET_WORD_BLOCK_A;
-    case RDSGroup::BLOCK_B:
-	return OFFSET_WORD_BLOCK_B;
-    case RDSGroup::BLOCK_C:
-	return isTypeBGroup? OFFSET_WORD_BLOCK_C2: OFFSET_WORD_BLOCK_C1;
-    case RDSGroup::BLOCK_D:
-	return OFFSET_WORD_BLOCK_D;
+    uint32_t syndrome = getSyndrome(b, isTypeBGroup);
+
+    // During synchronization we allow zero errors,
+    // thus we check the syndrome register directly here
+    if (!rdsIsSynchronized)
+	return syndrome == 0;
+
+    // Increment for BER calculations
+    rdsBitsProcessed += NUM_BITS_BLOCK_PAYLOAD;
+
+    if (syndrome != 0 && crcFecEnabled)
+	syndrome = correctBurstErrors(syndrome);
+
+    // if the syndrome is not equal to zero there was an error in the crc
+    // When no fec is used, we mark all bits as erroneous
+    if (syndrome != 0)
+	rdsNumofBitErrors += NUM_BITS_BLOCK_PAYLOAD;
+
+    // calc BER
+    if (rdsBitsProcessed >= NUM_BITS_BER_CALC_RESET) {
+	rdsNumofBitErrors = 0;
+	rdsBitsProcessed = 0;
     }
+
+    return syndrome == 0;
+}
+
+// burst error correction (IEC 62106 / EN 50067 Annex B).
+// The syndrome of the received block with the offset removed
+// depends on the error pattern only, so a single table lookup
+// finds the burst of up to 5 bits, anywhere in the 26-bit block
+// including the check bits, that explains it.
+uint32_t rdsBlockSynchronizer::correctBurstErrors(uint32_t syndrome) {
+    const uint32_t errorVector = syndromeTables.burst[syndrome];
+    if (errorVector == 0)
+	return syndrome;
+
+    rdsBitstream ^= errorVector;
+    rdsSyndrome ^= syndrome;
+    rdsNumofBitErrors++;
+    return 0;
 }
 
 rdsBlockSynchronizer::SyncResult
@@ -284,16 +254,14 @@ rdsBlockSynchronizer::SyncResult
 rdsBlockSynchronizer::pushBitSynchronized(bool b, RDSGroup* rdsGrp) {
 
     // assert rdsIsSynchronized == true
-    rdsBitstream = (rdsBitstream << 1) | (b ? 01 : 00);
+    shiftBit(b);
     if (++rdsBitsinBlock < NUM_BITS_PER_BLOCK)
 	return RDS_BUFFERING;
 
     rdsBitsinBlock = 0;
 
     // decode bitstream for current block
-    if (!decodeBlock(rdsCurrentBlock,
-	    rdsBitstream,
-	    rdsGrp->isTypeBGroup())) {
+    if (!decodeBlock(rdsCurrentBlock, rdsGrp->isTypeBGroup())) {
 	rdsNumofCRCErrors++;
 	return RDS_NO_CRC;
     }
@@ -313,16 +281,12 @@ rdsBlockSynchronizer::pushBitSynchronized(bool b, RDSGroup* rdsGrp) {
 // until we have a valid block a
 rdsBlockSynchronizer::SyncResult
 rdsBlockSynchronizer::pushBitInBlockA(bool b, RDSGroup* rdsGrp) {
-    uint32_t offsetWord = 0;
-    uint32_t syndrome = 0;
-
     // assert rdsIsSynchronized != true and rdsCurrentBlock == BLOCK_A
-    rdsBitstream = (rdsBitstream << 1) | (b? 01: 00);
-    offsetWord = getOffset(RDSGroup::BLOCK_A,
-	rdsGrp->isTypeBGroup());
+    shiftBit(b);
 
-    // calculate  crc and get the syndrome
-    syndrome = getSyndrome(rdsBitstream & 0x3FFFFFF, offsetWord);
+    // the syndrome slides along with the bitstream
+    const uint32_t syndrome = getSyndrome(RDSGroup::BLOCK_A,
+	rdsGrp->isTypeBGroup());
 
     // During synchronization phase NO errors are allowed
     // in case of error, we continue shifting since we are in BLOCK_A
@@ -341,11 +305,8 @@ rdsBlockSynchronizer::pushBitInBlockA(bool b, RDSGroup* rdsGrp) {
 
 rdsBlockSynchronizer::SyncResult
 rdsBlockSynchronizer::pushBitNotSynchronized(bool b, RDSGroup* rdsGrp) {
-    uint32_t offsetWord = 0;
-    uint32_t syndrome = 0;
-
     // assert rdsIsSynchronized != true and rdsCurrentBlock != BLOCK_A
-    rdsBitstream = (rdsBitstream << 1) | (b? 01: 00);
+    shiftBit(b);
     if (rdsBitsinBlock < NUM_BITS_PER_BLOCK - 1) {
 	rdsBitsinBlock++;
 	return RDS_BUFFERING;
@@ -353,12 +314,10 @@ rdsBlockSynchronizer::pushBitNotSynchronized(bool b, RDSGroup* rdsGrp) {
 
     rdsBitsinBlock = 0;
 
-    offsetWord = getOffset(rdsCurrentBlock,
+    // get the syndrome
+    const uint32_t syndrome = getSyndrome(rdsCurrentBlock,
 	rdsGrp->isTypeBGroup());
 
-    // calculate  crc and get the syndrome
-    syndrome = getSyndrome(rdsBitstream, offsetWord);
-
     // we want zero errors during synchronization
     if (syndrome != 0) {
 	rdsNumofSyncErrors++;
@@ -29,6 +29,7 @@
 #include "trigtabs.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <algorithm>
 
 const DSPFLOAT RDS_BITCLK_HZ = 1187.5;
 
@@ -71,9 +72,7 @@ rdsDecoder::rdsDecoder(RadioInterface* radioInterface,
     // two values of x, we better make the symbollength odd
     length = (symbolCeiling & ~01) + 1;
     rdsFilterSize = 2 * length + 1;
-    rdsBuffer = new DSPFLOAT[rdsFilterSize];
-    memset(rdsBuffer, 0, rdsFilterSize * sizeof(DSPFLOAT));
-    matchIndex = 0;
+    rdsBuffer = new firDelayLine<DSPFLOAT>(rdsFilterSize);
     rdsKernel = new DSPFLOAT[rdsFilterSize];
     rdsKernel[length] = 0;
     for (i = 1; i <= length; i++) {
@@ -82,6 +81,9 @@ rdsDecoder::rdsDecoder(RadioInterface* radioInterface,
 	rdsKernel[length-i] = -0.75*cos(4*M_PI*x)*((1.0/(1.0/x-64*x))-((1.0/(9.0/x-64*x))));
     }
 
+    // the delay line has the oldest sample first
+    std::reverse(rdsKernel, rdsKernel + rdsFilterSize);
+
     // The matched filter is followed by a pretty sharp filter
     // to eliminate all remaining "noise".
     sharpFilter = new BandPassIIR(7, RDS_BITCLK_HZ-6, RDS_BITCLK_HZ+6, rate, S_BUTTERWORTH);
@@ -110,11 +112,12 @@ rdsDecoder::~rdsDecoder(void) {
     delete rdsGroup;
     delete blockSynchroniser;
     delete [] rdsKernel;
-    delete [] rdsBuffer;
+    delete rdsBuffer;
     delete sharpFilter;
 }
 
-void rdsDecoder::reset(void) {
+void rdsDecoder::reset(int32_t frequency) {
+    groupDecoder->setFrequency(frequency);
     groupDecoder->reset();
 }
 
@@ -123,19 +126,7 @@ void rdsDecoder::setPartialText(bool p) {
 }
 
 DSPFLOAT rdsDecoder::match(DSPFLOAT v) {
-    int16_t i;
-    DSPFLOAT tmp = 0;
-
-    rdsBuffer[matchIndex] = v;
-    for (i = 0; i<rdsFilterSize; i++) {
-	int16_t index = (matchIndex-i);
-	if (index<0)
-	    index += rdsFilterSize;
-	tmp += rdsBuffer[index]*rdsKernel[i];
-    }
-
-    matchIndex = (matchIndex+1)%rdsFilterSize;
-    return tmp;
+    return firDot(rdsBuffer->push(v), rdsKernel, rdsFilterSize);
 }
 
 /*
@@ -50,7 +50,10 @@ rdsGroupDecoder::rdsGroupDecoder(RadioInterface* radioInterface, bool p) {
 	radioInterface, SLOT(showLabel(const QString&)));
     connect(this, SIGNAL(setRadioText(const QString&)),
 	radioInterface, SLOT(showText(const QString&)));
+    connect(this, SIGNAL(setPiCode(int, int)),
+	radioInterface, SLOT(showPiCode(int, int)));
     partialText = p;
+    frequency = 0;
     reset();
 }
 
@@ -59,12 +62,18 @@ rdsGroupDecoder::~rdsGroupDecoder(void) {
 	radioInterface, SLOT(showLabel(const QString&)));
     disconnect(this, SIGNAL(setRadioText(const QString&)),
 	radioInterface, SLOT(showText(const QString&)));
+    disconnect(this, SIGNAL(setPiCode(int, int)),
+	radioInterface, SLOT(showPiCode(int, int)));
 }
 
 void rdsGroupDecoder::setPartialText(bool p) {
     partialText = p;
 }
 
+void rdsGroupDecoder::setFrequency(int32_t f) {
+    frequency = f;
+}
+
 void rdsGroupDecoder::reset(void) {
     piCode = 0;
     alphabet = tabG0;
@@ -92,6 +101,7 @@ bool rdsGroupDecoder::decode(RDSGroup* grp) {
     if (grp->getPiCode() != piCode) {
 	reset();
 	piCode = grp->getPiCode();
+	setPiCode(piCode, frequency);
     }
 
     // Cannot decode B type groups
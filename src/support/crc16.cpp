@@ -0,0 +1,56 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "crc16.h"
+
+//	crcTable[k][b] is what byte b does to the register when followed
+//	by k zero bytes, so eight bytes can be folded in independently
+static uint16_t crcTable[8][256];
+
+static struct crcTables {
+    crcTables() {
+	for (int b = 0; b < 256; b++) {
+	    uint16_t c = b << 8;
+
+	    for (int j = 0; j < 8; j++)
+		c = (c & 0x8000)? (c << 1) ^ 0x1021: c << 1;
+	    crcTable[0][b] = c;
+	}
+	for (int k = 1; k < 8; k++)
+	    for (int b = 0; b < 256; b++) {
+		uint16_t c = crcTable[k - 1][b];
+
+		crcTable[k][b] = (c << 8) ^ crcTable[0][c >> 8];
+	    }
+    }
+} tables;
+
+uint16_t crc16(const uint8_t *data, int32_t length, uint16_t crc) {
+    for (; length >= 8; data += 8, length -= 8)
+	crc = crcTable[7][data[0] ^ (crc >> 8)] ^
+	      crcTable[6][data[1] ^ (crc & 0xFF)] ^
+	      crcTable[5][data[2]] ^ crcTable[4][data[3]] ^
+	      crcTable[3][data[4]] ^ crcTable[2][data[5]] ^
+	      crcTable[1][data[6]] ^ crcTable[0][data[7]];
+    for (; length > 0; data++, length--)
+	crc = (crc << 8) ^ crcTable[0][(crc >> 8) ^ *data];
+    return crc;
+}
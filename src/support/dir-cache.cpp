@@ -19,147 +19,316 @@
  *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <QCryptographicHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QRegularExpression>
 #include "dir-cache.h"
 #include "logging.h"
 
 ImageCache::ImageCache(const QString& relativeCacheDir) {
     cacheDir = QDir::home().absoluteFilePath(relativeCacheDir);
-    loadCache();
+    channelImages = 0;
+    pixmaps.setMaxCost(IMAGE_LRU);
+    loadIndex();
 }
 
 ImageCache::~ImageCache() {
-    cache.clear();
-    channelIndex.clear();
+    services.clear();
+    references.clear();
+    pixmaps.clear();
 }
 
-void ImageCache::loadCache() {
-    cache.clear();
-    channelIndex.clear();
+void ImageCache::setChannel(const QString& channel) {
+    QString prefix = channel + "/";
 
-    QDir dir(cacheDir);
-    if (!dir.exists()) {
-	log(LOG_CACHE, LOG_CHATTY, "Cache dir does not exist %s", qPrintable(cacheDir));
+    locker.lock();
+    this->channel = channel;
+    channelImages = 0;
+    for (auto it = services.constBegin(); it != services.constEnd(); ++it)
+	if (it.key().startsWith(prefix))
+	    channelImages += it.value().size();
+    locker.unlock();
+    log(LOG_CACHE, LOG_MIN, "%i images cached for %s", channelImages, qPrintable(channel));
+}
+
+//	one line per image: channel, service, width, height, type and hash
+//	later lines replace earlier ones for the same service, size and type
+void ImageCache::loadIndex() {
+    QFile file(cacheDir + "/" + IMAGE_INDEX);
+    QList<QString> unused;
+    int lines = 0;
+    int entries = 0;
+
+    services.clear();
+    references.clear();
+    if (!file.exists()) {
+	migrate();
 	return;
     }
-    log(LOG_CACHE, LOG_MIN, "loading %s", qPrintable(cacheDir));
+    if (!file.open(QIODevice::ReadOnly)) {
+	log(LOG_CACHE, LOG_MIN, "could not read %s", qPrintable(file.fileName()));
+	return;
+    }
+    QList<QByteArray> index = file.readAll().split('\n');
+    file.close();
+    for (const QByteArray& line : index) {
+	QList<QByteArray> fields = line.split('\t');
+	QString removed;
 
-    QStringList channelDirs = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+	if (fields.size() != 6)
+	    continue;
+	lines++;
+	ImageInfo info;
+	info.width = fields[2].toInt();
+	info.height = fields[3].toInt();
+	info.imageType = QString(fields[4]);
+	info.hash = QString(fields[5]);
+	info.path = imagePath(info.hash, info.imageType);
+	if (insert(serviceKey(QString(fields[0]), QString(fields[1])), info, &removed))
+	    unused.append(removed);
+    }
 
-    for (const QString& serviceId : channelDirs) {
-	QString channelPath = cacheDir + "/" + serviceId;
-	QDir channelDir(channelPath);
+    // a file that was replaced may have come back later on
+    for (const QString& path : unused)
+	if (!references.contains(QFileInfo(path).completeBaseName()))
+	    QFile::remove(path);
+    for (auto it = services.constBegin(); it != services.constEnd(); ++it)
+	entries += it.value().size();
+    log(LOG_CACHE, LOG_MIN, "loaded %i image entries from %s", entries, qPrintable(cacheDir));
+    if (lines > 2 * entries)
+	writeIndex();
+}
 
-	QStringList files = channelDir.entryList(QDir::Files);
+QByteArray ImageCache::indexLine(const QString& key, const ImageInfo& info) {
+    QByteArray k = key.toUtf8();
 
-	for (const QString& filename : files) {
-	    QRegularExpression pattern("^(\\d+)x(\\d+)-([0-9a-fA-F]{4})\\.(\\w+)$");
-	    QRegularExpressionMatch match = pattern.match(filename);
+    k.replace('/', '\t');
+    return QString("%1\t%2\t%3\t%4\t%5\n")
+	.arg(QString(k)).arg(info.width).arg(info.height)
+	.arg(info.imageType).arg(info.hash).toUtf8();
+}
 
-	    if (match.hasMatch()) {
-		int width = match.captured(1).toInt();
-		int height = match.captured(2).toInt();
-		QString hash = match.captured(3).toLower();
-		QString imageType = match.captured(4).toLower();
+//	the old index stays in place until the new one is complete
+void ImageCache::writeIndex() {
+    QSaveFile file(cacheDir + "/" + IMAGE_INDEX);
+    QDir dir;
 
-		QString key = hashKey(serviceId.toLower(), width, height, imageType);
-		QString fullPath = channelPath + "/" + filename;
+    dir.mkpath(cacheDir);
+    if (!file.open(QIODevice::WriteOnly)) {
+	log(LOG_CACHE, LOG_MIN, "could not open %s for writing", qPrintable(file.fileName()));
+	return;
+    }
+    for (auto it = services.constBegin(); it != services.constEnd(); ++it)
+	for (const ImageInfo& info : it.value())
+	    file.write(indexLine(it.key(), info));
+    if (!file.commit())
+	log(LOG_CACHE, LOG_MIN, "could not write %s", qPrintable(file.fileName()));
+}
 
-		cache[key] = fullPath;
+void ImageCache::appendIndex(const QByteArray& line) {
+    QFile file(cacheDir + "/" + IMAGE_INDEX);
 
-		ImageInfo newInfo{fullPath, width, height, imageType, hash};
-		log(LOG_CACHE, LOG_CHATTY, "found %s %s %i %i", qPrintable(fullPath), qPrintable(serviceId), width, height);
-		removeFromChannelIndex(serviceId, width, height, imageType);
+    indexLocker.lock();
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+	indexLocker.unlock();
+	log(LOG_CACHE, LOG_MIN, "could not open %s for writing", qPrintable(file.fileName()));
+	return;
+    }
+    file.write(line);
+    file.close();
+    indexLocker.unlock();
+}
+
+//	the cache used to be a channel/service/size-hash.type tree,
+//	it is moved over to the index the first time round
+void ImageCache::migrate() {
+    QDir dir(cacheDir);
+    QRegularExpression pattern("^(\\d+)x(\\d+)-[0-9a-fA-F]{4}\\.(\\w+)$");
+    QList<QString> unused;
+
+    if (!dir.exists())
+	return;
+    for (const QString& ch : dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+	QDir channelDir(cacheDir + "/" + ch);
+	bool moved = true;
+
+	if (ch == IMAGE_DIR)
+	    continue;
+	for (const QString& serviceId : channelDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+	    QDir serviceDir(channelDir.filePath(serviceId));
 
-		channelIndex.insert(serviceId, newInfo);
+	    for (const QString& filename : serviceDir.entryList(QDir::Files)) {
+		QRegularExpressionMatch match = pattern.match(filename);
+		QFile file(serviceDir.filePath(filename));
+		QString removed;
+		ImageInfo info;
+
+		if (!match.hasMatch() || !file.open(QIODevice::ReadOnly)) {
+		    moved = false;
+		    continue;
+		}
+		QByteArray image = file.readAll();
+		file.close();
+		info.width = match.captured(1).toInt();
+		info.height = match.captured(2).toInt();
+		info.imageType = match.captured(3).toLower();
+		info.hash = calculateHash(image);
+		info.path = imagePath(info.hash, info.imageType);
+		if (!QFile::exists(info.path)) {
+		    dir.mkpath(IMAGE_DIR);
+		    if (!QFile::rename(file.fileName(), info.path)) {
+			log(LOG_CACHE, LOG_MIN, "could not move %s", qPrintable(file.fileName()));
+			moved = false;
+			continue;
+		    }
+		}
+		if (insert(serviceKey(ch, serviceId.toLower()), info, &removed))
+		    unused.append(removed);
 	    }
 	}
+
+	// whatever could not be moved stays where it was
+	if (moved)
+	    channelDir.removeRecursively();
+	else
+	    log(LOG_CACHE, LOG_MIN, "leaving %s in place", qPrintable(channelDir.path()));
     }
+    for (const QString& path : unused)
+	if (!references.contains(QFileInfo(path).completeBaseName()))
+	    QFile::remove(path);
+    if (services.size() > 0) {
+	log(LOG_CACHE, LOG_MIN, "moved %i services to the image index", (int) services.size());
+	writeIndex();
+    }
+}
+
+//	returns true if an entry went, and its file is no longer used
+bool ImageCache::insert(const QString& key, const ImageInfo& info, QString *unused) {
+    QList<ImageInfo>& entries = services[key];
+    bool removed = false;
 
-    log(LOG_CACHE, LOG_MIN, "Cached %i image paths", cache.size());
+    for (int i = 0; i < entries.size(); i++)
+	if (entries[i] == info) {
+	    QString hash = entries[i].hash;
+
+	    if (--references[hash] == 0) {
+		references.remove(hash);
+		*unused = entries[i].path;
+		removed = true;
+	    }
+	    entries.removeAt(i);
+	    break;
+	}
+    entries.append(info);
+    references[info.hash]++;
+    return removed && *unused != info.path;
 }
-    
+
 int ImageCache::imageCount() {
-    return cache.size();
+    locker.lock();
+    int count = channelImages;
+    locker.unlock();
+    return count;
 }
 
 bool ImageCache::hasImage(int32_t SId, int width, int height, 
 		  const QString& imageType) {
-    QString key = hashKey(toServiceId(SId), width, height, imageType);
-    return cache.contains(key);
+    bool found = false;
+
+    locker.lock();
+    for (const ImageInfo& entry : services.value(serviceKey(channel, toServiceId(SId))))
+	if (entry.width == width && entry.height == height &&
+	    entry.imageType == imageType.toLower()) {
+	    found = true;
+	    break;
+	}
+    locker.unlock();
+    return found;
 }
     
 QList<ImageInfo> ImageCache::getImagesForChannel(int32_t SId) {
     QString serviceId = toServiceId(SId);
     log(LOG_CACHE, LOG_CHATTY, "searching images for %s", qPrintable(serviceId));
-    return channelIndex.values(serviceId);
+    locker.lock();
+    QList<ImageInfo> images = services.value(serviceKey(channel, serviceId));
+    locker.unlock();
+    return images;
 }
     
 void ImageCache::addImage(int32_t SId, int width, int height, 
 		  const QString& imageType, const QByteArray& image) {
-    QString serviceId = toServiceId(SId);
-    QString key = hashKey(serviceId, width, height, imageType);
-    QString imageHash = calculateHash(image);
-    QString filename = QString("%1x%2-%3.%4")
-	.arg(width).arg(height).arg(imageHash).arg(imageType.toLower());
-    QString channelPath = QDir::home().absoluteFilePath(cacheDir + "/" + serviceId);
-    QString fullPath = channelPath + "/" + filename;
-
-    QString existingPath = cache.value(key, "");
-    if (existingPath == fullPath) {
-	log(LOG_CACHE, LOG_CHATTY, "skipping unchanged image %s", qPrintable(existingPath));
-	return;
-    } else if (existingPath != "") {
-	cache.remove(key);
-	removeFromChannelIndex(serviceId, width, height, imageType);
-	QFile::remove(existingPath);
-	log(LOG_CACHE, LOG_CHATTY, "replacing mage %s", qPrintable(existingPath));
-    } else
-	log(LOG_CACHE, LOG_MIN, "writing image %s", qPrintable(fullPath));
-    QDir dir;
-    dir.mkpath(channelPath);
+    ImageInfo info;
+    QString unused;
 
-    QFile file(fullPath);
-    if (!file.open(QIODevice::WriteOnly)) {
-	log(LOG_CACHE, LOG_MIN, "could not open %s for writing", qPrintable(fullPath));
-	return;
+    info.width = width;
+    info.height = height;
+    info.imageType = imageType.toLower();
+    info.hash = calculateHash(image);
+    info.path = imagePath(info.hash, info.imageType);
+
+    // the file is written with the lock released
+    locker.lock();
+    QString key = serviceKey(channel, toServiceId(SId));
+    for (const ImageInfo& entry : services.value(key))
+	if (entry == info && entry.hash == info.hash) {
+	    locker.unlock();
+	    log(LOG_CACHE, LOG_CHATTY, "skipping unchanged image %s", qPrintable(info.path));
+	    return;
+	}
+    bool stored = references.contains(info.hash);
+    locker.unlock();
+
+    if (!stored && !QFile::exists(info.path)) {
+	QDir dir;
+	QFile file(info.path);
+
+	log(LOG_CACHE, LOG_MIN, "writing image %s", qPrintable(info.path));
+	dir.mkpath(cacheDir + "/" + IMAGE_DIR);
+	if (!file.open(QIODevice::WriteOnly)) {
+	    log(LOG_CACHE, LOG_MIN, "could not open %s for writing", qPrintable(info.path));
+	    return;
+	}
+	file.write(image);
+	file.close();
     }
-    file.write(image);
-    file.close();
 
-    cache[key] = fullPath;
-    ImageInfo info{fullPath, width, height, imageType, imageHash};
-    channelIndex.insert(serviceId, info);
+    locker.lock();
+    int before = services.value(key).size();
+    bool removed = insert(key, info, &unused);
+    channelImages += services.value(key).size() - before;
+    locker.unlock();
+    appendIndex(indexLine(key, info));
+    if (removed) {
+	log(LOG_CACHE, LOG_CHATTY, "replacing image %s", qPrintable(unused));
+	QFile::remove(unused);
+    }
 }
 
+//	the same logo is asked for on every channel switch
 QPixmap ImageCache::loadImage(const QString& path) {
-    QPixmap p;
-    QString fullPath = QDir::home().absoluteFilePath(path);
+    QPixmap *cached = pixmaps.object(path);
+
+    if (cached != nullptr)
+	return *cached;
 
-    log(LOG_CACHE, LOG_MIN, "loading image %s", qPrintable(fullPath));
-    p.load(fullPath);
+    QPixmap p;
+    log(LOG_CACHE, LOG_MIN, "loading image %s", qPrintable(path));
+    p.load(path);
+    if (!p.isNull())
+	pixmaps.insert(path, new QPixmap(p), qMax(1, p.width() * p.height() * 4 / 1024));
     return p;
 }
 
-void ImageCache::removeFromChannelIndex(const QString& serviceId, int width, 
-				int height, const QString& imageType) {
-    QList<ImageInfo> entries = channelIndex.values(serviceId);
-
-    for (const ImageInfo& entry : entries) {
-	if (entry.width == width && 
-	    entry.height == height && 
-	    entry.imageType == imageType) {
-	    channelIndex.remove(serviceId, entry);
-	    break;
-	}
-    }
+QString ImageCache::serviceKey(const QString& channel, const QString& serviceId) {
+    return QString("%1/%2").arg(channel).arg(serviceId);
 }
 
-QString ImageCache::hashKey(QString serviceId, int width, int height, const QString& imageType) {
-    return QString("%1/%2x%3.%4")
-	.arg(serviceId).arg(width).arg(height).arg(imageType.toLower());
+QString ImageCache::imagePath(const QString& hash, const QString& imageType) {
+    return QString("%1/%2/%3.%4").arg(cacheDir).arg(IMAGE_DIR).arg(hash).arg(imageType);
 }
 
 QString ImageCache::calculateHash(const QByteArray& data) {
-    uint hash = qHash(data);
-    return QString("%1").arg(hash & 0xFFFF, 4, 16, QChar('0'));
+    return QString(QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex());
 }
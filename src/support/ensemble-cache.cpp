@@ -0,0 +1,157 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <QDir>
+#include <QFile>
+#include <QSettings>
+#include "ensemble-cache.h"
+#include "logging.h"
+
+#define	ENS_LAST_EID	"lastEId"
+#define	ENS_SERVICES	"services"
+#define	ENS_NAME	"name"
+#define	ENS_SID		"SId"
+#define	ENS_SCIDS	"SCIds"
+#define	ENS_SUBCHID	"subchId"
+#define	ENS_START	"startAddr"
+#define	ENS_LENGTH	"length"
+#define	ENS_SHORT	"shortForm"
+#define	ENS_PROT	"protLevel"
+#define	ENS_BITRATE	"bitRate"
+#define	ENS_ASCTY	"ASCTy"
+#define	ENS_LANGUAGE	"language"
+#define	ENS_PTY		"programType"
+
+EnsembleCache::EnsembleCache(const QString& relativeCacheDir) {
+    cacheDir = QDir::home().absoluteFilePath(relativeCacheDir);
+}
+
+EnsembleCache::~EnsembleCache() {
+}
+
+QString EnsembleCache::fileName(const QString& channel) {
+    return QString("%1/%2.ini").arg(cacheDir).arg(channel);
+}
+
+//	we don't know the EId until FIG 0/0 comes in, so we go for the
+//	ensemble last seen on the channel
+bool EnsembleCache::lookup(const QString& channel, const QString& serviceName,
+			   int32_t *EId, audiodata *ad) {
+    QString path = fileName(channel);
+
+    ad->defined = false;
+    if (!QFile::exists(path))
+	return false;
+    QSettings s(path, QSettings::IniFormat);
+    bool ok;
+    int32_t id = s.value(ENS_LAST_EID, "").toString().toInt(&ok, 16);
+
+    if (!ok)
+	return false;
+    s.beginGroup(QString::number(id, 16));
+    int size = s.beginReadArray(ENS_SERVICES);
+    for (int i = 0; i < size; i++) {
+	s.setArrayIndex(i);
+	if (s.value(ENS_NAME, "").toString() != serviceName)
+	    continue;
+	ad->serviceName = serviceName;
+	ad->channel = channel;
+	ad->SId = s.value(ENS_SID, 0).toInt();
+	ad->SCIds = s.value(ENS_SCIDS, 0).toInt();
+	ad->subchId = s.value(ENS_SUBCHID, -1).toInt();
+	ad->startAddr = s.value(ENS_START, 0).toInt();
+	ad->length = s.value(ENS_LENGTH, 0).toInt();
+	ad->shortForm = s.value(ENS_SHORT, false).toBool();
+	ad->protLevel = s.value(ENS_PROT, 0).toInt();
+	ad->bitRate = s.value(ENS_BITRATE, 0).toInt();
+	ad->ASCTy = s.value(ENS_ASCTY, 0).toInt();
+	ad->language = s.value(ENS_LANGUAGE, 0).toInt();
+	ad->programType = s.value(ENS_PTY, 0).toInt();
+	ad->compnr = 0;
+	ad->fmFrequency = -1;
+
+	// a mangled entry is as good as no entry
+	ad->defined = ad->subchId >= 0 && ad->length > 0 && ad->bitRate > 0;
+	break;
+    }
+    s.endArray();
+    s.endGroup();
+    if (!ad->defined)
+	return false;
+    *EId = id;
+    log(LOG_CACHE, LOG_MIN, "found %s in cached ensemble %x on %s",
+	qPrintable(serviceName), id, qPrintable(channel));
+    return true;
+}
+
+void EnsembleCache::store(const QString& channel, int32_t EId,
+			  const std::vector<audiodata>& services) {
+    QDir dir;
+
+    if (services.size() == 0)
+	return;
+    dir.mkpath(cacheDir);
+    QSettings s(fileName(channel), QSettings::IniFormat);
+
+    s.setValue(ENS_LAST_EID, QString::number(EId, 16));
+    s.beginGroup(QString::number(EId, 16));
+    s.remove("");
+    s.beginWriteArray(ENS_SERVICES, services.size());
+    for (int i = 0; i < (int) services.size(); i++) {
+	const audiodata &ad = services.at(i);
+
+	s.setArrayIndex(i);
+	s.setValue(ENS_NAME, ad.serviceName);
+	s.setValue(ENS_SID, ad.SId);
+	s.setValue(ENS_SCIDS, ad.SCIds);
+	s.setValue(ENS_SUBCHID, ad.subchId);
+	s.setValue(ENS_START, ad.startAddr);
+	s.setValue(ENS_LENGTH, ad.length);
+	s.setValue(ENS_SHORT, ad.shortForm);
+	s.setValue(ENS_PROT, ad.protLevel);
+	s.setValue(ENS_BITRATE, ad.bitRate);
+	s.setValue(ENS_ASCTY, ad.ASCTy);
+	s.setValue(ENS_LANGUAGE, ad.language);
+	s.setValue(ENS_PTY, ad.programType);
+    }
+    s.endArray();
+    s.endGroup();
+    log(LOG_CACHE, LOG_MIN, "cached ensemble %x on %s with %i services",
+	EId, qPrintable(channel), (int) services.size());
+}
+
+void EnsembleCache::drop(const QString& channel) {
+    if (QFile::remove(fileName(channel)))
+	log(LOG_CACHE, LOG_MIN, "dropped cached ensemble on %s", qPrintable(channel));
+}
+
+//	what the backend needs to be set up the same way
+bool EnsembleCache::sameLayout(const audiodata *a, const audiodata *b) {
+    return a->defined && b->defined &&
+	   a->SId == b->SId &&
+	   a->subchId == b->subchId &&
+	   a->startAddr == b->startAddr &&
+	   a->length == b->length &&
+	   a->shortForm == b->shortForm &&
+	   a->protLevel == b->protLevel &&
+	   a->bitRate == b->bitRate &&
+	   a->ASCTy == b->ASCTy;
+}
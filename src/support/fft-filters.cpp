@@ -35,130 +35,157 @@ fftFilter::fftFilter(int32_t size, int16_t degree) {
     filterDegree = degree;
     OverlapSize = filterDegree;
     NumofSamples = fftSize - OverlapSize;
+    inp = 0;
 
-    MyFFT = new common_fft(fftSize);
-    FFT_A = MyFFT->getVector();
-    MyIFFT = new common_ifft(fftSize);
-    FFT_C = MyIFFT->getVector();
-
-    FilterFFT = new common_fft(fftSize);
-    filterVector = FilterFFT->getVector();
-    RfilterVector = new DSPFLOAT[fftSize];
+    filterVector = new DSPCOMPLEX[fftSize];
+    RfilterVector = new DSPCOMPLEX[fftSize / 2 + 1];
+
+    complexWindow = (DSPCOMPLEX*)FFTW_MALLOC(fftSize * sizeof(DSPCOMPLEX));
+    complexSpectrum = (DSPCOMPLEX*)FFTW_MALLOC(fftSize * sizeof(DSPCOMPLEX));
+    complexResult = (DSPCOMPLEX*)FFTW_MALLOC(fftSize * sizeof(DSPCOMPLEX));
+    realWindow = (DSPFLOAT*)FFTW_MALLOC(fftSize * sizeof(DSPFLOAT));
+    realSpectrum = (DSPCOMPLEX*)FFTW_MALLOC((fftSize / 2 + 1) * sizeof(DSPCOMPLEX));
+    realResult = (DSPFLOAT*)FFTW_MALLOC(fftSize * sizeof(DSPFLOAT));
+
+    complexForward = FFTW_PLAN_DFT_1D(fftSize,
+        reinterpret_cast<fftwf_complex*>(complexWindow),
+        reinterpret_cast<fftwf_complex*>(complexSpectrum),
+        FFTW_FORWARD, FFTW_ESTIMATE);
+    complexBackward = FFTW_PLAN_DFT_1D(fftSize,
+        reinterpret_cast<fftwf_complex*>(complexSpectrum),
+        reinterpret_cast<fftwf_complex*>(complexResult),
+        FFTW_BACKWARD, FFTW_ESTIMATE);
+    realForward = fftwf_plan_dft_r2c_1d(fftSize, realWindow,
+        reinterpret_cast<fftwf_complex*>(realSpectrum), FFTW_ESTIMATE);
+    realBackward = fftwf_plan_dft_c2r_1d(fftSize,
+        reinterpret_cast<fftwf_complex*>(realSpectrum), realResult,
+        FFTW_ESTIMATE);
 
-    Overloop = new DSPCOMPLEX[OverlapSize];
-    inp = 0;
     for (i = 0; i < fftSize; i++) {
-        FFT_A[i] = 0;
-        FFT_C[i] = 0;
         filterVector[i] = 0;
-        RfilterVector[i] = 0;
+        complexWindow[i] = 0;
+        complexResult[i] = 0;
+        realWindow[i] = 0;
+        realResult[i] = 0;
     }
+    for (i = 0; i <= fftSize / 2; i++)
+        RfilterVector[i] = 0;
 }
 
 fftFilter::~fftFilter() {
-    delete MyFFT;
-    delete MyIFFT;
-    delete FilterFFT;
+    FFTW_DESTROY_PLAN(complexForward);
+    FFTW_DESTROY_PLAN(complexBackward);
+    FFTW_DESTROY_PLAN(realForward);
+    FFTW_DESTROY_PLAN(realBackward);
+    FFTW_FREE(complexWindow);
+    FFTW_FREE(complexSpectrum);
+    FFTW_FREE(complexResult);
+    FFTW_FREE(realWindow);
+    FFTW_FREE(realSpectrum);
+    FFTW_FREE(realResult);
+    delete[] filterVector;
     delete[] RfilterVector;
-    delete[] Overloop;
 }
 
-void fftFilter::setSimple(int32_t low, int32_t high, int32_t rate) {
+// the real path only sees the real part of the kernel, whose
+// spectrum is the hermitian part of the complex one.
+// Both have the 1 / fftSize of the inverse transform folded in,
+// the real one also has the historical gain of 3
+void fftFilter::setKernel(const DSPCOMPLEX* kernel) {
+    common_fft FilterFFT(fftSize);
+    DSPCOMPLEX* v = FilterFFT.getVector();
+    DSPFLOAT scale = 1.0 / fftSize;
     int32_t i;
-    BasicBandPass* BandPass = new BasicBandPass((int16_t)filterDegree,
-        low, high, rate);
 
     for (i = 0; i < filterDegree; i++)
-        filterVector[i] = (BandPass->getKernel())[i];
-    memset(&filterVector[filterDegree], 0,
-        (fftSize - filterDegree) * sizeof(DSPCOMPLEX));
-    FilterFFT->do_FFT();
+        v[i] = kernel[i];
+    for (i = filterDegree; i < fftSize; i++)
+        v[i] = 0;
+    FilterFFT.do_FFT();
+
+    for (i = 0; i < fftSize; i++)
+        filterVector[i] = v[i] * scale;
+    for (i = 0; i <= fftSize / 2; i++)
+        RfilterVector[i] = (v[i] + conj(v[(fftSize - i) % fftSize])) * (DSPFLOAT)(1.5 * scale);
     inp = 0;
-    delete BandPass;
+}
+
+void fftFilter::setSimple(int32_t low, int32_t high, int32_t rate) {
+    BasicBandPass BandPass((int16_t)filterDegree, low, high, rate);
+
+    setKernel(BandPass.getKernel());
 }
 
 void fftFilter::setBand(int32_t low, int32_t high, int32_t rate) {
-    int32_t i;
-    BandPassFIR* BandPass = new BandPassFIR((int16_t)filterDegree,
-        low, high,
-        rate);
+    BandPassFIR BandPass((int16_t)filterDegree, low, high, rate);
 
-    for (i = 0; i < filterDegree; i++)
-        filterVector[i] = (BandPass->getKernel())[i];
-    // filterVector [i] = conj ((BandPass -> getKernel ()) [i]);
-    memset(&filterVector[filterDegree], 0,
-        (fftSize - filterDegree) * sizeof(DSPCOMPLEX));
-    FilterFFT->do_FFT();
-    inp = 0;
-    delete BandPass;
+    setKernel(BandPass.getKernel());
 }
 
 void fftFilter::setLowPass(int32_t low, int32_t rate) {
-    int32_t i;
-    LowPassFIR* LowPass = new LowPassFIR((int16_t)filterDegree,
-        low,
-        rate);
+    LowPassFIR LowPass((int16_t)filterDegree, low, rate);
 
-    for (i = 0; i < filterDegree; i++)
-        filterVector[i] = (LowPass->getKernel())[i];
-    memset(&filterVector[filterDegree], 0,
-        (fftSize - filterDegree) * sizeof(DSPCOMPLEX));
-    FilterFFT->do_FFT();
-    inp = 0;
-    delete LowPass;
+    setKernel(LowPass.getKernel());
 }
 
-DSPFLOAT fftFilter::Pass(DSPFLOAT x) {
+// The window holds the last OverlapSize samples of the previous
+// block followed by the new ones, the first OverlapSize outputs of
+// the circular convolution are the aliased ones and are dropped
+void fftFilter::processComplex(void) {
     int32_t j;
-    DSPFLOAT sample;
-
-    sample = real(FFT_C[inp]);
-    FFT_A[inp] = x;
-
-    if (++inp >= NumofSamples) {
-        inp = 0;
-        memset(&FFT_A[NumofSamples], 0,
-            (fftSize - NumofSamples) * sizeof(DSPCOMPLEX));
-        MyFFT->do_FFT();
-
-        for (j = 0; j < fftSize; j++) {
-            FFT_C[j] = FFT_A[j] * filterVector[j];
-            FFT_C[j] = DSPCOMPLEX(real(FFT_C[j]) * 3,
-                imag(FFT_C[j]) * 3);
-        }
-
-        MyIFFT->do_IFFT();
-        for (j = 0; j < OverlapSize; j++) {
-            FFT_C[j] += Overloop[j];
-            Overloop[j] = FFT_C[NumofSamples + j];
-        }
-    }
 
-    return sample;
+    FFTW_EXECUTE(complexForward);
+    for (j = 0; j < fftSize; j++)
+        complexSpectrum[j] *= filterVector[j];
+    FFTW_EXECUTE(complexBackward);
+    memmove(complexWindow, &complexWindow[NumofSamples],
+        OverlapSize * sizeof(DSPCOMPLEX));
+    inp = 0;
 }
 
-DSPCOMPLEX fftFilter::Pass(DSPCOMPLEX z) {
-    DSPCOMPLEX sample;
-    int16_t j;
-
-    sample = FFT_C[inp];
-    FFT_A[inp] = DSPCOMPLEX(real(z), imag(z));
-
-    if (++inp >= NumofSamples) {
-        inp = 0;
-        memset(&FFT_A[NumofSamples], 0,
-            (fftSize - NumofSamples) * sizeof(DSPCOMPLEX));
-        MyFFT->do_FFT();
+void fftFilter::processReal(void) {
+    int32_t j;
 
-        for (j = 0; j < fftSize; j++)
-            FFT_C[j] = FFT_A[j] * filterVector[j];
+    FFTW_EXECUTE(realForward);
+    for (j = 0; j <= fftSize / 2; j++)
+        realSpectrum[j] *= RfilterVector[j];
+    FFTW_EXECUTE(realBackward);
+    memmove(realWindow, &realWindow[NumofSamples],
+        OverlapSize * sizeof(DSPFLOAT));
+    inp = 0;
+}
 
-        MyIFFT->do_IFFT();
-        for (j = 0; j < OverlapSize; j++) {
-            FFT_C[j] += Overloop[j];
-            Overloop[j] = FFT_C[NumofSamples + j];
-        }
+// in and out may be the same buffer
+void fftFilter::Pass(const DSPCOMPLEX* in, DSPCOMPLEX* out, int32_t n) {
+    while (n > 0) {
+        int32_t amount = NumofSamples - inp;
+
+        if (amount > n)
+            amount = n;
+        memcpy(&complexWindow[OverlapSize + inp], in, amount * sizeof(DSPCOMPLEX));
+        memcpy(out, &complexResult[OverlapSize + inp], amount * sizeof(DSPCOMPLEX));
+        in += amount;
+        out += amount;
+        n -= amount;
+        inp += amount;
+        if (inp >= NumofSamples)
+            processComplex();
     }
+}
 
-    return sample;
+void fftFilter::Pass(const DSPFLOAT* in, DSPFLOAT* out, int32_t n) {
+    while (n > 0) {
+        int32_t amount = NumofSamples - inp;
+
+        if (amount > n)
+            amount = n;
+        memcpy(&realWindow[OverlapSize + inp], in, amount * sizeof(DSPFLOAT));
+        memcpy(out, &realResult[OverlapSize + inp], amount * sizeof(DSPFLOAT));
+        in += amount;
+        out += amount;
+        n -= amount;
+        inp += amount;
+        if (inp >= NumofSamples)
+            processReal();
+    }
 }
@@ -0,0 +1,152 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "fir-engine.h"
+#include "simd-helper.h"
+
+DSPFLOAT firDot(const DSPFLOAT* a, const DSPFLOAT* b, int n) {
+    DSPFLOAT sum = 0;
+    int i = 0;
+
+#if defined(SIMD_AVX2)
+    __m256 acc = _mm256_setzero_ps();
+    DSPFLOAT t[8];
+
+    for (; i + 8 <= n; i += 8)
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc);
+    _mm256_storeu_ps(t, acc);
+    sum = ((t[0] + t[4]) + (t[1] + t[5])) + ((t[2] + t[6]) + (t[3] + t[7]));
+#elif defined(SIMD_SSE2)
+    __m128 acc = _mm_setzero_ps();
+    DSPFLOAT t[4];
+
+    for (; i + 4 <= n; i += 4)
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    _mm_storeu_ps(t, acc);
+    sum = (t[0] + t[2]) + (t[1] + t[3]);
+#elif defined(SIMD_NEON)
+    float32x4_t acc = vdupq_n_f32(0);
+    DSPFLOAT t[4];
+
+    for (; i + 4 <= n; i += 4)
+        acc = vmlaq_f32(acc, vld1q_f32(a + i), vld1q_f32(b + i));
+    vst1q_f32(t, acc);
+    sum = (t[0] + t[2]) + (t[1] + t[3]);
+#endif
+
+    for (; i < n; i++)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+// n is expected to be even, the vector widths are, so the
+// lanes keep their parity
+void firDot2(const DSPFLOAT* a, const DSPFLOAT* b, int n, DSPFLOAT* even, DSPFLOAT* odd) {
+    DSPFLOAT e = 0;
+    DSPFLOAT o = 0;
+    int i = 0;
+
+#if defined(SIMD_AVX2)
+    __m256 acc = _mm256_setzero_ps();
+    DSPFLOAT t[8];
+
+    for (; i + 8 <= n; i += 8)
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc);
+    _mm256_storeu_ps(t, acc);
+    e = (t[0] + t[4]) + (t[2] + t[6]);
+    o = (t[1] + t[5]) + (t[3] + t[7]);
+#elif defined(SIMD_SSE2)
+    __m128 acc = _mm_setzero_ps();
+    DSPFLOAT t[4];
+
+    for (; i + 4 <= n; i += 4)
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    _mm_storeu_ps(t, acc);
+    e = t[0] + t[2];
+    o = t[1] + t[3];
+#elif defined(SIMD_NEON)
+    float32x4_t acc = vdupq_n_f32(0);
+    DSPFLOAT t[4];
+
+    for (; i + 4 <= n; i += 4)
+        acc = vmlaq_f32(acc, vld1q_f32(a + i), vld1q_f32(b + i));
+    vst1q_f32(t, acc);
+    e = t[0] + t[2];
+    o = t[1] + t[3];
+#endif
+
+    for (; i + 1 < n; i += 2) {
+        e += a[i] * b[i];
+        o += a[i + 1] * b[i + 1];
+    }
+    *even = e;
+    *odd = o;
+}
+
+firEngine::firEngine(int16_t size)
+    : complexLine(size)
+    , realLine(size) {
+    this->size = size;
+    complexKernel = false;
+    realKernel = new DSPFLOAT[size];
+    pairKernel = new DSPFLOAT[2 * size];
+    swappedKernel = new DSPFLOAT[2 * size];
+    for (int i = 0; i < size; i++)
+        realKernel[i] = 0;
+    for (int i = 0; i < 2 * size; i++) {
+        pairKernel[i] = 0;
+        swappedKernel[i] = 0;
+    }
+}
+
+firEngine::~firEngine(void) {
+    delete[] realKernel;
+    delete[] pairKernel;
+    delete[] swappedKernel;
+}
+
+// kernel [0] applies to the newest sample, the delay line has
+// the newest sample last
+void firEngine::setKernel(const DSPCOMPLEX* kernel) {
+    int i;
+
+    complexKernel = false;
+    for (i = 0; i < size; i++)
+        if (imag(kernel[i]) != 0) {
+            complexKernel = true;
+            break;
+        }
+
+    for (i = 0; i < size; i++) {
+        DSPCOMPLEX k = kernel[size - 1 - i];
+
+        realKernel[i] = real(k);
+        pairKernel[2 * i] = real(k);
+        pairKernel[2 * i + 1] = complexKernel ? imag(k) : real(k);
+        swappedKernel[2 * i] = imag(k);
+        swappedKernel[2 * i + 1] = real(k);
+    }
+}
+
+void firEngine::reset(void) {
+    complexLine.reset();
+    realLine.reset();
+}
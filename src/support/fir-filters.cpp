@@ -55,6 +55,7 @@ void LowPassFIR::newKernel(int32_t Fc) {
 
     for (i = 0; i < filterSize; i++)
         filterKernel[i] = DSPCOMPLEX(tmp[i] / sum, 0);
+    updateKernel();
 }
 
 LowPassFIR::~LowPassFIR() {
@@ -93,6 +94,7 @@ void HighPassFIR::newKernel(int32_t Fc) {
             filterKernel[i] = DSPCOMPLEX(1.0 - tmp[i] / sum, 0);
         else
             filterKernel[i] = DSPCOMPLEX(-tmp[i] / sum, 0);
+    updateKernel();
 }
 
 HighPassFIR::~HighPassFIR() {
@@ -160,6 +162,7 @@ BasicBandPass::BasicBandPass(int16_t firsize,
         (DSPFLOAT)high / rate);
     for (i = 0; i < filterSize; i++)
         filterKernel[i] = DSPCOMPLEX(t1[i], t1[i]);
+    updateKernel();
 }
 
 BasicBandPass::~BasicBandPass() {
@@ -205,6 +208,7 @@ void BandPassFIR::newKernel(int32_t low, int32_t high) {
         filterKernel[i] = DSPCOMPLEX(tmp[i] * cos(v) / sum,
             tmp[i] * sin(v) / sum);
     }
+    updateKernel();
 }
 
 BandPassFIR::~BandPassFIR() {
@@ -317,6 +321,7 @@ void DecimatingFIR::newKernel(int32_t low) {
 
     for (i = 0; i < filterSize; i++)
         filterKernel[i] = DSPCOMPLEX(tmp[i] / sum, tmp[i]);
+    updateKernel();
 }
 
 DSPCOMPLEX* DecimatingFIR::getKernel(void) {
@@ -359,6 +364,7 @@ void DecimatingFIR::newKernel(int32_t low, int32_t high) {
         filterKernel[i] = DSPCOMPLEX(tmp[i] * cos(v) / sum,
             tmp[i] * sin(v) / sum);
     }
+    updateKernel();
 }
 
 DecimatingFIR::~DecimatingFIR() {
@@ -367,65 +373,64 @@ DecimatingFIR::~DecimatingFIR() {
 // The real cpu killer: this function is called once for every
 // sample that comes from the dongle. So, it really should be
 // optimized.
+// Samples that are decimated away only go in the delay line.
 bool DecimatingFIR::Pass(DSPCOMPLEX z, DSPCOMPLEX* z_out) {
-    int16_t i;
-    DSPCOMPLEX tmp = 0;
-    int16_t index;
-
-    Buffer[ip] = z;
     if (++decimationCounter < decimationFactor) {
-        ip = (ip + 1) % filterSize;
+        engine.push(z);
         return false;
     }
 
     decimationCounter = 0;
-
-    // we are working with a circular buffer, we take two steps
-    // we move from ip .. 0 with i going from 0 .. ip -1
-    for (i = 0; i <= ip; i++) {
-        index = ip - i;
-        tmp += Buffer[index] * filterKernel[i];
-    }
-
-    //	and then we take the rest
-    for (i = ip + 1; i < filterSize; i++) {
-        index = filterSize + ip - i;
-        tmp += Buffer[index] * filterKernel[i];
-    }
-
-    ip = (ip + 1) % filterSize;
-    *z_out = tmp;
+    *z_out = engine.Pass(z);
     return true;
 }
 
 bool DecimatingFIR::Pass(DSPFLOAT z, DSPFLOAT* z_out) {
     if (++decimationCounter < decimationFactor) {
-        Buffer[ip] = DSPCOMPLEX(z, 0);
-        ip = (ip + 1) % filterSize;
+        engine.push(z);
         return false;
     }
 
     decimationCounter = 0;
-    *z_out = Basic_FIR::Pass(z);
+    *z_out = engine.Pass(z);
     return true;
 }
 
+// block versions, in and out may be the same buffer
+// returns the number of output samples
+int DecimatingFIR::Pass(const DSPCOMPLEX* in, DSPCOMPLEX* out, int n) {
+    int i;
+    int count = 0;
+
+    for (i = 0; i < n; i++)
+        if (Pass(in[i], &out[count]))
+            count++;
+    return count;
+}
+
+int DecimatingFIR::Pass(const DSPFLOAT* in, DSPFLOAT* out, int n) {
+    int i;
+    int count = 0;
+
+    for (i = 0; i < n; i++)
+        if (Pass(in[i], &out[count]))
+            count++;
+    return count;
+}
+
 // The Hilbertfilter is derived from QEX Mar/April 1998
 // to perform a 90 degree phase shift needed for (a.o)
 // USB and LSB detection.
-HilbertFilter::HilbertFilter(int16_t fsize, DSPFLOAT f, int32_t rate) {
+HilbertFilter::HilbertFilter(int16_t fsize, DSPFLOAT f, int32_t rate)
+    : delayLine(fsize) {
     firsize = fsize;
     this->rate = rate;
-    cosKernel = new DSPFLOAT[fsize];
-    sinKernel = new DSPFLOAT[fsize];
-    Buffer = new DSPCOMPLEX[fsize];
+    kernel = new DSPFLOAT[2 * fsize];
     adjustFilter(f);
 }
 
 HilbertFilter::~HilbertFilter() {
-    delete[] cosKernel;
-    delete[] sinKernel;
-    delete[] Buffer;
+    delete[] kernel;
 }
  
 // the validity of the hilbertshift was validated
@@ -440,14 +445,17 @@ void HilbertFilter::adjustFilter(DSPFLOAT centre) {
     for (i = 0; i < firsize; i++)
         v1[i] = v1[i] / sum;
 
+    // tap 0 has always applied to the oldest sample, and tap i
+    // to the i-1 th newest one: lay the kernel out accordingly
     for (i = 0; i < firsize; i++) {
         DSPFLOAT omega = 2.0 * M_PI * centre;
-        cosKernel[i] = v1[i] * cos(omega * (i - ((DSPFLOAT)firsize - 1) / (2.0 * rate)));
-        sinKernel[i] = v1[i] * sin(omega * (i - ((DSPFLOAT)firsize - 1) / (2.0 * rate)));
-        Buffer[i] = 0;
+        int16_t j = (firsize - i) % firsize;
+
+        kernel[2 * j] = v1[i] * cos(omega * (i - ((DSPFLOAT)firsize - 1) / (2.0 * rate)));
+        kernel[2 * j + 1] = v1[i] * sin(omega * (i - ((DSPFLOAT)firsize - 1) / (2.0 * rate)));
     }
 
-    ip = 0;
+    delayLine.reset();
 }
 
 DSPCOMPLEX HilbertFilter::Pass(DSPFLOAT a, DSPFLOAT b) {
@@ -455,21 +463,16 @@ DSPCOMPLEX HilbertFilter::Pass(DSPFLOAT a, DSPFLOAT b) {
 }
 
 DSPCOMPLEX HilbertFilter::Pass(DSPCOMPLEX z) {
-    DSPCOMPLEX tmp = 0;
+    const DSPFLOAT* w = reinterpret_cast<const DSPFLOAT*>(delayLine.push(z));
     DSPFLOAT re, im;
-    int i;
 
-    Buffer[ip] = z;
-    ip = (ip + 1) % firsize;
+    firDot2(w, kernel, 2 * firsize, &re, &im);
+    return DSPCOMPLEX(re, im);
+}
 
-    for (i = 0; i < firsize; i++) {
-        int16_t index = ip - i;
-        if (index < 0)
-            index += firsize;
-        re = real(Buffer[index]);
-        im = imag(Buffer[index]);
-        tmp += DSPCOMPLEX(re * cosKernel[i], im * sinKernel[i]);
-    }
+void HilbertFilter::Pass(const DSPCOMPLEX* in, DSPCOMPLEX* out, int n) {
+    int i;
 
-    return tmp;
+    for (i = 0; i < n; i++)
+        out[i] = Pass(in[i]);
 }
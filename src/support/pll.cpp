@@ -78,6 +78,41 @@ DSPFLOAT pll::doPll(DSPCOMPLEX signal, DSPFLOAT phase) {
     return ret;
 }
 
+// block version, for the FM decoder: returns the phase increment,
+// i.e. the frequency, after each sample.
+// The loop state is kept in locals, and the table lookups are
+// replaced by polynomials
+void pll::doPll(const DSPCOMPLEX* signal, DSPFLOAT* phaseIncrs, int32_t n) {
+    DSPFLOAT phase = ncoPhase;
+    DSPFLOAT incr = phaseIncr;
+    DSPFLOAT defaultIncr = cf*2*M_PI/rate;
+    const DSPFLOAT twoPi = 2*M_PI;
+    const DSPFLOAT b = beta;
+    const DSPFLOAT alpha = 1-beta;
+    const DSPFLOAT loLimit = ncoLLimit;
+    const DSPFLOAT hiLimit = ncoHLimit;
+
+    for (int32_t i = 0; i < n; i++) {
+	DSPCOMPLEX nco = polyPhasor(phase);
+	DSPFLOAT re = real(nco)*real(signal[i])-imag(nco)*imag(signal[i]);
+	DSPFLOAT im = real(nco)*imag(signal[i])+imag(nco)*real(signal[i]);
+
+	incr = b*incr-alpha*polyAtan2(im, re);
+	if (incr<loLimit || incr>hiLimit)
+	    incr = defaultIncr;
+
+	// the limits keep the increment well within one turn
+	phase += incr;
+	if (phase >= twoPi)
+	    phase -= twoPi;
+	else if (phase < 0)
+	    phase += twoPi;
+	phaseIncrs[i] = incr;
+    }
+    ncoPhase = phase;
+    phaseIncr = incr;
+}
+
 DSPFLOAT pll::getPhaseIncr(void) {
     return phaseIncr;
 }
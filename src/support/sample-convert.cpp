@@ -0,0 +1,115 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "sample-convert.h"
+#include "simd-helper.h"
+#include <algorithm>
+#include <cfloat>
+#include <climits>
+
+void resetAgcStats(agcStats *stats) {
+    stats->min = INT_MAX;
+    stats->max = INT_MIN;
+    stats->overflows = 0;
+}
+
+void mergeAgcStats(agcStats *stats, const agcStats *more) {
+    stats->min = std::min(stats->min, more->min);
+    stats->max = std::max(stats->max, more->max);
+    stats->overflows += more->overflows;
+}
+
+//	integer samples are exact in a float, so min, max and the
+//	overflow test are done on the widened values;
+//	x <= lo and x >= hi become x < lo + 0.5 and x > hi - 0.5
+template <class T, vfloat (*load)(const T *)>
+static void convertKernel(const T *in, float *out, int32_t n,
+			  float offset, float scale, int32_t lo, int32_t hi,
+			  agcStats *stats) {
+    const vfloat vOffset = vSet(offset);
+    const vfloat vScale = vSet(scale);
+    const vfloat vLo = vSet(lo + 0.5f);
+    const vfloat vHi = vSet(hi - 0.5f);
+    const vfloat one = vSet(1);
+    const vfloat zero = vSet(0);
+    vfloat vMinimum = vSet(FLT_MAX);
+    vfloat vMaximum = vSet(-FLT_MAX);
+    vfloat vCount = zero;
+    float minimum, maximum, count;
+    float t[VFLOAT_SIZE];
+    int32_t i = 0;
+
+    for (; i + VFLOAT_SIZE <= n; i += VFLOAT_SIZE) {
+	vfloat x = load(in + i);
+
+	vMinimum = vMin(vMinimum, x);
+	vMaximum = vMax(vMaximum, x);
+	vCount = vAdd(vCount, vSelect(vOr(vLess(x, vLo), vLess(vHi, x)), one, zero));
+	vStore(out + i, vMul(vSub(x, vOffset), vScale));
+    }
+
+    vStore(t, vMinimum);
+    minimum = t[0];
+    for (int j = 1; j < VFLOAT_SIZE; j++)
+	minimum = std::min(minimum, t[j]);
+    vStore(t, vMaximum);
+    maximum = t[0];
+    for (int j = 1; j < VFLOAT_SIZE; j++)
+	maximum = std::max(maximum, t[j]);
+    vStore(t, vCount);
+    count = 0;
+    for (int j = 0; j < VFLOAT_SIZE; j++)
+	count += t[j];
+
+    for (; i < n; i++) {
+	float x = (float) in[i];
+
+	minimum = std::min(minimum, x);
+	maximum = std::max(maximum, x);
+	if (x < lo + 0.5f || x > hi - 0.5f)
+	    count++;
+	out[i] = (x - offset) * scale;
+    }
+
+    if (stats == nullptr || n == 0)
+	return;
+    stats->min = std::min(stats->min, (int) minimum);
+    stats->max = std::max(stats->max, (int) maximum);
+    stats->overflows += (int) count;
+}
+
+void convertIQ(const uint8_t *in, std::complex<float> *V, int32_t n,
+	       float offset, float scale, int32_t lo, int32_t hi, agcStats *stats) {
+    convertKernel<uint8_t, vLoadU8>(in, (float *) V, 2 * n,
+				    offset, scale, lo, hi, stats);
+}
+
+void convertIQ(const int16_t *in, std::complex<float> *V, int32_t n,
+	       float offset, float scale, int32_t lo, int32_t hi, agcStats *stats) {
+    convertKernel<int16_t, vLoadS16>(in, (float *) V, 2 * n,
+				     offset, scale, lo, hi, stats);
+}
+
+void convertIQ(const int32_t *in, std::complex<float> *V, int32_t n,
+	       float offset, float scale, int32_t lo, int32_t hi, agcStats *stats) {
+    convertKernel<int32_t, vLoadS32>(in, (float *) V, 2 * n,
+				     offset, scale, lo, hi, stats);
+}
@@ -0,0 +1,265 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <QBuffer>
+#include <QImageReader>
+#include <QPainter>
+#include "slide-pipeline.h"
+#include "logging.h"
+
+slidePipeline::slidePipeline(void) {
+    running = true;
+    generation = 0;
+    cache = nullptr;
+}
+
+slidePipeline::~slidePipeline(void) {
+    stop();
+}
+
+void slidePipeline::stop(void) {
+    locker.lock();
+    running = false;
+    wakeUp.wakeAll();
+    locker.unlock();
+    wait();
+}
+
+// whatever is still queued belongs to the previous cache
+void slidePipeline::setCache(ImageCache *c) {
+    cacheLocker.lock();
+    locker.lock();
+    cache = c;
+    generation++;
+    jobs.clear();
+    locker.unlock();
+    cacheLocker.unlock();
+}
+
+void slidePipeline::addSlide(const QByteArray &data, const char *type,
+			     const QString &name, QSize target) {
+    slideJob job { data, type, name, -1, target, true, 0 };
+
+    locker.lock();
+    job.generation = generation;
+
+    // a slide that hasn't made it to the screen yet is stale anyway
+    for (auto it = jobs.begin(); jobs.size() >= SLIDE_QUEUE && it != jobs.end(); )
+	if (it->isSlide)
+	    it = jobs.erase(it);
+	else
+	    ++it;
+    jobs.push_back(job);
+    wakeUp.wakeOne();
+    locker.unlock();
+}
+
+void slidePipeline::addPicture(const QByteArray &data, const char *type,
+			       const QString &name, int32_t SId, QSize target) {
+    slideJob job { data, type, name, SId, target, false, 0 };
+
+    locker.lock();
+    job.generation = generation;
+    jobs.push_back(job);
+    wakeUp.wakeOne();
+    locker.unlock();
+}
+
+void slidePipeline::run(void) {
+    for (;;) {
+	locker.lock();
+	while (running && jobs.empty())
+	    wakeUp.wait(&locker);
+	if (!running) {
+	    locker.unlock();
+	    return;
+	}
+	slideJob job = jobs.front();
+	jobs.pop_front();
+	locker.unlock();
+	process(job);
+    }
+}
+
+void slidePipeline::process(const slideJob &job) {
+    QImage image;
+    QSize original;
+    bool found = false;
+
+    // carousels keep sending the same pictures, and a slide and a
+    // picture with the same content are decoded differently
+    for (auto it = variants.begin(); it != variants.end(); ++it)
+	if (it->target == job.target && it->isSlide == job.isSlide &&
+	    it->type == job.type && it->data == job.data) {
+	    slideVariant v = *it;
+
+	    variants.erase(it);
+	    variants.push_front(v);
+	    image = v.image;
+	    original = v.original;
+	    found = true;
+	    break;
+	}
+    if (!found) {
+	if (!decode(job, &image, &original))
+	    return;
+	variants.push_front(slideVariant { job.data, job.target, job.isSlide, job.type,
+					   image, original });
+	if (variants.size() > SLIDE_VARIANTS)
+	    variants.pop_back();
+    }
+    if (job.isSlide) {
+	emit slideReady(image, job.generation);
+	return;
+    }
+
+    cacheLocker.lock();
+    if (cache != nullptr && job.generation == generation)
+	cache->addImage(job.SId, original.width(), original.height(), job.type, job.data);
+    cacheLocker.unlock();
+    emit pictureReady(image, job.SId, original.width(), original.height(), job.generation);
+}
+
+// large pictures are decoded straight to the size they will be shown at
+bool slidePipeline::decode(const slideJob &job, QImage *image, QSize *original) {
+    QBuffer buffer;
+    buffer.setData(job.data);
+    buffer.open(QIODevice::ReadOnly);
+
+    QImageReader reader(&buffer);
+
+    if (!reader.canRead())
+	return false;
+
+    QString found = reader.format();
+    if (found != job.type) {
+	log(LOG_EVENT, LOG_MIN, "expected %s to be %s found %s", qPrintable(job.name),
+	    qPrintable(job.type), qPrintable(found));
+	return false;
+    }
+    *original = reader.size();
+    if (original->isValid() && job.target.isValid() &&
+	(original->width() > job.target.width() || original->height() > job.target.height()))
+	reader.setScaledSize(original->scaled(job.target, Qt::KeepAspectRatio));
+    if (!reader.read(image)) {
+	log(LOG_EVENT, LOG_MIN, "cannot decode %s: %s", qPrintable(job.name),
+	    qPrintable(reader.errorString()));
+	return false;
+    }
+    if (!original->isValid())
+	*original = image->size();
+    if (job.isSlide)
+	*image = trimBorders(*image);
+    return !image->isNull();
+}
+
+#define BLACK_THRESHOLD 10
+
+static inline bool isBorder(QRgb pixel) {
+    return qAlpha(pixel) == 0 ||
+	(qRed(pixel) <= BLACK_THRESHOLD &&
+	 qGreen(pixel) <= BLACK_THRESHOLD &&
+	 qBlue(pixel) <= BLACK_THRESHOLD);
+}
+
+// the whole row, without an early exit, so that the loop vectorises
+static bool rowIsBorder(const QRgb *line, int width) {
+    uint32_t content = 0;
+
+    for (int x = 0; x < width; x++)
+	content |= !isBorder(line[x]);
+    return content == 0;
+}
+
+// Black or transparent borders go. If there are borders all around,
+// the sides are made transparent rather than cut, so that the content
+// keeps its scale.
+QImage trimBorders(const QImage &image) {
+    QImage img = image;
+
+    if (img.format() != QImage::Format_RGB32 && img.format() != QImage::Format_ARGB32)
+	img = img.convertToFormat(QImage::Format_ARGB32);
+
+    int width = img.width();
+    int height = img.height();
+    int top = 0;
+    int bottom = height - 1;
+    int left = 0;
+    int right = width - 1;
+
+    if (width == 0 || height == 0)
+	return QImage();
+
+    bool trimTop = isBorder(reinterpret_cast<const QRgb *>(img.constScanLine(0))[0]);
+    bool trimBottom = isBorder(reinterpret_cast<const QRgb *>(img.constScanLine(bottom))[right]);
+
+    if (trimTop)
+	for (; top < height &&
+	       rowIsBorder(reinterpret_cast<const QRgb *>(img.constScanLine(top)), width); ++top);
+    if (trimBottom)
+	for (; bottom > top &&
+	       rowIsBorder(reinterpret_cast<const QRgb *>(img.constScanLine(bottom)), width); --bottom);
+    if (top > bottom)
+	return QImage();
+
+    // the sides, a row at a time, and only as far as the edges found so far
+    if (trimTop || trimBottom) {
+	int contentLeft = trimTop? width: 0;
+	int contentRight = trimBottom? -1: width - 1;
+
+	for (int y = top; y <= bottom; y++) {
+	    const QRgb *line = reinterpret_cast<const QRgb *>(img.constScanLine(y));
+	    int x;
+
+	    for (x = 0; x < contentLeft && isBorder(line[x]); x++);
+	    contentLeft = x;
+	    for (x = width - 1; x > contentRight && isBorder(line[x]); x--);
+	    contentRight = x;
+	    if (contentLeft == 0 && contentRight == width - 1)
+		break;
+	}
+	left = contentLeft;
+	right = contentRight;
+    }
+
+    int doTop = (top > 0 || bottom < height - 1);
+    int doSides = (left > 0 || right < width - 1);
+    if (left > right)
+	return QImage();
+    else if (!doTop && !doSides)
+	return img;
+
+    // if only one pair of sides, we can just trim the image,
+    // as the content scaling won't change
+    if (doTop != doSides)
+	return img.copy(left, top, right - left + 1, bottom - top + 1);
+
+    // otherwise crop top and bottom and fill left and right
+    img = img.copy(0, top, width, bottom - top + 1).convertToFormat(QImage::Format_ARGB32);
+    QPainter painter(&img);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    if (left > 0)
+	painter.fillRect(0, 0, left, img.height(), Qt::transparent);
+    if (right < width - 1)
+	painter.fillRect(right + 1, 0, width - right - 1, img.height(), Qt::transparent);
+    painter.end();
+    return img;
+}
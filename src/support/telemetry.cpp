@@ -0,0 +1,351 @@
+/*
+ *    Copyright (C) 2022
+ *    Marco Greco <marcogrecopriolo@gmail.com>
+ *
+ *    This file is part of the guglielmo FM DAB tuner software package.
+ *
+ *    guglielmo is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    guglielmo is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with guglielmo; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "telemetry.h"
+#include "constants.h"
+#include "logging.h"
+#include <QFile>
+#include <QSaveFile>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#if !IS_WINDOWS
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0	// SO_NOSIGPIPE instead
+#endif
+#endif
+
+bool telemetryEnabled = false;
+
+static const char *stageNames[TEL_STAGES] = {
+    "sample_wait", "sync", "fft", "demap",
+    "fic_viterbi", "msc_viterbi", "rs", "aac"
+};
+
+static const char *counterNames[TEL_COUNTERS] = {
+    "sync_lost", "fic_crc_errors", "fig_repeats", "rs_failures", "aac_errors",
+    "audio_underrun_samples", "audio_overrun_samples"
+};
+
+static const char *gaugeNames[TEL_GAUGES] = {
+    "audio_fill_permille"
+};
+
+static const double quantiles[4] = { 0.5, 0.9, 0.99, 0.999 };
+
+//	blocks are never freed: a thread that exits hands its block,
+//	counts and all, to the next thread that starts recording
+static std::atomic<telemetryBlock *> blockList(nullptr);
+static std::atomic<int64_t> gaugeValues[TEL_GAUGES];
+
+class telemetryOwner {
+public:
+    telemetryOwner(void): block(nullptr) {}
+    ~telemetryOwner(void) {
+	if (block != nullptr)
+	    block->inUse.store(false, std::memory_order_release);
+    }
+
+    telemetryBlock *block;
+};
+
+static thread_local telemetryOwner owner;
+
+static
+telemetryBlock *acquireBlock(void) {
+    telemetryBlock *b;
+
+    for (b = blockList.load(std::memory_order_acquire); b != nullptr; b = b->next) {
+	bool idle = false;
+
+	if (b->inUse.compare_exchange_strong(idle, true, std::memory_order_acquire))
+	    return b;
+    }
+    b = new telemetryBlock;
+    for (int s = 0; s < TEL_STAGES; s++) {
+	for (int i = 0; i < TEL_BUCKETS; i++)
+	    b->stage[s].bucket[i].store(0);
+	b->stage[s].count.store(0);
+	b->stage[s].sum.store(0);
+	b->stage[s].max.store(0);
+    }
+    for (int c = 0; c < TEL_COUNTERS; c++)
+	b->counter[c].store(0);
+    b->inUse.store(true);
+    b->next = blockList.load(std::memory_order_relaxed);
+    while (!blockList.compare_exchange_weak(b->next, b, std::memory_order_release))
+	;
+    return b;
+}
+
+telemetryBlock *telemetryThreadBlock(void) {
+    if (owner.block == nullptr)
+	owner.block = acquireBlock();
+    return owner.block;
+}
+
+void telemetrySetGauge(telemetryGauge g, int64_t v) {
+    if (telemetryEnabled)
+	gaugeValues[g].store(v, std::memory_order_relaxed);
+}
+
+//	the upper bound of a bucket, so that quantiles err on the safe side
+static
+uint64_t bucketLimit(int b) {
+    if (b < (2 << TEL_SUB_BITS))
+	return b;
+    int msb = ((b - (2 << TEL_SUB_BITS)) >> TEL_SUB_BITS) + TEL_SUB_BITS + 1;
+    uint64_t sub = b & ((1 << TEL_SUB_BITS) - 1);
+
+    return (((1 << TEL_SUB_BITS) + sub + 1) << (msb - TEL_SUB_BITS)) - 1;
+}
+
+telemetryWriter::telemetryWriter(const QString &target, int32_t interval) {
+    this->target = target;
+    this->interval = interval;
+    listenSocket = -1;
+    json = target.endsWith(".json");
+    if (target.startsWith("unix:")) {
+	socketPath = target.mid(5);
+	json = false;
+    }
+    previous.assign(TEL_STAGES * TEL_BUCKETS, 0);
+    current.assign(TEL_STAGES * TEL_BUCKETS, 0);
+    memset(stages, 0, sizeof(stages));
+    memset(counters, 0, sizeof(counters));
+    memset(gauges, 0, sizeof(gauges));
+    telemetryEnabled = true;
+    start();
+}
+
+telemetryWriter::~telemetryWriter(void) {
+    stop();
+}
+
+void telemetryWriter::stop(void) {
+    if (!isRunning())
+	return;
+    stopping.release();
+    wait();
+}
+
+//	sums the per thread blocks, and works out the quantiles of
+//	what was recorded since the last snapshot
+void telemetryWriter::snapshot(void) {
+    memset(stages, 0, sizeof(stages));
+    memset(counters, 0, sizeof(counters));
+    std::fill(current.begin(), current.end(), 0);
+    for (telemetryBlock *b = blockList.load(std::memory_order_acquire);
+	 b != nullptr; b = b->next) {
+	for (int s = 0; s < TEL_STAGES; s++) {
+	    telemetryHistogram &h = b->stage[s];
+
+	    for (int i = 0; i < TEL_BUCKETS; i++)
+		current[s * TEL_BUCKETS + i] += h.bucket[i].load(std::memory_order_relaxed);
+	    stages[s].count += h.count.load(std::memory_order_relaxed);
+	    stages[s].sum += h.sum.load(std::memory_order_relaxed);
+	    stages[s].max = std::max(stages[s].max, (uint64_t) h.max.load(std::memory_order_relaxed));
+	}
+	for (int c = 0; c < TEL_COUNTERS; c++)
+	    counters[c] += b->counter[c].load(std::memory_order_relaxed);
+    }
+    for (int g = 0; g < TEL_GAUGES; g++)
+	gauges[g] = gaugeValues[g].load(std::memory_order_relaxed);
+
+    for (int s = 0; s < TEL_STAGES; s++) {
+	uint64_t *cur = &current[s * TEL_BUCKETS];
+	uint64_t *prev = &previous[s * TEL_BUCKETS];
+	uint64_t total = 0;
+
+	for (int i = 0; i < TEL_BUCKETS; i++)
+	    total += cur[i] - prev[i];
+	for (int q = 0; q < 4; q++) {
+	    uint64_t rank = (uint64_t) (quantiles[q] * total + 0.5);
+	    uint64_t seen = 0;
+	    int i;
+
+	    if (total == 0)
+		continue;
+	    if (rank == 0)
+		rank = 1;
+	    for (i = 0; i < TEL_BUCKETS - 1; i++) {
+		seen += cur[i] - prev[i];
+		if (seen >= rank)
+		    break;
+	    }
+	    stages[s].quantile[q] = bucketLimit(i);
+	}
+    }
+    previous.swap(current);
+}
+
+QByteArray telemetryWriter::format(void) {
+    QString out;
+
+    if (json) {
+	out = "{\n  \"stages\": {\n";
+	for (int s = 0; s < TEL_STAGES; s++)
+	    out += QString("    \"%1\": {\"count\": %2, \"sum_ns\": %3, \"max_ns\": %4, "
+			   "\"p50_ns\": %5, \"p90_ns\": %6, \"p99_ns\": %7, \"p999_ns\": %8}%9\n")
+		.arg(stageNames[s]).arg(stages[s].count).arg(stages[s].sum)
+		.arg(stages[s].max).arg(stages[s].quantile[0])
+		.arg(stages[s].quantile[1]).arg(stages[s].quantile[2])
+		.arg(stages[s].quantile[3]).arg(s < TEL_STAGES - 1? ",": "");
+	out += "  },\n  \"counters\": {\n";
+	for (int c = 0; c < TEL_COUNTERS; c++)
+	    out += QString("    \"%1\": %2%3\n").arg(counterNames[c])
+		.arg(counters[c]).arg(c < TEL_COUNTERS - 1? ",": "");
+	out += "  },\n  \"gauges\": {\n";
+	for (int g = 0; g < TEL_GAUGES; g++)
+	    out += QString("    \"%1\": %2%3\n").arg(gaugeNames[g])
+		.arg(gauges[g]).arg(g < TEL_GAUGES - 1? ",": "");
+	out += "  }\n}\n";
+	return out.toUtf8();
+    }
+
+    out = "# TYPE " TARGET "_stage_seconds summary\n";
+    for (int s = 0; s < TEL_STAGES; s++) {
+	for (int q = 0; q < 4; q++)
+	    out += QString(TARGET "_stage_seconds{stage=\"%1\",quantile=\"%2\"} %3\n")
+		.arg(stageNames[s]).arg(quantiles[q])
+		.arg(stages[s].quantile[q] / 1e9, 0, 'g', 6);
+	out += QString(TARGET "_stage_seconds_sum{stage=\"%1\"} %2\n")
+	    .arg(stageNames[s]).arg(stages[s].sum / 1e9, 0, 'g', 9);
+	out += QString(TARGET "_stage_seconds_count{stage=\"%1\"} %2\n")
+	    .arg(stageNames[s]).arg(stages[s].count);
+    }
+    out += "# TYPE " TARGET "_stage_max_seconds gauge\n";
+    for (int s = 0; s < TEL_STAGES; s++)
+	out += QString(TARGET "_stage_max_seconds{stage=\"%1\"} %2\n")
+	    .arg(stageNames[s]).arg(stages[s].max / 1e9, 0, 'g', 6);
+    for (int c = 0; c < TEL_COUNTERS; c++)
+	out += QString("# TYPE " TARGET "_%1_total counter\n" TARGET "_%1_total %2\n")
+	    .arg(counterNames[c]).arg(counters[c]);
+    for (int g = 0; g < TEL_GAUGES; g++)
+	out += QString("# TYPE " TARGET "_%1 gauge\n" TARGET "_%1 %2\n")
+	    .arg(gaugeNames[g]).arg(gauges[g]);
+    return out.toUtf8();
+}
+
+//	QSaveFile writes to a temporary and renames it over the target on
+//	commit, so readers see either the old file or the new one, never
+//	a partial or missing one
+bool telemetryWriter::writeFile(const QByteArray &data) {
+    QSaveFile f(target);
+
+    if (!f.open(QIODevice::WriteOnly))
+	return false;
+    if (f.write(data) != data.size()) {
+	f.cancelWriting();
+	return false;
+    }
+    return f.commit();
+}
+
+//	a fresh snapshot per connection, the scraper sets the pace
+void telemetryWriter::serve(void) {
+#if !IS_WINDOWS
+    struct pollfd p;
+
+    p.fd = listenSocket;
+    p.events = POLLIN;
+    if (poll(&p, 1, 200) <= 0)
+	return;
+    int s = accept(listenSocket, nullptr, nullptr);
+
+    if (s < 0)
+	return;
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+
+    setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+    snapshot();
+    QByteArray data = format();
+    const char *d = data.constData();
+    int left = data.size();
+
+    while (left > 0) {
+	// a scraper hanging up early must not take the receiver with it
+	ssize_t n = send(s, d, left, MSG_NOSIGNAL);
+
+	if (n < 0 && errno == EINTR)
+	    continue;
+	if (n <= 0) {
+	    if (n < 0 && errno == EPIPE)
+		log(LOG_EVENT, LOG_VERBOSE, "telemetry client went away");
+	    break;
+	}
+	d += n;
+	left -= n;
+    }
+    ::close(s);
+#endif
+}
+
+void telemetryWriter::run(void) {
+    if (socketPath != "") {
+#if !IS_WINDOWS
+	struct sockaddr_un addr;
+	QByteArray path = QFile::encodeName(socketPath);
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if ((size_t) path.size() >= sizeof(addr.sun_path)) {
+	    log(LOG_EVENT, LOG_MIN, "telemetry socket path too long %s", path.constData());
+	    return;
+	}
+	strcpy(addr.sun_path, path.constData());
+	unlink(addr.sun_path);
+	listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listenSocket < 0 ||
+	    bind(listenSocket, (struct sockaddr *) &addr, sizeof(addr)) < 0 ||
+	    listen(listenSocket, 4) < 0) {
+	    log(LOG_EVENT, LOG_MIN, "telemetry cannot listen on %s", path.constData());
+	    if (listenSocket >= 0)
+		::close(listenSocket);
+	    listenSocket = -1;
+	    return;
+	}
+	log(LOG_EVENT, LOG_MIN, "telemetry listening on %s", path.constData());
+	while (!stopping.tryAcquire(1, 0))
+	    serve();
+	::close(listenSocket);
+	listenSocket = -1;
+	unlink(addr.sun_path);
+#else
+	log(LOG_EVENT, LOG_MIN, "telemetry sockets are not supported");
+#endif
+	return;
+    }
+
+    log(LOG_EVENT, LOG_MIN, "telemetry written to %s every %i ms",
+	qPrintable(target), interval);
+    do {
+	snapshot();
+	if (!writeFile(format()))
+	    log(LOG_EVENT, LOG_MIN, "telemetry cannot write %s", qPrintable(target));
+    } while (!stopping.tryAcquire(1, interval));
+}
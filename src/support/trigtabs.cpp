@@ -33,6 +33,7 @@
 #define	NEGSIZE		(-TABSIZE)
 
 #include	"trigtabs.h"
+#include	"simd-helper.h"
 
 float toBaseRadians(DSPFLOAT phase) {
     DSPFLOAT cycles;
@@ -158,3 +159,120 @@ DSPFLOAT trigTabs::atan2(float y, float x) {
 float	trigTabs::argX	(DSPCOMPLEX v) {
 	return this -> atan2 (imag (v), real (v));
 }
+
+// The batch versions are polynomial approximations, which can be
+// vectorized, as opposed to table lookups.
+// atan2 is good to about 2e-6 radians, sin and cos to about 1e-6
+static inline vfloat atan2Kernel(vfloat y, vfloat x) {
+    vfloat zero = vSet(0);
+    vfloat ax = vAbs(x);
+    vfloat ay = vAbs(y);
+    vfloat a = vDiv(vMin(ax, ay), vMax(vMax(ax, ay), vSet(1e-30f)));
+    vfloat s = vMul(a, a);
+    vfloat r = vSet(-0.01172120f);
+
+    r = vAdd(vMul(r, s), vSet(0.05265332f));
+    r = vAdd(vMul(r, s), vSet(-0.11643287f));
+    r = vAdd(vMul(r, s), vSet(0.19354346f));
+    r = vAdd(vMul(r, s), vSet(-0.33262347f));
+    r = vAdd(vMul(r, s), vSet(0.99997726f));
+    r = vMul(r, a);
+    r = vSelect(vLess(ax, ay), vSub(vSet(M_PI / 2), r), r);
+    r = vSelect(vLess(x, zero), vSub(vSet(M_PI), r), r);
+    return vSelect(vLess(y, zero), vSub(zero, r), r);
+}
+
+static inline void sinCosKernel(vfloat phase, vfloat* s, vfloat* c) {
+    vfloat zero = vSet(0);
+    vfloat q = vFloor(vAdd(vMul(phase, vSet(2 / M_PI)), vSet(0.5f)));
+
+    // reduce to +/- pi/4, in two steps to keep the precision
+    vfloat r = vSub(phase, vMul(q, vSet(1.5707963705062866f)));
+    r = vAdd(r, vMul(q, vSet(4.37113900018624283e-8f)));
+    vfloat r2 = vMul(r, r);
+
+    vfloat sr = vAdd(vMul(vSet(-1.0f / 5040), r2), vSet(1.0f / 120));
+    sr = vAdd(vMul(sr, r2), vSet(-1.0f / 6));
+    sr = vAdd(vMul(vMul(sr, r2), r), r);
+    vfloat cr = vAdd(vMul(vSet(1.0f / 40320), r2), vSet(-1.0f / 720));
+    cr = vAdd(vMul(cr, r2), vSet(1.0f / 24));
+    cr = vAdd(vMul(cr, r2), vSet(-0.5f));
+    cr = vAdd(vMul(cr, r2), vSet(1.0f));
+
+    // quadrant 0 .. 3
+    vfloat quadrant = vSub(q, vMul(vFloor(vMul(q, vSet(0.25f))), vSet(4.0f)));
+    vfloat odd = vSub(quadrant, vMul(vFloor(vMul(quadrant, vSet(0.5f))), vSet(2.0f)));
+    vmask swap = vLess(vSet(0.5f), odd);
+    vmask negSin = vLess(vSet(1.5f), quadrant);
+    vmask negCos = vXor(vLess(vSet(0.5f), quadrant), vLess(vSet(2.5f), quadrant));
+    vfloat vs = vSelect(swap, cr, sr);
+    vfloat vc = vSelect(swap, sr, cr);
+
+    *s = vSelect(negSin, vSub(zero, vs), vs);
+    *c = vSelect(negCos, vSub(zero, vc), vc);
+}
+
+void trigTabs::atan2(const float* y, const float* x, float* out, int32_t n) {
+    float ty[VFLOAT_SIZE];
+    float tx[VFLOAT_SIZE];
+    int32_t i;
+
+    for (i = 0; i + VFLOAT_SIZE <= n; i += VFLOAT_SIZE)
+        vStore(&out[i], atan2Kernel(vLoad(&y[i]), vLoad(&x[i])));
+    if (i < n) {
+        int32_t rest = n - i;
+
+        for (int32_t j = 0; j < VFLOAT_SIZE; j++) {
+            ty[j] = (j < rest) ? y[i + j] : 0;
+            tx[j] = (j < rest) ? x[i + j] : 1;
+        }
+        vStore(ty, atan2Kernel(vLoad(ty), vLoad(tx)));
+        for (int32_t j = 0; j < rest; j++)
+            out[i + j] = ty[j];
+    }
+}
+
+void trigTabs::argX(const DSPCOMPLEX* v, float* out, int32_t n) {
+    float ty[VFLOAT_SIZE];
+    float tx[VFLOAT_SIZE];
+    int32_t i;
+
+    for (i = 0; i < n; i += VFLOAT_SIZE) {
+        int32_t rest = (n - i < VFLOAT_SIZE) ? n - i : VFLOAT_SIZE;
+
+        for (int32_t j = 0; j < VFLOAT_SIZE; j++) {
+            ty[j] = (j < rest) ? imag(v[i + j]) : 0;
+            tx[j] = (j < rest) ? real(v[i + j]) : 1;
+        }
+        vStore(ty, atan2Kernel(vLoad(ty), vLoad(tx)));
+        for (int32_t j = 0; j < rest; j++)
+            out[i + j] = ty[j];
+    }
+}
+
+void trigTabs::sinCos(const DSPFLOAT* phase, DSPFLOAT* s, DSPFLOAT* c, int32_t n) {
+    float tp[VFLOAT_SIZE];
+    float ts[VFLOAT_SIZE];
+    float tc[VFLOAT_SIZE];
+    vfloat vs, vc;
+    int32_t i;
+
+    for (i = 0; i + VFLOAT_SIZE <= n; i += VFLOAT_SIZE) {
+        sinCosKernel(vLoad(&phase[i]), &vs, &vc);
+        vStore(&s[i], vs);
+        vStore(&c[i], vc);
+    }
+    if (i < n) {
+        int32_t rest = n - i;
+
+        for (int32_t j = 0; j < VFLOAT_SIZE; j++)
+            tp[j] = (j < rest) ? phase[i + j] : 0;
+        sinCosKernel(vLoad(tp), &vs, &vc);
+        vStore(ts, vs);
+        vStore(tc, vc);
+        for (int32_t j = 0; j < rest; j++) {
+            s[i + j] = ts[j];
+            c[i + j] = tc[j];
+        }
+    }
+}